@@ -12,9 +12,11 @@
 #include "leds_task.h"
 #include "modes_task.h"
 #include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
 
 // Setup timer with microsecond resolution for keeping track of time.
-SystemTimer sys_timer;
+// Interrupts at 1 kHz to trigger the preemptive tasks so it needs to be a multiple of their frequencies.
+SystemTimer sys_timer(1000);
 
 // Periodic Tasks ->     Task name        Frequency (Hz)
 MainControlTask          main_control_task   (1000);
@@ -22,32 +24,43 @@ ComplementaryFilterTask  comp_filter_task     (500);
 StatusUpdateTask         status_update_task     (5);
 LedsTask                 leds_task             (20);
 ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100); // Fastest rate globs can be streamed at.
 
-// Queued Tasks ->       Task name      Queue Size (elements)
-TelemetrySendTask        send_task            (100);
+// Queued Tasks ->       Task name      Queue Size (elements per class)
+TelemetrySendTask        send_task             (40);
 
 // General Tasks ->      Task name
 TelemetryReceiveTask     receive_task; // Runs when data is ready from serial port.
 
-// Create the scheduler to manage when tasks run.
-Scheduler::Scheduler scheduler;
+// Create the scheduler to manage when tasks run.  Uses a ready-set so the time it takes
+// to pick the next task doesn't depend on how many tasks are registered.
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
 
 //*****************************************************************************
 int main(void)
 {
     debug_printf("Hi I'm Eeva.");
 
+    // Add periodic tasks here that can't be delayed by other tasks running.  These run from an
+    // interrupt so they preempt every task in the normal array below.
+    static Scheduler::Task * preemptive_tasks[] =
+    {
+        &main_control_task,
+    };
+
+    const uint32_t number_of_preemptive_tasks = sizeof(preemptive_tasks) / sizeof(preemptive_tasks[0]);
+
     // Add tasks here to register them with the scheduler.
     // A task at the beginning of the array will have a higher priority than one towards the end.
     static Scheduler::Task * tasks[] =
     {
-        &main_control_task,
         &comp_filter_task,
         &send_task,
         &receive_task,
         &leds_task,
         &modes_task,
         &status_update_task,
+        &stream_task,
     };
 
     const uint32_t number_of_tasks = sizeof(tasks) / sizeof(tasks[0]);
@@ -62,6 +75,12 @@ int main(void)
         assert_msg(registration_success, ASSERT_STOP, "Failed to register task \"%s\"", tasks[i]->name());
     }
 
+    for (uint32_t i = 0; i < number_of_preemptive_tasks; ++i)
+    {
+        bool registration_success = scheduler.registerPreemptiveTask(*preemptive_tasks[i]);
+        assert_msg(registration_success, ASSERT_STOP, "Failed to register preemptive task \"%s\"", preemptive_tasks[i]->name());
+    }
+
     debug_printf("Everything is setup correctly.");
 
     // Allow tasks to start running.
@@ -0,0 +1,264 @@
+// Includes
+#include <cstring>
+#include "glob_gather.h"
+#include "glob_registry.h"
+#include "math_util.h"
+
+//*****************************************************************************
+GlobGather::GlobGather(void) :
+    num_locals_(0),
+    num_entries_(0),
+    sample_bytes_(0)
+{
+}
+
+//*****************************************************************************
+bool GlobGather::addLocal(glob_id_t id, void const * data, uint16_t instance)
+{
+    if ((num_locals_ >= MAX_GATHER_LOCALS) || (id >= NUM_GLOBS) || (data == NULL))
+    {
+        return false;
+    }
+
+    locals_[num_locals_].data = data;
+    locals_[num_locals_].instance = instance;
+    locals_[num_locals_].id = id;
+    num_locals_++;
+
+    return true;
+}
+
+//*****************************************************************************
+glo_capture_channels_status_t GlobGather::compile(glo_capture_channels_t const & channels, uint8_t * bad_channel)
+{
+    *bad_channel = 0;
+
+    if (channels.num_channels > CAPTURE_MAX_CHANNELS)
+    {
+        *bad_channel = CAPTURE_MAX_CHANNELS;
+        return CAPTURE_CHANNELS_TOO_BIG;
+    }
+
+    // Check everything first so the old channels are left alone if any are bad.
+    uint16_t sample_bytes = 0;
+    uint16_t source_bytes = 0;
+    uint8_t num_sources = 0;
+    for (uint8_t i = 0; i < channels.num_channels; ++i)
+    {
+        *bad_channel = i;
+
+        glob_id_t id = channels.glob_id[i];
+        uint16_t instance = (channels.instance[i] == 0) ? 1 : channels.instance[i];
+        if ((id >= NUM_GLOBS) || (instance > globs[id]->get_num_instances()) || !isField(id, channels.offset[i], channels.type[i]))
+        {
+            return CAPTURE_CHANNELS_BAD_FIELD;
+        }
+
+        sample_bytes += glob_field_type_size(channels.type[i]);
+        if (sample_bytes > CAPTURE_MAX_CHANNEL_BYTES)
+        {
+            return CAPTURE_CHANNELS_TOO_BIG;
+        }
+
+        // Count each glob that has to be read once, the first time a channel uses it.
+        bool new_source = (findLocal(id, instance) == NULL);
+        for (uint8_t j = 0; new_source && (j < i); ++j)
+        {
+            uint16_t other_instance = (channels.instance[j] == 0) ? 1 : channels.instance[j];
+            new_source = (channels.glob_id[j] != id) || (other_instance != instance);
+        }
+        if (new_source)
+        {
+            num_sources++;
+            source_bytes += (globs[id]->get_num_bytes() + 3) & ~3u;
+            if ((num_sources > MAX_SNAPSHOT_GLOBS) || (source_bytes > GATHER_SOURCE_BYTES))
+            {
+                return CAPTURE_CHANNELS_TOO_BIG;
+            }
+        }
+    }
+
+    // Now build the table, giving each glob that's read its own spot in the source buffer.
+    sources_.clear();
+    source_bytes = 0;
+    for (uint8_t i = 0; i < channels.num_channels; ++i)
+    {
+        glob_id_t id = channels.glob_id[i];
+        uint16_t instance = (channels.instance[i] == 0) ? 1 : channels.instance[i];
+
+        uint8_t const * data = (uint8_t const *)findLocal(id, instance);
+        for (uint8_t j = 0; (data == NULL) && (j < i); ++j)
+        {
+            uint16_t other_instance = (channels.instance[j] == 0) ? 1 : channels.instance[j];
+            if ((channels.glob_id[j] == id) && (other_instance == instance))
+            {
+                data = entries_[j].source - channels.offset[j];
+            }
+        }
+        if (data == NULL)
+        {
+            data = (uint8_t const *)source_buffer_ + source_bytes;
+            sources_.add(*globs[id], (void *)data, instance);
+            source_bytes += (globs[id]->get_num_bytes() + 3) & ~3u;
+        }
+
+        entries_[i].source = data + channels.offset[i];
+        entries_[i].size = (uint8_t)glob_field_type_size(channels.type[i]);
+        entries_[i].type = channels.type[i];
+    }
+
+    num_entries_ = channels.num_channels;
+    sample_bytes_ = sample_bytes;
+    *bad_channel = 0;
+
+    return CAPTURE_CHANNELS_OK;
+}
+
+//*****************************************************************************
+void GlobGather::read(void)
+{
+    sources_.read();
+}
+
+//*****************************************************************************
+uint16_t GlobGather::gather(uint8_t * sample) const
+{
+    uint8_t * next = sample;
+    for (uint8_t i = 0; i < num_entries_; ++i)
+    {
+        // Fixed size copies so each is a single load and store.  Samples are packed so they're unaligned.
+        entry_t const & entry = entries_[i];
+        switch (entry.size)
+        {
+            case 4:
+                memcpy(next, entry.source, 4);
+                break;
+            case 2:
+                memcpy(next, entry.source, 2);
+                break;
+            default:
+                *next = *entry.source;
+                break;
+        }
+        next += entry.size;
+    }
+
+    return (uint16_t)(next - sample);
+}
+
+//*****************************************************************************
+uint16_t GlobGather::pack(float const * values, uint8_t * sample) const
+{
+    uint8_t * next = sample;
+    for (uint8_t i = 0; i < num_entries_; ++i)
+    {
+        // Not a number is zero for integers.  The limits are the biggest floats that fit.
+        float value = (values[i] == values[i]) ? values[i] : 0.0f;
+        float rounded = (value >= 0.0f) ? (value + 0.5f) : (value - 0.5f);
+        switch (entries_[i].type)
+        {
+            case GLOB_FIELD_UINT16:
+            {
+                uint16_t field = (uint16_t)limit(rounded, 0.0f, 65535.0f);
+                memcpy(next, &field, sizeof(field));
+                break;
+            }
+            case GLOB_FIELD_UINT32:
+            {
+                uint32_t field = (uint32_t)limit(rounded, 0.0f, 4294967040.0f);
+                memcpy(next, &field, sizeof(field));
+                break;
+            }
+            case GLOB_FIELD_INT32:
+            {
+                int32_t field = (int32_t)limit(rounded, -2147483648.0f, 2147483520.0f);
+                memcpy(next, &field, sizeof(field));
+                break;
+            }
+            case GLOB_FIELD_FLOAT:
+                memcpy(next, &values[i], sizeof(float));
+                break;
+            default:
+                *next = (uint8_t)limit(rounded, 0.0f, 255.0f);
+                break;
+        }
+        next += entries_[i].size;
+    }
+
+    return (uint16_t)(next - sample);
+}
+
+//*****************************************************************************
+float GlobGather::value(uint8_t channel) const
+{
+    if (channel >= num_entries_)
+    {
+        return 0;
+    }
+
+    entry_t const & entry = entries_[channel];
+    switch (entry.type)
+    {
+        case GLOB_FIELD_UINT16:
+        {
+            uint16_t value;
+            memcpy(&value, entry.source, sizeof(value));
+            return value;
+        }
+        case GLOB_FIELD_UINT32:
+        {
+            uint32_t value;
+            memcpy(&value, entry.source, sizeof(value));
+            return value;
+        }
+        case GLOB_FIELD_INT32:
+        {
+            int32_t value;
+            memcpy(&value, entry.source, sizeof(value));
+            return value;
+        }
+        case GLOB_FIELD_FLOAT:
+        {
+            float value;
+            memcpy(&value, entry.source, sizeof(value));
+            return value;
+        }
+        default:
+            return *entry.source;
+    }
+}
+
+//*****************************************************************************
+void const * GlobGather::findLocal(glob_id_t id, uint16_t instance) const
+{
+    for (uint8_t i = 0; i < num_locals_; ++i)
+    {
+        if ((locals_[i].id == id) && (locals_[i].instance == instance))
+        {
+            return locals_[i].data;
+        }
+    }
+    return NULL;
+}
+
+//*****************************************************************************
+bool GlobGather::isField(glob_id_t id, uint16_t offset, uint8_t type)
+{
+    if (type >= NUM_GLOB_FIELD_TYPES)
+    {
+        return false;
+    }
+
+    uint16_t size = glob_field_type_size(type);
+    glob_info_t const & info = glob_registry[id];
+    for (uint8_t i = 0; i < info.num_fields; ++i)
+    {
+        glob_field_t const & field = info.fields[i];
+        if ((field.type == type) && (offset >= field.offset) &&
+            (offset + size <= field.offset + field.count * size) && ((offset - field.offset) % size == 0))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,343 @@
+// Includes
+#include "glob_registry.h"
+
+//******************************************************************************
+// Field descriptors for every glob type in glob_types.h.  Must list every field in order.  The checks
+// at the bottom of this file fail to compile if one is missing (except pad bytes, which are optional).
+GLOB_FIELDS(glo_motion_commands_t) =
+{
+    GLOB_FIELD(glo_motion_commands_t, linear_velocity),
+    GLOB_FIELD(glo_motion_commands_t, angular_velocity),
+};
+
+GLOB_FIELDS(glo_raw_imu_t) =
+{
+    GLOB_FIELD(glo_raw_imu_t, gyros),
+    GLOB_FIELD(glo_raw_imu_t, accels),
+};
+
+GLOB_FIELDS(glo_imu_t) =
+{
+    GLOB_FIELD(glo_imu_t, gyros),
+    GLOB_FIELD(glo_imu_t, accels),
+};
+
+GLOB_FIELDS(glo_analog_t) =
+{
+    GLOB_FIELD(glo_analog_t, voltages),
+    GLOB_FIELD(glo_analog_t, battery_voltage),
+};
+
+GLOB_FIELDS(glo_roll_pitch_yaw_t) =
+{
+    GLOB_FIELD(glo_roll_pitch_yaw_t, rpy),
+};
+
+GLOB_FIELDS(glo_quaternion_t) =
+{
+    GLOB_FIELD(glo_quaternion_t, q),
+};
+
+GLOB_FIELDS(glo_theta_zero_t) =
+{
+    GLOB_FIELD(glo_theta_zero_t, theta),
+};
+
+GLOB_FIELDS(glo_odometry_t) =
+{
+    GLOB_FIELD(glo_odometry_t, left_distance),
+    GLOB_FIELD(glo_odometry_t, right_distance),
+    GLOB_FIELD(glo_odometry_t, avg_distance),
+    GLOB_FIELD(glo_odometry_t, yaw),
+    GLOB_FIELD(glo_odometry_t, left_speed),
+    GLOB_FIELD(glo_odometry_t, right_speed),
+    GLOB_FIELD(glo_odometry_t, avg_speed),
+};
+
+GLOB_FIELDS(glo_pid_params_t) =
+{
+    GLOB_FIELD(glo_pid_params_t, kp),
+    GLOB_FIELD(glo_pid_params_t, ki),
+    GLOB_FIELD(glo_pid_params_t, kd),
+    GLOB_FIELD(glo_pid_params_t, integral_lolimit),
+    GLOB_FIELD(glo_pid_params_t, integral_hilimit),
+    GLOB_FIELD(glo_pid_params_t, lolimit),
+    GLOB_FIELD(glo_pid_params_t, hilimit),
+};
+
+GLOB_FIELDS(glo_modes_t) =
+{
+    GLOB_FIELD(glo_modes_t, main_mode),
+    GLOB_FIELD(glo_modes_t, sub_mode),
+    GLOB_FIELD(glo_modes_t, state),
+};
+
+GLOB_FIELDS(glo_assert_message_t) =
+{
+    GLOB_FIELD(glo_assert_message_t, action),
+    GLOB_FIELD(glo_assert_message_t, text),
+    GLOB_FIELD(glo_assert_message_t, valid),
+};
+
+GLOB_FIELDS(glo_debug_message_t) =
+{
+    GLOB_FIELD(glo_debug_message_t, text),
+    GLOB_FIELD(glo_debug_message_t, valid),
+};
+
+GLOB_FIELDS(glo_capture_data_t) =
+{
+    GLOB_FIELD(glo_capture_data_t, time),
+    GLOB_FIELD(glo_capture_data_t, data),
+};
+
+GLOB_FIELDS(glo_driving_command_t) =
+{
+    GLOB_FIELD(glo_driving_command_t, movement_type),
+    GLOB_FIELD(glo_driving_command_t, linear_velocity),
+    GLOB_FIELD(glo_driving_command_t, angular_velocity),
+};
+
+GLOB_FIELDS(glo_capture_command_t) =
+{
+    GLOB_FIELD(glo_capture_command_t, is_start),
+    GLOB_FIELD(glo_capture_command_t, paused),
+    GLOB_FIELD(glo_capture_command_t, frequency),
+    GLOB_FIELD(glo_capture_command_t, desired_samples),
+    GLOB_FIELD(glo_capture_command_t, total_samples),
+    GLOB_FIELD(glo_capture_command_t, stream),
+    GLOB_FIELD(glo_capture_command_t, unfiltered),
+};
+
+GLOB_FIELDS(glo_status_data_t) =
+{
+    GLOB_FIELD(glo_status_data_t, battery),
+    GLOB_FIELD(glo_status_data_t, roll),
+    GLOB_FIELD(glo_status_data_t, pitch),
+    GLOB_FIELD(glo_status_data_t, yaw),
+    GLOB_FIELD(glo_status_data_t, main_mode),
+    GLOB_FIELD(glo_status_data_t, sub_mode),
+    GLOB_FIELD(glo_status_data_t, state),
+    GLOB_FIELD(glo_status_data_t, error_codes),
+    GLOB_FIELD(glo_status_data_t, left_linear_position),
+    GLOB_FIELD(glo_status_data_t, right_linear_position),
+    GLOB_FIELD(glo_status_data_t, left_angular_position),
+    GLOB_FIELD(glo_status_data_t, right_angular_position),
+    GLOB_FIELD(glo_status_data_t, left_linear_velocity),
+    GLOB_FIELD(glo_status_data_t, right_linear_velocity),
+    GLOB_FIELD(glo_status_data_t, left_angular_velocity),
+    GLOB_FIELD(glo_status_data_t, right_angular_velocity),
+    GLOB_FIELD(glo_status_data_t, left_pwm),
+    GLOB_FIELD(glo_status_data_t, right_pwm),
+    GLOB_FIELD(glo_status_data_t, firmware_version),
+    GLOB_FIELD(glo_status_data_t, processor_id),
+};
+
+GLOB_FIELDS(glo_robot_command_t) =
+{
+    GLOB_VALUE(glo_robot_command_t),
+};
+
+GLOB_FIELDS(glo_motor_pwm_t) =
+{
+    GLOB_FIELD(glo_motor_pwm_t, left_duty),
+    GLOB_FIELD(glo_motor_pwm_t, right_duty),
+};
+
+GLOB_FIELDS(glo_wave_t) =
+{
+    GLOB_FIELD(glo_wave_t, type),
+    GLOB_FIELD(glo_wave_t, state),
+    GLOB_FIELD(glo_wave_t, pad),
+    GLOB_FIELD(glo_wave_t, value),
+    GLOB_FIELD(glo_wave_t, magnitude),
+    GLOB_FIELD(glo_wave_t, frequency),
+    GLOB_FIELD(glo_wave_t, duration),
+    GLOB_FIELD(glo_wave_t, offset),
+    GLOB_FIELD(glo_wave_t, time),
+    GLOB_FIELD(glo_wave_t, total_time),
+    GLOB_FIELD(glo_wave_t, run_continuous),
+    GLOB_FIELD(glo_wave_t, pad2),
+    GLOB_FIELD(glo_wave_t, vmax),
+    GLOB_FIELD(glo_wave_t, amax),
+    GLOB_FIELD(glo_wave_t, dx),
+    GLOB_FIELD(glo_wave_t, t1),
+    GLOB_FIELD(glo_wave_t, t2),
+    GLOB_FIELD(glo_wave_t, t3),
+    GLOB_FIELD(glo_wave_t, c1),
+    GLOB_FIELD(glo_wave_t, c2),
+    GLOB_FIELD(glo_wave_t, c3),
+};
+
+GLOB_FIELDS(glo_request_t) =
+{
+    GLOB_FIELD(glo_request_t, requested_id),
+};
+
+GLOB_FIELDS(glo_task_timing_t) =
+{
+    GLOB_FIELD(glo_task_timing_t, task_name),
+    GLOB_FIELD(glo_task_timing_t, timer_frequency),
+    GLOB_FIELD(glo_task_timing_t, recording_duration),
+    GLOB_FIELD(glo_task_timing_t, execute_counts),
+    GLOB_FIELD(glo_task_timing_t, times_skipped),
+    GLOB_FIELD(glo_task_timing_t, delay_ticks_max),
+    GLOB_FIELD(glo_task_timing_t, delay_ticks_min),
+    GLOB_FIELD(glo_task_timing_t, delay_ticks_avg),
+    GLOB_FIELD(glo_task_timing_t, run_ticks_max),
+    GLOB_FIELD(glo_task_timing_t, run_ticks_min),
+    GLOB_FIELD(glo_task_timing_t, run_ticks_avg),
+    GLOB_FIELD(glo_task_timing_t, interval_ticks_max),
+    GLOB_FIELD(glo_task_timing_t, interval_ticks_min),
+    GLOB_FIELD(glo_task_timing_t, interval_ticks_avg),
+};
+
+GLOB_FIELDS(glo_link_mode_t) =
+{
+    GLOB_FIELD(glo_link_mode_t, framing),
+    GLOB_FIELD(glo_link_mode_t, batch_frames),
+    GLOB_FIELD(glo_link_mode_t, reliable_bulk),
+};
+
+GLOB_FIELDS(glo_telemetry_stats_t) =
+{
+    GLOB_FIELD(glo_telemetry_stats_t, bytes_per_second),
+    GLOB_FIELD(glo_telemetry_stats_t, queue_depth),
+    GLOB_FIELD(glo_telemetry_stats_t, max_queue_depth),
+    GLOB_FIELD(glo_telemetry_stats_t, num_dropped),
+};
+
+GLOB_FIELDS(glo_bulk_transfer_t) =
+{
+    GLOB_FIELD(glo_bulk_transfer_t, num_sent),
+    GLOB_FIELD(glo_bulk_transfer_t, num_resent),
+    GLOB_FIELD(glo_bulk_transfer_t, first_instance),
+    GLOB_FIELD(glo_bulk_transfer_t, last_instance),
+    GLOB_FIELD(glo_bulk_transfer_t, window),
+    GLOB_FIELD(glo_bulk_transfer_t, transfer_id),
+    GLOB_FIELD(glo_bulk_transfer_t, glob_id),
+    GLOB_FIELD(glo_bulk_transfer_t, state),
+};
+
+GLOB_FIELDS(glo_bulk_ack_t) =
+{
+    GLOB_FIELD(glo_bulk_ack_t, missing),
+    GLOB_FIELD(glo_bulk_ack_t, next_instance),
+    GLOB_FIELD(glo_bulk_ack_t, newest_instance),
+    GLOB_FIELD(glo_bulk_ack_t, transfer_id),
+};
+
+GLOB_FIELDS(glo_stream_subscription_t) =
+{
+    GLOB_FIELD(glo_stream_subscription_t, rate),
+    GLOB_FIELD(glo_stream_subscription_t, first_instance),
+    GLOB_FIELD(glo_stream_subscription_t, last_instance),
+    GLOB_FIELD(glo_stream_subscription_t, decimation),
+    GLOB_FIELD(glo_stream_subscription_t, glob_id),
+    GLOB_FIELD(glo_stream_subscription_t, status),
+};
+
+GLOB_FIELDS(glo_capture_status_t) =
+{
+    GLOB_FIELD(glo_capture_status_t, num_captured),
+    GLOB_FIELD(glo_capture_status_t, num_sent),
+    GLOB_FIELD(glo_capture_status_t, num_overruns),
+    GLOB_FIELD(glo_capture_status_t, backlog),
+    GLOB_FIELD(glo_capture_status_t, max_backlog),
+    GLOB_FIELD(glo_capture_status_t, ring_size),
+    GLOB_FIELD(glo_capture_status_t, streaming),
+};
+
+GLOB_FIELDS(glo_capture_channels_t) =
+{
+    GLOB_FIELD(glo_capture_channels_t, scale),
+    GLOB_FIELD(glo_capture_channels_t, zero),
+    GLOB_FIELD(glo_capture_channels_t, offset),
+    GLOB_FIELD(glo_capture_channels_t, instance),
+    GLOB_FIELD(glo_capture_channels_t, glob_id),
+    GLOB_FIELD(glo_capture_channels_t, type),
+    GLOB_FIELD(glo_capture_channels_t, num_channels),
+    GLOB_FIELD(glo_capture_channels_t, status),
+    GLOB_FIELD(glo_capture_channels_t, sample_bytes),
+    GLOB_FIELD(glo_capture_channels_t, bad_channel),
+    GLOB_FIELD(glo_capture_channels_t, format),
+    GLOB_FIELD(glo_capture_channels_t, samples_per_instance),
+};
+
+GLOB_FIELDS(glo_capture_trigger_t) =
+{
+    GLOB_FIELD(glo_capture_trigger_t, level),
+    GLOB_FIELD(glo_capture_trigger_t, num_pre_sent),
+    GLOB_FIELD(glo_capture_trigger_t, pre_samples),
+    GLOB_FIELD(glo_capture_trigger_t, post_samples),
+    GLOB_FIELD(glo_capture_trigger_t, instance),
+    GLOB_FIELD(glo_capture_trigger_t, source),
+    GLOB_FIELD(glo_capture_trigger_t, edge),
+    GLOB_FIELD(glo_capture_trigger_t, channel),
+    GLOB_FIELD(glo_capture_trigger_t, glob_id),
+    GLOB_FIELD(glo_capture_trigger_t, state),
+};
+
+//******************************************************************************
+// Registry built from the glob list.
+#define GLOB_INFO(var_name, struct_type, id, num_instances, owner_task, storage) \
+    { id, #var_name, #struct_type, #owner_task, sizeof(struct_type), num_instances, storage, \
+      struct_type##_fields, sizeof(struct_type##_fields) / sizeof(glob_field_t) },
+#undef GLOB
+#undef GLOB_SEQLOCK
+#define GLOB(var_name, struct_type, id, num_instances, owner_task) \
+    GLOB_INFO(var_name, struct_type, id, num_instances, owner_task, GLOB_STORAGE_LOCKED)
+#ifdef GLOBS_ALWAYS_LOCKED
+#define GLOB_SEQLOCK GLOB
+#else
+#define GLOB_SEQLOCK(var_name, struct_type, id, num_instances, owner_task) \
+    GLOB_INFO(var_name, struct_type, id, num_instances, owner_task, GLOB_STORAGE_SEQLOCK)
+#endif
+constexpr glob_info_t glob_registry[NUM_GLOBS] =
+{
+#include "glob_list.h"
+};
+
+//******************************************************************************
+// Return true if the fields are in order without any gaps besides alignment padding
+// and the last one ends at the end of the struct (besides padding).
+static constexpr bool glob_fields_match(glob_field_t const * fields, uint8_t num_fields, uint16_t struct_size, uint16_t end)
+{
+    return (num_fields == 0) ? ((end <= struct_size) && (struct_size - end < 4)) :
+           ((fields[0].offset >= end) &&
+            (fields[0].offset - end < glob_field_type_size(fields[0].type)) &&
+            glob_fields_match(fields + 1, num_fields - 1, struct_size,
+                              fields[0].offset + fields[0].count * glob_field_type_size(fields[0].type)));
+}
+
+//******************************************************************************
+// Return true if every registry entry from 'index' on is at the index of its ID.
+static constexpr bool glob_ids_in_order(uint8_t index)
+{
+    return (index == NUM_GLOBS) || ((glob_registry[index].id == index) && glob_ids_in_order(index + 1));
+}
+
+static_assert(glob_ids_in_order(0), "Globs in glob_list.h must be in ID order.");
+
+#undef GLOB
+#undef GLOB_SEQLOCK
+#define GLOB(var_name, struct_type, id, num_instances, owner_task) \
+    static_assert(glob_fields_match(glob_registry[id].fields, glob_registry[id].num_fields, sizeof(struct_type), 0), \
+                  "Field descriptors for " #struct_type " don't match the struct.");
+#define GLOB_SEQLOCK GLOB
+#include "glob_list.h"
+
+//******************************************************************************
+char const * glob_field_type_name(glob_field_type_t type)
+{
+    switch (type)
+    {
+        case GLOB_FIELD_UINT8:  return "uint8";
+        case GLOB_FIELD_UINT16: return "uint16";
+        case GLOB_FIELD_UINT32: return "uint32";
+        case GLOB_FIELD_INT32:  return "int32";
+        case GLOB_FIELD_FLOAT:  return "float";
+        case GLOB_FIELD_CHAR:   return "char";
+        default:                return "unknown";
+    }
+}
@@ -0,0 +1,89 @@
+// Includes
+#include "glob_snapshot.h"
+#include "util_assert.h"
+
+//*****************************************************************************
+GlobSnapshot::GlobSnapshot(void) :
+    num_members_(0),
+    tick_stamp_(0),
+    num_retries_(0),
+    num_fallbacks_(0)
+{
+}
+
+//*****************************************************************************
+bool GlobSnapshot::addMember(GlobBase * glob, void * destination, uint16_t instance)
+{
+    if (num_members_ >= MAX_SNAPSHOT_GLOBS)
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Can't add more than %d globs to a snapshot.", (int)MAX_SNAPSHOT_GLOBS);
+        return false;
+    }
+
+    if ((destination == NULL) || (instance == 0) || (instance > glob->get_num_instances()))
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Invalid snapshot member for glob %d.", (int)glob->get_id());
+        return false;
+    }
+
+    members_[num_members_].glob = glob;
+    members_[num_members_].destination = destination;
+    members_[num_members_].instance = instance;
+    num_members_++;
+
+    return true;
+}
+
+//*****************************************************************************
+uint64_t GlobSnapshot::read(void)
+{
+    for (uint8_t attempt = 0; attempt < MAX_SNAPSHOT_ATTEMPTS; ++attempt)
+    {
+        // If a publish is in progress then this is interrupting it and it can't finish until this returns.
+        if (GlobBase::publishes_in_progress() != 0)
+        {
+            break;
+        }
+
+        uint32_t generation = GlobBase::publish_generation();
+
+        uint64_t newest_tick_stamp = 0;
+        for (uint8_t i = 0; i < num_members_; ++i)
+        {
+            uint64_t tick_stamp = 0;
+            member_t & member = members_[i];
+            member.glob->copy_to_buffer_unlocked(member.destination, member.instance, &tick_stamp);
+            if (tick_stamp > newest_tick_stamp) { newest_tick_stamp = tick_stamp; }
+        }
+
+        // Make sure the copies are done before checking if anything was published during them.
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (GlobBase::publish_generation() == generation)
+        {
+            tick_stamp_ = newest_tick_stamp;
+            return tick_stamp_; // nothing was published during the pass
+        }
+
+        num_retries_++;
+    }
+
+    num_fallbacks_++;
+    readEachAtomically();
+
+    return tick_stamp_;
+}
+
+//*****************************************************************************
+void GlobSnapshot::readEachAtomically(void)
+{
+    tick_stamp_ = 0;
+
+    for (uint8_t i = 0; i < num_members_; ++i)
+    {
+        uint64_t tick_stamp = 0;
+        member_t & member = members_[i];
+        member.glob->copy_to_buffer(member.destination, member.instance, &tick_stamp);
+        if (tick_stamp > tick_stamp_) { tick_stamp_ = tick_stamp; }
+    }
+}
@@ -0,0 +1,117 @@
+// Includes
+#include <cstring>
+#include "glob_trigger.h"
+
+//*****************************************************************************
+GlobTrigger::GlobTrigger(void) :
+    armed_(false),
+    have_last_(false),
+    source_(TRIGGER_SOURCE_NONE),
+    edge_(TRIGGER_EDGE_RISING),
+    channel_(0),
+    glob_id_(0),
+    instance_(1),
+    level_(0),
+    last_value_(0),
+    num_asserts_(0),
+    last_copy_(0)
+{
+}
+
+//*****************************************************************************
+bool GlobTrigger::isValid(glo_capture_trigger_t const & settings, GlobGather const & gather)
+{
+    switch (settings.source)
+    {
+        case TRIGGER_SOURCE_NONE:
+        case TRIGGER_SOURCE_ASSERT:
+            return true;
+        case TRIGGER_SOURCE_CHANNEL:
+            return (settings.channel < gather.numChannels()) && (settings.edge < NUM_TRIGGER_EDGES);
+        case TRIGGER_SOURCE_GLOB_CHANGE:
+        {
+            uint16_t instance = (settings.instance == 0) ? 1 : settings.instance;
+            return (settings.glob_id < NUM_GLOBS) &&
+                   (instance <= globs[settings.glob_id]->get_num_instances()) &&
+                   (globs[settings.glob_id]->get_num_bytes() <= TRIGGER_MAX_GLOB_BYTES);
+        }
+        default:
+            return false;
+    }
+}
+
+//*****************************************************************************
+void GlobTrigger::arm(glo_capture_trigger_t const & settings, uint32_t num_asserts)
+{
+    source_ = settings.source;
+    edge_ = settings.edge;
+    channel_ = settings.channel;
+    glob_id_ = settings.glob_id;
+    instance_ = (settings.instance == 0) ? 1 : settings.instance;
+    level_ = settings.level;
+    num_asserts_ = num_asserts;
+    have_last_ = false;
+    armed_ = (source_ != TRIGGER_SOURCE_NONE);
+}
+
+//*****************************************************************************
+bool GlobTrigger::check(float const * values, uint32_t num_asserts)
+{
+    if (!armed_)
+    {
+        return false;
+    }
+
+    bool triggered = false;
+    switch (source_)
+    {
+        case TRIGGER_SOURCE_CHANNEL:
+        {
+            float value = values[channel_];
+            triggered = have_last_ && crossed(value);
+            last_value_ = value;
+            break;
+        }
+        case TRIGGER_SOURCE_GLOB_CHANGE:
+        {
+            // Compare contents rather than tick stamps since most owners publish every run whether or not
+            // anything changed.
+            GlobBase const * glob = globs[glob_id_];
+            uint8_t next_copy = last_copy_ ^ 1;
+            glob->copy_to_buffer(glob_copies_[next_copy], instance_);
+            triggered = have_last_ && (memcmp(glob_copies_[next_copy], glob_copies_[last_copy_], glob->get_num_bytes()) != 0);
+            last_copy_ = next_copy;
+            break;
+        }
+        case TRIGGER_SOURCE_ASSERT:
+            triggered = (num_asserts != num_asserts_);
+            break;
+        default:
+            break;
+    }
+
+    have_last_ = true;
+    if (triggered)
+    {
+        armed_ = false;
+    }
+
+    return triggered;
+}
+
+//*****************************************************************************
+bool GlobTrigger::crossed(float value) const
+{
+    bool rising = (last_value_ < level_) && (value >= level_);
+    bool falling = (last_value_ > level_) && (value <= level_);
+
+    switch (edge_)
+    {
+        case TRIGGER_EDGE_RISING:
+            return rising;
+        case TRIGGER_EDGE_FALLING:
+            return falling;
+        default:
+            return rising || falling;
+    }
+}
@@ -1,8 +1,19 @@
-
 // Automatically define globs (declared in globs.h) without double maintenance.
 #define DEFINE_GLOBS
 #include "globs.h"
 #undef DEFINE_GLOBS
 
-// Array of metadata. This gets populated in the constructor of the globs.
-GlobBase * globs[NUM_GLOBS];
+// Array of metadata indexed by ID.  Built from the same list so it's a constant table instead
+// of something every glob constructor has to fill in at boot.
+#undef GLOB
+#undef GLOB_SEQLOCK
+#define GLOB(var_name, struct_type, id, num_instances, owner_task) &var_name,
+#define GLOB_SEQLOCK(var_name, struct_type, id, num_instances, owner_task) &var_name,
+GlobBase * const globs[NUM_GLOBS] =
+{
+#include "glob_list.h"
+};
+
+// Publish tracking shared by all globs.  See GlobSnapshot.
+std::atomic<uint32_t> GlobBase::publish_generation_(0);
+std::atomic<uint32_t> GlobBase::publishes_in_progress_(0);
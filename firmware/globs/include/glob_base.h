@@ -2,79 +2,164 @@
 #define GLOB_BASE_H_INCLUDED
 
 // Includes
-#include <cstring>
+#include <atomic>
+#include <cstdint>
 #include "scheduler.h"
 
+// Arbitrary limit on how many tasks can subscribe to a single glob.
+const uint8_t MAX_GLOB_SUBSCRIBERS = 4;
+
 // Give common meta data and functionality to all globs.
 class GlobBase
 {
   public: // methods
 
-    // Constructor - see field descriptions
-    GlobBase(uint8_t id, uint8_t num_bytes, uint16_t num_instances, void *data):
+    // Constructor - see field descriptions.  Constexpr so globs are initialized at compile time
+    // (copied from flash with the rest of .data) instead of running constructors at boot.
+    constexpr GlobBase(uint8_t id, uint16_t num_bytes, uint16_t num_instances):
       id_(id),
       num_bytes_(num_bytes),
       num_instances_(num_instances),
-      data_ptr_(data),
-      time_stamp_(0)
-    {}
+      send_size_(num_bytes),
+      subscribers_{},
+      num_subscribers_(0)
+    {
+    }
 
     // Accessors
     uint8_t get_id(void) const { return id_; }
     uint16_t get_num_instances(void) const { return num_instances_; }
-    uint8_t get_num_bytes(void) const { return num_bytes_; }
-    const void * get_data_pointer(void) const { return data_ptr_; }
+    uint16_t get_num_bytes(void) const { return num_bytes_; }
 
-    // Return time the glob was last updated.  Atomic.
-    double get_timestamp(void) const
+    // Return how many bytes from the start of each instance are sent over the link.  All of them unless
+    // the owner set it smaller because the rest isn't used (e.g. capture data with only a few channels).
+    uint16_t get_send_size(void) const { return send_size_; }
+    void set_send_size(uint16_t send_size)
     {
-        double current_timestamp;
-        bool enabled = scheduler.disableInterrupts();
-        current_timestamp = time_stamp_;
-        scheduler.restoreInterrupts(enabled);
-        return current_timestamp;
+        send_size_ = ((send_size == 0) || (send_size > num_bytes_)) ? num_bytes_ : send_size;
     }
 
-    // Copy 'instance' data directly to buffer.  Re-entrant.
-    // Return false on failure.
-    bool copy_to_buffer(void * buffer, uint16_t instance) const
-    {
-        if ((instance == 0) || (instance > num_instances_)) { return false; }
+    // Copy 'instance' data directly to buffer.  Re-entrant. If 'tick_stamp' isn't null then
+    // it's set to when the copied data was published.  Return false on failure.
+    virtual bool copy_to_buffer(void * buffer, uint16_t instance, uint64_t * tick_stamp = NULL) const = 0;
 
-        // Need to subtract one from instance number since it's indexed off 1.
-        uint32_t instance_offset = ((uint32_t)(instance-1)) * num_bytes_;
+    // Same as copy_to_buffer() but only copies the first 'num_bytes' (e.g. get_send_size()) and splits them
+    // between two buffers when they don't all fit in 'first_size' bytes of 'first' (e.g. space in a ring
+    // buffer that wraps).  Re-entrant.
+    virtual bool copy_to_split_buffer(void * first, uint16_t first_size, void * second, uint16_t instance,
+                                      uint16_t num_bytes) const = 0;
+
+    // Same as copy_to_buffer() but doesn't disable interrupts, so the copy can be torn if a publish
+    // interrupts it.  Only for callers that detect that themselves (see GlobSnapshot).
+    virtual bool copy_to_buffer_unlocked(void * buffer, uint16_t instance, uint64_t * tick_stamp) const = 0;
+
+    // Return system ticks (see scheduler.currentTicks()) when 'instance' was last published.
+    // Zero if it's never been published or the instance is invalid.  Atomic.
+    virtual uint64_t get_tick_stamp(uint16_t instance=1) const = 0;
+
+    // Return time in seconds when 'instance' was last published.  Only converts
+    // to seconds when called, so avoid in code that runs often.
+    double get_timestamp(uint16_t instance=1) const
+    {
+        return sys_timer.ticksToSeconds(get_tick_stamp(instance));
+    }
 
-        uint32_t instance_ptr = (uint32_t)data_ptr_ + instance_offset;
+    // Return how many ticks ago 'instance' was published, relative to the scheduler's current
+    // tick snapshot.  Zero if it was published after the snapshot was taken (e.g. by a preemptive task).
+    uint64_t age_ticks(uint16_t instance=1) const
+    {
+        uint64_t current_ticks = scheduler.currentTicks();
+        uint64_t tick_stamp = get_tick_stamp(instance);
+        return (tick_stamp < current_ticks) ? (current_ticks - tick_stamp) : 0;
+    }
 
-        // Accessing non-atomic data so need to disable interrupts.
-        bool enabled = scheduler.disableInterrupts();
-        memcpy(buffer, (void const *)instance_ptr, num_bytes_);
-        scheduler.restoreInterrupts(enabled);
+    // Return true if 'instance' has been published and is less than 'max_age_ticks' old.
+    bool is_fresher_than(uint64_t max_age_ticks, uint16_t instance=1) const
+    {
+        uint64_t current_ticks = scheduler.currentTicks();
+        uint64_t tick_stamp = get_tick_stamp(instance);
+        if (tick_stamp == 0) { return false; }
+        return (tick_stamp >= current_ticks) || ((current_ticks - tick_stamp) < max_age_ticks);
+    }
 
+    // Have 'task' notified (see Scheduler::notifyTask()) every time any instance is published so it
+    // can run on new data instead of polling.  Should be called from the task's initialize().
+    // Return false if there are already too many subscribers.
+    bool subscribe(Scheduler::Task & task)
+    {
+        if (num_subscribers_ >= MAX_GLOB_SUBSCRIBERS) { return false; }
+        subscribers_[num_subscribers_++] = &task;
         return true;
     }
 
+    // Publish several globs so that no preemptive task (or GlobSnapshot read from one) can see only
+    // some of them updated.  Call before the first publish and pass the returned state to
+    // end_group_publish() after the last one.  Normal tasks can't interrupt each other so don't need it.
+    static uint32_t begin_group_publish(void)
+    {
+        return scheduler.disablePreemptiveTasks();
+    }
+    static void end_group_publish(uint32_t previous_state)
+    {
+        scheduler.restorePreemptiveTasks(previous_state);
+    }
+
+    // Return number of publishes (to any glob) that have finished and how many are in progress.
+    static uint32_t publish_generation(void) { return publish_generation_.load(std::memory_order_acquire); }
+    static uint32_t publishes_in_progress(void) { return publishes_in_progress_.load(std::memory_order_acquire); }
+
+  protected: // methods
+
+    // Must surround every write to glob storage so GlobSnapshot can tell if a publish interrupted it.
+    static void publish_started(void)
+    {
+        publishes_in_progress_.fetch_add(1, std::memory_order_acq_rel);
+    }
+    static void publish_finished(void)
+    {
+        publish_generation_.fetch_add(1, std::memory_order_acq_rel);
+        publishes_in_progress_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    // Tell subscribed tasks there's new data.  Called after every publish.
+    void notify_subscribers(void) const
+    {
+        for (uint8_t i = 0; i < num_subscribers_; ++i)
+        {
+            scheduler.notifyTask(*subscribers_[i]);
+        }
+    }
+
   protected: // fields
 
     // Unique ID (ie 0, 1, 2, etc)
     const uint8_t id_;
 
     // Total number of bytes glob data takes up (so doesn't include base data)
-    const uint8_t num_bytes_;
+    const uint16_t num_bytes_;
 
     // How many instances of the underlying data type is stored in the glob.
     const uint16_t num_instances_;
 
-    // Pointer to first instance.
-    const void * data_ptr_;
+    // Bytes from the start of each instance that are sent. See get_send_size().
+    uint16_t send_size_;
+
+    // Tasks to notify when glob is published.
+    Scheduler::Task * subscribers_[MAX_GLOB_SUBSCRIBERS];
+    uint8_t num_subscribers_;
+
+  private: // fields
+
+    // Incremented after every publish to any glob. Defined in globs.cpp
+    static std::atomic<uint32_t> publish_generation_;
 
-    // Time that the glob data was last updated.
-    double time_stamp_;
+    // Number of publishes that have started but not finished (i.e. interrupted by the caller).
+    static std::atomic<uint32_t> publishes_in_progress_;
 
 };
 
-// Externed here so template can use it to add new globs in the constructor.
-// Defined in globs.cpp
-extern GlobBase * globs[];
+// All globs indexed by ID. Const so it's built at compile time and stays in flash.
+// Defined in globs.cpp from glob_list.h
+extern GlobBase * const globs[];
 
 #endif
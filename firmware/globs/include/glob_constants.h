@@ -13,6 +13,124 @@ enum
     ROBOT_COMMAND_TIME_TASKS,
 };
 
+//******************************************************************************
+typedef uint8_t glo_link_framing_t;
+enum
+{
+    LINK_FRAMING_START_BYTE, // Frames begin with a 0xFE start byte.
+    LINK_FRAMING_COBS,       // Frames are COBS encoded and end with a zero byte.
+
+    NUM_LINK_FRAMINGS
+};
+
+//******************************************************************************
+// Classes of telemetry the send task queues separately, highest priority first.
+typedef uint8_t telemetry_class_t;
+enum
+{
+    TELEMETRY_CLASS_CRITICAL, // Assert messages and link mode replies.
+    TELEMETRY_CLASS_CONTROL,  // Status and other globs the GUI is waiting on.
+    TELEMETRY_CLASS_BULK,     // Capture dumps, debug messages, task timing and other multi-instance requests.
+
+    NUM_TELEMETRY_CLASSES
+};
+
+//******************************************************************************
+// State of a reliable bulk transfer. See GloBulkTransfer.
+typedef uint8_t glo_bulk_state_t;
+enum
+{
+    BULK_STATE_IDLE,    // Not sending anything.
+    BULK_STATE_SENDING, // Sending and waiting for acknowledgements.
+    BULK_STATE_DONE,    // Receiver acknowledged every instance.
+    BULK_STATE_FAILED,  // Gave up after too many timeouts without an acknowledgement.
+};
+
+//******************************************************************************
+// What happened to a stream subscription. See TelemetryStreamTask.
+typedef uint8_t glo_stream_status_t;
+enum
+{
+    STREAM_STATUS_OFF,          // Not streaming (cancelled or never subscribed).
+    STREAM_STATUS_ACTIVE,       // Streaming as close to the requested rate as the stream task can.
+    STREAM_STATUS_RATE_LIMITED, // Streaming slower than requested to stay under the bandwidth limit.
+    STREAM_STATUS_REJECTED,     // Invalid glob or instances, or no bandwidth left.
+};
+
+//******************************************************************************
+enum
+{
+    STREAM_MAX_SUBSCRIPTIONS = 8
+};
+
+//******************************************************************************
+// Whether a capture channel list was accepted. See glo_capture_channels_t.
+typedef uint8_t glo_capture_channels_status_t;
+enum
+{
+    CAPTURE_CHANNELS_OK,        // Channels are being captured.
+    CAPTURE_CHANNELS_BAD_FIELD, // Glob, instance, offset or type doesn't match a field in the glob registry.
+    CAPTURE_CHANNELS_TOO_BIG,   // Too many channels, too many bytes or too many other globs to read.
+    CAPTURE_CHANNELS_BUSY,      // Can't change channels while capturing.
+    CAPTURE_CHANNELS_BAD_FORMAT, // Unknown format, or a quantized one with a scale that's zero or not a number.
+};
+
+//******************************************************************************
+// How capture samples are packed into capture data instances. See glo_capture_channels_t and CaptureEncoder.
+typedef uint8_t glo_capture_format_t;
+enum
+{
+    CAPTURE_FORMAT_RAW,         // One sample per instance with each channel's own bytes.
+    CAPTURE_FORMAT_INT16,       // Several samples per instance with every channel quantized to int16.
+    CAPTURE_FORMAT_INT16_DELTA, // Same as int16 but after the first sample in an instance only the int8
+                                // change from the sample before is kept (so fast steps take a few samples).
+    NUM_CAPTURE_FORMATS
+};
+
+//******************************************************************************
+// What starts a triggered capture. See glo_capture_trigger_t.
+typedef uint8_t glo_trigger_source_t;
+enum
+{
+    TRIGGER_SOURCE_NONE,        // Start capturing right away like an untriggered capture.
+    TRIGGER_SOURCE_CHANNEL,     // A capture channel crosses the trigger level.
+    TRIGGER_SOURCE_GLOB_CHANGE, // Data in a glob instance changes.
+    TRIGGER_SOURCE_ASSERT,      // Any assert fails.
+
+    NUM_TRIGGER_SOURCES
+};
+
+//******************************************************************************
+// Which way a channel has to cross the trigger level.
+typedef uint8_t glo_trigger_edge_t;
+enum
+{
+    TRIGGER_EDGE_RISING,
+    TRIGGER_EDGE_FALLING,
+    TRIGGER_EDGE_EITHER,
+
+    NUM_TRIGGER_EDGES
+};
+
+//******************************************************************************
+// Where a triggered capture is at.
+typedef uint8_t glo_trigger_state_t;
+enum
+{
+    TRIGGER_STATE_IDLE,      // Not capturing, or capturing without a trigger.
+    TRIGGER_STATE_ARMED,     // Keeping history and waiting for the trigger.
+    TRIGGER_STATE_TRIGGERED, // Capturing the samples after the trigger.
+    TRIGGER_STATE_DONE,      // Samples from around the trigger have been sent.
+    TRIGGER_STATE_REJECTED,  // Settings were invalid so they weren't used.
+};
+
+//******************************************************************************
+enum
+{
+    CAPTURE_MAX_CHANNELS = 16,      // Most channels in a capture sample.
+    CAPTURE_MAX_CHANNEL_BYTES = 32, // Most bytes of every channel together (not counting the time).
+};
+
 //******************************************************************************
 typedef uint8_t glo_operating_state_t;
 enum
@@ -0,0 +1,100 @@
+#ifndef GLOB_GATHER_H_INCLUDED
+#define GLOB_GATHER_H_INCLUDED
+
+// Includes
+#include "glob_snapshot.h"
+#include "globs.h"
+
+// Most globs a gather can be given copies of. See addLocal().
+const uint8_t MAX_GATHER_LOCALS = 12;
+
+// Bytes for the copies of globs a gather reads itself (the ones it wasn't given copies of).
+const uint16_t GATHER_SOURCE_BYTES = 256;
+
+// Packs chosen fields of chosen glob instances back to back, e.g. the channels of a data capture (see
+// glo_capture_channels_t).  The channel list is checked against the glob registry and compiled into a
+// flat table of where each field is and how many bytes it is, so gathering a sample is a short copy loop.
+// Fields of globs the caller already keeps copies of (see addLocal()) are copied straight from those.
+// The rest of the globs are read together into a source buffer by read().
+class GlobGather
+{
+  public: // methods
+
+    // Constructor. No channels until compile() is called.
+    GlobGather(void);
+
+    // Copy fields of glob 'id' instance 'instance' from 'data' instead of reading the glob.  The caller
+    // has to keep 'data' up to date.  Return false if there are too many.
+    bool addLocal(glob_id_t id, void const * data, uint16_t instance=1);
+
+    // Replace the channels with the first 'channels.num_channels'.  Return CAPTURE_CHANNELS_OK or why they
+    // were rejected, in which case the old channels are kept and 'bad_channel' is set to the first one that
+    // was rejected.  Don't call while another task could be in the middle of read() or gather().
+    glo_capture_channels_status_t compile(glo_capture_channels_t const & channels, uint8_t * bad_channel);
+
+    // Read the globs that aren't copied from local data.  Call once before each gather().
+    void read(void);
+
+    // Copy every channel into 'sample' back to back. Return how many bytes that is (see sampleBytes()).
+    uint16_t gather(uint8_t * sample) const;
+
+    // Same as gather() but with 'values' (one per channel, e.g. filtered ones) converted to the type of each
+    // channel, rounded to the nearest and clamped for integers.
+    uint16_t pack(float const * values, uint8_t * sample) const;
+
+    // Return bytes of every channel together.
+    uint16_t sampleBytes(void) const { return sample_bytes_; }
+
+    // Return how many channels there are.
+    uint8_t numChannels(void) const { return num_entries_; }
+
+    // Return the current value of 'channel' (from the last read() for globs without local copies), or
+    // zero if there's no such channel.
+    float value(uint8_t channel) const;
+
+  private: // types
+
+    // Where a glob instance's data is copied from.
+    struct local_t
+    {
+        void const * data;
+        uint16_t instance;
+        glob_id_t id;
+    };
+
+    // One channel in the gather table.
+    struct entry_t
+    {
+        uint8_t const * source;
+        uint8_t size;
+        uint8_t type; // glob_field_type_t
+    };
+
+  private: // methods
+
+    // Return the local copy of glob 'id' instance 'instance' or null if there isn't one.
+    void const * findLocal(glob_id_t id, uint16_t instance) const;
+
+    // Return true if 'offset' is the start of an element of a 'type' field of glob 'id'.
+    static bool isField(glob_id_t id, uint16_t offset, uint8_t type);
+
+  private: // fields
+
+    // Globs the caller keeps copies of.
+    local_t locals_[MAX_GATHER_LOCALS];
+    uint8_t num_locals_;
+
+    // Reads the rest of the globs into the source buffer.  Word aligned so fields can be copied from it.
+    GlobSnapshot sources_;
+    uint32_t source_buffer_[GATHER_SOURCE_BYTES / 4];
+
+    // Gather table in channel order.
+    entry_t entries_[CAPTURE_MAX_CHANNELS];
+    uint8_t num_entries_;
+
+    // Bytes of every channel together.
+    uint16_t sample_bytes_;
+
+};
+
+#endif
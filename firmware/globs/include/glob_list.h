@@ -0,0 +1,43 @@
+// List of every glob.  Included (possibly several times) after defining GLOB and GLOB_SEQLOCK to
+// expand each entry into what's needed, e.g. declarations in globs.h and the definitions, 'globs' table
+// and registry (see glob_registry.h) in .cpp files.  So there's no include guard on purpose.
+// Entries must be in ID order since the 'globs' table is indexed by ID.
+//
+// To define new objects you must add the ID to globs.h, the struct to glob_types.h and its
+// field descriptors to glob_registry.cpp.
+
+// Macro use:
+// Argument 1: Glob variable name
+// Argument 2: Name of struct (defined in glob_types.h)
+// Argument 3: ID (must be unique, see enumeration in globs.h)
+// Argument 4: How many instances of struct to hold (usually just one)
+// Argument 5: The owner task allowed to publish the object
+GLOB_SEQLOCK(glo_assert_message,  glo_assert_message_t,      GLO_ID_ASSERT_MESSAGE,       3,    TelemetrySendTask)
+GLOB_SEQLOCK(glo_debug_message,   glo_debug_message_t,       GLO_ID_DEBUG_MESSAGE,        5,    TelemetrySendTask)
+GLOB(glo_capture_data,            glo_capture_data_t,        GLO_ID_CAPTURE_DATA,         2001, MainControlTask) // 192K available RAM. This uses ~70K. Add 1 since instance 0 isn't used. Used as a ring buffer (see CaptureRing).
+GLOB(glo_driving_command,         glo_driving_command_t,     GLO_ID_DRIVING_COMMAND,      1,    TelemetryReceiveTask)
+GLOB(glo_capture_command,         glo_capture_command_t,     GLO_ID_CAPTURE_COMMAND,      1,    MainControlTask)
+GLOB_SEQLOCK(glo_status_data,     glo_status_data_t,         GLO_ID_STATUS_DATA,          1,    StatusUpdateTask)
+GLOB(glo_motion_commands,         glo_motion_commands_t,     GLO_ID_MOTION_COMMANDS,      1,    TelemetryReceiveTask)
+GLOB_SEQLOCK(glo_raw_imu,         glo_raw_imu_t,             GLO_ID_RAW_IMU,              1,    ComplementaryFilterTask)
+GLOB_SEQLOCK(glo_analog,          glo_analog_t,              GLO_ID_ANALOG,               1,    MainControlTask)
+GLOB_SEQLOCK(glo_imu,             glo_imu_t,                 GLO_ID_IMU,                  1,    ComplementaryFilterTask)
+GLOB_SEQLOCK(glo_roll_pitch_yaw,  glo_roll_pitch_yaw_t,      GLO_ID_ROLL_PITCH_YAW,       1,    ComplementaryFilterTask)
+GLOB_SEQLOCK(glo_quaternion,      glo_quaternion_t,          GLO_ID_QUATERNION,           1,    ComplementaryFilterTask)
+GLOB(glo_theta_zero,              glo_theta_zero_t,          GLO_ID_THETA_ZERO,           1,    MainControlTask)
+GLOB_SEQLOCK(glo_odometry,        glo_odometry_t,            GLO_ID_ODOMETRY,             1,    MainControlTask)
+GLOB(glo_modes,                   glo_modes_t,               GLO_ID_MODES,                1,    ModesTask)
+GLOB(glo_robot_command,           glo_robot_command_t,       GLO_ID_ROBOT_COMMAND,        1,    ModesTask)
+GLOB_SEQLOCK(glo_motor_pwm,       glo_motor_pwm_t,           GLO_ID_MOTOR_PWM,            1,    MainControlTask)
+GLOB(glo_wave,                    glo_wave_t,                GLO_ID_WAVE,                 1,    MainControlTask)
+GLOB(glo_pid_params,              glo_pid_params_t,          GLO_ID_PID_PARAMS,           NUM_PID_CONTROLLERS,  TelemetryReceiveTask)
+GLOB(glo_request,                 glo_request_t,             GLO_ID_REQUEST,              1,    TelemetryReceiveTask)
+GLOB(glo_task_timing,             glo_task_timing_t,         GLO_ID_TASK_TIMING,          1,    TelemetrySendTask)
+GLOB(glo_link_mode,               glo_link_mode_t,           GLO_ID_LINK_MODE,            1,    TelemetryReceiveTask)
+GLOB(glo_telemetry_stats,         glo_telemetry_stats_t,     GLO_ID_TELEMETRY_STATS,      1,    TelemetrySendTask)
+GLOB(glo_bulk_transfer,           glo_bulk_transfer_t,       GLO_ID_BULK_TRANSFER,        1,    TelemetrySendTask)
+GLOB(glo_bulk_ack,                glo_bulk_ack_t,            GLO_ID_BULK_ACK,             1,    TelemetryReceiveTask)
+GLOB(glo_stream_subscription,     glo_stream_subscription_t, GLO_ID_STREAM_SUBSCRIPTION,  STREAM_MAX_SUBSCRIPTIONS,  TelemetryStreamTask)
+GLOB(glo_capture_status,          glo_capture_status_t,      GLO_ID_CAPTURE_STATUS,       1,    TelemetryStreamTask)
+GLOB(glo_capture_channels,        glo_capture_channels_t,    GLO_ID_CAPTURE_CHANNELS,     1,    MainControlTask)
+GLOB(glo_capture_trigger,         glo_capture_trigger_t,     GLO_ID_CAPTURE_TRIGGER,      1,    MainControlTask)
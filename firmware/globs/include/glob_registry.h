@@ -0,0 +1,99 @@
+#ifndef GLOB_REGISTRY_H_INCLUDED
+#define GLOB_REGISTRY_H_INCLUDED
+
+// Includes
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "globs.h"
+
+// Compile time description of every glob and the layout of its struct.  It's all constant so
+// it lives in flash and costs nothing at boot.  Generated from glob_list.h so it can't drift from
+// the actual globs, and the field descriptors are checked against each struct when compiling.
+// The host schema tool (host/tools/glob_schema.cpp) writes it out as JSON so decoders on the PC
+// side can parse any glob without having a hand written copy of its layout.
+
+// Type of a single field element.  Values are part of the schema so only add to the end.
+typedef uint8_t glob_field_type_t;
+enum
+{
+    GLOB_FIELD_UINT8,
+    GLOB_FIELD_UINT16,
+    GLOB_FIELD_UINT32,
+    GLOB_FIELD_INT32,
+    GLOB_FIELD_FLOAT,
+    GLOB_FIELD_CHAR, // text
+
+    NUM_GLOB_FIELD_TYPES,
+};
+
+// How the glob keeps its instances consistent.  See glob_storage.h
+typedef uint8_t glob_storage_type_t;
+enum
+{
+    GLOB_STORAGE_LOCKED,
+    GLOB_STORAGE_SEQLOCK,
+};
+
+// One field (or array of fields) in a glob struct.
+typedef struct
+{
+    char const * name;
+    glob_field_type_t type;
+    uint16_t offset; // bytes from start of struct
+    uint16_t count;  // number of elements, 1 if not an array
+
+} glob_field_t;
+
+// Everything known about a glob at compile time.
+typedef struct
+{
+    glob_id_t id;
+    char const * name;      // glob variable (e.g. glo_imu)
+    char const * type_name; // glob struct (e.g. glo_imu_t)
+    char const * owner;     // task allowed to publish
+    uint16_t num_bytes;     // size of one instance
+    uint16_t num_instances;
+    glob_storage_type_t storage;
+    glob_field_t const * fields;
+    uint8_t num_fields;
+
+} glob_info_t;
+
+// Map a C++ type to the field type enum.  Only types that have a specialization can be used in globs.
+template <typename T> struct glob_field_type_of;
+template <> struct glob_field_type_of<uint8_t>  { static const glob_field_type_t value = GLOB_FIELD_UINT8; };
+template <> struct glob_field_type_of<uint16_t> { static const glob_field_type_t value = GLOB_FIELD_UINT16; };
+template <> struct glob_field_type_of<uint32_t> { static const glob_field_type_t value = GLOB_FIELD_UINT32; };
+template <> struct glob_field_type_of<int32_t>  { static const glob_field_type_t value = GLOB_FIELD_INT32; };
+template <> struct glob_field_type_of<float>    { static const glob_field_type_t value = GLOB_FIELD_FLOAT; };
+template <> struct glob_field_type_of<char>     { static const glob_field_type_t value = GLOB_FIELD_CHAR; };
+
+// Return size in bytes of one element of the field type.
+constexpr uint16_t glob_field_type_size(glob_field_type_t type)
+{
+    return (type == GLOB_FIELD_UINT8 || type == GLOB_FIELD_CHAR) ? 1 :
+           (type == GLOB_FIELD_UINT16) ? 2 : 4;
+}
+
+// Return name of the field type used in the schema (e.g. "float").
+char const * glob_field_type_name(glob_field_type_t type);
+
+// Describe 'field' of 'struct_type'. Type, offset and array count are all deduced from the struct.
+#define GLOB_FIELD_ELEMENT(struct_type, field) \
+    std::remove_extent<decltype(((struct_type *)0)->field)>::type
+#define GLOB_FIELD(struct_type, field) \
+    { #field, glob_field_type_of<GLOB_FIELD_ELEMENT(struct_type, field)>::value, offsetof(struct_type, field), \
+      sizeof(((struct_type *)0)->field) / sizeof(GLOB_FIELD_ELEMENT(struct_type, field)) }
+
+// Describe a glob that's a single value instead of a struct (e.g. glo_robot_command_t).
+#define GLOB_VALUE(value_type) \
+    { "value", glob_field_type_of<value_type>::value, 0, 1 }
+
+// Start the field descriptor table for 'struct_type'. See glob_registry.cpp
+#define GLOB_FIELDS(struct_type) constexpr glob_field_t struct_type##_fields[]
+
+// Registry indexed by glob ID. Defined in glob_registry.cpp
+extern const glob_info_t glob_registry[NUM_GLOBS];
+
+#endif
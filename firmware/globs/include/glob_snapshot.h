@@ -0,0 +1,93 @@
+#ifndef GLOB_SNAPSHOT_H_INCLUDED
+#define GLOB_SNAPSHOT_H_INCLUDED
+
+// Includes
+#include "glob_template.h"
+
+// Arbitrary limit on how many globs can be read together.
+const uint8_t MAX_SNAPSHOT_GLOBS = 8;
+
+// How many times a snapshot read will start over before reading each glob atomically instead.
+const uint8_t MAX_SNAPSHOT_ATTEMPTS = 3;
+
+// Reads a declared group of globs together so a task sees them all from the same point in time
+// (e.g. IMU and attitude from the same filter step) instead of reading them one at a time.
+//
+// Rather than disabling interrupts for every glob, all members are copied in one pass and then
+// a single check is made that no glob was published during the pass.  If one was then the pass
+// is repeated. This relies on the scheduler's priorities: anything that interrupts the reader runs
+// to completion before the reader continues, so a publish can't still be going when the check passes.
+// If the reader itself interrupted a publish (e.g. from the preemptive tier) it can't wait for it
+// to finish, so each glob is read atomically instead. Writers that need several globs to be seen
+// together by preemptive tasks should use GlobBase::begin_group_publish().
+class GlobSnapshot
+{
+  public: // methods
+
+    // Constructor
+    GlobSnapshot(void);
+
+    // Add glob 'instance' to the group. It will be copied into 'destination' every read().
+    // Return false if the group is full.
+    template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+    bool add(GlobTemplate<object_type, num_instances, OwnerTask, StorageType> & glob,
+             object_type * destination, uint16_t instance=1)
+    {
+        return addMember(&glob, (void *)destination, instance);
+    }
+
+    // Same as above for a glob that's only known at run time (e.g. by ID).  'destination' has to hold
+    // get_num_bytes() of the glob.
+    bool add(GlobBase & glob, void * destination, uint16_t instance=1)
+    {
+        return addMember(&glob, destination, instance);
+    }
+
+    // Remove every glob from the group.
+    void clear(void) { num_members_ = 0; }
+
+    // Copy every glob in the group to its destination. Return the most recent tick stamp of
+    // the group, i.e. when the newest member was published.
+    uint64_t read(void);
+
+    // Return the tick stamp found by the last read().
+    uint64_t tickStamp(void) const { return tick_stamp_; }
+
+    // Return number of times a read had to start over or fall back to atomic reads.  Diagnostic only.
+    uint32_t numRetries(void) const { return num_retries_; }
+    uint32_t numFallbacks(void) const { return num_fallbacks_; }
+
+  private: // methods
+
+    // Add member to group. Return false if full or glob is invalid.
+    bool addMember(GlobBase * glob, void * destination, uint16_t instance);
+
+    // Copy every member using copy_to_buffer() so each is atomic on its own.
+    void readEachAtomically(void);
+
+  private: // types
+
+    // A glob instance that's read as part of the group.
+    struct member_t
+    {
+        GlobBase * glob;
+        void * destination;
+        uint16_t instance;
+    };
+
+  private: // fields
+
+    // Globs in the group.
+    member_t members_[MAX_SNAPSHOT_GLOBS];
+    uint8_t num_members_;
+
+    // Newest tick stamp of the group from the last read.
+    uint64_t tick_stamp_;
+
+    // Diagnostic counters. See accessors.
+    uint32_t num_retries_;
+    uint32_t num_fallbacks_;
+
+};
+
+#endif
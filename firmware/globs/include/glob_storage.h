@@ -0,0 +1,237 @@
+#ifndef GLOB_STORAGE_H_INCLUDED
+#define GLOB_STORAGE_H_INCLUDED
+
+// Includes
+#include <atomic>
+#include <cstring>
+#include "scheduler.h"
+
+// Storage policies that decide how a GlobTemplate keeps its instances consistent when
+// they're published and read from different tasks/interrupts.  Each policy provides:
+//    write(instance_index, data, tick_stamp)
+//    read(instance_index, copy, &tick_stamp)
+//    readUnlocked(instance_index, copy, &tick_stamp)
+//    readSplit(instance_index, first, first_size, second, size, &tick_stamp)
+//    readTickStamp(instance_index)
+// where instance_index is zero based and already validated by the glob.  Tick stamps are
+// system ticks (see SystemTimer) so publishing doesn't need any (software) double math.
+
+// Copy 'size' bytes from 'source' to 'first', or if 'first_size' is smaller than that then the
+// rest goes to 'second'.  Lets globs be copied straight into ring buffers that wrap.
+inline void glob_copy_split(void * first, uint16_t first_size, void * second, void const * source, uint16_t size)
+{
+    if (first_size >= size)
+    {
+        memcpy(first, source, size);
+        return;
+    }
+    memcpy(first, source, first_size);
+    memcpy(second, (uint8_t const *)source + first_size, size - first_size);
+}
+
+// Default storage. Every write and read disables interrupts around the copy.  Cheap for small
+// globs, but for large ones that's a long time that no interrupt (even systick) can run.
+template <typename object_type, uint16_t num_instances>
+class GlobLockedStorage
+{
+  public: // methods
+
+    // Constructor. Zeroes everything at compile time.
+    constexpr GlobLockedStorage(void) :
+      instances_{},
+      tick_stamp_(0)
+    {
+    }
+
+    // Atomically copy 'data' into the instance.
+    void write(uint16_t index, void const * data, uint64_t tick_stamp)
+    {
+        bool enabled = scheduler.disableInterrupts();
+        memcpy((void *)&instances_[index], data, sizeof(object_type));
+        tick_stamp_ = tick_stamp;
+        scheduler.restoreInterrupts(enabled);
+    }
+
+    // Atomically copy the instance into 'copy' and return when it was last written.
+    void read(uint16_t index, void * copy, uint64_t * tick_stamp) const
+    {
+        bool enabled = scheduler.disableInterrupts();
+        memcpy(copy, (void const *)&instances_[index], sizeof(object_type));
+        *tick_stamp = tick_stamp_;
+        scheduler.restoreInterrupts(enabled);
+    }
+
+    // Same as read() but only the first 'size' bytes are copied and split between two buffers.
+    // See glob_copy_split().
+    void readSplit(uint16_t index, void * first, uint16_t first_size, void * second, uint16_t size, uint64_t * tick_stamp) const
+    {
+        bool enabled = scheduler.disableInterrupts();
+        glob_copy_split(first, first_size, second, (void const *)&instances_[index], size);
+        *tick_stamp = tick_stamp_;
+        scheduler.restoreInterrupts(enabled);
+    }
+
+    // Same as read() without disabling interrupts, so the copy is torn if a write interrupts it.
+    void readUnlocked(uint16_t index, void * copy, uint64_t * tick_stamp) const
+    {
+        memcpy(copy, (void const *)&instances_[index], sizeof(object_type));
+        *tick_stamp = tick_stamp_;
+    }
+
+    // Return when the instance was last written. Shared by all instances to save RAM on big globs.
+    uint64_t readTickStamp(uint16_t /*index*/) const
+    {
+        bool enabled = scheduler.disableInterrupts();
+        uint64_t tick_stamp = tick_stamp_;
+        scheduler.restoreInterrupts(enabled);
+        return tick_stamp;
+    }
+
+  private: // fields
+
+    // Glob data array.
+    object_type instances_[num_instances];
+
+    // System ticks when any instance was last written to.
+    uint64_t tick_stamp_;
+
+};
+
+// Sequence counter (seqlock) storage. Nothing ever disables interrupts. Each instance has two
+// slots and the writer always fills the slot readers aren't using, then bumps the sequence to
+// switch readers over to it.  A reader copies the current slot and then checks the sequence again.
+// If the writer started reusing that slot while it was copying (the copy could be torn) it retries.
+//
+// Since the writer never touches the slot that's being read, a reader that interrupts a writer
+// (e.g. the preemptive tier reading a glob a normal task is publishing) gets the previous data
+// on its first try instead of spinning.  A retry only happens if the writer publishes twice while
+// a single copy is in progress. Costs twice the RAM so only use for globs that are large or read
+// from interrupts.  Only one task can publish to an instance, which is already true of all globs.
+template <typename object_type, uint16_t num_instances>
+class GlobSeqlockStorage
+{
+  public: // methods
+
+    // Constructor. Zeroes everything at compile time.
+    constexpr GlobSeqlockStorage(void) :
+      slots_{},
+      sequences_{},
+      num_retries_(0)
+    {
+    }
+
+    // Copy 'data' into the unused slot and then make it current.  Must only be called by the owner task.
+    void write(uint16_t index, void const * data, uint64_t tick_stamp);
+
+    // Copy the current slot into 'copy' and return when it was written.  Safe from any context.
+    void read(uint16_t index, void * copy, uint64_t * tick_stamp) const
+    {
+        readSplit(index, copy, sizeof(object_type), NULL, sizeof(object_type), tick_stamp);
+    }
+
+    // Same as read() but only the first 'size' bytes are copied and split between two buffers.
+    // See glob_copy_split().
+    void readSplit(uint16_t index, void * first, uint16_t first_size, void * second, uint16_t size, uint64_t * tick_stamp) const;
+
+    // Reads never disable interrupts so this is the same as read().
+    void readUnlocked(uint16_t index, void * copy, uint64_t * tick_stamp) const { read(index, copy, tick_stamp); }
+
+    // Return when the current slot was written without copying the data.  Safe from any context.
+    uint64_t readTickStamp(uint16_t index) const;
+
+    // Return how many times a read had to be restarted because of a torn copy.
+    uint32_t numRetries(void) const { return num_retries_.load(std::memory_order_relaxed); }
+
+  private: // types
+
+    struct slot_t
+    {
+        object_type data;
+        uint64_t tick_stamp;
+    };
+
+  private: // fields
+
+    // Two copies of every instance.
+    slot_t slots_[num_instances][2];
+
+    // Incremented once when the writer starts filling a slot and again once it's done, so it's
+    // odd while a write is in progress. Readers use slot (sequence / 2) % 2 which is always complete.
+    std::atomic<uint32_t> sequences_[num_instances];
+
+    // Number of reads that had to try again.  Diagnostic only.
+    mutable std::atomic<uint32_t> num_retries_;
+
+};
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances>
+void GlobSeqlockStorage<object_type, num_instances>::write(uint16_t index, void const * data, uint64_t tick_stamp)
+{
+    // Only the owner writes the sequence so it doesn't need to be synchronized with itself.
+    uint32_t sequence = sequences_[index].load(std::memory_order_relaxed);
+
+    // Mark the write as started before touching the slot so a reader that's still copying it
+    // from the last time it was current will see the sequence move by 2 and retry.
+    sequences_[index].store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    slot_t & slot = slots_[index][((sequence >> 1) + 1) & 1];
+    memcpy((void *)&slot.data, data, sizeof(object_type));
+    slot.tick_stamp = tick_stamp;
+
+    // Release so the slot contents are visible before readers switch to it.
+    sequences_[index].store(sequence + 2, std::memory_order_release);
+}
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances>
+void GlobSeqlockStorage<object_type, num_instances>::readSplit(uint16_t index, void * first, uint16_t first_size,
+                                                               void * second, uint16_t size, uint64_t * tick_stamp) const
+{
+    while (true)
+    {
+        uint32_t sequence = sequences_[index].load(std::memory_order_acquire);
+
+        slot_t const & slot = slots_[index][(sequence >> 1) & 1];
+        glob_copy_split(first, first_size, second, (void const *)&slot.data, size);
+        *tick_stamp = slot.tick_stamp;
+
+        // Make sure the copy is finished before checking if the writer started reusing the slot.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t new_sequence = sequences_[index].load(std::memory_order_relaxed);
+
+        // Moving by 1 means the writer is (or was) only filling the other slot.
+        if ((new_sequence - sequence) < 2)
+        {
+            return;
+        }
+
+        num_retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances>
+uint64_t GlobSeqlockStorage<object_type, num_instances>::readTickStamp(uint16_t index) const
+{
+    while (true)
+    {
+        // Same as read() but only for the stamp, which is 64 bits so can't be read atomically on its own.
+        uint32_t sequence = sequences_[index].load(std::memory_order_acquire);
+
+        uint64_t tick_stamp = slots_[index][(sequence >> 1) & 1].tick_stamp;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t new_sequence = sequences_[index].load(std::memory_order_relaxed);
+
+        if ((new_sequence - sequence) < 2)
+        {
+            return tick_stamp;
+        }
+
+        num_retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#endif
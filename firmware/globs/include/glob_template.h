@@ -3,10 +3,16 @@
 
 // Includes
 #include "glob_base.h"
+#include "glob_storage.h"
+
+// Returned by read() when the request is invalid.
+const uint64_t INVALID_GLOB_TICK_STAMP = UINT64_MAX;
 
 // Define a template class that specializes the generic glob base for different
-// data types and different number of instances of those types.
-template <typename object_type, const uint16_t num_instances, class OwnerTask>
+// data types and different number of instances of those types.  The storage type
+// decides how reads and publishes are kept atomic (see glob_storage.h).
+template <typename object_type, const uint16_t num_instances, class OwnerTask,
+          class StorageType = GlobLockedStorage<object_type, num_instances> >
 class GlobTemplate : public GlobBase
 {
   // Specify an owner which is in charge of publishing new data to the glob.
@@ -14,68 +20,141 @@ class GlobTemplate : public GlobBase
 
   public: // methods
 
-    // Constructor.  Add glob base information to global 'globs' array.
-    GlobTemplate(uint8_t id);
+    // Constructor.  Constexpr so there's no static initialization work at boot.  The storage is
+    // a separate object so it can stay in zeroed RAM (.bss) instead of being copied from flash.
+    constexpr GlobTemplate(uint8_t id, StorageType & storage);
 
     // Perform atomic copy of glob into output 'copy' parameter.  If successful
-    // then return the timestamp of object (i.e. last time it was written to),
-    // otherwise return -1 to signify error.
-    double read(object_type *copy, uint16_t instance=1);
+    // then return the tick stamp of object (i.e. system ticks when it was last written to),
+    // otherwise return INVALID_GLOB_TICK_STAMP to signify error.
+    uint64_t read(object_type *copy, uint16_t instance=1);
+
+    // Copy 'instance' data directly to buffer.  Re-entrant.
+    // Return false on failure.
+    virtual bool copy_to_buffer(void * buffer, uint16_t instance, uint64_t * tick_stamp = NULL) const;
+
+    // Copy into two buffers. See GlobBase.
+    virtual bool copy_to_split_buffer(void * first, uint16_t first_size, void * second, uint16_t instance,
+                                      uint16_t num_bytes) const;
+
+    // Copy without disabling interrupts. See GlobBase.
+    virtual bool copy_to_buffer_unlocked(void * buffer, uint16_t instance, uint64_t * tick_stamp) const;
+
+    // Return system ticks when 'instance' was last published or zero if never (or invalid instance).
+    virtual uint64_t get_tick_stamp(uint16_t instance=1) const;
 
   private: // methods
 
-    // Atomically copy 'data' to the glob instance. Return true if successful.
+    // Atomically copy 'data' to the glob instance and notify subscribers. Return true if successful.
     bool publish(object_type const * data, uint16_t instance=1);
 
-    // Glob data array. Atomic read/writes using template methods.
-    object_type instances_[num_instances];
+    // Same as above but with the tick stamp the data corresponds to (e.g. when a sensor was
+    // sampled) instead of the scheduler's current ticks.
+    bool publish(object_type const * data, uint16_t instance, uint64_t tick_stamp);
+
+  private: // fields
+
+    // Glob data. Atomic read/writes are handled by the storage.
+    StorageType & storage_;
 
 };
 
 //*****************************************************************************
-template <typename object_type, uint16_t num_instances, class OwnerTask>
-GlobTemplate<object_type, num_instances, OwnerTask>::GlobTemplate(uint8_t id) :
-    GlobBase(id, sizeof(object_type), num_instances, (void *)&(instances_))
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+constexpr GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::GlobTemplate(uint8_t id, StorageType & storage) :
+    GlobBase(id, sizeof(object_type), num_instances),
+    storage_(storage)
 {
-    globs[id] = this;
 }
 
 //*****************************************************************************
-template <typename object_type, uint16_t num_instances, class OwnerTask>
-double GlobTemplate<object_type, num_instances, OwnerTask>::read(object_type * copy, uint16_t instance)
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+uint64_t GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::read(object_type * copy, uint16_t instance)
 {
-    double time_stamp = 0.0;
+    uint64_t tick_stamp = 0;
 
     if ((instance == 0) || (instance > num_instances) || (copy == NULL))
     {
-        return -1.0; // invalid read request so return invalid time stamp
+        return INVALID_GLOB_TICK_STAMP; // invalid read request so return invalid tick stamp
     }
 
-    bool enabled = scheduler.disableInterrupts();
+    storage_.read(instance-1, (void *)copy, &tick_stamp);
+
+    return tick_stamp;
+}
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+bool GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::copy_to_buffer(void * buffer, uint16_t instance, uint64_t * tick_stamp) const
+{
+    uint64_t read_tick_stamp = 0;
+
+    if ((instance == 0) || (instance > num_instances) || (buffer == NULL)) { return false; }
+
+    // Need to subtract one from instance number since it's indexed off 1.
+    storage_.read(instance-1, buffer, &read_tick_stamp);
+
+    if (tick_stamp != NULL) { *tick_stamp = read_tick_stamp; }
+
+    return true;
+}
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+bool GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::copy_to_split_buffer(void * first, uint16_t first_size, void * second, uint16_t instance,
+                                                                                          uint16_t num_bytes) const
+{
+    uint64_t read_tick_stamp = 0;
+
+    if ((instance == 0) || (instance > num_instances) || (first == NULL)) { return false; }
+    if ((num_bytes > sizeof(object_type)) || ((first_size < num_bytes) && (second == NULL))) { return false; }
+
+    storage_.readSplit(instance-1, first, first_size, second, num_bytes, &read_tick_stamp);
+
+    return true;
+}
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+bool GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::copy_to_buffer_unlocked(void * buffer, uint16_t instance, uint64_t * tick_stamp) const
+{
+    if ((instance == 0) || (instance > num_instances) || (buffer == NULL) || (tick_stamp == NULL)) { return false; }
 
-    memcpy((void *)copy, (void const *)&(instances_[instance-1]), num_bytes_);
-    time_stamp = time_stamp_;
+    storage_.readUnlocked(instance-1, buffer, tick_stamp);
 
-    scheduler.restoreInterrupts(enabled);
+    return true;
+}
 
-    return time_stamp;
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+uint64_t GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::get_tick_stamp(uint16_t instance) const
+{
+    if ((instance == 0) || (instance > num_instances)) { return 0; }
+
+    return storage_.readTickStamp(instance-1);
 }
 
 //*****************************************************************************
-template <typename object_type, uint16_t num_instances, class OwnerTask>
-bool GlobTemplate<object_type, num_instances, OwnerTask>::publish(object_type const * new_data, uint16_t instance)
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+bool GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::publish(object_type const * new_data, uint16_t instance)
+{
+    return publish(new_data, instance, scheduler.currentTicks());
+}
+
+//*****************************************************************************
+template <typename object_type, uint16_t num_instances, class OwnerTask, class StorageType>
+bool GlobTemplate<object_type, num_instances, OwnerTask, StorageType>::publish(object_type const * new_data, uint16_t instance, uint64_t tick_stamp)
 {
     if ((instance == 0) || (instance > num_instances) || (new_data == NULL))
     {
         return false; // invalid instance number or bad data
     }
 
-    bool enabled = scheduler.disableInterrupts();
-
-    memcpy((void *)(instances_ + (instance-1)), (void const *)new_data, num_bytes_);
-    time_stamp_ = sys_timer.seconds();
+    publish_started();
+    storage_.write(instance-1, (void const *)new_data, tick_stamp);
+    publish_finished();
 
-    scheduler.restoreInterrupts(enabled);
+    notify_subscribers();
 
     return true; // successfully published
 }
@@ -0,0 +1,71 @@
+#ifndef GLOB_TRIGGER_H_INCLUDED
+#define GLOB_TRIGGER_H_INCLUDED
+
+// Includes
+#include "glob_gather.h"
+#include "globs.h"
+
+// Biggest glob a trigger can watch for changes, since it keeps two copies of it.
+const uint16_t TRIGGER_MAX_GLOB_BYTES = 128;
+
+// Decides when a triggered data capture starts (see glo_capture_trigger_t).  Checked once per capture
+// sample, so a channel crossing the level is seen between two samples and a glob change is any change
+// between the reads at two samples.  Nothing before the first sample after arm() can trigger it.
+class GlobTrigger
+{
+  public: // methods
+
+    // Constructor. Not armed.
+    GlobTrigger(void);
+
+    // Return true if 'settings' can be used with the capture channels in 'gather'.
+    static bool isValid(glo_capture_trigger_t const & settings, GlobGather const & gather);
+
+    // Start looking for what's in 'settings', which have to be valid.  'num_asserts' is how many asserts
+    // there have been so far.
+    void arm(glo_capture_trigger_t const & settings, uint32_t num_asserts);
+
+    // Stop looking for the trigger.
+    void disarm(void) { armed_ = false; }
+
+    // Call after each sample with the 'values' of its channels (after any filtering, so it triggers on what's
+    // captured).  Return true (and disarm) the first time the trigger happens.
+    bool check(float const * values, uint32_t num_asserts);
+
+    // Return true if still waiting for the trigger.
+    bool isArmed(void) const { return armed_; }
+
+  private: // methods
+
+    // Return true if the channel crossed the level from the last sample to 'value'.
+    bool crossed(float value) const;
+
+  private: // fields
+
+    // True while waiting for the trigger.
+    bool armed_;
+
+    // False until the first sample since arm(), which there's nothing to compare to.
+    bool have_last_;
+
+    // Copy of the settings.
+    glo_trigger_source_t source_;
+    glo_trigger_edge_t edge_;
+    uint8_t channel_;
+    glob_id_t glob_id_;
+    uint16_t instance_;
+    float level_;
+
+    // Channel value at the last sample.
+    float last_value_;
+
+    // Assert count when armed.
+    uint32_t num_asserts_;
+
+    // Glob data at the last sample and this one, swapped each check.
+    uint32_t glob_copies_[2][TRIGGER_MAX_GLOB_BYTES / 4];
+    uint8_t last_copy_;
+
+};
+
+#endif
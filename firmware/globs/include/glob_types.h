@@ -1,6 +1,6 @@
 // Define types of all globs. Instances are defined in globs.cpp
 // To use globs include globs.h.
-// To define new objects you must modify this file and globs.h
+// To define new objects you must modify this file, globs.h, glob_list.h and glob_registry.cpp
 
 #ifndef GLOB_TYPES_H_INCLUDED
 #define GLOB_TYPES_H_INCLUDED
@@ -128,19 +128,15 @@ typedef struct
 } glo_debug_message_t;
 
 //******************************************************************************
-// Data that is transmitted when a capture command is received.
-// Variable names are kept generic since what's being sent back changes frequently.
+// Data that is transmitted when a capture command is received.  What's captured is picked by the GUI
+// (see glo_capture_channels_t) and only the time and the channels' bytes are sent, so the frame is sized
+// to the channels.  The default channels are 8 floats so the whole struct is sent.  Quantized formats
+// (see glo_capture_format_t) pack several samples into each instance (see CaptureEncoder for how) and
+// the rest of the samples are one capture period apart from the first.
 typedef struct
 {
-    float time; // seconds
-    float d1;
-    float d2;
-    float d3;
-    float d4;
-    float d5;
-    float d6;
-    float d7;
-    float d8;
+    float time; // seconds, of the first sample in the instance.
+    uint8_t data[CAPTURE_MAX_CHANNEL_BYTES]; // Every channel back to back in channel order.
 
 } glo_capture_data_t;
 
@@ -161,9 +157,19 @@ typedef struct
 {
     uint8_t is_start;         // False (0) if should stop sending data.
     uint8_t paused;           // Collection won't start until this is set to false.
-    uint16_t frequency;       // Rate that data is recorded [Hz]
+    uint16_t frequency;       // Rate that data is recorded [Hz].  Below the control rate every channel is low-pass
+                              // filtered at the control rate first so faster changes don't alias into the samples
+                              // (see CaptureDecimator), which delays them a little.  Sample times are shifted back
+                              // to make up for it, so the first can be before zero.  Filtered captures are limited
+                              // to 1/64th of the control rate, and the command sent back has the rate that's used.
     uint32_t desired_samples; // How many samples to collect before stopping.
     uint32_t total_samples;   // Used to notify UI samples are done being sent and how many there should be.
+                              // Counted from the first sample of the first instance sent, so with a
+                              // quantized format any after that in the last instance aren't samples.
+    uint8_t stream;           // Non-zero to send samples while capturing (see CaptureRing) instead of after.
+                              // Then desired_samples isn't limited by the capture data glob and zero means
+                              // until a stop command.  Instances are reused, so order samples by time.
+    uint8_t unfiltered;       // Non-zero to just keep every Nth control loop sample, e.g. for mode or count channels.
 
 } glo_capture_command_t;
 
@@ -264,4 +270,131 @@ typedef struct
 
 } glo_task_timing_t;
 
+//******************************************************************************
+// How the telemetry link is framed (see glo_frame.h).  The GUI sends this to change modes.  It's sent
+// back in the old mode as an acknowledgement and then both directions switch to the new mode.
+typedef struct
+{
+    glo_link_framing_t framing;       // How frames are delimited.
+    uint8_t            batch_frames;  // Non-zero if several globs can be packed into one frame.
+    uint8_t            reliable_bulk; // Non-zero if ranges of instances are sent as reliable bulk transfers.
+
+} glo_link_mode_t;
+
+//******************************************************************************
+// How the telemetry send task is sharing the link between classes of telemetry.
+// Published by the send task about once a second while it's sending.
+typedef struct
+{
+    float    bytes_per_second[NUM_TELEMETRY_CLASSES]; // Sent since the last publish, including framing.
+    uint16_t queue_depth[NUM_TELEMETRY_CLASSES];      // Queued globs waiting to be sent.
+    uint16_t max_queue_depth[NUM_TELEMETRY_CLASSES];  // Most queued globs since the last publish.
+    uint32_t num_dropped[NUM_TELEMETRY_CLASSES];      // Globs dropped because the queue was full (since boot).
+
+} glo_telemetry_stats_t;
+
+//******************************************************************************
+// Describes a reliable bulk transfer (see GloBulkTransfer).  Sent when the transfer starts, before any
+// of the instances, and again when it's done or fails.
+typedef struct
+{
+    uint32_t num_sent;       // Instances sent so far, including ones sent again.
+    uint32_t num_resent;     // Instances sent again because they were reported missing or timed out.
+    uint16_t first_instance;
+    uint16_t last_instance;
+    uint16_t window;         // Most instances sent past the oldest one that hasn't been acknowledged.
+    uint8_t  transfer_id;    // Goes back in every acknowledgement.
+    uint8_t  glob_id;        // Glob whose instances are being sent.
+    glo_bulk_state_t state;
+
+} glo_bulk_transfer_t;
+
+//******************************************************************************
+// Acknowledgement the GUI sends back while receiving a reliable bulk transfer.  Should be sent
+// whenever a frame with instances of the transfer, or the glo_bulk_transfer_t announcing it, is received.
+typedef struct
+{
+    uint32_t missing[2];      // Bit i (0 to 63, missing[0] holds 0 to 31) is set if 'next_instance + i' hasn't been received.
+    uint16_t next_instance;   // Every instance before this one has been received.
+    uint16_t newest_instance; // Instance received most recently.
+    uint8_t  transfer_id;     // From glo_bulk_transfer_t.
+
+} glo_bulk_ack_t;
+
+//******************************************************************************
+// Ask for a glob to be sent periodically (see TelemetryStreamTask).  The instance is which subscription
+// it is (1 to STREAM_MAX_SUBSCRIPTIONS) and replaces whatever that subscription was.  It's sent back
+// with the rate and status that were granted.
+typedef struct
+{
+    float    rate;           // [Hz] How often to send the glob. Zero cancels the subscription.
+    uint16_t first_instance; // First instance of the glob to send.
+    uint16_t last_instance;  // Last instance to send. Zero for just the first one.
+    uint16_t decimation;     // Only send every Nth instance from the first. Zero or one sends them all.
+    uint8_t  glob_id;        // Glob to send.
+    glo_stream_status_t status; // Set in the reply.
+
+} glo_stream_subscription_t;
+
+//******************************************************************************
+// Progress of a streaming capture (see glo_capture_command_t).  Sent about twice a second while
+// samples are being sent and once more after the last one.  Samples are counted in capture data
+// instances, which hold more than one with a quantized format (see glo_capture_format_t).
+typedef struct
+{
+    uint32_t num_captured; // Samples taken since the capture started, including dropped ones.
+    uint32_t num_sent;     // Samples handed to the link (or acknowledged if bulk transfers are reliable).
+    uint32_t num_overruns; // Samples dropped because the ring buffer was full of ones that weren't sent yet.
+    uint16_t backlog;      // Samples waiting in the ring buffer to be sent.
+    uint16_t max_backlog;  // Most samples that were waiting at once.  Near ring_size means the link can't keep up.
+    uint16_t ring_size;    // Samples the ring buffer holds.
+    uint8_t  streaming;    // Non-zero until every sample has been sent.
+
+} glo_capture_status_t;
+
+//******************************************************************************
+// Which glob fields are captured (see glo_capture_data_t), one channel per array index.  The GUI
+// sends it and gets back the channels that are in use with how they were checked.  Channels can't
+// be changed while capturing, and shouldn't be until the last capture's samples are all sent.
+// Offsets and types are checked against the glob registry (see glob_registry.h), so a channel has
+// to be one element of a field.  The robot sends it again when each capture starts so the GUI has
+// what it needs to decode the samples.
+typedef struct
+{
+    float    scale[CAPTURE_MAX_CHANNELS];    // Quantized formats only. A channel is zero + scale * the int16.
+    float    zero[CAPTURE_MAX_CHANNELS];     // Values out of range are clamped to the nearest one that isn't.
+    uint16_t offset[CAPTURE_MAX_CHANNELS];   // Bytes from the start of the glob struct.
+    uint16_t instance[CAPTURE_MAX_CHANNELS]; // Instance of the glob. Zero is the same as one.
+    uint8_t  glob_id[CAPTURE_MAX_CHANNELS];
+    uint8_t  type[CAPTURE_MAX_CHANNELS];     // glob_field_type_t of the field.
+    uint8_t  num_channels;                   // Zero goes back to the default channels.
+    glo_capture_channels_status_t status;    // Set in the reply.
+    uint16_t sample_bytes;                   // Set in the reply. Bytes sent per instance, including the time.
+    uint8_t  bad_channel;                    // Set in the reply. First channel that was rejected.
+    glo_capture_format_t format;
+    uint8_t  samples_per_instance;           // Set in the reply.
+
+} glo_capture_channels_t;
+
+//******************************************************************************
+// Start a capture on an event like an oscilloscope does instead of right away.  Sent by the GUI (and
+// sent back with the state) before a capture command.  While armed the capture keeps the last
+// 'pre_samples' in the capture buffer, and once it triggers it captures 'post_samples' more and sends
+// them all.  Stays set for every capture until the source is set back to none.  Triggered captures
+// aren't streamed and ignore the capture command's desired samples.
+typedef struct
+{
+    float    level;         // Level a channel crosses for TRIGGER_SOURCE_CHANNEL.
+    uint32_t num_pre_sent;  // Set by the robot. Samples sent from before the trigger (fewer if it triggered early).
+    uint16_t pre_samples;   // Most samples to keep from before the trigger.
+    uint16_t post_samples;  // Samples to capture from the trigger on, including the one that triggered it.
+    uint16_t instance;      // Glob instance for TRIGGER_SOURCE_GLOB_CHANGE. Zero is the same as one.
+    glo_trigger_source_t source;
+    glo_trigger_edge_t   edge;    // For TRIGGER_SOURCE_CHANNEL.
+    uint8_t  channel;             // Capture channel (see glo_capture_channels_t) for TRIGGER_SOURCE_CHANNEL.
+    uint8_t  glob_id;             // Glob for TRIGGER_SOURCE_GLOB_CHANGE.
+    glo_trigger_state_t  state;   // Set by the robot.
+
+} glo_capture_trigger_t;
+
 #endif // GLOB_TYPES_H_INCLUDED
@@ -0,0 +1,52 @@
+#ifndef HOST_PORT_H_INCLUDED
+#define HOST_PORT_H_INCLUDED
+
+// Includes
+#include <cstdint>
+
+namespace Scheduler { class Task; }
+
+// Shared state between the host versions of the hardware specific files and the host main.
+// Only used when building the firmware for a PC (HOST_PORT defined), see host/main.cpp.
+
+// Virtual clock tick stamp that the scheduler stops at once it runs out of tasks to run.
+extern uint64_t host_stop_ticks;
+
+// Total number of bytes the telemetry link has written to the (simulated) serial port.
+extern uint64_t host_bytes_sent;
+
+// How many times the firmware has read the 64 bit system time (SystemTimer::ticks()), the 32 bit cycle
+// counter (SystemTimer::cycles()) and the scheduler's tick snapshot (Scheduler::currentTicks()).
+// Defined here instead of in a host file so tools that don't link system_timer_host.cpp still build.
+struct host_read_counts_t
+{
+    uint64_t tick_reads;
+    uint64_t cycle_reads;
+    uint64_t snapshot_reads;
+};
+inline host_read_counts_t & host_read_counts(void) { static host_read_counts_t counts; return counts; }
+
+// If set then called with everything the telemetry link sends so host tools can decode it.
+extern void (*host_tx_sink)(uint8_t const * data, uint16_t length);
+
+// If set then returns how many bytes are still waiting in the serial port's transfer buffer, e.g. to
+// model the link's baud rate.  Otherwise the simulated port sends everything as soon as it's committed.
+extern uint32_t (*host_tx_backlog)(void);
+
+// If set then called right before every task runs with how long its last run took on the PC (zero the first
+// time) and returns how many ticks the task takes on the robot.  The virtual clock moves forward that much
+// before the task runs, with systick (and the preemptive tier) running in the middle like on the robot.
+// Running the task at the end of its time means anything it publishes or writes is as late as it could be.
+// Otherwise tasks take no time, which keeps every run deterministic.
+extern uint64_t (*host_task_work)(Scheduler::Task const & task, double pc_seconds);
+
+// If set then called with true whenever the firmware disables interrupts (when they were enabled) and with
+// false when it enables them again, so host tools can count or time how long interrupts are masked.
+extern void (*host_interrupts_masked)(bool masked);
+
+// Called by Task::execute() right before and after run() to apply host_task_work.  The first returns the
+// PC time to pass to the second.
+double host_task_starting(Scheduler::Task const & task);
+void host_task_finished(Scheduler::Task const & task, double pc_started);
+
+#endif
@@ -0,0 +1,143 @@
+// Runs the full robot task set on a PC with a virtual clock.  The clock jumps straight to the next
+// time a task needs to run whenever the scheduler is idle, so hours of robot time only take seconds.
+// Every run is deterministic since nothing depends on how fast the PC is.
+//
+// Build from the firmware directory (HOST_PORT swaps in the host versions of the hardware specific code):
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/[a-z]*.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp scheduler/task.cpp scheduler/periodic_task.cpp \
+       tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp libraries/glo_link/[a-z]*.cpp \
+       libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+       libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+       embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+       -o eeva_host
+*/
+// Usage: eeva_host [simulated seconds]   (defaults to one hour)
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "host_port.h"
+#include "scheduler.h"
+#include "util_assert.h"
+#include "debug_printf.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "main_control_task.h"
+#include "telemetry_receive_task.h"
+#include "status_update_task.h"
+#include "leds_task.h"
+#include "modes_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Same setup as the robot (see embitz_projects/eeva_full_version/source/main.cpp)
+SystemTimer sys_timer(1000);
+
+// Periodic Tasks ->     Task name        Frequency (Hz)
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100); // Fastest rate globs can be streamed at.
+
+// Queued Tasks ->       Task name      Queue Size (elements per class)
+TelemetrySendTask        send_task             (40);
+
+// General Tasks ->      Task name
+TelemetryReceiveTask     receive_task;
+
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+//*****************************************************************************
+static void print_task_counts(Scheduler::Task const * task)
+{
+    printf("  %-16s %12lu\n", task->name(), (unsigned long)task->numTimesRan());
+}
+
+//*****************************************************************************
+int main(int argc, char * argv[])
+{
+    double simulated_seconds = 3600.0;
+    if (argc > 1)
+    {
+        simulated_seconds = atof(argv[1]);
+    }
+
+    if (simulated_seconds <= 0)
+    {
+        printf("Usage: %s [simulated seconds]\n", argv[0]);
+        return 1;
+    }
+
+    host_stop_ticks = (uint64_t)(simulated_seconds * sys_timer.frequency());
+
+    static Scheduler::Task * preemptive_tasks[] =
+    {
+        &main_control_task,
+    };
+
+    static Scheduler::Task * tasks[] =
+    {
+        &comp_filter_task,
+        &send_task,
+        &receive_task,
+        &leds_task,
+        &modes_task,
+        &status_update_task,
+        &stream_task,
+    };
+
+    const uint32_t number_of_preemptive_tasks = sizeof(preemptive_tasks) / sizeof(preemptive_tasks[0]);
+    const uint32_t number_of_tasks = sizeof(tasks) / sizeof(tasks[0]);
+
+    for (uint32_t i = 0; i < number_of_tasks; ++i)
+    {
+        bool registration_success = scheduler.registerTask(*tasks[i]);
+        assert_msg(registration_success, ASSERT_STOP, "Failed to register task \"%s\"", tasks[i]->name());
+    }
+
+    for (uint32_t i = 0; i < number_of_preemptive_tasks; ++i)
+    {
+        bool registration_success = scheduler.registerPreemptiveTask(*preemptive_tasks[i]);
+        assert_msg(registration_success, ASSERT_STOP, "Failed to register preemptive task \"%s\"", preemptive_tasks[i]->name());
+    }
+
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+    // Returns once the virtual clock reaches the stop time.
+    scheduler.scheduleTasks();
+
+    std::chrono::duration<double> wall_elapsed = std::chrono::steady_clock::now() - wall_start;
+
+    double simulated_elapsed = sys_timer.seconds();
+    double wall_seconds = wall_elapsed.count();
+
+    printf("Simulated %.3f s in %.3f s of wall-clock time\n", simulated_elapsed, wall_seconds);
+    if (wall_seconds > 0)
+    {
+        printf("Simulated time per wall-clock second: %.1f s\n", simulated_elapsed / wall_seconds);
+    }
+    printf("Telemetry bytes sent: %llu\n", (unsigned long long)host_bytes_sent);
+
+    printf("Task executions:\n");
+    for (uint8_t i = 0; i < scheduler.numPreemptiveTasks(); ++i)
+    {
+        print_task_counts(scheduler.preemptiveTask(i));
+    }
+    for (uint8_t i = 0; i < scheduler.numTasks(); ++i)
+    {
+        print_task_counts(scheduler.task(i));
+    }
+
+    double microseconds_per_tick = 1e6 / sys_timer.frequency();
+    printf("Sensor to PWM latency: avg %.1f us, max %.1f us\n",
+           main_control_task.sensorToPwmTicksAvg() * microseconds_per_tick,
+           main_control_task.sensorToPwmTicksMax() * microseconds_per_tick);
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Host (PC) version of the hardware specific parts of the Scheduler. See scheduler/scheduler_port.cpp.
+// There's only one thread and the only 'interrupt' is the simulated systick, which can only fire
+// while the scheduler is idle (or while a task is given run time by host_task_work, which is never while
+// it has interrupts masked), so interrupt masking just has to track state for nesting.  The
+// preemptive tier (PendSV) is simulated by running it right away unless it's masked or already running.
+
+// Includes
+#include <chrono>
+#include <map>
+#include <sys/resource.h>
+#include "scheduler.h"
+#include "host_port.h"
+
+uint64_t host_stop_ticks = UINT64_MAX;
+
+uint64_t (*host_task_work)(Scheduler::Task const & task, double pc_seconds) = NULL;
+
+void (*host_interrupts_masked)(bool masked) = NULL;
+
+// How long each task's last run took on the PC, and how many times the OS had interrupted the PC when it
+// started.  See pc_interruptions().
+struct pc_run_t
+{
+    double seconds;
+    long interruptions;
+};
+static std::map<Scheduler::Task const *, pc_run_t> task_pc_runs;
+
+// Simulated PRIMASK and BASEPRI registers.
+static bool interrupts_disabled = false;
+static uint32_t base_priority = 0;
+
+// Simulated PendSV pending and active bits.
+static bool preemptive_tier_pending = false;
+static bool preemptive_tier_active = false;
+
+namespace Scheduler {
+
+//*****************************************************************************
+void Scheduler::configureInterrupts(void)
+{
+    // No interrupt controller to setup.
+}
+
+//*****************************************************************************
+void Scheduler::pendPreemptiveTasks(void)
+{
+    preemptive_tier_pending = true;
+
+    // PendSV would run as soon as systick returns so just run the tasks now. If it's already running
+    // or masked then it runs again once it returns or is unmasked, same as the real interrupt.
+    if (preemptive_tier_active || interrupts_disabled || (base_priority != 0))
+    {
+        return;
+    }
+
+    preemptive_tier_active = true;
+    while (preemptive_tier_pending)
+    {
+        preemptive_tier_pending = false;
+        runPreemptiveTasks();
+    }
+    preemptive_tier_active = false;
+}
+
+//*****************************************************************************
+void Scheduler::idle(uint64_t wake_ticks)
+{
+    // Nothing can happen until the next timer task (or systick interrupt) so skip right to it.
+    sys_timer.advance(wake_ticks);
+
+    if (sys_timer.virtualTicks() >= host_stop_ticks)
+    {
+        stop();
+    }
+}
+
+//*****************************************************************************
+bool Scheduler::disableInterrupts(void) const
+{
+    bool already_enabled = !interrupts_disabled;
+    interrupts_disabled = true;
+
+    if (already_enabled && (host_interrupts_masked != NULL))
+    {
+        host_interrupts_masked(true);
+    }
+
+    return already_enabled;
+}
+
+//*****************************************************************************
+void Scheduler::restoreInterrupts(bool enabled) const
+{
+    if (enabled)
+    {
+        interrupts_disabled = false;
+
+        if (host_interrupts_masked != NULL)
+        {
+            host_interrupts_masked(false);
+        }
+
+        // Preemptive tier was requested while masked so it runs as soon as it's unmasked.
+        if ((base_priority == 0) && preemptive_tier_pending)
+        {
+            scheduler.pendPreemptiveTasks();
+        }
+    }
+}
+
+//*****************************************************************************
+uint32_t Scheduler::maxInterruptsDisabledCycles(void) const
+{
+    // Simulated time doesn't pass while tasks run so there's nothing to measure.
+    return 0;
+}
+
+//*****************************************************************************
+void Scheduler::resetInterruptsDisabledCycles(void)
+{
+}
+
+//*****************************************************************************
+uint32_t Scheduler::disablePreemptiveTasks(void) const
+{
+    uint32_t previous_state = base_priority;
+    base_priority = PREEMPTIVE_TASK_IRQ_PRIORITY;
+    return previous_state;
+}
+
+//*****************************************************************************
+void Scheduler::restorePreemptiveTasks(uint32_t previous_state) const
+{
+    base_priority = previous_state;
+
+    // Preemptive tier was requested while masked so it runs as soon as it's unmasked.
+    if ((base_priority == 0) && !interrupts_disabled && preemptive_tier_pending)
+    {
+        scheduler.pendPreemptiveTasks();
+    }
+}
+
+} // Scheduler namespace
+
+//*****************************************************************************
+static double pc_seconds(void)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//*****************************************************************************
+// Return how many times the OS has switched away from this process or handled a page fault for it.  Either
+// takes far longer than most tasks, so a run that includes one isn't a measure of the task.
+static long pc_interruptions(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw + usage.ru_minflt + usage.ru_majflt;
+}
+
+//*****************************************************************************
+double host_task_starting(Scheduler::Task const & task)
+{
+    if (host_task_work == NULL)
+    {
+        return 0;
+    }
+
+    pc_run_t & run = task_pc_runs[&task];
+    sys_timer.busy(host_task_work(task, run.seconds));
+
+    // Start timing after the preemptive tier had its chance to run.
+    run.interruptions = pc_interruptions();
+    return pc_seconds();
+}
+
+//*****************************************************************************
+void host_task_finished(Scheduler::Task const & task, double pc_started)
+{
+    if (host_task_work == NULL)
+    {
+        return;
+    }
+
+    double seconds = pc_seconds() - pc_started;
+
+    // If the OS got in the way then keep the last time.
+    pc_run_t & run = task_pc_runs[&task];
+    if (pc_interruptions() == run.interruptions)
+    {
+        run.seconds = seconds;
+    }
+}
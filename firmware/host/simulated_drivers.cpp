@@ -0,0 +1,191 @@
+// Host (PC) versions of the robot's hardware drivers.  These replace the driver source files in
+// libraries/util that access peripheral registers.  The simulated robot sits still and level with
+// a full battery, which is enough to exercise every task and the telemetry link.
+
+// Includes
+#include <cstring>
+#include "analog_in.h"
+#include "digital_in.h"
+#include "digital_out.h"
+#include "encoder.h"
+#include "green_leds.h"
+#include "mpu6000.h"
+#include "physical_constants.h"
+#include "processor_id.h"
+#include "pwm_out_advanced_timer.h"
+#include "robot_settings.h"
+#include "tb6612fng.h"
+#include "user_leds.h"
+#include "user_pb.h"
+
+// Stand in for GPIO registers since DigitalIn/Out access them directly.
+static GPIO_TypeDef simulated_gpio_port;
+
+//*****************************************************************************
+AnalogIn::AnalogIn(void)
+{
+    memset((void *)adc_raw_values_, 0, sizeof(adc_raw_values_));
+}
+
+//*****************************************************************************
+void AnalogIn::getVoltages(float voltages[9])
+{
+    for (uint8_t i = 0; i < 9; ++i)
+    {
+        voltages[i] = 0.0f;
+    }
+
+    // Last channel is the battery voltage divider.
+    voltages[8] = (FULL_BATTERY_VOLTAGE - BATTERY_OFFSET) / BATTERY_SCALE;
+}
+
+//*****************************************************************************
+DigitalIn::DigitalIn(digital_in_pin_t /*pin*/, GPIOPuPd_TypeDef /*pull_up_pull_down*/) :
+    gpio_pin_(0),
+    rcc_ahb1periph_(0),
+    port_(&simulated_gpio_port)
+{
+}
+
+//*****************************************************************************
+DigitalOut::DigitalOut(digital_out_pin_t /*pin*/, GPIOOType_TypeDef /*out_type*/,
+                       GPIOPuPd_TypeDef /*pull_up_pull_down*/, uint8_t /*initial_state*/) :
+    gpio_pin_(0),
+    rcc_ahb1periph_(0),
+    port_(&simulated_gpio_port)
+{
+}
+
+//*****************************************************************************
+Encoder::Encoder(encoder_id_t id) :
+    encoder_id_(id),
+    prev_counter_(0),
+    overflows_(0)
+{
+}
+
+//*****************************************************************************
+int32_t Encoder::read(void)
+{
+    return ((int32_t)overflows_ << 16) + prev_counter_;
+}
+
+//*****************************************************************************
+void Encoder::set(int32_t count32)
+{
+    overflows_ = (int16_t)(count32 >> 16);
+    prev_counter_ = (uint16_t)count32;
+}
+
+//*****************************************************************************
+GreenLeds::GreenLeds(void)
+{
+}
+
+//*****************************************************************************
+void GreenLeds::set(uint8_t /*pattern*/)
+{
+}
+
+//*****************************************************************************
+MPU6000::MPU6000(void) :
+    product_id_(0),
+    spi_(NULL),
+    spi_bus_(SPI_BUS_3),
+    gyro_range_scale_(0),
+    accel_range_scale_(0)
+{
+}
+
+//*****************************************************************************
+int8_t MPU6000::initialize(void)
+{
+    return 0; // Successful driver initialization
+}
+
+//*****************************************************************************
+void MPU6000::readGyro(float * data)
+{
+    data[0] = 0.0f;
+    data[1] = 0.0f;
+    data[2] = 0.0f;
+}
+
+//*****************************************************************************
+void MPU6000::readAccel(float * data)
+{
+    data[0] = 0.0f;
+    data[1] = 0.0f;
+    data[2] = GRAVITY;
+}
+
+//*****************************************************************************
+PwmOutAdvancedTimer::PwmOutAdvancedTimer(void) :
+    auto_reload_reg_(0)
+{
+}
+
+//*****************************************************************************
+void PwmOutAdvancedTimer::setDuty(float /*duty*/, uint8_t /*channel_num*/)
+{
+}
+
+//*****************************************************************************
+void read_processor_id(uint8_t id[PROCESSOR_ID_SIZE])
+{
+    memset(id, 0, PROCESSOR_ID_SIZE);
+}
+
+//*****************************************************************************
+TB6612FNG::TB6612FNG(void)
+{
+}
+
+//*****************************************************************************
+void TB6612FNG::setDutyA(float /*duty*/)
+{
+}
+
+//*****************************************************************************
+void TB6612FNG::setDutyB(float /*duty*/)
+{
+}
+
+//*****************************************************************************
+UserLeds::UserLeds(void)
+{
+}
+
+//*****************************************************************************
+void UserLeds::set(user_led_id_t /*led*/)
+{
+}
+
+//*****************************************************************************
+void UserLeds::clear(user_led_id_t /*led*/)
+{
+}
+
+//*****************************************************************************
+void UserLeds::toggle(user_led_id_t /*led*/)
+{
+}
+
+//*****************************************************************************
+UserPushButton::UserPushButton(user_button_id_t button_id) :
+    button_id_(button_id),
+    button_was_pressed_(false)
+{
+}
+
+//*****************************************************************************
+bool UserPushButton::read(void)
+{
+    return false; // nobody is pressing it
+}
+
+//*****************************************************************************
+bool UserPushButton::activated(void)
+{
+    return false;
+}
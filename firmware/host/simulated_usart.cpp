@@ -0,0 +1,257 @@
+// Host (PC) version of the serial port.  Only receives what's passed to hostReceive() and anything
+// sent is counted and thrown away (after being passed to host_tx_sink if it's set).  Replaces usart.cpp, dma_rx.cpp and dma_tx.cpp from libraries/util.
+
+// Includes
+#include <cstddef>
+#include "dma_rx.h"
+#include "dma_tx.h"
+#include "host_port.h"
+#include "usart.h"
+
+uint64_t host_bytes_sent = 0;
+void (*host_tx_sink)(uint8_t const * data, uint16_t length) = NULL;
+uint32_t (*host_tx_backlog)(void) = NULL;
+
+// Static class fields
+bool  Usart::init[USART_BUS_COUNT];
+Usart Usart::objs[USART_BUS_COUNT];
+
+//*****************************************************************************
+Usart * Usart::instance(usart_bus_t bus)
+{
+    if (bus >= USART_BUS_COUNT)
+    {
+        return NULL;
+    }
+
+    if (!init[bus])
+    {
+        objs[bus].bus_ = bus;
+        objs[bus].USARTx_ = NULL;
+        objs[bus].baudrate_ = (bus == USART_BUS_1) ? USART1_BAUD_RATE : USART2_BAUD_RATE;
+        uint32_t rx_buff_size = (bus == USART_BUS_1) ? USART1_RX_BUFF_SIZE : USART2_RX_BUFF_SIZE;
+        objs[bus].dma_rx_ = new DmaRx(NULL, 0, 0, rx_buff_size);
+        uint32_t tx_buff_size = (bus == USART_BUS_1) ? USART1_TX_BUFF_SIZE : USART2_TX_BUFF_SIZE;
+        objs[bus].dma_tx_ = new DmaTx(NULL, 0, (IRQn)0, 0, 0, 0, tx_buff_size);
+        init[bus] = true;
+    }
+
+    return &objs[bus];
+}
+
+//*****************************************************************************
+Usart::~Usart(void)
+{
+    if (dma_tx_ != NULL)
+    {
+        delete dma_tx_;
+    }
+
+    if (dma_rx_ != NULL)
+    {
+        delete dma_rx_;
+    }
+}
+
+//*****************************************************************************
+bool Usart::getByte(uint8_t * byte)
+{
+    return dma_rx_->getByte(byte);
+}
+
+//*****************************************************************************
+bool Usart::sendBuffer(uint8_t const * data, uint16_t len)
+{
+    return dma_tx_->sendBuffer(data, len);
+}
+
+//*****************************************************************************
+void Usart::updateBaudrate(uint32_t baudrate)
+{
+    baudrate_ = baudrate;
+}
+
+//*****************************************************************************
+DmaRx::DmaRx(DMA_Stream_TypeDef * /*dma_stream*/, uint32_t /*channel*/, uint32_t /*periph_base_address*/, uint32_t buff_length) :
+    buff_length_(buff_length),
+    buff_bottom_(0)
+{
+    // Fake stream registers so NDTR counts down like the real DMA.
+    buff_ = new uint8_t[buff_length];
+    dma_stream_ = new DMA_Stream_TypeDef();
+    dma_stream_->NDTR = buff_length;
+}
+
+//*****************************************************************************
+DmaRx::~DmaRx(void)
+{
+    delete[] buff_;
+    delete dma_stream_;
+}
+
+//*****************************************************************************
+void DmaRx::hostReceive(uint8_t const * data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        buff_[bufferTop()] = data[i];
+
+        // Circular mode reloads the count once it reaches zero.
+        if (--dma_stream_->NDTR == 0)
+        {
+            dma_stream_->NDTR = buff_length_;
+        }
+    }
+}
+
+//*****************************************************************************
+uint32_t DmaRx::bufferTop(void) const
+{
+    return buff_length_ - (uint16_t)dma_stream_->NDTR;
+}
+
+//*****************************************************************************
+bool DmaRx::empty(void) const
+{
+    return (bufferTop() == buff_bottom_);
+}
+
+//*****************************************************************************
+bool DmaRx::getByte(uint8_t * byte)
+{
+    if (empty()) { return false; }
+
+    *byte = buff_[buff_bottom_];
+    buff_bottom_ = (buff_bottom_ + 1) % buff_length_;
+
+    return true;
+}
+
+//*****************************************************************************
+uint8_t const * DmaRx::peekSpan(uint32_t * length) const
+{
+    uint32_t buff_top = bufferTop();
+    *length = (buff_top >= buff_bottom_) ? (buff_top - buff_bottom_) : (buff_length_ - buff_bottom_);
+    return &buff_[buff_bottom_];
+}
+
+//*****************************************************************************
+void DmaRx::consume(uint32_t length)
+{
+    buff_bottom_ = (buff_bottom_ + length) % buff_length_;
+}
+
+//*****************************************************************************
+DmaTx::DmaTx(DMA_Stream_TypeDef * dma_stream, uint32_t /*channel*/, IRQn dma_irq_num, uint32_t /*periph_base_address*/,
+             uint32_t transfer_complete_bit, uint32_t transfer_error_bit, uint32_t buff_length) :
+    buff_(NULL),
+    buff_length_(buff_length),
+    buff_top_(0),
+    dma_top_(0),
+    dma_active_(false),
+    dma_irq_num_(dma_irq_num),
+    dma_stream_(dma_stream),
+    transfer_complete_bit_(transfer_complete_bit),
+    transfer_error_bit_(transfer_error_bit),
+    error_count_(0),
+    reserved_start_(0),
+    reserved_length_(0)
+{
+    buff_ = new uint8_t[buff_length];
+}
+
+//*****************************************************************************
+DmaTx::~DmaTx(void)
+{
+    delete[] buff_;
+}
+
+//*****************************************************************************
+bool DmaTx::sendBuffer(uint8_t const * data, uint16_t len)
+{
+    dma_tx_region_t region;
+    if (!reserve(len, &region))
+    {
+        return false;
+    }
+
+    region.write(0, data, len);
+
+    commit();
+
+    return true;
+}
+
+//*****************************************************************************
+bool DmaTx::reserve(uint16_t len, dma_tx_region_t * region)
+{
+    if ((len > buff_length_) || (len == 0))
+    {
+        return false;
+    }
+
+    return (reserveUpTo(len, region) == len);
+}
+
+//*****************************************************************************
+uint16_t DmaTx::reserveUpTo(uint16_t max_len, dma_tx_region_t * region)
+{
+    // Everything is written to the start of the buffer since it's sent right away.
+    uint16_t free_space = freeSpace();
+    uint16_t len = (max_len < free_space) ? max_len : free_space;
+
+    region->part[0] = buff_;
+    region->length[0] = len;
+    region->part[1] = NULL;
+    region->length[1] = 0;
+
+    reserved_start_ = 0;
+    reserved_length_ = len;
+
+    return len;
+}
+
+//*****************************************************************************
+uint16_t DmaTx::freeSpace(void)
+{
+    // Unless there's a link model the serial port is infinitely fast so the buffer is always empty.
+    uint32_t backlog = (host_tx_backlog != NULL) ? host_tx_backlog() : 0;
+    if (backlog >= buff_length_ - 1)
+    {
+        return 0;
+    }
+    return buff_length_ - 1 - backlog;
+}
+
+//*****************************************************************************
+void DmaTx::commit(void)
+{
+    commit(reserved_length_);
+}
+
+//*****************************************************************************
+void DmaTx::commit(uint16_t num_bytes)
+{
+    if (num_bytes > reserved_length_)
+    {
+        num_bytes = reserved_length_;
+    }
+
+    host_bytes_sent += num_bytes;
+    if ((host_tx_sink != NULL) && (num_bytes > 0))
+    {
+        host_tx_sink(buff_ + reserved_start_, num_bytes);
+    }
+
+    reserved_length_ = 0;
+}
+
+//*****************************************************************************
+void DmaTx::handleISR(void)
+{
+}
+
+//*****************************************************************************
+void DmaTx::poll(void)
+{
+}
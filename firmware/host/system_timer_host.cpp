@@ -0,0 +1,92 @@
+// Host (PC) version of the system timer. See libraries/util/system_timer.cpp.
+// Time is virtual so it only moves forward when advance() is called (e.g. when the scheduler is idle)
+// which makes every run deterministic and lets the firmware run as fast as the PC allows.
+
+// Includes
+#include "system_timer.h"
+#include "scheduler.h"
+
+// Clock speed of the robot's processor so tick counts match the real hardware.
+#define HOST_TIMER_FREQUENCY 168000000UL
+
+//*****************************************************************************
+SystemTimer::SystemTimer(uint32_t interrupt_frequency) :
+    rollover_ticks_(0),
+    last_reported_ticks_(0),
+    virtual_ticks_(0)
+{
+    timer_frequency_ = HOST_TIMER_FREQUENCY;
+
+    // Same as the real timer so the simulated systick interrupts at the same rate.
+    reload_value_ = 0xFFFFFF;
+    if (interrupt_frequency != 0)
+    {
+        reload_value_ = timer_frequency_ / interrupt_frequency;
+    }
+
+    seconds_per_tick_ = 1.0 / timer_frequency_;
+}
+
+//*****************************************************************************
+extern "C" void SysTick_Handler(void)
+{
+    sys_timer.rollover();
+
+    scheduler.triggerPreemptiveTasks();
+}
+
+//*****************************************************************************
+uint64_t SystemTimer::ticks(void)
+{
+    host_read_counts().tick_reads++;
+    last_reported_ticks_ = virtual_ticks_;
+    return virtual_ticks_;
+}
+
+//*****************************************************************************
+void SystemTimer::advance(uint64_t new_ticks)
+{
+    // Stop at the next interrupt since whatever runs in it could make a task ready.
+    uint64_t interrupt_ticks = rollover_ticks_ + reload_value_;
+
+    if (new_ticks >= interrupt_ticks)
+    {
+        virtual_ticks_ = interrupt_ticks;
+        SysTick_Handler();
+    }
+    else if (new_ticks > virtual_ticks_)
+    {
+        virtual_ticks_ = new_ticks;
+    }
+}
+
+//*****************************************************************************
+void SystemTimer::busy(uint64_t num_ticks)
+{
+    while (num_ticks > 0)
+    {
+        uint64_t interrupt_ticks = rollover_ticks_ + reload_value_;
+        uint64_t step = interrupt_ticks - virtual_ticks_;
+        if (step > num_ticks)
+        {
+            virtual_ticks_ += num_ticks;
+            return;
+        }
+
+        // Only the time up to the interrupt counts.  It can run tasks that call this again, which moves
+        // the clock on by however long they take.
+        virtual_ticks_ = interrupt_ticks;
+        num_ticks -= step;
+        SysTick_Handler();
+    }
+}
+
+//*****************************************************************************
+void SystemTimer::busyWait(double seconds_to_wait)
+{
+    uint64_t stop_ticks = virtual_ticks_ + (uint64_t)(seconds_to_wait * timer_frequency_);
+    while (virtual_ticks_ < stop_ticks)
+    {
+        advance(stop_ticks);
+    }
+}
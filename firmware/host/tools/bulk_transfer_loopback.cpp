@@ -0,0 +1,499 @@
+// Sends a capture dump from TelemetrySendTask to a simulated GUI over a pseudo-terminal and measures
+// goodput (unique capture bytes the GUI gets per second) with frames lost on the way.  Both directions
+// model a 115200 baud (8N1) wire: a frame goes through the pty once its last byte would be on the
+// other end.  'loss' percent of frames in each direction get a bit flipped so the receiver's CRC check
+// drops them.
+//
+// The GUI sends a link mode glob (see glo_link_mode_t) to turn reliable bulk transfers on or off and
+// then a capture command for 'samples' samples.  MainControlTask captures them and sends the dump
+// like it does for the real GUI, and the GUI checks what it gets against the capture data glob.
+// With reliable transfers on the GUI answers each frame of the dump with a glo_bulk_ack_t and the
+// robot keeps sending until it's all acknowledged.  Otherwise the dump is fire-and-forget like it was
+// before, so whatever is lost stays lost.  Either way the time is from the robot starting to send the
+// dump until the last new sample gets to the GUI.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/bulk_transfer_loopback.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+       host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+       scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+       libraries/glo_link/[a-z]*.cpp \
+       libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+       libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+       embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+       -lutil -o bulk_transfer_loopback
+*/
+// Usage: bulk_transfer_loopback [loss percent] [reliable 0 or 1] [samples] [random seed]
+//        (default to 5, 1, 2000 and 1)
+
+// Includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "crc.h"
+#include "glo_frame.h"
+#include "globs.h"
+#include "host_port.h"
+#include "periodic_task.h"
+#include "scheduler.h"
+#include "usart.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Pseudo-terminal includes.  After the firmware's since termios.h defines macros (e.g. CR1) that
+// clash with the STM32 register names.
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Same tasks as the host simulation (see host/main.cpp) since the firmware refers to them, but only
+// the main control task, the telemetry tasks and the loopback task below are registered.
+SystemTimer sys_timer(1000);
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+// Bytes per second on a 115200 baud 8N1 link.
+const double LINK_BYTES_PER_SECOND = 115200.0 / 10.0;
+
+// Give up if the dump takes longer than this.
+const double MAX_SECONDS = 120.0;
+
+// One direction of the serial link.  Frames wait here until they're done going over the wire.
+struct wire_t
+{
+    struct frame_t
+    {
+        double arrive_seconds;
+        std::vector<uint8_t> bytes;
+    };
+    std::deque<frame_t> frames;
+    double free_seconds; // when the last queued byte is on the wire
+    uint64_t num_bytes;
+    uint32_t num_frames;
+    uint32_t num_corrupted;
+};
+static wire_t downlink; // robot to GUI
+static wire_t uplink;   // GUI to robot
+
+static double loss_percent = 5.0;
+static uint16_t num_samples = 2000;
+
+// Pseudo-terminal between the two.  The robot has the master end and the GUI has the slave end.
+static int robot_fd = -1;
+static int gui_fd = -1;
+
+// What the GUI has received.
+struct gui_t
+{
+    std::vector<uint8_t> rx;         // bytes not parsed yet
+    std::vector<bool> have;          // capture data instances received, indexed by instance
+    uint32_t num_unique;
+    uint32_t num_duplicates;
+    uint32_t num_bad_data;
+    uint32_t num_acks;
+    bool link_mode_confirmed;
+    bool transfer_started;
+    glo_bulk_transfer_t transfer;   // last announcement received
+    uint16_t newest_instance;       // capture data instance received most recently
+    double dump_start_seconds;      // when the robot started sending the dump
+    double last_data_seconds;       // when the last new sample was received
+    bool dump_finished;             // robot has nothing left to send
+};
+static gui_t gui;
+
+//******************************************************************************
+static void queue_frame(wire_t * wire, uint8_t const * data, uint16_t length)
+{
+    double now = sys_timer.seconds();
+    double start = (wire->free_seconds > now) ? wire->free_seconds : now;
+    wire->free_seconds = start + length / LINK_BYTES_PER_SECOND;
+
+    wire_t::frame_t frame;
+    frame.arrive_seconds = wire->free_seconds;
+    frame.bytes.assign(data, data + length);
+    if (rand() % 10000 < loss_percent * 100)
+    {
+        frame.bytes[rand() % length] ^= (uint8_t)(1 << (rand() % 8));
+        wire->num_corrupted++;
+    }
+    wire->frames.push_back(frame);
+    wire->num_bytes += length;
+    wire->num_frames++;
+}
+
+//******************************************************************************
+// Called with each frame the send task commits.
+static void send_frame(uint8_t const * frame, uint16_t length)
+{
+    bool dump_frame = (frame[MSG_ID_IDX] == GLO_ID_BULK_TRANSFER) || (frame[MSG_ID_IDX] == GLO_ID_CAPTURE_DATA) ||
+                      ((frame[MSG_ID_IDX] == MSG_BATCH_ID) && (frame[MSG_HEADER_SIZE] == GLO_ID_CAPTURE_DATA));
+    if (dump_frame && (gui.dump_start_seconds == 0))
+    {
+        double now = sys_timer.seconds();
+        gui.dump_start_seconds = (downlink.free_seconds > now) ? downlink.free_seconds : now;
+    }
+
+    queue_frame(&downlink, frame, length);
+}
+
+//******************************************************************************
+static uint32_t wire_backlog(void)
+{
+    double seconds_left = downlink.free_seconds - sys_timer.seconds();
+    return (seconds_left > 0) ? (uint32_t)(seconds_left * LINK_BYTES_PER_SECOND + 0.5) : 0;
+}
+
+//******************************************************************************
+// Write 'data' into one end of the pty and read it back out of the other.
+static std::vector<uint8_t> through_pty(int write_fd, int read_fd, std::vector<uint8_t> const & data)
+{
+    std::vector<uint8_t> out(data.size());
+    size_t num_written = 0;
+    size_t num_read = 0;
+    while (num_read < data.size())
+    {
+        if (num_written < data.size())
+        {
+            ssize_t result = write(write_fd, &data[num_written], data.size() - num_written);
+            num_written += (result > 0) ? result : 0;
+        }
+
+        pollfd readable = { read_fd, POLLIN, 0 };
+        if (poll(&readable, 1, 1000) <= 0)
+        {
+            fprintf(stderr, "Pseudo-terminal stopped passing data\n");
+            exit(1);
+        }
+        ssize_t result = read(read_fd, &out[num_read], data.size() - num_read);
+        num_read += (result > 0) ? result : 0;
+    }
+    return out;
+}
+
+//******************************************************************************
+// Frame and queue a glob the GUI sends, the same way GloTxLink does.
+static void gui_send(uint8_t id, void const * data, uint8_t num_bytes)
+{
+    uint8_t frame[MSG_MAX_FRAME_SIZE];
+    frame[0] = MSG_START_BYTE;
+    frame[1] = 1;
+    frame[2] = id;
+    frame[3] = 1;
+    frame[4] = 0;
+    frame[5] = 0;
+    frame[6] = num_bytes;
+    memcpy(frame + MSG_HEADER_SIZE, data, num_bytes);
+    uint16_t crc = crc_final(crc_update(crc_init(), frame, MSG_HEADER_SIZE + num_bytes));
+    frame[MSG_HEADER_SIZE + num_bytes] = (uint8_t)crc;
+    frame[MSG_HEADER_SIZE + num_bytes + 1] = (uint8_t)(crc >> 8);
+
+    queue_frame(&uplink, frame, MSG_HEADER_SIZE + num_bytes + MSG_CRC_SIZE);
+}
+
+//******************************************************************************
+// Acknowledge everything the GUI has so far.
+static void gui_acknowledge(void)
+{
+    glo_bulk_ack_t ack;
+    memset(&ack, 0, sizeof(ack));
+    ack.transfer_id = gui.transfer.transfer_id;
+
+    uint32_t next = gui.transfer.first_instance;
+    while ((next <= gui.transfer.last_instance) && gui.have[next])
+    {
+        next++;
+    }
+    ack.next_instance = (uint16_t)next;
+    ack.newest_instance = gui.newest_instance;
+
+    for (uint32_t offset = 0; (offset < 64) && (next + offset <= gui.transfer.last_instance); ++offset)
+    {
+        if (!gui.have[next + offset])
+        {
+            ack.missing[offset / 32] |= 1u << (offset % 32);
+        }
+    }
+
+    gui_send(GLO_ID_BULK_ACK, &ack, sizeof(ack));
+    gui.num_acks++;
+}
+
+//******************************************************************************
+static void gui_receive(uint8_t id, uint16_t instance, uint8_t const * body, uint8_t num_bytes)
+{
+    switch (id)
+    {
+        case GLO_ID_LINK_MODE:
+            gui.link_mode_confirmed = true;
+            break;
+        case GLO_ID_BULK_TRANSFER:
+            memcpy(&gui.transfer, body, sizeof(gui.transfer));
+            gui.transfer_started = true;
+            if (gui.transfer.state == BULK_STATE_SENDING)
+            {
+                gui_acknowledge();
+            }
+            break;
+        case GLO_ID_CAPTURE_DATA:
+        {
+            // Instances stay in the glob until the next capture so they can be checked against it.
+            glo_capture_data_t expected;
+            glo_capture_data.read(&expected, instance);
+            if ((num_bytes != sizeof(expected)) || (memcmp(body, &expected, sizeof(expected)) != 0))
+            {
+                gui.num_bad_data++;
+                return;
+            }
+            gui.newest_instance = instance;
+            if (gui.have[instance])
+            {
+                gui.num_duplicates++;
+                return;
+            }
+            gui.have[instance] = true;
+            gui.num_unique++;
+            gui.last_data_seconds = sys_timer.seconds();
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+//******************************************************************************
+// Pass every glob in a complete frame to gui_receive().  Return true if it had capture data.
+static bool gui_handle_frame(uint8_t const * frame)
+{
+    uint8_t id = frame[MSG_ID_IDX];
+    uint8_t const * body = frame + MSG_HEADER_SIZE;
+
+    if (id != MSG_BATCH_ID)
+    {
+        gui_receive(id, frame[3] | (frame[4] << 8), body, frame[MSG_LENGTH_IDX]);
+        return id == GLO_ID_CAPTURE_DATA;
+    }
+
+    bool had_data = false;
+    uint16_t offset = 0;
+    for (uint8_t record = 0; record < frame[MSG_INSTANCE_IDX]; ++record)
+    {
+        uint8_t const * header = body + offset;
+        uint16_t first = header[1] | (header[2] << 8);
+        for (uint8_t i = 0; i < header[3]; ++i)
+        {
+            gui_receive(header[0], first + i, header + MSG_RECORD_HEADER_SIZE + i * header[4], header[4]);
+        }
+        had_data = had_data || (header[0] == GLO_ID_CAPTURE_DATA);
+        offset += MSG_RECORD_HEADER_SIZE + header[3] * header[4];
+    }
+    return had_data;
+}
+
+//******************************************************************************
+// Parse what the GUI has read off the pty (start byte framing), skipping anything that's corrupted.
+static void gui_parse(void)
+{
+    size_t start = 0;
+    while (gui.rx.size() - start >= MSG_HEADER_SIZE)
+    {
+        if (gui.rx[start] != MSG_START_BYTE)
+        {
+            start++;
+            continue;
+        }
+
+        size_t frame_size = MSG_HEADER_SIZE + gui.rx[start + MSG_LENGTH_IDX] + MSG_CRC_SIZE;
+        if (gui.rx.size() - start < frame_size)
+        {
+            break; // rest hasn't arrived yet
+        }
+
+        uint8_t const * frame = &gui.rx[start];
+        uint16_t crc = crc_final(crc_update(crc_init(), frame, frame_size - MSG_CRC_SIZE));
+        if ((frame[frame_size - 2] != (uint8_t)crc) || (frame[frame_size - 1] != (uint8_t)(crc >> 8)))
+        {
+            start++; // look for the next start byte
+            continue;
+        }
+
+        bool had_data = gui_handle_frame(frame);
+        if (had_data && gui.transfer_started && (gui.transfer.state == BULK_STATE_SENDING))
+        {
+            gui_acknowledge();
+        }
+        start += frame_size;
+    }
+    gui.rx.erase(gui.rx.begin(), gui.rx.begin() + start);
+}
+
+// Moves frames over the pty once they're done going over the wire and plays the GUI.
+class LoopbackTask : public Scheduler::PeriodicTask
+{
+  public: // methods
+
+    LoopbackTask(bool reliable) :
+        PeriodicTask("Loopback", TASK_ID_STATUS_UPDATE, 1000),
+        reliable_(reliable),
+        link_mode_retry_seconds_(0),
+        capture_retry_seconds_(0)
+    {
+    }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        double now = sys_timer.seconds();
+
+        while (!uplink.frames.empty() && (uplink.frames.front().arrive_seconds <= now))
+        {
+            std::vector<uint8_t> bytes = through_pty(gui_fd, robot_fd, uplink.frames.front().bytes);
+            Usart::instance(USART_BUS_2)->hostReceive(&bytes[0], bytes.size());
+            uplink.frames.pop_front();
+        }
+
+        while (!downlink.frames.empty() && (downlink.frames.front().arrive_seconds <= now))
+        {
+            std::vector<uint8_t> bytes = through_pty(robot_fd, gui_fd, downlink.frames.front().bytes);
+            gui.rx.insert(gui.rx.end(), bytes.begin(), bytes.end());
+            downlink.frames.pop_front();
+            gui_parse();
+        }
+
+        // What the GUI sends can be lost too, so it asks again if nothing happens.
+        if (!gui.link_mode_confirmed && (now >= link_mode_retry_seconds_))
+        {
+            glo_link_mode_t mode;
+            mode.framing = LINK_FRAMING_START_BYTE;
+            mode.batch_frames = true;
+            mode.reliable_bulk = reliable_;
+            gui_send(GLO_ID_LINK_MODE, &mode, sizeof(mode));
+            link_mode_retry_seconds_ = now + 0.5;
+        }
+        else if (gui.link_mode_confirmed && (gui.dump_start_seconds == 0) && (now >= capture_retry_seconds_))
+        {
+            glo_capture_command_t command;
+            memset(&command, 0, sizeof(command));
+            command.is_start = true;
+            command.desired_samples = num_samples;
+            gui_send(GLO_ID_CAPTURE_COMMAND, &command, sizeof(command));
+
+            // Long enough to capture everything at the main control task's 1 kHz.
+            capture_retry_seconds_ = now + num_samples / 1000.0 + 1.0;
+        }
+
+        // Reliable transfers stay queued until everything is acknowledged (or it fails).
+        bool all_sent = (gui.dump_start_seconds > 0) && (send_task.numQueued() == 0) &&
+                        downlink.frames.empty() && uplink.frames.empty();
+        if (all_sent)
+        {
+            gui.dump_finished = true;
+            host_stop_ticks = scheduler.currentTicks();
+        }
+    }
+
+  private: // fields
+
+    bool reliable_;
+    double link_mode_retry_seconds_;
+    double capture_retry_seconds_;
+
+};
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    loss_percent = (argc > 1) ? atof(argv[1]) : 5.0;
+    bool reliable = (argc > 2) ? (atoi(argv[2]) != 0) : true;
+    num_samples = (argc > 3) ? atoi(argv[3]) : 2000;
+    srand((argc > 4) ? atoi(argv[4]) : 1);
+
+    if (openpty(&robot_fd, &gui_fd, NULL, NULL, NULL) != 0)
+    {
+        perror("openpty");
+        return 1;
+    }
+    termios raw;
+    tcgetattr(gui_fd, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(gui_fd, TCSANOW, &raw);
+    fcntl(robot_fd, F_SETFL, O_NONBLOCK);
+    fcntl(gui_fd, F_SETFL, O_NONBLOCK);
+
+    gui.have.assign(glo_capture_data.get_num_instances() + 1, false);
+
+    LoopbackTask loopback_task(reliable);
+
+    host_tx_sink = send_frame;
+    host_tx_backlog = wire_backlog;
+    host_stop_ticks = (uint64_t)(MAX_SECONDS * sys_timer.frequency());
+
+    scheduler.registerTask(main_control_task);
+    scheduler.registerTask(loopback_task);
+    scheduler.registerTask(receive_task);
+    scheduler.registerTask(send_task);
+
+    scheduler.scheduleTasks();
+
+    if (gui.dump_start_seconds == 0)
+    {
+        printf("Robot never started sending the dump\n");
+        return 1;
+    }
+
+    double elapsed = gui.last_data_seconds - gui.dump_start_seconds;
+    double unique_bytes = (double)gui.num_unique * sizeof(glo_capture_data_t);
+
+    // What the robot announced last, in case the GUI missed it.
+    glo_bulk_transfer_t transfer;
+    glo_bulk_transfer.read(&transfer);
+
+    printf("%s transfer, %.1f%% of frames corrupted each way, %u samples of %u bytes over a %.0f bytes/s link\n",
+           reliable ? "Reliable" : "Fire-and-forget", loss_percent, num_samples, (unsigned)sizeof(glo_capture_data_t),
+           LINK_BYTES_PER_SECOND);
+    if (!gui.dump_finished)
+    {
+        printf("Dump didn't finish in %.0f seconds\n", MAX_SECONDS);
+    }
+    else if (reliable)
+    {
+        printf("Transfer %s: %u sent, %u sent again\n", (transfer.state == BULK_STATE_DONE) ? "done" : "failed",
+               transfer.num_sent, transfer.num_resent);
+    }
+    printf("Samples received:  %u of %u (%.2f%%), %u duplicates, %u bad\n", gui.num_unique, num_samples,
+           100.0 * gui.num_unique / num_samples, gui.num_duplicates, gui.num_bad_data);
+    printf("Time:              %.3f s\n", elapsed);
+    printf("Goodput:           %.0f bytes/s (%.1f%% of the link)\n", unique_bytes / elapsed,
+           100.0 * unique_bytes / elapsed / LINK_BYTES_PER_SECOND);
+    printf("Robot to GUI:      %u frames, %llu bytes, %u corrupted\n", downlink.num_frames,
+           (unsigned long long)downlink.num_bytes, downlink.num_corrupted);
+    printf("GUI to robot:      %u frames (%u acknowledgements), %llu bytes, %u corrupted\n", uplink.num_frames,
+           gui.num_acks, (unsigned long long)uplink.num_bytes, uplink.num_corrupted);
+
+    bool passed = gui.dump_finished && (gui.num_bad_data == 0) &&
+                  (!reliable || ((transfer.state == BULK_STATE_DONE) && (gui.num_unique == num_samples)));
+    return passed ? 0 : 1;
+}
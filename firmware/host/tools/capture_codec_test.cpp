@@ -0,0 +1,240 @@
+// Round trip test of the quantized capture formats (see CaptureEncoder and glo_capture_format_t).
+// Synthetic signals like the default capture channels (tilt, wave, duties, distances and speeds at the
+// control rate) are packed into capture data instances the way the main control task does it and
+// unpacked with CaptureDecoder:
+//
+//  - int16 has to come back within half a step of every value that's in range.
+//  - int16 delta has to match an independent model of the clamped deltas exactly.  How far it's off
+//    from the real values (e.g. after the wave steps) is only reported.
+//  - Values out of range have to come back clamped to the ends and not a number has to come back as zero.
+//
+// Also prints how many samples fit in the capture data instances and what they take on the wire.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/capture_codec_test.cpp -o capture_codec_test
+*/
+// Usage: capture_codec_test [number of samples] [random seed]   (defaults to 20000 and 1)
+
+// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "capture_codec.h"
+#include "glo_frame.h"
+#include "glob_types.h"
+
+// Default capture channels and how finely the GUI would want each one.
+const uint8_t NUM_CHANNELS = 8;
+static char const * const channel_names[NUM_CHANNELS] = { "tilt", "wave", "left duty", "right duty",
+                                                          "left distance", "right distance", "left speed", "right speed" };
+static float const channel_scales[NUM_CHANNELS] = { 1e-4f, 1e-3f, 1e-4f, 1e-4f, 1e-3f, 1e-3f, 1e-3f, 1e-3f };
+static float const channel_zeros[NUM_CHANNELS] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// Capture rate, and how many capture data instances there are (one isn't used).
+const float SAMPLE_HZ = 1000.0f;
+const uint16_t NUM_INSTANCES = 2000;
+
+// Bytes per second on a 115200 baud 8N1 link.
+const double LINK_BYTES_PER_SECOND = 115200.0 / 10.0;
+
+//******************************************************************************
+static float noise(float amplitude)
+{
+    return amplitude * (2.0f * rand() / (float)RAND_MAX - 1.0f);
+}
+
+//******************************************************************************
+// Fill 'values' with 'num_samples' samples of every channel, one sample after another.
+static void make_signals(std::vector<float> & values, uint32_t num_samples)
+{
+    values.resize(num_samples * NUM_CHANNELS);
+    for (uint32_t n = 0; n < num_samples; ++n)
+    {
+        float t = n / SAMPLE_HZ;
+        float * sample = &values[n * NUM_CHANNELS];
+        sample[0] = 0.05f * sinf(2.0f * (float)M_PI * 1.3f * t) + noise(0.0005f);
+        sample[1] = (fmodf(t, 0.5f) < 0.25f) ? 0.2f : -0.2f;
+        sample[2] = 0.3f * sinf(2.0f * (float)M_PI * 1.0f * t) + noise(0.002f);
+        sample[3] = 0.3f * sinf(2.0f * (float)M_PI * 1.0f * t + 0.3f) + noise(0.002f);
+        sample[4] = 0.3f * t + 0.02f * sinf(2.0f * (float)M_PI * 0.5f * t);
+        sample[5] = 0.29f * t + 0.02f * sinf(2.0f * (float)M_PI * 0.5f * t + 0.1f);
+        sample[6] = 0.3f + 0.2f * sinf(2.0f * (float)M_PI * 3.0f * t) + noise(0.005f);
+        sample[7] = 0.3f + 0.2f * sinf(2.0f * (float)M_PI * 3.0f * t + 0.2f) + noise(0.005f);
+    }
+}
+
+//******************************************************************************
+// Pack 'values' into capture data instances like the main control task, including a partly full last
+// one, then unpack them into 'decoded'.  Return samples per instance, or zero if the encoder refused.
+static uint8_t round_trip(std::vector<float> const & values, uint8_t num_channels, float const * scales,
+                          float const * zeros, bool delta, std::vector<float> & decoded)
+{
+    uint32_t num_samples = values.size() / num_channels;
+
+    CaptureEncoder encoder;
+    if (!encoder.configure(num_channels, scales, zeros, delta, CAPTURE_MAX_CHANNEL_BYTES))
+    {
+        return 0;
+    }
+    uint8_t samples_per_instance = encoder.samplesPerBlock();
+
+    std::vector<glo_capture_data_t> instances;
+    glo_capture_data_t instance;
+    memset(&instance, 0xA5, sizeof(instance));
+    for (uint32_t n = 0; n < num_samples; ++n)
+    {
+        if (encoder.add(&values[n * num_channels], instance.data))
+        {
+            instances.push_back(instance);
+        }
+    }
+    if (encoder.numInBlock() > 0)
+    {
+        instances.push_back(instance);
+    }
+
+    decoded.assign(num_samples * num_channels, 0.0f);
+    for (uint32_t i = 0; i < instances.size(); ++i)
+    {
+        uint32_t first = i * samples_per_instance;
+        uint8_t count = (uint8_t)std::min<uint32_t>(samples_per_instance, num_samples - first);
+        CaptureDecoder::decode(instances[i].data, count, num_channels, scales, zeros, delta, &decoded[first * num_channels]);
+    }
+
+    return samples_per_instance;
+}
+
+//******************************************************************************
+// Model of what delta encoding should give back: clamped changes that catch up over the next samples.
+static void delta_model(std::vector<float> const & values, uint8_t samples_per_instance, std::vector<float> & expected)
+{
+    uint32_t num_samples = values.size() / NUM_CHANNELS;
+    expected.resize(values.size());
+
+    int32_t last[NUM_CHANNELS];
+    for (uint32_t n = 0; n < num_samples; ++n)
+    {
+        for (uint8_t i = 0; i < NUM_CHANNELS; ++i)
+        {
+            float steps = (values[n * NUM_CHANNELS + i] - channel_zeros[i]) * (1.0f / channel_scales[i]);
+            int32_t target = (int32_t)lroundf(std::max(-32767.0f, std::min(32767.0f, steps)));
+            if ((n % samples_per_instance) == 0)
+            {
+                last[i] = target;
+            }
+            else
+            {
+                last[i] += std::max(-127, std::min(127, target - last[i]));
+            }
+            expected[n * NUM_CHANNELS + i] = channel_zeros[i] + channel_scales[i] * last[i];
+        }
+    }
+}
+
+//******************************************************************************
+// Print the error of each channel in steps.  Return the most that any channel was off.
+static double print_errors(std::vector<float> const & values, std::vector<float> const & decoded)
+{
+    uint32_t num_samples = values.size() / NUM_CHANNELS;
+    double worst = 0;
+    for (uint8_t i = 0; i < NUM_CHANNELS; ++i)
+    {
+        double max_steps = 0;
+        double sum_squares = 0;
+        uint32_t num_off = 0;
+        for (uint32_t n = 0; n < num_samples; ++n)
+        {
+            double steps = fabs((double)decoded[n * NUM_CHANNELS + i] - values[n * NUM_CHANNELS + i]) / channel_scales[i];
+            max_steps = std::max(max_steps, steps);
+            sum_squares += steps * steps;
+            num_off += (steps > 0.5 + 1e-3) ? 1 : 0;
+        }
+        printf("  %-15s %12.3f %12.3f %12u\n", channel_names[i], max_steps, sqrt(sum_squares / num_samples), num_off);
+        worst = std::max(worst, max_steps);
+    }
+    return worst;
+}
+
+//******************************************************************************
+static void print_sizes(char const * name, uint16_t data_bytes, uint8_t samples_per_instance)
+{
+    uint16_t instance_bytes = sizeof(float) + data_bytes;
+    double single_bytes = (double)(MSG_HEADER_SIZE + instance_bytes + MSG_CRC_SIZE) / samples_per_instance;
+    uint16_t per_batch = (MSG_MAX_BODY_SIZE - MSG_RECORD_HEADER_SIZE) / instance_bytes;
+    double batch_bytes = (double)(MSG_HEADER_SIZE + MSG_RECORD_HEADER_SIZE + per_batch * instance_bytes + MSG_CRC_SIZE) /
+                         (per_batch * samples_per_instance);
+    uint32_t capacity = (uint32_t)NUM_INSTANCES * samples_per_instance;
+    printf("%-12s %10u %10u %10u %12.2f %12.2f %12.2f\n", name, instance_bytes, samples_per_instance, capacity,
+           single_bytes, batch_bytes, capacity * batch_bytes / LINK_BYTES_PER_SECOND);
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_samples = (argc > 1) ? atoi(argv[1]) : 20000;
+    srand((argc > 2) ? atoi(argv[2]) : 1);
+
+    std::vector<float> values;
+    make_signals(values, num_samples);
+    bool passed = true;
+
+    printf("%u samples of %u channels at %.0f Hz\n\n", num_samples, NUM_CHANNELS, SAMPLE_HZ);
+
+    std::vector<float> decoded;
+    uint8_t int16_per_instance = round_trip(values, NUM_CHANNELS, channel_scales, channel_zeros, false, decoded);
+    printf("int16 error in steps\n  %-15s %12s %12s %12s\n", "Channel", "Max", "RMS", "Over half");
+    double worst = print_errors(values, decoded);
+    bool int16_passed = (int16_per_instance > 0) && (worst <= 0.5 + 1e-3);
+    printf("  %s\n\n", int16_passed ? "passed" : "FAILED");
+    passed = passed && int16_passed;
+
+    uint8_t delta_per_instance = round_trip(values, NUM_CHANNELS, channel_scales, channel_zeros, true, decoded);
+    printf("int16 delta error in steps\n  %-15s %12s %12s %12s\n", "Channel", "Max", "RMS", "Over half");
+    print_errors(values, decoded);
+    std::vector<float> expected;
+    delta_model(values, delta_per_instance, expected);
+    uint32_t num_mismatched = 0;
+    for (uint32_t i = 0; i < values.size(); ++i)
+    {
+        num_mismatched += (decoded[i] != expected[i]) ? 1 : 0;
+    }
+    bool delta_passed = (delta_per_instance > 0) && (num_mismatched == 0);
+    printf("  %u values don't match the model - %s\n\n", num_mismatched, delta_passed ? "passed" : "FAILED");
+    passed = passed && delta_passed;
+
+    // Ends of the range and values that aren't numbers.
+    float const edge_scale[2] = { 0.01f, 0.01f };
+    float const edge_zero[2] = { 1.0f, -2.0f };
+    std::vector<float> edges = { 1e9f, -1e9f, -1e9f, NAN, 1.0f + 327.67f, -2.0f - 327.67f, NAN, INFINITY };
+    std::vector<float> edges_expected = { 1.0f + 327.67f, -2.0f - 327.67f, 1.0f - 327.67f, -2.0f,
+                                          1.0f + 327.67f, -2.0f - 327.67f, 1.0f, -2.0f + 327.67f };
+    round_trip(edges, 2, edge_scale, edge_zero, false, decoded);
+    bool edges_passed = true;
+    for (uint32_t i = 0; i < edges.size(); ++i)
+    {
+        edges_passed = edges_passed && (fabsf(decoded[i] - edges_expected[i]) < 1e-3f);
+    }
+    float const zero_scale[2] = { 1.0f, 0.0f };
+    edges_passed = edges_passed && (round_trip(edges, 2, zero_scale, edge_zero, false, decoded) == 0);
+    printf("Clamping, not a number and zero scale - %s\n\n", edges_passed ? "passed" : "FAILED");
+    passed = passed && edges_passed;
+
+    printf("%-12s %10s %10s %10s %12s %12s %12s\n", "Format", "Instance", "Samples", "Capacity", "Bytes per", "Bytes per", "Full dump");
+    printf("%-12s %10s %10s %10s %12s %12s %12s\n", "", "bytes", "per inst", "", "sample", "sample", "seconds");
+    printf("%-12s %10s %10s %10s %12s %12s %12s\n", "", "", "", "", "(1/frame)", "(batched)", "(batched)");
+    print_sizes("raw", NUM_CHANNELS * sizeof(float), 1);
+    CaptureEncoder encoder;
+    encoder.configure(NUM_CHANNELS, channel_scales, channel_zeros, false, CAPTURE_MAX_CHANNEL_BYTES);
+    print_sizes("int16", encoder.usedBytes(), encoder.samplesPerBlock());
+    encoder.configure(NUM_CHANNELS, channel_scales, channel_zeros, true, CAPTURE_MAX_CHANNEL_BYTES);
+    print_sizes("int16 delta", encoder.usedBytes(), encoder.samplesPerBlock());
+
+    printf("\n%s\n", passed ? "All passed" : "FAILED");
+    return passed ? 0 : 1;
+}
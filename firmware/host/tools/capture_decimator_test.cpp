@@ -0,0 +1,311 @@
+// Test of the anti-aliasing filter that data capture uses below the control rate (see CaptureDecimator).
+//
+//  - The filter design has to match a double precision design with the C library's sine to within 1e-6,
+//    since it uses its own sine so the robot and host get the same coefficients.  It also has to lose
+//    less than 0.1 dB at 20% of the output rate and cut everything from 60% of it up by 40 dB or more.
+//    That's checked for every factor up to DECIMATOR_MAX_FACTOR, which is the slowest a filtered capture
+//    can go, and bigger factors have to be turned down.
+//  - Filtered samples have to be bit for bit the same as a plain FIR over every input that's only
+//    summed at the kept ones, for several factors and channels at once.
+//  - A chirp from zero to half the control rate is captured at lower rates by just keeping every Nth
+//    input (what capture did before) and by filtering first.  Where the chirp is at 60% of the capture
+//    rate or more it would fold back below 40%, so the biggest sample there is how much aliasing got in.
+//    Filtering has to cut that by 40 dB or more, again for every factor up to DECIMATOR_MAX_FACTOR.
+//
+// Only some factors are printed, along with the worst of all of them.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -ffp-contract=off -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/capture_decimator_test.cpp -o capture_decimator_test
+*/
+// Usage: capture_decimator_test [chirp seconds] [random seed]   (defaults to 600 and 1)
+
+// Includes
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "capture_decimator.h"
+
+// Control rate the inputs are taken at.
+const double INPUT_HZ = 1000.0;
+
+// Factors that are printed and checked bit for bit, which are capture rates of 500 Hz down to about 16 Hz
+// (the slowest filtered capture at this input rate).
+static uint16_t const factors[] = { 2, 3, 4, 5, 8, 10, 16, 25, 50, 62, 64 };
+const uint8_t NUM_FACTORS = sizeof(factors) / sizeof(factors[0]);
+
+// Aliasing has to be cut at least this much, and samples at 20% of the output rate lose at most this much.
+const double MIN_SUPPRESSION_DB = 40.0;
+const double MAX_DROOP_DB = 0.1;
+
+//******************************************************************************
+static double to_db(double gain)
+{
+    return 20.0 * log10((gain > 1e-12) ? gain : 1e-12);
+}
+
+//******************************************************************************
+// Return the same filter as CaptureDecimator::design() done in double precision with the C library.
+static std::vector<double> reference_design(uint16_t factor)
+{
+    uint32_t num_taps = DECIMATOR_TAPS_PER_OUTPUT * factor;
+
+    std::vector<double> coefficients(num_taps);
+    double cutoff = 0.4 / factor;
+    double middle = (num_taps - 1) * 0.5;
+    double sum = 0;
+    for (uint32_t n = 0; n < num_taps; ++n)
+    {
+        double from_middle = n - middle;
+        double sinc = (from_middle == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * from_middle) / (M_PI * from_middle);
+        coefficients[n] = sinc * (0.54 - 0.46 * cos(2 * M_PI * n / (num_taps - 1)));
+        sum += coefficients[n];
+    }
+    for (uint32_t n = 0; n < num_taps; ++n)
+    {
+        coefficients[n] /= sum;
+    }
+    return coefficients;
+}
+
+//******************************************************************************
+// Return the gain of 'coefficients' at 'frequency' cycles per input.
+static double gain_at(float const * coefficients, uint16_t num_taps, double frequency)
+{
+    double re = 0, im = 0;
+    for (uint16_t n = 0; n < num_taps; ++n)
+    {
+        re += coefficients[n] * cos(2 * M_PI * frequency * n);
+        im -= coefficients[n] * sin(2 * M_PI * frequency * n);
+    }
+    return sqrt(re * re + im * im);
+}
+
+//******************************************************************************
+// Return true if 'factor' is one of the ones that are printed.
+static bool listed(uint16_t factor)
+{
+    for (uint8_t f = 0; f < NUM_FACTORS; ++f)
+    {
+        if (factors[f] == factor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//******************************************************************************
+static bool check_design(void)
+{
+    bool passed = true;
+
+    double worst_sine = 0;
+    for (int32_t i = -40000; i <= 40000; ++i)
+    {
+        float x = i * 1e-4f;
+        worst_sine = fmax(worst_sine, fabs(CaptureDecimator::sinPi(x) - sin(M_PI * (double)x)));
+    }
+    printf("Sine from -4 to 4 pi: max error %.2g\n", worst_sine);
+    passed = passed && (worst_sine < 1e-6);
+
+    double worst_droop = 0;
+    double worst_stop = -1000;
+    for (uint16_t factor = 2; factor <= DECIMATOR_MAX_FACTOR; ++factor)
+    {
+        float coefficients[DECIMATOR_MAX_TAPS];
+        uint16_t num_taps = CaptureDecimator::design(factor, coefficients);
+        std::vector<double> reference = reference_design(factor);
+
+        double worst = (num_taps == reference.size()) ? 0 : 1;
+        for (uint16_t n = 0; (n < num_taps) && (n < reference.size()); ++n)
+        {
+            worst = fmax(worst, fabs(coefficients[n] - reference[n]));
+        }
+
+        double cutoff = 1.0 / factor; // output rate in cycles per input
+        double stop = 0;
+        for (double frequency = 0.6 * cutoff; frequency <= 0.5; frequency += 1e-4)
+        {
+            stop = fmax(stop, gain_at(coefficients, num_taps, frequency));
+        }
+        double droop = -to_db(gain_at(coefficients, num_taps, 0.2 * cutoff));
+        worst_droop = fmax(worst_droop, droop);
+        worst_stop = fmax(worst_stop, to_db(stop));
+
+        bool ok = (worst < 1e-6) && (droop <= MAX_DROOP_DB) && (to_db(stop) <= -MIN_SUPPRESSION_DB);
+        if (listed(factor) || !ok)
+        {
+            printf("Factor %2u: %3u taps, max error %.2g, gain at 0.2/0.3/0.4 of output rate %5.2f/%5.2f/%5.2f dB, "
+                   "above 0.6 %6.1f dB%s\n", factor, num_taps, worst, -droop,
+                   to_db(gain_at(coefficients, num_taps, 0.3 * cutoff)),
+                   to_db(gain_at(coefficients, num_taps, 0.4 * cutoff)), to_db(stop), ok ? "" : "  FAILED");
+        }
+        passed = passed && ok;
+    }
+    printf("Factors 2 to %u: worst gain at 0.2 of output rate %5.2f dB, above 0.6 %6.1f dB\n",
+           DECIMATOR_MAX_FACTOR, -worst_droop, worst_stop);
+
+    // Anything slower has to be turned down rather than filtered with too short a filter.
+    CaptureDecimator decimator;
+    bool rejected = !decimator.configure(1, DECIMATOR_MAX_FACTOR + 1) && (decimator.factor() == 1);
+    printf("Factor %u: %s\n", DECIMATOR_MAX_FACTOR + 1, rejected ? "rejected" : "NOT REJECTED");
+    passed = passed && rejected;
+
+    return passed;
+}
+
+//******************************************************************************
+// Filter 'inputs' ('num_channels' per input) with a plain FIR, keeping the first input and every 'factor'th
+// one after it.  Inputs before the first are the same as it, which starts a sum with the missing part of the
+// filter times the first input.  Sums in the same order as CaptureDecimator.
+static std::vector<float> reference_filter(std::vector<float> const & inputs, uint8_t num_channels, uint16_t factor,
+                                           float const * coefficients, uint16_t num_taps)
+{
+    std::vector<float> outputs;
+    uint32_t num_inputs = inputs.size() / num_channels;
+    for (uint32_t n = 0; n < num_inputs; n += factor)
+    {
+        int32_t first_input = (int32_t)n - (num_taps - 1);
+        uint16_t num_past = (first_input < 0) ? (uint16_t)-first_input : 0;
+        for (uint8_t i = 0; i < num_channels; ++i)
+        {
+            float sum = (num_past > 0) ? CaptureDecimator::sumOf(coefficients, num_past) * inputs[i] : 0.0f;
+            for (uint16_t k = num_past; k < num_taps; ++k)
+            {
+                sum += coefficients[k] * inputs[(first_input + k) * num_channels + i];
+            }
+            outputs.push_back(sum);
+        }
+    }
+    return outputs;
+}
+
+//******************************************************************************
+static bool check_bit_exact(uint32_t num_inputs)
+{
+    // Noise, a step, a ramp and a fast sine on top of an offset, like a mix of capture channels.
+    const uint8_t num_channels = 4;
+    std::vector<float> inputs(num_inputs * num_channels);
+    for (uint32_t n = 0; n < num_inputs; ++n)
+    {
+        float * sample = &inputs[n * num_channels];
+        sample[0] = 2.0f * rand() / (float)RAND_MAX - 1.0f;
+        sample[1] = (n < num_inputs / 3) ? -3.0f : 12.5f;
+        sample[2] = 0.01f * n;
+        sample[3] = 100.0f + (float)sin(2 * M_PI * 0.37 * n);
+    }
+
+    bool passed = true;
+    for (uint8_t f = 0; f <= NUM_FACTORS; ++f)
+    {
+        uint16_t factor = (f == 0) ? 1 : factors[f - 1];
+
+        CaptureDecimator decimator;
+        decimator.configure(num_channels, factor);
+        std::vector<float> outputs;
+        for (uint32_t n = 0; n < num_inputs; ++n)
+        {
+            float sample[num_channels];
+            if (decimator.add(&inputs[n * num_channels], sample))
+            {
+                outputs.insert(outputs.end(), sample, sample + num_channels);
+            }
+        }
+
+        std::vector<float> reference = reference_filter(inputs, num_channels, factor, decimator.coefficients(), decimator.numTaps());
+        bool same = (outputs.size() == reference.size()) &&
+                    (memcmp(outputs.data(), reference.data(), outputs.size() * sizeof(float)) == 0);
+        printf("Factor %2u: %6u outputs of %u channels %s\n", factor, (unsigned)(outputs.size() / num_channels),
+               num_channels, same ? "bit exact" : "DIFFERENT");
+        passed = passed && same;
+    }
+
+    return passed;
+}
+
+//******************************************************************************
+static bool check_chirp(double seconds)
+{
+    // Linear chirp from 0 Hz to half the input rate.
+    uint32_t num_inputs = (uint32_t)(seconds * INPUT_HZ);
+    double sweep_rate = 0.5 * INPUT_HZ / seconds; // [Hz / sec]
+    std::vector<float> chirp(num_inputs);
+    for (uint32_t n = 0; n < num_inputs; ++n)
+    {
+        double t = n / INPUT_HZ;
+        chirp[n] = (float)sin(M_PI * sweep_rate * t * t);
+    }
+
+    printf("Chirp 0 to %.0f Hz over %.0f seconds, biggest sample where it's 60%% of the capture rate or more:\n",
+           0.5 * INPUT_HZ, seconds);
+
+    bool passed = true;
+    double least_suppression = 1000;
+    for (uint16_t factor = 2; factor <= DECIMATOR_MAX_FACTOR; ++factor)
+    {
+        double capture_hz = INPUT_HZ / factor;
+        double alias_hz = 0.6 * capture_hz;
+
+        CaptureDecimator decimator;
+        decimator.configure(1, factor);
+
+        double kept_peak = 0;
+        double filtered_peak = 0;
+        for (uint32_t n = 0; n < num_inputs; ++n)
+        {
+            float filtered;
+            if (!decimator.add(&chirp[n], &filtered))
+            {
+                continue;
+            }
+
+            // Filtered samples are centered on an earlier input.  Leave out the very end where the
+            // filter would need inputs past half the input rate.
+            double kept_hz = sweep_rate * n / INPUT_HZ;
+            double filtered_hz = sweep_rate * (n - decimator.delay()) / INPUT_HZ;
+            if ((kept_hz >= alias_hz) && (kept_hz < 0.49 * INPUT_HZ))
+            {
+                kept_peak = fmax(kept_peak, fabs(chirp[n]));
+            }
+            if ((filtered_hz >= alias_hz) && (filtered_hz < 0.49 * INPUT_HZ))
+            {
+                filtered_peak = fmax(filtered_peak, fabs(filtered));
+            }
+        }
+
+        double suppression = to_db(kept_peak) - to_db(filtered_peak);
+        bool ok = (suppression >= MIN_SUPPRESSION_DB);
+        if (listed(factor) || !ok)
+        {
+            printf("  %5.1f Hz (factor %2u, %3u taps): every Nth %6.1f dB, filtered %6.1f dB, %5.1f dB less%s\n",
+                   capture_hz, factor, decimator.numTaps(), to_db(kept_peak), to_db(filtered_peak), suppression,
+                   ok ? "" : "  FAILED");
+        }
+        least_suppression = fmin(least_suppression, suppression);
+        passed = passed && ok;
+    }
+    printf("  Factors 2 to %u: at least %.1f dB less\n", DECIMATOR_MAX_FACTOR, least_suppression);
+
+    return passed;
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 600.0;
+    srand((argc > 2) ? atoi(argv[2]) : 1);
+
+    bool design_passed = check_design();
+    bool exact_passed = check_bit_exact(20000);
+    bool chirp_passed = check_chirp(seconds);
+
+    printf("Design %s, bit exact %s, aliasing %s\n", design_passed ? "passed" : "FAILED",
+           exact_passed ? "passed" : "FAILED", chirp_passed ? "passed" : "FAILED");
+
+    return (design_passed && exact_passed && chirp_passed) ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+// Measures how late MainControlTask starts each period and the sensor to PWM latency with the full task set
+// taking time to run, while a streaming data capture keeps the stream and send tasks busy.  The host sim
+// normally runs tasks in no time at all, which makes both look perfect.  Here each task takes as long as
+// its recent runs took on the PC times how much slower the robot is (see host_task_work), with systick and
+// the preemptive tier running in the middle of it.  Recent is the median of the last few runs, since a
+// single slow run on the PC (e.g. a cache miss or another process) would be a huge one on the robot.
+//
+// Run it once with main control in the preemptive tier (how the robot runs it) and once as a normal task
+// to see what the preemptive tier buys.  Masking interrupts or the preemptive tier still takes no time
+// here, so on the robot the preemptive tier can also be late by up to the longest time either is masked
+// (see MEASURE_INTERRUPTS_DISABLED in scheduler.h).
+//
+// Add -DCONTROL_ON_NEW_DATA to run main control on every new attitude estimate at the filter's rate instead
+// of on its own timer (see MainControlTask) to compare the sensor to PWM latency.  Its timer is only a
+// timeout then, so how late it starts isn't reported.
+//
+// The PC's timing changes from run to run, so the numbers do too.  Compare the modeled run times it prints
+// to the task timing the GUI shows for the robot to pick the slowdown.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/control_jitter.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+       host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+       scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+       libraries/glo_link/[a-z]*.cpp \
+       libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+       libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+       embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+       -o control_jitter
+*/
+// Usage: control_jitter [preemptive|cooperative] [robot slowdown] [simulated seconds]
+//        (defaults to preemptive, 100 and 60)
+
+// Includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "debug_printf.h"
+#include "globs.h"
+#include "host_port.h"
+#include "scheduler.h"
+#include "util_assert.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Same setup as the robot (see embitz_projects/eeva_full_version/source/main.cpp)
+SystemTimer sys_timer(1000);
+#ifdef CONTROL_ON_NEW_DATA
+MainControlTask          main_control_task    (500, true); // Must match filter rate.
+#else
+MainControlTask          main_control_task   (1000);
+#endif
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+// Leave out the first second so every task has a PC time to go by.
+const double WARM_UP_SECONDS = 1.0;
+
+// How many times slower the robot runs the same code than the PC.
+static double robot_slowdown = 100.0;
+
+// How many of each task's last PC run times to take the median of.
+const uint32_t NUM_RECENT_RUNS = 5;
+
+// Modeled run times of every task, in ticks.
+struct work_stats_t
+{
+    Scheduler::Task const * task;
+    double recent_pc_seconds[NUM_RECENT_RUNS];
+    uint64_t num_runs;
+    uint64_t sum_ticks;
+    uint64_t max_ticks;
+};
+static std::vector<work_stats_t> work_stats;
+
+// How many ticks after it was due each run of main control started.
+static std::vector<uint32_t> control_late_ticks;
+
+//*****************************************************************************
+static uint64_t task_work(Scheduler::Task const & task, double pc_seconds)
+{
+    work_stats_t * stats = NULL;
+    for (uint32_t i = 0; i < work_stats.size(); ++i)
+    {
+        if (work_stats[i].task == &task)
+        {
+            stats = &work_stats[i];
+        }
+    }
+    if (stats == NULL)
+    {
+        work_stats_t new_stats;
+        memset(&new_stats, 0, sizeof(new_stats));
+        new_stats.task = &task;
+        work_stats.push_back(new_stats);
+        stats = &work_stats.back();
+    }
+
+    // Oldest run is dropped for the one that just finished.
+    memmove(&stats->recent_pc_seconds[0], &stats->recent_pc_seconds[1],
+            (NUM_RECENT_RUNS - 1) * sizeof(stats->recent_pc_seconds[0]));
+    stats->recent_pc_seconds[NUM_RECENT_RUNS - 1] = pc_seconds;
+
+    double sorted_pc_seconds[NUM_RECENT_RUNS];
+    memcpy(sorted_pc_seconds, stats->recent_pc_seconds, sizeof(sorted_pc_seconds));
+    std::sort(sorted_pc_seconds, sorted_pc_seconds + NUM_RECENT_RUNS);
+    double median_pc_seconds = sorted_pc_seconds[NUM_RECENT_RUNS / 2];
+
+    uint64_t work_ticks = (uint64_t)(median_pc_seconds * robot_slowdown * sys_timer.frequency());
+
+    if (sys_timer.seconds() < WARM_UP_SECONDS)
+    {
+        return work_ticks;
+    }
+
+#ifndef CONTROL_ON_NEW_DATA
+    if (&task == &main_control_task)
+    {
+        // Called right as it starts, before it decides when to run next.
+        control_late_ticks.push_back((uint32_t)(sys_timer.ticks() - main_control_task.nextRunTicks()));
+    }
+#endif
+
+    stats->num_runs++;
+    stats->sum_ticks += work_ticks;
+    stats->max_ticks = std::max(stats->max_ticks, work_ticks);
+
+    return work_ticks;
+}
+
+//*****************************************************************************
+static double to_microseconds(double ticks)
+{
+    return ticks * 1e6 / sys_timer.frequency();
+}
+
+//*****************************************************************************
+int main(int argc, char ** argv)
+{
+    bool preemptive = (argc <= 1) || (strcmp(argv[1], "cooperative") != 0);
+    robot_slowdown = (argc > 2) ? atof(argv[2]) : 100.0;
+    double simulated_seconds = (argc > 3) ? atof(argv[3]) : 60.0;
+
+    if ((argc > 1) && !preemptive && (strcmp(argv[1], "cooperative") != 0))
+    {
+        printf("Usage: %s [preemptive|cooperative] [robot slowdown] [simulated seconds]\n", argv[0]);
+        return 1;
+    }
+
+    host_task_work = task_work;
+    host_stop_ticks = (uint64_t)(simulated_seconds * sys_timer.frequency());
+
+    Scheduler::Task * tasks[] =
+    {
+        &comp_filter_task,
+        &send_task,
+        &receive_task,
+        &leds_task,
+        &modes_task,
+        &status_update_task,
+        &stream_task,
+    };
+
+    if (!preemptive)
+    {
+        // Highest priority normal task, which is how it ran before the preemptive tier.
+        scheduler.registerTask(main_control_task);
+    }
+    for (uint32_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); ++i)
+    {
+        scheduler.registerTask(*tasks[i]);
+    }
+    if (preemptive)
+    {
+        scheduler.registerPreemptiveTask(main_control_task);
+    }
+
+    // Stream the default capture channels at the control rate until the end.
+    glo_capture_command_t command;
+    memset(&command, 0, sizeof(command));
+    command.is_start = true;
+    command.stream = true;
+    main_control_task.handle(command);
+
+    scheduler.scheduleTasks();
+
+#ifdef CONTROL_ON_NEW_DATA
+    char const * trigger = "on new attitude";
+#else
+    char const * trigger = "on its timer";
+#endif
+    printf("Main control %s %s, robot %.0fx slower than the PC, %.0f s with a capture streaming (%.0f kB sent)\n",
+           preemptive ? "preemptive" : "cooperative", trigger, robot_slowdown, simulated_seconds,
+           host_bytes_sent / 1000.0);
+
+    printf("  %-16s %10s %10s %10s\n", "Modeled task", "Runs", "Avg us", "Max us");
+    for (uint32_t i = 0; i < work_stats.size(); ++i)
+    {
+        work_stats_t const & stats = work_stats[i];
+        printf("  %-16s %10llu %10.1f %10.1f\n", stats.task->name(), (unsigned long long)stats.num_runs,
+               to_microseconds((double)stats.sum_ticks / stats.num_runs), to_microseconds(stats.max_ticks));
+    }
+
+    std::vector<uint32_t> sorted = control_late_ticks;
+    std::sort(sorted.begin(), sorted.end());
+    if (!sorted.empty())
+    {
+        double sum = 0;
+        for (uint32_t i = 0; i < sorted.size(); ++i)
+        {
+            sum += sorted[i];
+        }
+        printf("Control start after it's due: avg %.1f us, median %.1f us, 99%% %.1f us, max %.1f us\n",
+               to_microseconds(sum / sorted.size()), to_microseconds(sorted[sorted.size() / 2]),
+               to_microseconds(sorted[sorted.size() * 99 / 100]), to_microseconds(sorted.back()));
+    }
+
+    printf("Sensor to PWM latency: avg %.1f us, max %.1f us\n",
+           to_microseconds(main_control_task.sensorToPwmTicksAvg()),
+           to_microseconds(main_control_task.sensorToPwmTicksMax()));
+
+    return 0;
+}
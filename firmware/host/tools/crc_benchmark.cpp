@@ -0,0 +1,149 @@
+// Checks crc_update() against a bit at a time reference and times it against the byte at a time table
+// loop it replaced, for the frame sizes the telemetry link sends most: 9 bytes (header and CRC around
+// a 0 byte body, e.g. a bare request), 60 bytes (status data) and 256 bytes (a large capture batch).
+// crc_update() is also checked when it's fed each frame in two pieces like GloTxLink does when a
+// frame wraps around the transfer buffer.
+//
+// The number of bytes per slice is picked at compile time, so build once per setting from the firmware
+// directory:
+/*
+   for n in 1 4 8; do
+     g++ -std=gnu++11 -O2 -DCRC_SLICE_BYTES=$n -Ilibraries/util/include \
+         host/tools/crc_benchmark.cpp libraries/util/crc.cpp -o crc_benchmark_$n
+   done
+*/
+// Usage: crc_benchmark [frames per size]   (defaults to 2000000)
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "crc.h"
+
+// Byte at a time table the firmware used before crc_update(), filled in by main().
+static uint16_t byte_table[256];
+
+//******************************************************************************
+static uint16_t reference_crc(uint8_t const * data, uint32_t size, uint16_t crc)
+{
+    while (size--)
+    {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+//******************************************************************************
+static uint16_t byte_table_crc(uint8_t const * data, uint32_t size, uint16_t crc)
+{
+    while (size--)
+    {
+        crc = (crc << 8) ^ byte_table[((crc >> 8) ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+//******************************************************************************
+static uint16_t sliced_crc(uint8_t const * data, uint32_t size, uint16_t crc)
+{
+    return crc_update(crc, data, size);
+}
+
+//******************************************************************************
+// Return false if crc_update() doesn't match the reference for every length and split point.
+static bool check(std::vector<uint8_t> const & data)
+{
+    uint8_t const check_string[] = "123456789";
+    if (crc_final(crc_update(crc_init(), check_string, 9)) != 0x29B1)
+    {
+        printf("Wrong CRC for check string\n");
+        return false;
+    }
+
+    for (uint32_t size = 0; size <= 300; ++size)
+    {
+        uint16_t expected = reference_crc(&data[0], size, 0xFFFF);
+        if ((byte_table_crc(&data[0], size, 0xFFFF) != expected) ||
+            (calculate_crc(&data[0], size, 0xFFFF) != expected))
+        {
+            printf("Wrong CRC for %u bytes\n", size);
+            return false;
+        }
+
+        for (uint32_t split = 0; split <= size; ++split)
+        {
+            uint16_t crc = crc_init();
+            crc = crc_update(crc, &data[0], split);
+            crc = crc_final(crc_update(crc, &data[split], size - split));
+            if (crc != expected)
+            {
+                printf("Wrong CRC for %u bytes split after %u\n", size, split);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//******************************************************************************
+// Return nanoseconds per frame.  The CRCs are summed so the calls can't be optimized away.
+static double time_frames(uint16_t (*crc_function)(uint8_t const *, uint32_t, uint16_t),
+                          std::vector<uint8_t> const & data, uint32_t frame_size, uint32_t num_frames,
+                          uint32_t * sum)
+{
+    uint32_t num_offsets = data.size() - frame_size;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_frames; ++i)
+    {
+        *sum += crc_function(&data[i % num_offsets], frame_size, 0xFFFF);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / num_frames;
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_frames = (argc > 1) ? atoi(argv[1]) : 2000000;
+
+    for (uint16_t byte = 0; byte < 256; ++byte)
+    {
+        uint8_t value = (uint8_t)byte;
+        byte_table[byte] = reference_crc(&value, 1, 0);
+    }
+
+    std::vector<uint8_t> data(4096);
+    srand(1);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)rand();
+    }
+
+    if (!check(data))
+    {
+        return 1;
+    }
+
+    printf("CRC_SLICE_BYTES %d, %u bytes of tables, matches reference\n", CRC_SLICE_BYTES, CRC_SLICE_BYTES * 512);
+    printf("%-12s %14s %12s %14s %12s %8s\n", "Frame bytes", "Table ns", "Table MB/s", "Sliced ns", "Sliced MB/s", "Speedup");
+
+    uint32_t sum = 0;
+    uint32_t const frame_sizes[] = { 9, 60, 256 };
+    for (uint32_t frame_size : frame_sizes)
+    {
+        double table_ns = time_frames(byte_table_crc, data, frame_size, num_frames, &sum);
+        double sliced_ns = time_frames(sliced_crc, data, frame_size, num_frames, &sum);
+        printf("%-12u %14.1f %12.0f %14.1f %12.0f %7.2fx\n", frame_size, table_ns, 1000.0 * frame_size / table_ns,
+               sliced_ns, 1000.0 * frame_size / sliced_ns, table_ns / sliced_ns);
+    }
+    printf("(checksum %u)\n", sum);
+
+    return 0;
+}
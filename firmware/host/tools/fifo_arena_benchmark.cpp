@@ -0,0 +1,261 @@
+// Checks FifoArena against a simple model and compares it to the SimpleArray of 256 byte slots the
+// send task used to save glob copies in.  It runs in three parts:
+//
+//   check     random allocate/free sequences (mostly in order, some out of order like when a higher
+//             telemetry class jumps ahead) verifying alignment, that blocks never overlap or get
+//             corrupted and that freeing everything leaves the whole arena free again
+//   capacity  how many copies of globs the send task saves (and a few others) fit in the same RAM
+//   timing    nanoseconds to save and free a copy with some already waiting
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -Iglobs/include -Ilibraries/util/include \
+       host/tools/fifo_arena_benchmark.cpp libraries/util/fifo_arena.cpp -o fifo_arena_benchmark
+*/
+// Usage: fifo_arena_benchmark [random check operations] [timing iterations]
+//        (default to 2000000 and 10000000)
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "fifo_arena.h"
+#include "glob_types.h"
+#include "simple_array.h"
+
+// Same RAM the send task used to have: 15 slots of the largest glob size.
+const uint32_t SLOT_SIZE = 256;
+const uint32_t NUM_SLOTS = 15;
+const uint32_t ARENA_BYTES = NUM_SLOTS * SLOT_SIZE;
+
+// What the send task used to store in its SimpleArray.
+struct slot_t
+{
+    uint8_t data[SLOT_SIZE];
+};
+
+// Block the check is keeping track of.
+struct model_block_t
+{
+    uint8_t * data;
+    uint32_t  size;
+    uint8_t   fill;
+};
+
+//******************************************************************************
+// Return false if any block isn't aligned, overlaps another one or doesn't hold its fill byte.
+static bool blocks_valid(FifoArena const & arena, std::vector<model_block_t> const & blocks, uint8_t const * base)
+{
+    std::vector<uint8_t> owner(arena.capacity(), 0);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        model_block_t const & block = blocks[i];
+        if ((reinterpret_cast<uintptr_t>(block.data) & 3) != 0)
+        {
+            printf("Block of %u bytes isn't aligned\n", block.size);
+            return false;
+        }
+
+        uint32_t offset = block.data - base;
+        if (offset + block.size > arena.capacity())
+        {
+            printf("Block of %u bytes runs past the end of the arena\n", block.size);
+            return false;
+        }
+
+        for (uint32_t j = 0; j < block.size; ++j)
+        {
+            if (owner[offset + j] || (block.data[j] != block.fill))
+            {
+                printf("Block of %u bytes overlaps another or was overwritten\n", block.size);
+                return false;
+            }
+            owner[offset + j] = 1;
+        }
+    }
+
+    return arena.numBlocks() == blocks.size();
+}
+
+//******************************************************************************
+// Return false if the arena ever hands out bad blocks over 'num_operations' random allocates/frees.
+static bool check(uint32_t num_operations)
+{
+    FifoArena arena(ARENA_BYTES);
+    std::vector<model_block_t> blocks; // oldest first
+    uint8_t const * base = NULL;
+    uint8_t next_fill = 1;
+
+    srand(1);
+
+    for (uint32_t op = 0; op < num_operations; ++op)
+    {
+        if ((rand() % 2) && !blocks.empty())
+        {
+            // Usually free the oldest, but sometimes one further back.
+            size_t index = (rand() % 8 == 0) ? rand() % blocks.size() : 0;
+            arena.free(blocks[index].data);
+            blocks.erase(blocks.begin() + index);
+        }
+        else
+        {
+            uint32_t size = (rand() % 4) ? 1 + rand() % 64 : 1 + rand() % SLOT_SIZE;
+            uint8_t * data = static_cast<uint8_t *>(arena.allocate(size));
+            if (data == NULL)
+            {
+                if (arena.capacity() - arena.numBytesUsed() >= 2 * FifoArena::blockSize(size))
+                {
+                    // Free space is at most split in two around the end, so one side had room.
+                    printf("Allocate of %u bytes failed with %u of %u bytes used\n", size, arena.numBytesUsed(), arena.capacity());
+                    return false;
+                }
+                continue;
+            }
+
+            if ((base == NULL) || (data - 4 < base))
+            {
+                base = data - 4; // first block header is at the start of the buffer
+            }
+
+            memset(data, next_fill, size);
+            model_block_t block = { data, size, next_fill };
+            blocks.push_back(block);
+            next_fill = (next_fill == 255) ? 1 : next_fill + 1;
+        }
+
+        if ((op % 64 == 0) && !blocks_valid(arena, blocks, base))
+        {
+            return false;
+        }
+    }
+
+    while (!blocks.empty())
+    {
+        arena.free(blocks.back().data);
+        blocks.pop_back();
+    }
+
+    if ((arena.numBytesUsed() != 0) || (arena.allocate(arena.capacity() - 4) == NULL))
+    {
+        printf("Arena isn't all free after freeing everything\n");
+        return false;
+    }
+
+    return true;
+}
+
+//******************************************************************************
+// Return how many 'size' byte copies fit before the arena is full.
+static uint32_t arena_capacity(uint32_t size)
+{
+    FifoArena arena(ARENA_BYTES);
+    uint32_t count = 0;
+    while (arena.allocate(size) != NULL)
+    {
+        count++;
+    }
+    return count;
+}
+
+//******************************************************************************
+// Return nanoseconds to save and free one copy with 'num_waiting' copies already saved.
+static double time_arena(uint32_t size, uint32_t num_waiting, uint32_t num_iterations, uint32_t * sum)
+{
+    FifoArena arena(ARENA_BYTES);
+    std::deque<void *> saved;
+    for (uint32_t i = 0; i < num_waiting; ++i)
+    {
+        saved.push_back(arena.allocate(size));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_iterations; ++i)
+    {
+        void * data = arena.allocate(size);
+        *static_cast<uint8_t *>(data) = (uint8_t)i;
+        saved.push_back(data);
+        *sum += *static_cast<uint8_t *>(saved.front());
+        arena.free(saved.front());
+        saved.pop_front();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / num_iterations;
+}
+
+//******************************************************************************
+// Same as time_arena() with the old SimpleArray.
+static double time_simple_array(uint32_t num_waiting, uint32_t num_iterations, uint32_t * sum)
+{
+    SimpleArray<slot_t> array(NUM_SLOTS);
+    std::deque<array_idx_t> saved;
+    for (uint32_t i = 0; i < num_waiting; ++i)
+    {
+        array_idx_t idx;
+        array.requestStorage(&idx);
+        saved.push_back(idx);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_iterations; ++i)
+    {
+        array_idx_t idx;
+        slot_t * data = static_cast<slot_t *>(array.requestStorage(&idx));
+        data->data[0] = (uint8_t)i;
+        saved.push_back(idx);
+        *sum += static_cast<slot_t *>(array.reference(saved.front()))->data[0];
+        array.remove(saved.front());
+        saved.pop_front();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / num_iterations;
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_operations = (argc > 1) ? atoi(argv[1]) : 2000000;
+    uint32_t num_iterations = (argc > 2) ? atoi(argv[2]) : 10000000;
+
+    if (!check(num_operations))
+    {
+        return 1;
+    }
+    printf("Check passed: %u random allocates/frees\n\n", num_operations);
+
+    struct { char const * name; uint32_t size; } const copies[] =
+    {
+        { "request",        sizeof(glo_request_t) },
+        { "status data",    sizeof(glo_status_data_t) },
+        { "task timing",    sizeof(glo_task_timing_t) },
+        { "assert message", sizeof(glo_assert_message_t) },
+        { "debug message",  sizeof(glo_debug_message_t) },
+        { "largest glob",   255 },
+    };
+
+    printf("Copies that fit in %u bytes\n", ARENA_BYTES);
+    printf("%-15s %6s %12s %12s\n", "Glob", "Bytes", "SimpleArray", "FifoArena");
+    for (size_t i = 0; i < sizeof(copies) / sizeof(copies[0]); ++i)
+    {
+        printf("%-15s %6u %12u %12u\n", copies[i].name, copies[i].size, NUM_SLOTS, arena_capacity(copies[i].size));
+    }
+
+    uint32_t sum = 0;
+    printf("\nNanoseconds to save and free a %u byte copy (debug message)\n", (uint32_t)sizeof(glo_debug_message_t));
+    printf("%-15s %12s %12s\n", "Already saved", "SimpleArray", "FifoArena");
+    uint32_t const waiting[] = { 0, 7, NUM_SLOTS - 1 };
+    for (size_t i = 0; i < sizeof(waiting) / sizeof(waiting[0]); ++i)
+    {
+        double array_ns = time_simple_array(waiting[i], num_iterations, &sum);
+        double arena_ns = time_arena(sizeof(glo_debug_message_t), waiting[i], num_iterations, &sum);
+        printf("%-15u %12.2f %12.2f\n", waiting[i], array_ns, arena_ns);
+    }
+    printf("(checksum %u)\n", sum);
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+// Measures what it costs to send capture samples as one glob per frame, packed into batch frames and
+// as big blocks of samples that GloTxLink splits into fragment frames (see glo_frame.h):
+//
+//  - Bytes on the wire per sample, how many frames and globs that is, and how fast GloRxLink parses it.
+//  - How many samples one bit error costs, since a missing fragment throws away the whole block.
+//
+// Nothing the firmware sends is bigger than a frame yet, so glo_task_timing (which isn't used here)
+// stands in for a block of CAPTURE_BLOCK_SAMPLES capture samples.  Everything is framed by the
+// firmware's GloTxLink and decoded by GloRxLink.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/fragmentation_benchmark.cpp host/simulated_usart.cpp libraries/glo_link/glo_rx_link.cpp \
+       libraries/glo_link/glo_tx_link.cpp libraries/util/crc.cpp -o fragmentation_benchmark
+*/
+// Usage: fragmentation_benchmark [number of bit error trials] [random seed]
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "glo_rx_link.h"
+#include "glo_tx_link.h"
+#include "globs.h"
+#include "host_port.h"
+#include "system_timer.h"
+#include "usart.h"
+
+// Samples in a block and how many blocks are sent.
+const uint16_t CAPTURE_BLOCK_SAMPLES = 64;
+const uint16_t NUM_BLOCKS = 31;
+const uint16_t NUM_SAMPLES = CAPTURE_BLOCK_SAMPLES * NUM_BLOCKS;
+const uint8_t GLO_ID_CAPTURE_BLOCK = GLO_ID_TASK_TIMING;
+const uint16_t CAPTURE_BLOCK_BYTES = CAPTURE_BLOCK_SAMPLES * sizeof(glo_capture_data_t);
+
+#define PATTERN_GLOB_BYTES(id, num_bytes) (((id) == GLO_ID_CAPTURE_BLOCK) ? CAPTURE_BLOCK_BYTES : (num_bytes))
+#include "pattern_globs.h"
+
+// Only the parts of the firmware the links use are linked in, so stub out the rest.
+// Bad CRCs assert, which is expected here, so just count them.
+static uint32_t num_asserts = 0;
+SystemTimer::SystemTimer(uint32_t /*interrupt_frequency*/) : rollover_ticks_(0), last_reported_ticks_(0), virtual_ticks_(0) {}
+SystemTimer sys_timer;
+void util_assert_failed(int /*action*/, char const * /*file_name*/, int /*line_number*/, const char * /*format*/, ...)
+{
+    num_asserts++;
+}
+
+// Bytes per second on a 115200 baud 8N1 link.
+const double LINK_BYTES_PER_SECOND = 115200.0 / 10.0;
+
+// How the samples are packed.
+enum
+{
+    MODE_SINGLE,
+    MODE_BATCHED,
+    MODE_BLOCKS,
+    NUM_MODES
+};
+static char const * const mode_names[NUM_MODES] = { "one per frame", "batched", "64 sample blocks" };
+
+// Everything the transmit link wrote to the serial port and how many frames that was.
+static std::vector<uint8_t> wire;
+static uint32_t num_frames = 0;
+
+// Samples the receive link decoded correctly, globs it handed over and how many didn't match what was sent.
+static uint32_t num_samples_decoded = 0;
+static uint32_t num_globs_decoded = 0;
+static uint32_t num_bad_globs = 0;
+
+//******************************************************************************
+static void capture_wire(uint8_t const * data, uint16_t length)
+{
+    wire.insert(wire.end(), data, data + length);
+    num_frames++;
+}
+
+//******************************************************************************
+static void check_decoded(uint8_t object_id, uint16_t instance, void * glob_data)
+{
+    static uint8_t pattern[MSG_MAX_GLOB_SIZE];
+
+    num_globs_decoded++;
+
+    if ((object_id >= NUM_GLOBS) || (instance == 0) || (instance > globs[object_id]->get_num_instances()))
+    {
+        num_bad_globs++;
+        return;
+    }
+
+    uint16_t num_bytes = globs[object_id]->get_num_bytes();
+    fill_pattern(pattern, object_id, instance, num_bytes);
+    if (memcmp(pattern, glob_data, num_bytes) != 0)
+    {
+        num_bad_globs++;
+        return;
+    }
+
+    num_samples_decoded += (object_id == GLO_ID_CAPTURE_BLOCK) ? CAPTURE_BLOCK_SAMPLES : 1;
+}
+
+//******************************************************************************
+static void encode(uint8_t mode, glo_link_framing_t framing)
+{
+    GloTxLink link(Usart::instance(USART_BUS_2));
+    link.set_framing(framing);
+
+    wire.clear();
+    num_frames = 0;
+
+    if (mode == MODE_SINGLE)
+    {
+        for (uint16_t instance = 1; instance <= NUM_SAMPLES; ++instance)
+        {
+            link.send(GLO_ID_CAPTURE_DATA, instance);
+        }
+    }
+    else if (mode == MODE_BATCHED)
+    {
+        uint16_t instance = 1;
+        while (instance <= NUM_SAMPLES)
+        {
+            link.beginBatch(MSG_MAX_FRAME_SIZE);
+            while ((instance <= NUM_SAMPLES) && (link.addToBatch(GLO_ID_CAPTURE_DATA, instance) == SEND_SUCCESS))
+            {
+                instance++;
+            }
+            link.endBatch();
+        }
+    }
+    else
+    {
+        // Send the same block over and over since there's only one instance of the stand-in glob.
+        for (uint16_t block = 0; block < NUM_BLOCKS; ++block)
+        {
+            link.send(GLO_ID_CAPTURE_BLOCK, 1);
+        }
+    }
+}
+
+//******************************************************************************
+// Feed 'stream' through a receive link in random sized chunks like it would come off the DMA.
+static uint32_t decode(glo_link_framing_t framing, std::vector<uint8_t> const & stream)
+{
+    Usart * port = Usart::instance(USART_BUS_2);
+    GloRxLink link(port, check_decoded);
+    link.setFraming(framing);
+
+    num_samples_decoded = 0;
+    num_globs_decoded = 0;
+    num_bad_globs = 0;
+
+    uint32_t offset = 0;
+    while (offset < stream.size())
+    {
+        uint32_t length = 1 + rand() % (USART2_RX_BUFF_SIZE - 1);
+        if (length > stream.size() - offset) { length = stream.size() - offset; }
+        port->hostReceive(&stream[offset], length);
+        link.parseAvailable(UINT32_MAX);
+        offset += length;
+    }
+
+    return link.numFragmentsDropped();
+}
+
+//******************************************************************************
+static void run_throughput(uint8_t mode, glo_link_framing_t framing)
+{
+    encode(mode, framing);
+    std::vector<uint8_t> const stream = wire;
+
+    // Repeat so it takes long enough to time.
+    const uint32_t repeats = 100;
+    uint64_t total_decoded = 0;
+    uint32_t globs_per_decode = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < repeats; ++r)
+    {
+        decode(framing, stream);
+        total_decoded += num_samples_decoded;
+        globs_per_decode = num_globs_decoded;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t num_payload_bytes = NUM_SAMPLES * sizeof(glo_capture_data_t);
+    printf("%-17s %-11s %8u %7u %7u %11.2f %9.1f%% %11.0f %10.1f %8s\n", mode_names[mode],
+           (framing == LINK_FRAMING_COBS) ? "cobs" : "start byte", (unsigned)stream.size(), num_frames,
+           globs_per_decode, (double)stream.size() / NUM_SAMPLES, 100.0 * num_payload_bytes / stream.size(),
+           LINK_BYTES_PER_SECOND * NUM_SAMPLES / stream.size(), stream.size() * repeats / seconds / 1e6,
+           (total_decoded == (uint64_t)NUM_SAMPLES * repeats) ? "yes" : "NO");
+}
+
+//******************************************************************************
+static void run_bit_errors(uint8_t mode, glo_link_framing_t framing, uint32_t num_trials)
+{
+    encode(mode, framing);
+    std::vector<uint8_t> const clean = wire;
+
+    uint64_t total_lost = 0;
+    uint32_t max_lost = 0;
+    uint64_t total_dropped = 0;
+    uint32_t total_bad = 0;
+
+    for (uint32_t trial = 0; trial < num_trials; ++trial)
+    {
+        // Flip one bit somewhere past the first frame.
+        std::vector<uint8_t> stream = clean;
+        uint32_t error_idx = clean.size() / NUM_BLOCKS + rand() % (clean.size() - clean.size() / NUM_BLOCKS);
+        stream[error_idx] ^= (uint8_t)(1 << (rand() % 8));
+
+        total_dropped += decode(framing, stream);
+        total_bad += num_bad_globs;
+
+        uint32_t num_lost = NUM_SAMPLES - num_samples_decoded;
+        total_lost += num_lost;
+        if (num_lost > max_lost) { max_lost = num_lost; }
+    }
+
+    printf("%-17s %-11s %12.1f %12u %12.2f %8u\n", mode_names[mode], (framing == LINK_FRAMING_COBS) ? "cobs" : "start byte",
+           (double)total_lost / num_trials, max_lost, (double)total_dropped / num_trials, total_bad);
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_trials = (argc > 1) ? atoi(argv[1]) : 2000;
+    srand((argc > 2) ? atoi(argv[2]) : 1);
+
+    host_tx_sink = capture_wire;
+
+    glo_link_framing_t const framings[] = { LINK_FRAMING_START_BYTE, LINK_FRAMING_COBS };
+
+    printf("Sending %u capture samples (%u bytes each, %.0f bytes/s link)\n", NUM_SAMPLES,
+           (unsigned)sizeof(glo_capture_data_t), LINK_BYTES_PER_SECOND);
+    printf("%-17s %-11s %8s %7s %7s %11s %10s %11s %10s %8s\n", "Packing", "Framing", "Wire", "Frames", "Globs",
+           "Bytes per", "Efficiency", "Samples/s", "Parse", "Decoded");
+    printf("%-17s %-11s %8s %7s %7s %11s %10s %11s %10s %8s\n", "", "", "bytes", "", "", "sample", "", "", "MB/s", "");
+    for (uint8_t mode = 0; mode < NUM_MODES; ++mode)
+    {
+        for (uint8_t i = 0; i < 2; ++i) { run_throughput(mode, framings[i]); }
+    }
+
+    printf("\nOne bit error (%u trials)\n", num_trials);
+    printf("%-17s %-11s %12s %12s %12s %8s\n", "Packing", "Framing", "Avg samples", "Max samples", "Partial", "Bad");
+    printf("%-17s %-11s %12s %12s %12s %8s\n", "", "", "lost", "lost", "blocks", "globs");
+    for (uint8_t mode = 0; mode < NUM_MODES; ++mode)
+    {
+        for (uint8_t i = 0; i < 2; ++i) { run_bit_errors(mode, framings[i], num_trials); }
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Writes the glob registry (see glob_registry.h) out as a JSON schema so decoders on the PC side
+// can parse any glob by name, offset and type instead of keeping their own copy of glob_types.h.
+// Uses the same compile time tables that are in the firmware image so they can't get out of sync.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/glob_schema.cpp globs/glob_registry.cpp -o glob_schema
+*/
+// Usage: glob_schema [output file]   (defaults to stdout)
+
+// Includes
+#include <cstdio>
+#include "glob_registry.h"
+
+// Name of each glob storage type used in the schema.
+static char const * storage_name(glob_storage_type_t storage)
+{
+    return (storage == GLOB_STORAGE_SEQLOCK) ? "seqlock" : "locked";
+}
+
+//******************************************************************************
+static void write_schema(FILE * file)
+{
+    // Everything on the wire is in the robot's native byte order.
+    fprintf(file, "{\n");
+    fprintf(file, "  \"byte_order\": \"little\",\n");
+    fprintf(file, "  \"num_globs\": %d,\n", NUM_GLOBS);
+    fprintf(file, "  \"globs\": [\n");
+
+    for (uint8_t i = 0; i < NUM_GLOBS; ++i)
+    {
+        glob_info_t const & info = glob_registry[i];
+
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"id\": %d,\n", info.id);
+        fprintf(file, "      \"name\": \"%s\",\n", info.name);
+        fprintf(file, "      \"type\": \"%s\",\n", info.type_name);
+        fprintf(file, "      \"owner\": \"%s\",\n", info.owner);
+        fprintf(file, "      \"size\": %d,\n", info.num_bytes);
+        fprintf(file, "      \"instances\": %d,\n", info.num_instances);
+        fprintf(file, "      \"storage\": \"%s\",\n", storage_name(info.storage));
+        fprintf(file, "      \"fields\": [\n");
+
+        for (uint8_t f = 0; f < info.num_fields; ++f)
+        {
+            glob_field_t const & field = info.fields[f];
+            fprintf(file, "        { \"name\": \"%s\", \"type\": \"%s\", \"offset\": %d, \"count\": %d }%s\n",
+                    field.name, glob_field_type_name(field.type), field.offset, field.count,
+                    (f + 1 < info.num_fields) ? "," : "");
+        }
+
+        fprintf(file, "      ]\n");
+        fprintf(file, "    }%s\n", (i + 1 < NUM_GLOBS) ? "," : "");
+    }
+
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    FILE * file = stdout;
+    if (argc > 1)
+    {
+        file = fopen(argv[1], "w");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Can't open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    write_schema(file);
+
+    if (file != stdout)
+    {
+        fclose(file);
+    }
+
+    return 0;
+}
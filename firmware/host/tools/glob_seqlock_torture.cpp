@@ -0,0 +1,171 @@
+// Torture test of GlobSeqlockStorage (see glob_storage.h).  One writer thread publishes a glob the size of
+// the assert message (with two instances) as fast as it can while reader threads read it every way the
+// storage allows (read(), readSplit() with a random split and readTickStamp()).  Every word the writer
+// publishes is the publish number plus the word's index and the tick stamp is the publish number, so any
+// copy that mixes two publishes (torn) is caught.  Publish numbers read from an instance also have to
+// keep going up (no stale slot after a newer one).
+//
+// Reads that overlapped a publish of the same slot are retried by the storage, so the number of retries
+// shows how many times the readers were caught in the middle of a copy.  On a PC with one core the threads
+// only interrupt each other when the OS switches between them, so it takes a lot of publishes for that.
+//
+// Built with -fsanitize=thread it reports the copies in and out of a slot as races, since a seqlock reader
+// copies optimistically and throws away what it got if the writer was there.  Torn copies are what count.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -pthread -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/glob_seqlock_torture.cpp -o glob_seqlock_torture
+*/
+// Usage: glob_seqlock_torture [publishes] [reader threads]   (defaults to 20000000 and 3)
+
+// Includes
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "glob_storage.h"
+#include "glob_types.h"
+
+// Same size as the biggest glob that uses seqlock storage.
+const uint32_t NUM_WORDS = sizeof(glo_assert_message_t) / sizeof(uint32_t);
+const uint16_t NUM_INSTANCES = 2;
+
+struct big_glob_t
+{
+    uint32_t words[NUM_WORDS];
+};
+
+typedef GlobSeqlockStorage<big_glob_t, NUM_INSTANCES> BigStorage;
+
+// What each reader found.
+struct reader_stats_t
+{
+    uint64_t num_reads;
+    uint64_t num_torn;
+    uint64_t num_backwards;
+};
+
+static std::atomic<bool> writer_done(false);
+
+//******************************************************************************
+// Return true if the words in 'glob' are all from the same publish and it's the one 'tick_stamp' says.
+static bool glob_consistent(big_glob_t const & glob, uint64_t tick_stamp)
+{
+    uint32_t publish = glob.words[0];
+    for (uint32_t i = 1; i < NUM_WORDS; ++i)
+    {
+        if (glob.words[i] != publish + i)
+        {
+            return false;
+        }
+    }
+    return publish == tick_stamp;
+}
+
+//******************************************************************************
+static void write_globs(BigStorage * storage, uint32_t num_publishes)
+{
+    big_glob_t glob;
+    for (uint32_t publish = 1; publish <= num_publishes; ++publish)
+    {
+        for (uint32_t i = 0; i < NUM_WORDS; ++i)
+        {
+            glob.words[i] = publish + i;
+        }
+        storage->write(publish % NUM_INSTANCES, &glob, publish);
+    }
+    writer_done = true;
+}
+
+//******************************************************************************
+static void read_globs(BigStorage const * storage, uint32_t seed, reader_stats_t * stats)
+{
+    uint64_t last_publish[NUM_INSTANCES] = { 0 };
+    uint32_t way = 0;
+
+    while (!writer_done)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint16_t index = (seed >> 16) % NUM_INSTANCES;
+        way = (way + 1) % 3;
+
+        big_glob_t glob;
+        uint64_t tick_stamp = 0;
+        bool consistent = true;
+        if (way == 0)
+        {
+            storage->read(index, &glob, &tick_stamp);
+            consistent = glob_consistent(glob, tick_stamp);
+        }
+        else if (way == 1)
+        {
+            // Same as copying into a ring buffer that wraps somewhere in the middle of the glob.
+            big_glob_t second;
+            uint16_t first_size = (uint16_t)(((seed >> 8) % NUM_WORDS) * sizeof(uint32_t));
+            storage->readSplit(index, &glob, first_size, &second, sizeof(big_glob_t), &tick_stamp);
+            memmove((uint8_t *)&glob + first_size, &second, sizeof(big_glob_t) - first_size);
+            consistent = glob_consistent(glob, tick_stamp);
+        }
+        else
+        {
+            tick_stamp = storage->readTickStamp(index);
+        }
+
+        stats->num_reads++;
+        stats->num_torn += consistent ? 0 : 1;
+        stats->num_backwards += (tick_stamp < last_publish[index]) ? 1 : 0;
+        last_publish[index] = tick_stamp;
+    }
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_publishes = (argc > 1) ? atoi(argv[1]) : 20000000;
+    uint32_t num_readers = (argc > 2) ? atoi(argv[2]) : 3;
+
+    // Static so it starts zeroed like a glob's storage.  Every instance gets publish zero before the readers
+    // start so they don't have to know about never published instances.
+    static BigStorage storage;
+    big_glob_t first_glob;
+    for (uint32_t i = 0; i < NUM_WORDS; ++i)
+    {
+        first_glob.words[i] = i;
+    }
+    for (uint16_t index = 0; index < NUM_INSTANCES; ++index)
+    {
+        storage.write(index, &first_glob, 0);
+    }
+
+    std::vector<reader_stats_t> stats(num_readers, reader_stats_t());
+    std::vector<std::thread> readers;
+    for (uint32_t i = 0; i < num_readers; ++i)
+    {
+        readers.push_back(std::thread(read_globs, &storage, i + 1, &stats[i]));
+    }
+    std::thread writer(write_globs, &storage, num_publishes);
+
+    writer.join();
+    reader_stats_t total = { 0, 0, 0 };
+    for (uint32_t i = 0; i < num_readers; ++i)
+    {
+        readers[i].join();
+        total.num_reads += stats[i].num_reads;
+        total.num_torn += stats[i].num_torn;
+        total.num_backwards += stats[i].num_backwards;
+    }
+
+    printf("%u publishes of %u bytes to %u instances, %u readers\n", num_publishes, (uint32_t)sizeof(big_glob_t),
+           NUM_INSTANCES, num_readers);
+    printf("%llu reads, %llu torn, %llu went backwards, %u retried\n", (unsigned long long)total.num_reads,
+           (unsigned long long)total.num_torn, (unsigned long long)total.num_backwards, storage.numRetries());
+
+    bool passed = (total.num_torn == 0) && (total.num_backwards == 0);
+    printf("Torture test %s\n", passed ? "passed" : "FAILED");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+// Measures how long interrupts are disabled while the robot's tasks run in the host sim, to compare the
+// seqlock globs (see GlobSeqlockStorage) with every glob disabling interrupts around its copies like they
+// all used to.  A capture is streaming and a debug message is printed 10 times a second so the send task
+// and the big message globs are busy too.
+//
+// Every section with interrupts disabled is timed on the PC (see host_interrupts_masked), which includes
+// reading the PC's clock twice.  That's timed the same way with nothing in between and printed too, since
+// it's most of a short section.  The longest ones are the OS switching away in the middle, so the
+// percentiles say more than the max.  The robot takes longer for everything, but the biggest glob that's
+// still copied with interrupts disabled (besides capture data, which is only 36 bytes) is what its
+// longest section comes down to, so that's reported from the glob registry too.
+//
+// Build once with the globs as they're listed and once with every glob locked from the firmware directory:
+/*
+   for storage in AS_LISTED ALWAYS_LOCKED; do
+     g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DGLOBS_$storage \
+         $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+         host/tools/interrupts_disabled.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+         host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+         scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+         libraries/glo_link/[a-z]*.cpp \
+         libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+         libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+         embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+         -o interrupts_disabled_$storage
+   done
+*/
+// Usage: interrupts_disabled [simulated seconds]   (defaults to 600)
+// For example: ./interrupts_disabled_ALWAYS_LOCKED; ./interrupts_disabled_AS_LISTED
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "debug_printf.h"
+#include "glob_registry.h"
+#include "globs.h"
+#include "host_port.h"
+#include "periodic_task.h"
+#include "scheduler.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Same setup as the robot (see embitz_projects/eeva_full_version/source/main.cpp)
+SystemTimer sys_timer(1000);
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+// Sections are counted by nanoseconds up to this long.  Anything longer only counts toward the max.
+const uint32_t MAX_COUNTED_NS = 1000000;
+
+// How many sections took each number of nanoseconds.
+static std::vector<uint64_t> section_counts(MAX_COUNTED_NS + 1, 0);
+static uint64_t num_sections = 0;
+static double max_ns = 0;
+
+static std::chrono::steady_clock::time_point masked_time;
+
+// Prints a debug message like a mode or experiment would.
+class DebugTask : public Scheduler::PeriodicTask
+{
+  public: // methods
+
+    DebugTask(void) :
+        PeriodicTask("Debug", TASK_ID_STATUS_UPDATE, 10),
+        count_(0)
+    {
+    }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        debug_printf("Debug message %u at %.3f seconds.", (unsigned)count_++, sys_timer.seconds());
+    }
+
+  private: // fields
+
+    uint32_t count_;
+
+};
+
+static DebugTask debug_task;
+
+//******************************************************************************
+static void time_section(bool masked)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (masked)
+    {
+        masked_time = now;
+        return;
+    }
+
+    double ns = std::chrono::duration<double, std::nano>(now - masked_time).count();
+    section_counts[(ns < MAX_COUNTED_NS) ? (uint32_t)ns : MAX_COUNTED_NS]++;
+    num_sections++;
+    max_ns = (ns > max_ns) ? ns : max_ns;
+}
+
+//******************************************************************************
+// Return the nanoseconds 'fraction' of the sections took less than.
+static uint32_t percentile_ns(double fraction)
+{
+    uint64_t target = (uint64_t)(fraction * num_sections);
+    uint64_t count = 0;
+    for (uint32_t ns = 0; ns <= MAX_COUNTED_NS; ++ns)
+    {
+        count += section_counts[ns];
+        if (count > target)
+        {
+            return ns;
+        }
+    }
+    return MAX_COUNTED_NS;
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    double simulated_seconds = (argc > 1) ? atof(argv[1]) : 600.0;
+
+    host_stop_ticks = (uint64_t)(simulated_seconds * sys_timer.frequency());
+
+    Scheduler::Task * tasks[] =
+    {
+        &comp_filter_task,
+        &send_task,
+        &receive_task,
+        &leds_task,
+        &modes_task,
+        &status_update_task,
+        &stream_task,
+        &debug_task,
+    };
+    for (uint32_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); ++i)
+    {
+        scheduler.registerTask(*tasks[i]);
+    }
+    scheduler.registerPreemptiveTask(main_control_task);
+
+    // Stream the default capture channels at the control rate until the end.
+    glo_capture_command_t command;
+    memset(&command, 0, sizeof(command));
+    command.is_start = true;
+    command.stream = true;
+    main_control_task.handle(command);
+
+    // Sections with nothing in them first, to see how long reading the clock takes.
+    for (uint32_t i = 0; i < 1000000; ++i)
+    {
+        time_section(true);
+        time_section(false);
+    }
+    uint32_t clock_ns = percentile_ns(0.5);
+    section_counts.assign(MAX_COUNTED_NS + 1, 0);
+    num_sections = 0;
+    max_ns = 0;
+
+    host_interrupts_masked = time_section;
+
+    scheduler.scheduleTasks();
+
+    host_interrupts_masked = NULL;
+
+#ifdef GLOBS_ALWAYS_LOCKED
+    char const * storage = "every glob locked";
+#else
+    char const * storage = "globs as listed";
+#endif
+    printf("Interrupts disabled with %s over %.0f simulated seconds (%.0f kB sent)\n", storage,
+           simulated_seconds, host_bytes_sent / 1000.0);
+    printf("  %.0f times per simulated second, PC time median %u ns, 99%% %u ns, 99.9%% %u ns, max %.0f ns "
+           "(reading the clock is %u ns)\n", num_sections / simulated_seconds, percentile_ns(0.5),
+           percentile_ns(0.99), percentile_ns(0.999), max_ns, clock_ns);
+
+    // Biggest glob published during the run that still disables interrupts around its copies.
+    glob_info_t const * biggest = NULL;
+    for (uint8_t i = 0; i < NUM_GLOBS; ++i)
+    {
+        glob_info_t const & info = glob_registry[i];
+        if ((info.storage == GLOB_STORAGE_LOCKED) && (info.id != GLO_ID_CAPTURE_DATA) &&
+            (globs[info.id]->get_tick_stamp() != 0) && ((biggest == NULL) || (info.num_bytes > biggest->num_bytes)))
+        {
+            biggest = &info;
+        }
+    }
+    if (biggest != NULL)
+    {
+        printf("  Biggest copy with interrupts disabled: %s (%u bytes)\n", biggest->name, biggest->num_bytes);
+    }
+
+    return 0;
+}
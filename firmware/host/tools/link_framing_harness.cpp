@@ -0,0 +1,328 @@
+// Compares the start byte framing against COBS framing (see glo_frame.h) on the telemetry link:
+//
+//  - Throughput: wire efficiency and how fast GloRxLink parses each framing on this PC.
+//  - Recovery: flips one random bit in a stream of frames and measures how many good frames are
+//    lost and how long (at 115200 baud) until the receiver is back in sync.
+//  - Fuzz: feeds random noise and randomly mutated streams through both parsers and checks that
+//    nothing that wasn't sent is ever accepted.
+//
+// Everything is framed by the firmware's GloTxLink and decoded by GloRxLink.
+//
+// Build from the firmware directory (add -fsanitize=address,undefined to check memory accesses):
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/link_framing_harness.cpp host/simulated_usart.cpp libraries/glo_link/glo_rx_link.cpp \
+       libraries/glo_link/glo_tx_link.cpp libraries/util/crc.cpp -o link_framing_harness
+*/
+// Usage: link_framing_harness [number of recovery trials] [random seed]
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "glo_rx_link.h"
+#include "glo_tx_link.h"
+#include "globs.h"
+#include "host_port.h"
+#include "pattern_globs.h"
+#include "system_timer.h"
+#include "usart.h"
+
+// Only the parts of the firmware the links use are linked in, so stub out the rest.
+// Bad CRCs assert, which is expected here, so just count them.
+static uint32_t num_asserts = 0;
+SystemTimer::SystemTimer(uint32_t /*interrupt_frequency*/) : rollover_ticks_(0), last_reported_ticks_(0), virtual_ticks_(0) {}
+SystemTimer sys_timer;
+void util_assert_failed(int /*action*/, char const * /*file_name*/, int /*line_number*/, const char * /*format*/, ...)
+{
+    num_asserts++;
+}
+
+// Bytes per second on a 115200 baud 8N1 link.
+const double LINK_BYTES_PER_SECOND = 115200.0 / 10.0;
+
+// Frames in each recovery trial and which one gets the bit error.
+const uint16_t RECOVERY_STREAM_FRAMES = 40;
+const uint16_t RECOVERY_CORRUPT_FRAME = 10;
+
+static char const * framing_name(glo_link_framing_t framing)
+{
+    return (framing == LINK_FRAMING_COBS) ? "cobs" : "start byte";
+}
+
+// Everything the transmit link wrote to the serial port, and where each frame starts.
+static std::vector<uint8_t> wire;
+static std::vector<uint32_t> frame_starts;
+
+// Instances of capture data the receive link decoded correctly, and how many globs it accepted
+// that weren't sent (i.e. the data doesn't match the pattern).
+static std::vector<uint16_t> decoded_instances;
+static uint32_t num_false_accepts = 0;
+
+//******************************************************************************
+static void capture_wire(uint8_t const * data, uint16_t length)
+{
+    frame_starts.push_back(wire.size());
+    wire.insert(wire.end(), data, data + length);
+}
+
+//******************************************************************************
+static void check_decoded(uint8_t object_id, uint16_t instance, void * glob_data)
+{
+    uint8_t pattern[256];
+
+    if ((object_id >= NUM_GLOBS) || (instance == 0) || (instance > globs[object_id]->get_num_instances()))
+    {
+        num_false_accepts++;
+        return;
+    }
+
+    uint8_t num_bytes = globs[object_id]->get_num_bytes();
+    fill_pattern(pattern, object_id, instance, num_bytes);
+    if (memcmp(pattern, glob_data, num_bytes) != 0)
+    {
+        num_false_accepts++;
+        return;
+    }
+
+    decoded_instances.push_back(instance);
+}
+
+//******************************************************************************
+// Send capture data instances 'first' to 'last', one per frame.
+static void encode_capture(glo_link_framing_t framing, uint16_t first, uint16_t last)
+{
+    GloTxLink link(Usart::instance(USART_BUS_2));
+    link.set_framing(framing);
+
+    wire.clear();
+    frame_starts.clear();
+
+    for (uint16_t instance = first; instance <= last; ++instance)
+    {
+        link.send(GLO_ID_CAPTURE_DATA, instance);
+    }
+}
+
+//******************************************************************************
+// Send a mix of globs (status stream plus capture dump) packed into batch frames.
+static uint32_t encode_mixed(glo_link_framing_t framing)
+{
+    GloTxLink link(Usart::instance(USART_BUS_2));
+    link.set_framing(framing);
+
+    wire.clear();
+    frame_starts.clear();
+
+    uint8_t const ids[] = { GLO_ID_STATUS_DATA, GLO_ID_ODOMETRY, GLO_ID_IMU, GLO_ID_MODES };
+    uint32_t num_globs = 0;
+    for (uint16_t update = 0; update < 200; ++update)
+    {
+        link.beginBatch(MSG_MAX_FRAME_SIZE);
+        for (uint8_t i = 0; i < sizeof(ids); ++i)
+        {
+            link.addToBatch(ids[i], 1);
+            num_globs++;
+        }
+        link.endBatch();
+
+        for (uint16_t first = 1; first <= 10; first += 5)
+        {
+            link.beginBatch(MSG_MAX_FRAME_SIZE);
+            for (uint16_t instance = first; instance < first + 5; ++instance)
+            {
+                link.addToBatch(GLO_ID_CAPTURE_DATA, instance);
+                num_globs++;
+            }
+            link.endBatch();
+        }
+    }
+
+    return num_globs;
+}
+
+//******************************************************************************
+// Feed 'stream' through a receive link in random sized chunks like it would come off the DMA.
+static void decode(glo_link_framing_t framing, std::vector<uint8_t> const & stream)
+{
+    Usart * port = Usart::instance(USART_BUS_2);
+    GloRxLink link(port, check_decoded);
+    link.setFraming(framing);
+
+    decoded_instances.clear();
+    num_false_accepts = 0;
+
+    uint32_t offset = 0;
+    while (offset < stream.size())
+    {
+        uint32_t length = 1 + rand() % (USART2_RX_BUFF_SIZE - 1);
+        if (length > stream.size() - offset) { length = stream.size() - offset; }
+        port->hostReceive(&stream[offset], length);
+        link.parseAvailable(UINT32_MAX);
+        offset += length;
+    }
+}
+
+//******************************************************************************
+static void run_throughput(glo_link_framing_t framing)
+{
+    uint32_t num_globs = encode_mixed(framing);
+    std::vector<uint8_t> stream = wire;
+
+    uint32_t num_payload_bytes = 200 * (globs[GLO_ID_STATUS_DATA]->get_num_bytes() + globs[GLO_ID_ODOMETRY]->get_num_bytes() +
+                               globs[GLO_ID_IMU]->get_num_bytes() + globs[GLO_ID_MODES]->get_num_bytes() +
+                               10 * globs[GLO_ID_CAPTURE_DATA]->get_num_bytes());
+
+    // Repeat so it takes long enough to time.
+    const uint32_t repeats = 200;
+    uint32_t num_decoded = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < repeats; ++r)
+    {
+        decode(framing, stream);
+        num_decoded += decoded_instances.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double efficiency = (double)num_payload_bytes / stream.size();
+    printf("%-11s %8u %8u %9.1f%% %12.0f %12.1f %8s\n", framing_name(framing), (unsigned)stream.size(),
+           num_payload_bytes, 100.0 * efficiency, efficiency * LINK_BYTES_PER_SECOND,
+           stream.size() * repeats / seconds / 1e6, (num_decoded == num_globs * repeats) ? "yes" : "NO");
+}
+
+//******************************************************************************
+// If 'header_only' then the error is always in the first few bytes of the frame (e.g. the length).
+static void run_recovery(glo_link_framing_t framing, uint32_t num_trials, bool header_only)
+{
+    uint32_t total_lost = 0;
+    uint32_t max_lost = 0;
+    uint64_t total_resync_bytes = 0;
+    uint32_t max_resync_bytes = 0;
+    uint32_t total_false_accepts = 0;
+
+    encode_capture(framing, 1, RECOVERY_STREAM_FRAMES);
+    std::vector<uint8_t> const clean = wire;
+    std::vector<uint32_t> const starts = frame_starts;
+
+    for (uint32_t trial = 0; trial < num_trials; ++trial)
+    {
+        // Flip one bit somewhere in the chosen frame.
+        uint32_t frame_start = starts[RECOVERY_CORRUPT_FRAME];
+        uint32_t frame_end = starts[RECOVERY_CORRUPT_FRAME + 1];
+        uint32_t error_range = header_only ? (MSG_HEADER_SIZE + 1) : (frame_end - frame_start);
+        uint32_t error_idx = frame_start + rand() % error_range;
+        std::vector<uint8_t> stream = clean;
+        stream[error_idx] ^= (uint8_t)(1 << (rand() % 8));
+
+        decode(framing, stream);
+        total_false_accepts += num_false_accepts;
+
+        // Everything besides the corrupted frame should still come through, so count any others lost.
+        uint32_t num_lost = RECOVERY_STREAM_FRAMES - 1 - decoded_instances.size();
+        if (decoded_instances.size() == RECOVERY_STREAM_FRAMES)
+        {
+            num_lost = 0; // error didn't matter (e.g. flipped a bit the CRC doesn't cover)
+        }
+        total_lost += num_lost;
+        if (num_lost > max_lost) { max_lost = num_lost; }
+
+        // Bytes from the error until the start of the first frame after it that was received.
+        uint32_t resync_frame = RECOVERY_STREAM_FRAMES;
+        for (size_t i = 0; i < decoded_instances.size(); ++i)
+        {
+            uint16_t frame = decoded_instances[i] - 1;
+            if ((frame > RECOVERY_CORRUPT_FRAME) && (frame < resync_frame)) { resync_frame = frame; }
+        }
+        uint32_t resync_start = (resync_frame < RECOVERY_STREAM_FRAMES) ? starts[resync_frame] : clean.size();
+        uint32_t resync_bytes = resync_start - error_idx;
+        total_resync_bytes += resync_bytes;
+        if (resync_bytes > max_resync_bytes) { max_resync_bytes = resync_bytes; }
+    }
+
+    printf("%-11s %-7s %10.2f %10u %12.1f %12.1f %10.2f %8u\n", framing_name(framing), header_only ? "header" : "any",
+           (double)total_lost / num_trials, max_lost,
+           1e3 * total_resync_bytes / num_trials / LINK_BYTES_PER_SECOND,
+           1e3 * max_resync_bytes / LINK_BYTES_PER_SECOND,
+           1e3 * (clean.size() / RECOVERY_STREAM_FRAMES) / LINK_BYTES_PER_SECOND, total_false_accepts);
+}
+
+//******************************************************************************
+static void run_fuzz(glo_link_framing_t framing, uint32_t num_rounds)
+{
+    uint32_t total_false_accepts = 0;
+    uint64_t num_bytes = 0;
+
+    encode_mixed(framing);
+    std::vector<uint8_t> const clean = wire;
+
+    for (uint32_t round = 0; round < num_rounds; ++round)
+    {
+        std::vector<uint8_t> stream;
+        if (round % 4 == 0)
+        {
+            // Pure noise, heavy on the bytes the parsers look for.
+            stream.resize(4096);
+            for (size_t i = 0; i < stream.size(); ++i)
+            {
+                int r = rand() % 8;
+                stream[i] = (r == 0) ? MSG_START_BYTE : (r == 1) ? MSG_COBS_DELIMITER : (uint8_t)rand();
+            }
+        }
+        else
+        {
+            // Real frames with bytes flipped, dropped and inserted.
+            stream = clean;
+            uint32_t num_mutations = 1 + rand() % 50;
+            for (uint32_t n = 0; n < num_mutations; ++n)
+            {
+                size_t idx = rand() % stream.size();
+                switch (rand() % 3)
+                {
+                    case 0: stream[idx] ^= (uint8_t)(1 << (rand() % 8)); break;
+                    case 1: stream.erase(stream.begin() + idx); break;
+                    default: stream.insert(stream.begin() + idx, (uint8_t)rand()); break;
+                }
+            }
+        }
+
+        decode(framing, stream);
+        total_false_accepts += num_false_accepts;
+        num_bytes += stream.size();
+    }
+
+    printf("%-11s %8u %12llu %14u\n", framing_name(framing), num_rounds, (unsigned long long)num_bytes, total_false_accepts);
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_trials = (argc > 1) ? atoi(argv[1]) : 2000;
+    srand((argc > 2) ? atoi(argv[2]) : 1);
+
+    host_tx_sink = capture_wire;
+
+    glo_link_framing_t const framings[] = { LINK_FRAMING_START_BYTE, LINK_FRAMING_COBS };
+
+    printf("Throughput (batched status stream and capture data, %.0f bytes/s link)\n", LINK_BYTES_PER_SECOND);
+    printf("%-11s %8s %8s %10s %12s %12s %8s\n", "Framing", "Wire", "Payload", "Efficiency", "Payload B/s", "Parse MB/s", "Decoded");
+    for (uint8_t i = 0; i < 2; ++i) { run_throughput(framings[i]); }
+
+    printf("\nRecovery from one bit error (%u trials, capture data one per frame)\n", num_trials);
+    printf("%-11s %-7s %10s %10s %12s %12s %10s %8s\n", "Framing", "Error", "Avg extra", "Max extra", "Avg resync",
+           "Max resync", "Frame", "False");
+    printf("%-11s %-7s %10s %10s %12s %12s %10s %8s\n", "", "in", "lost", "lost", "ms", "ms", "ms", "accepts");
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+        run_recovery(framings[i], num_trials, false);
+        run_recovery(framings[i], num_trials, true);
+    }
+
+    printf("\nFuzz (noise and mutated streams)\n");
+    printf("%-11s %8s %12s %14s\n", "Framing", "Rounds", "Bytes", "False accepts");
+    for (uint8_t i = 0; i < 2; ++i) { run_fuzz(framings[i], num_trials); }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Stand-ins for the firmware's globs for host tools that only link in the telemetry links (not the
+// scheduler the real globs need).  Every glob has the same ID, size and number of instances as the
+// real one, and every instance reads back as a pattern so decoded data can be checked.
+// Defines the 'globs' table, so only include it in one file of a tool.
+//
+// A tool can define PATTERN_GLOB_BYTES(id, num_bytes) before including this to change the size of a
+// glob, e.g. to try out one bigger than anything the firmware sends yet.
+
+#ifndef PATTERN_GLOBS_H_INCLUDED
+#define PATTERN_GLOBS_H_INCLUDED
+
+// Includes
+#include "glo_frame.h"
+#include "globs.h"
+
+#ifndef PATTERN_GLOB_BYTES
+#define PATTERN_GLOB_BYTES(id, num_bytes) (num_bytes)
+#endif
+
+//******************************************************************************
+// Fill 'data' with a pattern that depends on the glob so the decoded data can be checked.
+inline void fill_pattern(uint8_t * data, uint8_t id, uint16_t instance, uint16_t num_bytes)
+{
+    for (uint16_t i = 0; i < num_bytes; ++i)
+    {
+        data[i] = (uint8_t)(id * 31 + instance * 7 + i);
+    }
+}
+
+// Glob that reads back the pattern for whichever instance is asked for.
+class PatternGlob : public GlobBase
+{
+  public: // methods
+
+    constexpr PatternGlob(uint8_t id, uint16_t num_bytes, uint16_t num_instances) :
+        GlobBase(id, num_bytes, num_instances) {}
+
+    virtual bool copy_to_buffer(void * buffer, uint16_t instance, uint64_t * /*tick_stamp*/) const
+    {
+        fill_pattern((uint8_t *)buffer, get_id(), instance, get_num_bytes());
+        return true;
+    }
+
+    virtual bool copy_to_split_buffer(void * first, uint16_t first_size, void * second, uint16_t instance,
+                                      uint16_t num_bytes) const
+    {
+        uint8_t data[MSG_MAX_GLOB_SIZE];
+        fill_pattern(data, get_id(), instance, get_num_bytes());
+        glob_copy_split(first, first_size, second, data, num_bytes);
+        return true;
+    }
+
+    virtual bool copy_to_buffer_unlocked(void * buffer, uint16_t instance, uint64_t * tick_stamp) const
+    {
+        return copy_to_buffer(buffer, instance, tick_stamp);
+    }
+
+    virtual uint64_t get_tick_stamp(uint16_t /*instance*/) const { return 0; }
+};
+
+#undef GLOB
+#undef GLOB_SEQLOCK
+#define GLOB(var_name, struct_type, id, num_instances, owner_task) \
+    PatternGlob(id, PATTERN_GLOB_BYTES(id, sizeof(struct_type)), num_instances),
+#define GLOB_SEQLOCK GLOB
+static PatternGlob pattern_globs[NUM_GLOBS] =
+{
+#include "glob_list.h"
+};
+
+#undef GLOB
+#define GLOB(var_name, struct_type, id, num_instances, owner_task) &pattern_globs[id],
+GlobBase * const globs[NUM_GLOBS] =
+{
+#include "glob_list.h"
+};
+
+#endif
@@ -0,0 +1,192 @@
+// Compares the byte at a time GloRxLink::parse() against GloRxLink::parseAvailable() on the same
+// received byte stream.  Bytes are written into the (simulated) DMA receive buffer in chunks like they
+// would arrive between task runs, then parsed until the buffer is empty.  Reports messages/second,
+// bytes/second and how many calls (i.e. scheduler dispatches) it took.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/rx_parse_benchmark.cpp host/simulated_usart.cpp libraries/glo_link/glo_rx_link.cpp \
+       libraries/util/crc.cpp -o rx_parse_benchmark
+*/
+// Usage: rx_parse_benchmark [recorded stream file or -] [chunk size]
+// Without a file (or with -) it uses a generated stream of typical GUI messages.  Chunk size defaults to 64 bytes.
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "crc.h"
+#include "glo_rx_link.h"
+#include "globs.h"
+#include "system_timer.h"
+#include "usart.h"
+
+// Only the parts of the firmware the receive link uses are linked in, so stub out the rest.
+SystemTimer::SystemTimer(uint32_t /*interrupt_frequency*/) : rollover_ticks_(0), last_reported_ticks_(0), virtual_ticks_(0) {}
+SystemTimer sys_timer;
+void util_assert_failed(int /*action*/, char const * file_name, int line_number, const char * /*format*/, ...)
+{
+    printf("Assert failed %s:%d\n", file_name, line_number);
+}
+
+// Totals from the callback so both parsers can be checked against each other.
+static uint32_t num_received = 0;
+static uint32_t received_sum = 0;
+
+//******************************************************************************
+static void count_message(uint8_t object_id, uint16_t instance, void * glob_data)
+{
+    num_received++;
+    received_sum += object_id + instance + ((uint8_t *)glob_data)[0];
+}
+
+//******************************************************************************
+// Frame one glob the same way GloTxLink::send() does and add it to 'stream'.
+static void add_message(std::vector<uint8_t> & stream, uint8_t id, uint16_t instance, uint8_t num_bytes)
+{
+    static uint8_t packet_num = 0;
+    uint8_t message[300];
+
+    message[0] = 0xFE;
+    message[1] = 1;
+    message[2] = id;
+    message[3] = (uint8_t)instance;
+    message[4] = (uint8_t)(instance >> 8);
+    message[5] = packet_num++;
+    message[6] = num_bytes;
+    for (uint8_t i = 0; i < num_bytes; ++i)
+    {
+        message[7 + i] = (uint8_t)rand();
+    }
+
+    uint16_t crc = calculate_crc(message, 7 + num_bytes, 0xFFFF);
+    message[7 + num_bytes] = (uint8_t)crc;
+    message[8 + num_bytes] = (uint8_t)(crc >> 8);
+
+    stream.insert(stream.end(), message, message + 9 + num_bytes);
+}
+
+//******************************************************************************
+// Mix of what the GUI sends while driving and tuning.
+static std::vector<uint8_t> generate_stream(void)
+{
+    std::vector<uint8_t> stream;
+    srand(1);
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+        add_message(stream, GLO_ID_DRIVING_COMMAND, 1, sizeof(glo_driving_command_t));
+        add_message(stream, GLO_ID_REQUEST, 1, sizeof(glo_request_t));
+        if (i % 4 == 0) { add_message(stream, GLO_ID_PID_PARAMS, 1 + (i % NUM_PID_CONTROLLERS), sizeof(glo_pid_params_t)); }
+        if (i % 8 == 0) { add_message(stream, GLO_ID_WAVE, 1, sizeof(glo_wave_t)); }
+        if (i % 16 == 0) { add_message(stream, GLO_ID_ROBOT_COMMAND, 1, sizeof(glo_robot_command_t)); }
+        if (i % 32 == 0)
+        {
+            // Line noise between messages.
+            for (uint8_t n = 0; n < 5; ++n) { stream.push_back((uint8_t)rand()); }
+        }
+    }
+    return stream;
+}
+
+//******************************************************************************
+// Feed 'stream' through the port 'repeats' times and parse it. Return seconds taken.
+static double run(std::vector<uint8_t> const & stream, uint32_t chunk_size, uint32_t repeats, bool bulk, uint64_t * num_calls)
+{
+    Usart * port = Usart::instance(USART_BUS_2);
+    GloRxLink link(port, count_message);
+
+    *num_calls = 0;
+    num_received = 0;
+    received_sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t r = 0; r < repeats; ++r)
+    {
+        for (uint32_t offset = 0; offset < stream.size(); offset += chunk_size)
+        {
+            uint32_t length = stream.size() - offset;
+            if (length > chunk_size) { length = chunk_size; }
+            port->hostReceive(&stream[offset], length);
+
+            while (link.dataReady())
+            {
+                if (bulk) { link.parseAvailable(UINT32_MAX); }
+                else      { link.parse(); }
+                (*num_calls)++;
+            }
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//******************************************************************************
+static std::vector<uint8_t> read_stream(char const * file_name)
+{
+    std::vector<uint8_t> stream;
+    FILE * file = fopen(file_name, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't open %s\n", file_name);
+        exit(1);
+    }
+    int c;
+    while ((c = fgetc(file)) != EOF)
+    {
+        stream.push_back((uint8_t)c);
+    }
+    fclose(file);
+    return stream;
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    bool use_file = (argc > 1) && (strcmp(argv[1], "-") != 0);
+    std::vector<uint8_t> stream = use_file ? read_stream(argv[1]) : generate_stream();
+    uint32_t chunk_size = (argc > 2) ? atoi(argv[2]) : 64;
+
+    if (stream.empty())
+    {
+        fprintf(stderr, "Stream is empty\n");
+        return 1;
+    }
+
+    // Whole chunk has to fit in the receive buffer since it's emptied after each one.
+    if ((chunk_size == 0) || (chunk_size >= USART2_RX_BUFF_SIZE))
+    {
+        fprintf(stderr, "Chunk size must be between 1 and %d\n", USART2_RX_BUFF_SIZE - 1);
+        return 1;
+    }
+
+    // Repeat so each run takes long enough to time.
+    uint32_t repeats = 1 + (20000000 / (stream.size() + 1));
+
+    printf("Stream: %u bytes, %u byte chunks, %u repeats\n", (unsigned)stream.size(), chunk_size, repeats);
+    printf("%-16s %10s %14s %14s %14s\n", "Parser", "Messages", "Messages/s", "Bytes/s", "Calls/message");
+
+    uint32_t results[2][2];
+    for (int bulk = 0; bulk <= 1; ++bulk)
+    {
+        uint64_t num_calls = 0;
+        double seconds = run(stream, chunk_size, repeats, bulk, &num_calls);
+        printf("%-16s %10u %14.0f %14.0f %14.2f\n", bulk ? "parseAvailable" : "parse",
+               num_received / repeats, num_received / seconds, (double)stream.size() * repeats / seconds,
+               (double)num_calls / num_received);
+        results[bulk][0] = num_received;
+        results[bulk][1] = received_sum;
+    }
+
+    if ((results[0][0] != results[1][0]) || (results[0][1] != results[1][1]))
+    {
+        printf("Parsers disagree!\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+// Times how long the scheduler takes to pick and run each task as the number of registered tasks grows,
+// for both scheduling modes (see scheduling_mode_t).  Tasks are registered in groups of four, highest
+// priority first:
+//
+//   periodic  runs at 1000, 500, 200, 100, 50 or 20 Hz, queues an item for the next task every run and
+//             tells the polled task to run every 10th run
+//   queued    runs once for every item in its queue (READY_SOURCE_EVENT)
+//   polled    only has needToRun(), like the receive task (READY_SOURCE_POLLED)
+//   periodic  same as the first one but without the other two
+//
+// Tasks don't do anything else and take no time in the host sim, so the PC time per task run is all
+// scheduler overhead (plus the task call).  Both modes have to run every task the same number of times.
+//
+// The scheduling mode is picked at compile time since the firmware needs the scheduler to be a global,
+// so build once per mode from the firmware directory:
+/*
+   for mode in SCAN READY_SET; do
+     g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+         -DBENCHMARK_MODE=SCHEDULING_MODE_$mode \
+         $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+         host/tools/scheduler_benchmark.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+         host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+         scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+         libraries/glo_link/[a-z]*.cpp \
+         libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+         libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+         embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+         -o scheduler_benchmark_$mode
+   done
+*/
+// Usage: scheduler_benchmark [number of tasks] [simulated seconds]   (defaults to 16 and 60)
+// For example: for n in 8 16 64; do ./scheduler_benchmark_SCAN $n; ./scheduler_benchmark_READY_SET $n; done
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "globs.h"
+#include "host_port.h"
+#include "periodic_task.h"
+#include "queued_task.h"
+#include "scheduler.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+#ifndef BENCHMARK_MODE
+#define BENCHMARK_MODE SCHEDULING_MODE_READY_SET
+#endif
+
+// Same tasks as the host simulation (see host/main.cpp) since the firmware refers to them, but only
+// the benchmark tasks below are registered.
+SystemTimer sys_timer(1000);
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::BENCHMARK_MODE);
+
+// Periodic task rates, used in order for each group.
+static float const frequencies[] = { 1000, 500, 200, 100, 50, 20 };
+const uint8_t NUM_FREQUENCIES = sizeof(frequencies) / sizeof(frequencies[0]);
+
+// Total runs of every benchmark task.
+static uint64_t total_runs = 0;
+
+// Runs once for every item queued by a periodic task.
+class ConsumerTask : public Scheduler::QueuedTask<uint32_t>
+{
+  public: // methods
+
+    ConsumerTask(void) :
+        QueuedTask("Consumer", TASK_ID_STATUS_UPDATE, 8)
+    {
+    }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        uint32_t item;
+        queue_.dequeue(&item);
+        total_runs++;
+    }
+
+};
+
+// Runs whenever its flag is set, which the scheduler can only find out by asking.
+class PolledTask : public Scheduler::Task
+{
+  public: // methods
+
+    PolledTask(void) :
+        Task("Polled", TASK_ID_STATUS_UPDATE),
+        flag_(false)
+    {
+    }
+
+    // Make the task need to run.
+    void setFlag(void) { flag_ = true; }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual bool needToRun(void) { return flag_; }
+
+    virtual void run(void)
+    {
+        flag_ = false;
+        total_runs++;
+    }
+
+  private: // fields
+
+    bool flag_;
+
+};
+
+// Runs at a fixed rate, optionally feeding a consumer and polled task.
+class ProducerTask : public Scheduler::PeriodicTask
+{
+  public: // methods
+
+    ProducerTask(float frequency, ConsumerTask * consumer, PolledTask * polled) :
+        PeriodicTask("Producer", TASK_ID_STATUS_UPDATE, frequency),
+        consumer_(consumer),
+        polled_(polled),
+        count_(0)
+    {
+    }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        count_++;
+        if (consumer_ != NULL)
+        {
+            consumer_->enqueue(count_);
+        }
+        if ((polled_ != NULL) && (count_ % 10 == 0))
+        {
+            polled_->setFlag();
+        }
+        total_runs++;
+    }
+
+  private: // fields
+
+    ConsumerTask * consumer_;
+    PolledTask * polled_;
+    uint32_t count_;
+
+};
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_tasks = (argc > 1) ? atoi(argv[1]) : 16;
+    double simulated_seconds = (argc > 2) ? atof(argv[2]) : 60.0;
+
+    if ((num_tasks == 0) || (num_tasks > Scheduler::MAX_NUMBER_OF_TASKS))
+    {
+        printf("Number of tasks has to be 1 to %u\n", Scheduler::MAX_NUMBER_OF_TASKS);
+        return 1;
+    }
+
+    // Tasks are made before they're registered so a group's first task can refer to the ones after it.
+    uint32_t num_polled = 0;
+    for (uint32_t i = 0; i < num_tasks; i += 4)
+    {
+        float frequency = frequencies[(i / 4) % NUM_FREQUENCIES];
+        ConsumerTask * consumer = (i + 1 < num_tasks) ? new ConsumerTask() : NULL;
+        PolledTask * polled = (i + 2 < num_tasks) ? new PolledTask() : NULL;
+
+        scheduler.registerTask(*new ProducerTask(frequency, consumer, polled));
+        if (consumer != NULL)
+        {
+            scheduler.registerTask(*consumer);
+        }
+        if (polled != NULL)
+        {
+            scheduler.registerTask(*polled);
+            num_polled++;
+        }
+        if (i + 3 < num_tasks)
+        {
+            scheduler.registerTask(*new ProducerTask(frequency, NULL, NULL));
+        }
+    }
+
+    host_stop_ticks = (uint64_t)(simulated_seconds * sys_timer.frequency());
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.scheduleTasks();
+    auto stop = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    char const * mode = (Scheduler::BENCHMARK_MODE == Scheduler::SCHEDULING_MODE_SCAN) ? "scan" : "ready-set";
+    printf("%-9s %2u tasks (%2u polled): %9llu runs in %.0f simulated seconds, %6.1f ns per run\n", mode,
+           num_tasks, num_polled, (unsigned long long)total_runs, simulated_seconds, seconds * 1e9 / total_runs);
+
+    return 0;
+}
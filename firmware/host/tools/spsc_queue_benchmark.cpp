@@ -0,0 +1,424 @@
+// Checks SpscQueue with a producer and consumer thread and compares it to the interrupt masking Queue.
+// It runs in three parts:
+//
+//   stress     a producer thread enqueues numbered items one at a time or in random batches while a
+//              consumer thread takes them out with dequeue(), dequeue_n() or front() and remove(), on a
+//              small queue so it's full and empty a lot.  Every item has to come out once, in order and
+//              with the data it went in with.  Then the same with a bigger queue to get the throughput.
+//   one core   nanoseconds to enqueue and dequeue an item with one thread doing both, which is what the
+//              robot does (a task or interrupt on each side, one core).  Queue against SpscQueue, plus
+//              SpscQueue moving batches.
+//   scheduler  a periodic task sends the same items to a QueuedTask on each kind of queue in the host sim,
+//              counting how many times interrupts are disabled for each item sent and received.
+//              Enqueuing to a QueuedTask on a Queue also tells the scheduler (Scheduler::setTaskReady()),
+//              while one on an SpscQueue is polled instead.
+//
+// Queue disables interrupts, which there's no PC version of for two threads, so it's only in the one core
+// and scheduler parts.  Disabling interrupts is just a flag on the PC, while on the robot it's also the
+// interrupts that have to wait, so the one core times are only a rough guide.  On a PC with one core the
+// two threads take turns, so the stress throughput is mostly the OS switching between them.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -pthread -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/spsc_queue_benchmark.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+       host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+       scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+       libraries/glo_link/[a-z]*.cpp \
+       libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+       libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+       embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+       -o spsc_queue_benchmark
+*/
+// Usage: spsc_queue_benchmark [stress items] [timing items] [simulated seconds]
+//        (default to 20000000, 50000000 and 60)
+
+// Includes
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "globs.h"
+#include "host_port.h"
+#include "periodic_task.h"
+#include "queue.h"
+#include "queued_task.h"
+#include "scheduler.h"
+#include "spsc_queue.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Same tasks as the host simulation (see host/main.cpp) since the firmware refers to them, but only
+// the tasks below are registered.
+SystemTimer sys_timer(1000);
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+// Queue sizes for the stress check (small so it's full and empty a lot) and the throughput.
+const uint32_t STRESS_QUEUE_SIZE = 16;
+const uint32_t THROUGHPUT_QUEUE_SIZE = 1024;
+
+// Most items moved at once by enqueue_n() and dequeue_n().
+const uint32_t MAX_BATCH = 8;
+
+// Items the one core timing keeps in the queue, like a task that's behind.
+const uint32_t NUM_WAITING = 4;
+
+// Items the periodic task sends to each queued task every run.
+const uint32_t ITEMS_PER_RUN = 3;
+
+// About the size of what the send task queues (glob_queue_t).  The data is worked out from the sequence
+// number so the consumer can tell if it got a torn or stale copy.
+struct item_t
+{
+    uint32_t sequence;
+    uint32_t data[3];
+};
+
+// How many times interrupts have been disabled, from host_interrupts_masked.
+static uint64_t num_masks = 0;
+
+//******************************************************************************
+static item_t make_item(uint32_t sequence)
+{
+    item_t item;
+    item.sequence = sequence;
+    item.data[0] = sequence * 2654435761UL;
+    item.data[1] = ~sequence;
+    item.data[2] = sequence ^ 0xA5A5A5A5UL;
+    return item;
+}
+
+//******************************************************************************
+// Return true if 'item' is the one made for 'sequence'.
+static bool item_valid(item_t const & item, uint32_t sequence)
+{
+    item_t expected = make_item(sequence);
+    return (item.sequence == expected.sequence) && (item.data[0] == expected.data[0]) &&
+           (item.data[1] == expected.data[1]) && (item.data[2] == expected.data[2]);
+}
+
+//******************************************************************************
+static void count_masks(bool masked)
+{
+    if (masked)
+    {
+        num_masks++;
+    }
+}
+
+//******************************************************************************
+// Producer thread. Batches of random sizes if 'random_batches', otherwise one at a time.
+static void produce(Scheduler::SpscQueue<item_t> * queue, uint32_t num_items, bool random_batches)
+{
+    uint32_t seed = 12345;
+    uint32_t next = 0;
+    while (next < num_items)
+    {
+        uint32_t batch = 1;
+        if (random_batches)
+        {
+            seed = seed * 1103515245 + 12345;
+            batch = (seed >> 16) % MAX_BATCH + 1;
+        }
+        batch = (batch > num_items - next) ? (num_items - next) : batch;
+
+        item_t items[MAX_BATCH];
+        for (uint32_t i = 0; i < batch; ++i)
+        {
+            items[i] = make_item(next + i);
+        }
+
+        uint32_t num_added = (batch == 1) ? (queue->enqueue(items[0]) ? 1 : 0) : queue->enqueue_n(items, batch);
+        if (num_added == 0)
+        {
+            std::this_thread::yield(); // full
+        }
+        next += num_added;
+    }
+}
+
+//******************************************************************************
+// Consumer thread.  Goes through the ways of taking items out if 'mixed', otherwise one at a time.
+// Return how many items were wrong or out of order.
+static uint32_t consume(Scheduler::SpscQueue<item_t> * queue, uint32_t num_items, bool mixed)
+{
+    uint32_t num_bad = 0;
+    uint32_t next = 0;
+    uint32_t way = 0;
+    while (next < num_items)
+    {
+        item_t items[MAX_BATCH];
+        uint32_t num_removed = 0;
+        way = mixed ? (way + 1) % 3 : 0;
+
+        if (way == 0)
+        {
+            num_removed = queue->dequeue(&items[0]) ? 1 : 0;
+        }
+        else if (way == 1)
+        {
+            num_removed = queue->dequeue_n(items, (next % MAX_BATCH) + 1);
+        }
+        else
+        {
+            item_t * front = queue->front();
+            if (front != NULL)
+            {
+                items[0] = *front;
+                num_removed = queue->remove() ? 1 : 0;
+            }
+        }
+
+        if (num_removed == 0)
+        {
+            std::this_thread::yield(); // empty
+        }
+        for (uint32_t i = 0; i < num_removed; ++i)
+        {
+            num_bad += item_valid(items[i], next + i) ? 0 : 1;
+        }
+        next += num_removed;
+    }
+    return num_bad;
+}
+
+//******************************************************************************
+// Run a producer and consumer thread.  Return how many items were wrong or out of order and how long it took.
+static uint32_t run_threads(uint32_t queue_size, uint32_t num_items, bool mixed, double * seconds)
+{
+    Scheduler::SpscQueue<item_t> queue(queue_size);
+    uint32_t num_bad = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&]() { num_bad = consume(&queue, num_items, mixed); });
+    std::thread producer(produce, &queue, num_items, mixed);
+    producer.join();
+    consumer.join();
+    auto stop = std::chrono::steady_clock::now();
+
+    *seconds = std::chrono::duration<double>(stop - start).count();
+    return num_bad + queue.count();
+}
+
+//******************************************************************************
+// Return nanoseconds to enqueue and dequeue an item one at a time with one thread.
+template <class QueueType>
+static double time_one_core(uint32_t num_items, uint32_t * sum)
+{
+    QueueType queue(THROUGHPUT_QUEUE_SIZE);
+    item_t item = make_item(0);
+    for (uint32_t i = 0; i < NUM_WAITING; ++i)
+    {
+        queue.enqueue(item);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_items; ++i)
+    {
+        item.sequence = i;
+        queue.enqueue(item);
+        queue.dequeue(&item);
+        *sum += item.sequence;
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / num_items;
+}
+
+//******************************************************************************
+// Return nanoseconds per item to enqueue and dequeue items in batches of MAX_BATCH with one thread.
+static double time_one_core_batches(uint32_t num_items, uint32_t * sum)
+{
+    Scheduler::SpscQueue<item_t> queue(THROUGHPUT_QUEUE_SIZE);
+    item_t items[MAX_BATCH];
+    for (uint32_t i = 0; i < MAX_BATCH; ++i)
+    {
+        items[i] = make_item(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_items; i += MAX_BATCH)
+    {
+        items[0].sequence = i;
+        queue.enqueue_n(items, MAX_BATCH);
+        queue.dequeue_n(items, MAX_BATCH);
+        *sum += items[0].sequence;
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / num_items;
+}
+
+// Takes items out of its queue, checking they come in order and counting interrupt masks.
+template <class QueueType>
+class ConsumerTask : public Scheduler::QueuedTask<item_t, QueueType>
+{
+  public: // methods
+
+    ConsumerTask(void) :
+        Scheduler::QueuedTask<item_t, QueueType>("Consumer", TASK_ID_STATUS_UPDATE, 64),
+        num_received_(0),
+        num_bad_(0),
+        num_receive_masks_(0),
+        num_send_masks_(0)
+    {
+    }
+
+    // Queue 'item' to the task, counting interrupt masks.  Return false if the queue is full.
+    bool send(item_t & item)
+    {
+        uint64_t masks_before = num_masks;
+        bool success = this->enqueue(item);
+        num_send_masks_ += num_masks - masks_before;
+        return success;
+    }
+
+    // Accessors
+    uint32_t numReceived(void) const { return num_received_; }
+    uint32_t numBad(void) const { return num_bad_; }
+    uint64_t numReceiveMasks(void) const { return num_receive_masks_; }
+    uint64_t numSendMasks(void) const { return num_send_masks_; }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        uint64_t masks_before = num_masks;
+        item_t item;
+        if (this->queue_.dequeue(&item))
+        {
+            num_bad_ += item_valid(item, num_received_) ? 0 : 1;
+            num_received_++;
+        }
+        num_receive_masks_ += num_masks - masks_before;
+    }
+
+  private: // fields
+
+    uint32_t num_received_;
+    uint32_t num_bad_;
+    uint64_t num_receive_masks_;
+    uint64_t num_send_masks_;
+
+};
+
+static ConsumerTask<Scheduler::Queue<item_t> > masking_consumer;
+static ConsumerTask<Scheduler::SpscQueue<item_t> > lock_free_consumer;
+
+// Sends the same items to both consumers.
+class ProducerTask : public Scheduler::PeriodicTask
+{
+  public: // methods
+
+    ProducerTask(void) :
+        PeriodicTask("Producer", TASK_ID_STATUS_UPDATE, 1000),
+        num_sent_(0)
+    {
+    }
+
+    // Return how many items were sent to each consumer.
+    uint32_t numSent(void) const { return num_sent_; }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        for (uint32_t i = 0; i < ITEMS_PER_RUN; ++i)
+        {
+            item_t item = make_item(num_sent_);
+            bool sent = masking_consumer.send(item);
+            item = make_item(num_sent_);
+            sent = lock_free_consumer.send(item) && sent;
+            num_sent_ += sent ? 1 : 0;
+        }
+    }
+
+  private: // fields
+
+    uint32_t num_sent_;
+
+};
+
+static ProducerTask producer_task;
+
+//******************************************************************************
+template <class QueueType>
+static void print_consumer(char const * name, ConsumerTask<QueueType> const & consumer, uint32_t num_sent)
+{
+    printf("  %-10s %9u received, %u wrong, %5.2f masks to send and %5.2f to receive each item\n", name,
+           consumer.numReceived(), consumer.numBad() + (num_sent - consumer.numReceived()),
+           (double)consumer.numSendMasks() / num_sent, (double)consumer.numReceiveMasks() / consumer.numReceived());
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint32_t num_stress_items = (argc > 1) ? atoi(argv[1]) : 20000000;
+    uint32_t num_timing_items = (argc > 2) ? atoi(argv[2]) : 50000000;
+    double simulated_seconds = (argc > 3) ? atof(argv[3]) : 60.0;
+
+    double seconds = 0;
+    uint32_t num_bad = run_threads(STRESS_QUEUE_SIZE, num_stress_items, true, &seconds);
+    printf("Stress: %u items through %u slots in random batches, %u wrong or out of order (%.1f s)\n",
+           num_stress_items, STRESS_QUEUE_SIZE, num_bad, seconds);
+    bool stress_passed = (num_bad == 0);
+
+    num_bad = run_threads(THROUGHPUT_QUEUE_SIZE, num_stress_items, false, &seconds);
+    printf("Two threads: %u items one at a time through %u slots, %u wrong, %.1f ns per item\n",
+           num_stress_items, THROUGHPUT_QUEUE_SIZE, num_bad, seconds * 1e9 / num_stress_items);
+    stress_passed = stress_passed && (num_bad == 0);
+
+    uint32_t sum = 0;
+    double masking_ns = time_one_core<Scheduler::Queue<item_t> >(num_timing_items, &sum);
+    double lock_free_ns = time_one_core<Scheduler::SpscQueue<item_t> >(num_timing_items, &sum);
+    double batch_ns = time_one_core_batches(num_timing_items, &sum);
+    // Counted separately so counting doesn't slow down the timing.
+    host_interrupts_masked = count_masks;
+    time_one_core<Scheduler::Queue<item_t> >(1000, &sum);
+    double masks_per_item = num_masks / 1000.0;
+
+    printf("One core: ns to enqueue and dequeue an item with %u waiting (sum %u)\n", NUM_WAITING, sum);
+    printf("  Queue %.2f ns (%.0f masks), SpscQueue %.2f ns, SpscQueue in batches of %u %.2f ns\n",
+           masking_ns, masks_per_item, lock_free_ns, MAX_BATCH, batch_ns);
+
+    scheduler.registerTask(producer_task);
+    scheduler.registerTask(masking_consumer);
+    scheduler.registerTask(lock_free_consumer);
+
+    host_stop_ticks = (uint64_t)(simulated_seconds * sys_timer.frequency());
+    scheduler.scheduleTasks();
+
+    uint32_t num_sent = producer_task.numSent();
+    printf("Scheduler: %u items sent to each queued task over %.0f simulated seconds\n", num_sent, simulated_seconds);
+    print_consumer("Queue", masking_consumer, num_sent);
+    print_consumer("SpscQueue", lock_free_consumer, num_sent);
+    bool scheduler_passed = (masking_consumer.numBad() == 0) && (masking_consumer.numReceived() == num_sent) &&
+                            (lock_free_consumer.numBad() == 0) && (lock_free_consumer.numReceived() == num_sent) &&
+                            (lock_free_consumer.numSendMasks() == 0) && (lock_free_consumer.numReceiveMasks() == 0);
+
+    printf("Stress %s, scheduler %s\n", stress_passed ? "passed" : "FAILED", scheduler_passed ? "passed" : "FAILED");
+
+    return (stress_passed && scheduler_passed) ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+// Runs TelemetrySendTask against a serial port that drains at 115200 baud (8N1) to see how well status
+// updates get through while the link is loaded.  A load task sends status data at 5 Hz the whole time
+// and adds a different load in each phase:
+//
+//   idle          status only
+//   capture dump  every instance of the capture data glob is requested every 10 seconds
+//   debug bursts  12 debug messages every half second
+//
+// For each phase it reports status latency (queued to last byte on the wire), the link's bytes/second
+// and the telemetry stats glob the send task published at the end of it.  Pass 0 to turn the shaping
+// off (see TelemetrySendTask::set_shaping()) so classes are still sent in priority order but any class
+// can fill the transfer buffer.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/telemetry_shaping.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+       host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+       scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+       libraries/glo_link/[a-z]*.cpp \
+       libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+       libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+       embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+       -o telemetry_shaping
+*/
+// Usage: telemetry_shaping [shaping 0 or 1]   (defaults to 1)
+
+// Includes
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include "debug_printf.h"
+#include "glo_frame.h"
+#include "globs.h"
+#include "host_port.h"
+#include "periodic_task.h"
+#include "scheduler.h"
+#include "util_assert.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Same tasks as the host simulation (see host/main.cpp) since the firmware refers to them, but only
+// the send task and the load task below are registered.
+SystemTimer sys_timer(1000);
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+// Bytes per second on a 115200 baud 8N1 link.
+const double LINK_BYTES_PER_SECOND = 115200.0 / 10.0;
+
+// Load phases.
+enum
+{
+    PHASE_IDLE,
+    PHASE_CAPTURE_DUMP,
+    PHASE_DEBUG_BURSTS,
+    NUM_PHASES
+};
+static char const * const phase_names[NUM_PHASES] = { "idle", "capture dump", "debug bursts" };
+const double PHASE_SECONDS = 20.0;
+
+// Simulated link: time the last queued byte is on the wire.
+static double wire_free_seconds = 0;
+
+// Time each status update was queued, oldest first.
+static std::deque<double> status_queued_seconds;
+
+// Results for each phase.
+struct phase_results_t
+{
+    uint32_t num_status;
+    double   status_latency_sum;
+    double   status_latency_max;
+    uint64_t num_wire_bytes;
+    glo_telemetry_stats_t stats;
+};
+static phase_results_t results[NUM_PHASES];
+
+//******************************************************************************
+static uint8_t current_phase(void)
+{
+    uint8_t phase = (uint8_t)(sys_timer.seconds() / PHASE_SECONDS);
+    return (phase < NUM_PHASES) ? phase : NUM_PHASES - 1;
+}
+
+//******************************************************************************
+static uint32_t wire_backlog(void)
+{
+    double seconds_left = wire_free_seconds - sys_timer.seconds();
+    return (seconds_left > 0) ? (uint32_t)(seconds_left * LINK_BYTES_PER_SECOND + 0.5) : 0;
+}
+
+//******************************************************************************
+static void record_status_sent(double sent_seconds)
+{
+    if (status_queued_seconds.empty())
+    {
+        return;
+    }
+
+    phase_results_t & result = results[current_phase()];
+    double latency = sent_seconds - status_queued_seconds.front();
+    status_queued_seconds.pop_front();
+
+    result.num_status++;
+    result.status_latency_sum += latency;
+    if (latency > result.status_latency_max)
+    {
+        result.status_latency_max = latency;
+    }
+}
+
+//******************************************************************************
+// Called with each frame the send task commits.  Queue it on the simulated wire and note when any
+// status data in it is done being sent.
+static void send_frame(uint8_t const * frame, uint16_t length)
+{
+    double now = sys_timer.seconds();
+    double start = (wire_free_seconds > now) ? wire_free_seconds : now;
+    wire_free_seconds = start + length / LINK_BYTES_PER_SECOND;
+
+    results[current_phase()].num_wire_bytes += length;
+
+    if (frame[MSG_ID_IDX] == GLO_ID_STATUS_DATA)
+    {
+        record_status_sent(wire_free_seconds);
+    }
+    else if (frame[MSG_ID_IDX] == MSG_BATCH_ID)
+    {
+        uint16_t offset = MSG_HEADER_SIZE;
+        for (uint8_t record = 0; record < frame[MSG_INSTANCE_IDX]; ++record)
+        {
+            uint8_t const * record_header = frame + offset;
+            for (uint8_t i = 0; (record_header[0] == GLO_ID_STATUS_DATA) && (i < record_header[3]); ++i)
+            {
+                record_status_sent(wire_free_seconds);
+            }
+            offset += MSG_RECORD_HEADER_SIZE + record_header[3] * record_header[4];
+        }
+    }
+}
+
+// Adds the load for whatever phase it is.
+class LoadTask : public Scheduler::PeriodicTask
+{
+  public: // methods
+
+    LoadTask(void) :
+        PeriodicTask("Load", TASK_ID_STATUS_UPDATE, 50),
+        last_phase_(PHASE_IDLE)
+    {
+    }
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    virtual void run(void)
+    {
+        uint8_t phase = current_phase();
+        if (phase != last_phase_)
+        {
+            // Save what the send task reported for the last phase.
+            glo_telemetry_stats.read(&results[last_phase_].stats);
+            last_phase_ = phase;
+        }
+
+        double phase_seconds = sys_timer.seconds() - phase * PHASE_SECONDS;
+
+        if (throttleHz(5))
+        {
+            status_queued_seconds.push_back(sys_timer.seconds());
+            if (!send_task.send(GLO_ID_STATUS_DATA))
+            {
+                status_queued_seconds.pop_back();
+            }
+        }
+
+        if ((phase == PHASE_CAPTURE_DUMP) && throttle(10) && (phase_seconds > 1))
+        {
+            send_task.send(GLO_ID_CAPTURE_DATA, 1, glo_capture_data.get_num_instances() - 1);
+        }
+
+        if ((phase == PHASE_DEBUG_BURSTS) && throttle(0.5))
+        {
+            for (int i = 0; i < 12; ++i)
+            {
+                debug_printf("Debug message %d of a burst sent at %.1f seconds to load the link.", i, sys_timer.seconds());
+            }
+        }
+    }
+
+  private: // fields
+
+    uint8_t last_phase_;
+
+};
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    bool shaping = (argc > 1) ? (atoi(argv[1]) != 0) : true;
+
+    LoadTask load_task;
+
+    host_tx_sink = send_frame;
+    host_tx_backlog = wire_backlog;
+    host_stop_ticks = (uint64_t)(NUM_PHASES * PHASE_SECONDS * sys_timer.frequency());
+
+    scheduler.registerTask(load_task);
+    scheduler.registerTask(send_task);
+
+    send_task.set_shaping(shaping);
+
+    scheduler.scheduleTasks();
+
+    glo_telemetry_stats.read(&results[NUM_PHASES - 1].stats);
+
+    printf("Shaping %s, %.0f bytes/s link, %.0f s per phase\n", shaping ? "on" : "off", LINK_BYTES_PER_SECOND, PHASE_SECONDS);
+    printf("%-13s %7s %11s %11s %9s   %-23s %-17s %-11s\n", "Phase", "Status", "Latency ms", "Max ms", "Link B/s",
+           "Class B/s (crit/ctl/bulk)", "Max queue depth", "Dropped");
+    for (uint8_t phase = 0; phase < NUM_PHASES; ++phase)
+    {
+        phase_results_t const & result = results[phase];
+        glo_telemetry_stats_t const & stats = result.stats;
+        printf("%-13s %7u %11.1f %11.1f %9.0f   %5.0f /%6.0f /%6.0f   %4u /%4u /%4u   %3u/%3u/%3u\n",
+               phase_names[phase], result.num_status,
+               (result.num_status > 0) ? 1000.0 * result.status_latency_sum / result.num_status : 0.0,
+               1000.0 * result.status_latency_max, result.num_wire_bytes / PHASE_SECONDS,
+               stats.bytes_per_second[TELEMETRY_CLASS_CRITICAL], stats.bytes_per_second[TELEMETRY_CLASS_CONTROL],
+               stats.bytes_per_second[TELEMETRY_CLASS_BULK],
+               stats.max_queue_depth[TELEMETRY_CLASS_CRITICAL], stats.max_queue_depth[TELEMETRY_CLASS_CONTROL],
+               stats.max_queue_depth[TELEMETRY_CLASS_BULK],
+               stats.num_dropped[TELEMETRY_CLASS_CRITICAL], stats.num_dropped[TELEMETRY_CLASS_CONTROL],
+               stats.num_dropped[TELEMETRY_CLASS_BULK]);
+    }
+    printf("Status updates left queued: %u\n", (unsigned)status_queued_seconds.size());
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Compares sending one glob per frame against batch frames (see glo_frame.h) for a capture dump and
+// a status stream.  Everything is framed by the firmware's GloTxLink, decoded again by GloRxLink and
+// checked, then the effective payload throughput is reported for a 115200 baud link (8N1, so 10 bits
+// on the wire per byte).
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/telemetry_throughput.cpp host/simulated_usart.cpp libraries/glo_link/glo_rx_link.cpp \
+       libraries/glo_link/glo_tx_link.cpp libraries/util/crc.cpp -o telemetry_throughput
+*/
+// Usage: telemetry_throughput [max frame size]   (defaults to the largest frame, 264 bytes)
+
+// Includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "glo_rx_link.h"
+#include "glo_tx_link.h"
+#include "globs.h"
+#include "host_port.h"
+#include "pattern_globs.h"
+#include "system_timer.h"
+#include "usart.h"
+
+// Only the parts of the firmware the links use are linked in, so stub out the rest.
+SystemTimer::SystemTimer(uint32_t /*interrupt_frequency*/) : rollover_ticks_(0), last_reported_ticks_(0), virtual_ticks_(0) {}
+SystemTimer sys_timer;
+void util_assert_failed(int /*action*/, char const * file_name, int line_number, const char * /*format*/, ...)
+{
+    printf("Assert failed %s:%d\n", file_name, line_number);
+}
+
+// Bytes per second on a 115200 baud 8N1 link.
+const double LINK_BYTES_PER_SECOND = 115200.0 / 10.0;
+
+// One glob instance to send.
+struct glob_ref_t
+{
+    uint8_t  id;
+    uint16_t instance;
+};
+
+// Everything the transmit link wrote to the serial port.
+static std::vector<uint8_t> wire;
+
+// Globs the receive link decoded that didn't match what was sent.
+static std::vector<glob_ref_t> const * expected = NULL;
+static uint32_t num_decoded = 0;
+static uint32_t num_mismatched = 0;
+
+//******************************************************************************
+static void capture_wire(uint8_t const * data, uint16_t length)
+{
+    wire.insert(wire.end(), data, data + length);
+}
+
+//******************************************************************************
+static void check_decoded(uint8_t object_id, uint16_t instance, void * glob_data)
+{
+    uint8_t pattern[256];
+    glob_ref_t const & ref = (*expected)[num_decoded % expected->size()];
+    uint8_t num_bytes = globs[ref.id]->get_num_bytes();
+    fill_pattern(pattern, ref.id, ref.instance, num_bytes);
+
+    if ((object_id != ref.id) || (instance != ref.instance) || (memcmp(pattern, glob_data, num_bytes) != 0))
+    {
+        num_mismatched++;
+    }
+    num_decoded++;
+}
+
+//******************************************************************************
+// Frame 'refs' the same way TelemetrySendTask::run() does, either one per frame or packed into
+// batch frames of up to 'mtu' bytes.  Return number of payload (glob data) bytes.
+static uint32_t encode(GloTxLink & link, std::vector<glob_ref_t> const & refs, uint16_t mtu)
+{
+    uint32_t num_payload_bytes = 0;
+    size_t next = 0;
+
+    while (next < refs.size())
+    {
+        if (mtu != 0)
+        {
+            link.beginBatch(mtu);
+        }
+
+        do
+        {
+            glob_ref_t const & ref = refs[next];
+            uint8_t result = (mtu != 0) ? link.addToBatch(ref.id, ref.instance) :
+                                          link.send(ref.id, ref.instance);
+            if (result == SEND_ERROR_NO_ROOM)
+            {
+                break;
+            }
+            num_payload_bytes += globs[ref.id]->get_num_bytes();
+            next++;
+        }
+        while ((mtu != 0) && (next < refs.size()));
+
+        if (mtu != 0)
+        {
+            link.endBatch();
+        }
+    }
+
+    return num_payload_bytes;
+}
+
+//******************************************************************************
+// Feed the captured wire bytes through the receive link in chunks that fit the receive buffer.
+static void decode(std::vector<glob_ref_t> const & refs)
+{
+    Usart * port = Usart::instance(USART_BUS_2);
+    GloRxLink link(port, check_decoded);
+
+    expected = &refs;
+    num_decoded = 0;
+    num_mismatched = 0;
+
+    const uint32_t chunk_size = USART2_RX_BUFF_SIZE / 2;
+    for (uint32_t offset = 0; offset < wire.size(); offset += chunk_size)
+    {
+        uint32_t length = wire.size() - offset;
+        if (length > chunk_size) { length = chunk_size; }
+        port->hostReceive(&wire[offset], length);
+        link.parseAvailable(UINT32_MAX);
+    }
+}
+
+//******************************************************************************
+// Send 'refs' both ways and print the results.  Return false if anything didn't decode.
+static bool run(char const * name, std::vector<glob_ref_t> const & refs, uint16_t mtu)
+{
+    bool all_decoded = true;
+
+    for (int batched = 0; batched <= 1; ++batched)
+    {
+        GloTxLink link(Usart::instance(USART_BUS_2));
+        wire.clear();
+
+        uint32_t num_payload_bytes = encode(link, refs, batched ? mtu : 0);
+        decode(refs);
+
+        double efficiency = (double)num_payload_bytes / wire.size();
+        printf("%-14s %-8s %10u %10u %10.1f%% %12.0f %10.3f %9u\n", name, batched ? "batched" : "single",
+               num_payload_bytes, (unsigned)wire.size(), 100.0 * efficiency, efficiency * LINK_BYTES_PER_SECOND,
+               wire.size() / LINK_BYTES_PER_SECOND, num_decoded);
+
+        if ((num_decoded != refs.size()) || (num_mismatched != 0))
+        {
+            printf("  decoded %u of %u globs, %u mismatched\n", num_decoded, (unsigned)refs.size(), num_mismatched);
+            all_decoded = false;
+        }
+    }
+
+    return all_decoded;
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    uint16_t mtu = (argc > 1) ? atoi(argv[1]) : MSG_MAX_FRAME_SIZE;
+
+    host_tx_sink = capture_wire;
+
+    // Full capture dump like MainControlTask sends when a capture finishes.
+    std::vector<glob_ref_t> capture_dump;
+    for (uint16_t instance = 1; instance <= 2000; ++instance)
+    {
+        glob_ref_t ref = { GLO_ID_CAPTURE_DATA, instance };
+        capture_dump.push_back(ref);
+    }
+
+    // Status plus the globs a GUI plots live, sent together every update.
+    std::vector<glob_ref_t> status_stream;
+    uint8_t const status_ids[] = { GLO_ID_STATUS_DATA, GLO_ID_ODOMETRY, GLO_ID_IMU,
+                                   GLO_ID_ROLL_PITCH_YAW, GLO_ID_MOTOR_PWM, GLO_ID_MODES };
+    for (uint16_t update = 0; update < 1000; ++update)
+    {
+        for (uint8_t i = 0; i < sizeof(status_ids); ++i)
+        {
+            glob_ref_t ref = { status_ids[i], 1 };
+            status_stream.push_back(ref);
+        }
+    }
+
+    printf("Max frame size %u bytes, 115200 baud (%.0f bytes/s)\n", mtu, LINK_BYTES_PER_SECOND);
+    printf("%-14s %-8s %10s %10s %11s %12s %10s %9s\n", "Stream", "Frames", "Payload", "Wire", "Efficiency",
+           "Payload B/s", "Seconds", "Decoded");
+
+    bool all_decoded = run("capture dump", capture_dump, mtu);
+    all_decoded &= run("status stream", status_stream, mtu);
+
+    return all_decoded ? 0 : 1;
+}
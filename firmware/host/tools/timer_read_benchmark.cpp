@@ -0,0 +1,249 @@
+// Counts how often the firmware reads the time during each 1 kHz control cycle and times each kind of
+// read on a simulated systick counter, to see what sampling the ticks once per scheduler loop
+// (Scheduler::currentTicks()) and measuring run times with the cycle counter (SystemTimer::cycles())
+// saves over calling SystemTimer::ticks() every time.
+//
+// The reads are counted by running the host sim with the robot's tasks (see host/main.cpp).  Without the
+// snapshot every snapshot read would be a ticks() call, and every task run would read ticks() once when
+// it finished instead of reading the cycle counter before and after.
+//
+// Each read is then timed on the PC against a count-down counter in memory standing in for systick,
+// with interrupt masking modeled as a flag like the host port does:
+//
+//   ticks() before  rollover count times the reload value, which is what ticks() used to do
+//   ticks() now     rollover ticks accumulated by the interrupt plus the pending interrupt check
+//   cycles()        one 32 bit read
+//   snapshot        one 64 bit read of memory
+//
+// The time a call that doesn't read anything takes (moving the counter on and the loop) is taken off, which
+// leaves the two single reads within the PC's noise of zero.
+//
+// The PC doesn't mask interrupts or do 64 bit math the way the robot does, so the times are only a rough
+// guide.  The read counts are the same as the robot's.
+//
+// Build from the firmware directory:
+/*
+   g++ -std=gnu++11 -O2 -DHOST_PORT -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER \
+       $(find . -type d -name include -not -path '*obj*' | sed 's/^/-I/') -Ilibraries/cmsis \
+       host/tools/timer_read_benchmark.cpp host/scheduler_port_host.cpp host/simulated_drivers.cpp \
+       host/simulated_usart.cpp host/system_timer_host.cpp globs/[a-z]*.cpp scheduler/scheduler.cpp \
+       scheduler/task.cpp scheduler/periodic_task.cpp tasks/[a-z]*.cpp modes/[a-z]*.cpp modes/experiments/[a-z]*.cpp \
+       libraries/glo_link/[a-z]*.cpp \
+       libraries/util/{complementary_filter,coordinate_conversions,crc,debug_printf,derivative_filter,fifo_arena}.cpp \
+       libraries/util/{pid_controller,six_point_sensor_cal,util_assert}.cpp \
+       embitz_projects/eeva_full_version/source/robot_settings.cpp -x c libraries/util/trigtables.c \
+       -o timer_read_benchmark
+*/
+// Usage: timer_read_benchmark [simulated seconds] [reads to time]   (defaults to 60 and 100000000)
+
+// Includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "globs.h"
+#include "host_port.h"
+#include "scheduler.h"
+#include "util_assert.h"
+
+// Task includes
+#include "complementary_filter_task.h"
+#include "leds_task.h"
+#include "main_control_task.h"
+#include "modes_task.h"
+#include "status_update_task.h"
+#include "telemetry_receive_task.h"
+#include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
+
+// Same setup as the robot (see embitz_projects/eeva_full_version/source/main.cpp)
+SystemTimer sys_timer(1000);
+MainControlTask          main_control_task   (1000);
+ComplementaryFilterTask  comp_filter_task     (500);
+StatusUpdateTask         status_update_task     (5);
+LedsTask                 leds_task             (20);
+ModesTask                modes_task            (20);
+TelemetryStreamTask      stream_task          (100);
+TelemetrySendTask        send_task             (40);
+TelemetryReceiveTask     receive_task;
+Scheduler::Scheduler scheduler(Scheduler::SCHEDULING_MODE_READY_SET);
+
+// Simulated systick.  Counts down from the reload value (168 MHz / 1 kHz) once per read.
+const uint32_t RELOAD_VALUE = 168000;
+static volatile uint32_t systick_val = RELOAD_VALUE;
+static volatile uint32_t systick_pending = 0;
+static volatile uint64_t rollover_count = 0;
+static volatile uint64_t rollover_ticks = 0;
+static volatile uint64_t last_reported_ticks = 0;
+
+// Simulated PRIMASK, the DWT cycle counter and the scheduler's snapshot.
+static volatile bool interrupts_disabled = false;
+static volatile uint32_t cycle_counter = 0;
+static volatile uint64_t snapshot_ticks = 0;
+
+//******************************************************************************
+static bool __attribute__((noinline)) disable_interrupts(void)
+{
+    bool already_enabled = !interrupts_disabled;
+    interrupts_disabled = true;
+    return already_enabled;
+}
+
+//******************************************************************************
+static void __attribute__((noinline)) restore_interrupts(bool enabled)
+{
+    if (enabled)
+    {
+        interrupts_disabled = false;
+    }
+}
+
+//******************************************************************************
+// Move the simulated counter on one tick, running the 'interrupt' when it reaches zero.
+static inline void tick(void)
+{
+    uint32_t val = systick_val;
+    if (val <= 1)
+    {
+        rollover_count = rollover_count + 1;
+        rollover_ticks = rollover_ticks + RELOAD_VALUE;
+        val = RELOAD_VALUE + 1;
+    }
+    systick_val = val - 1;
+    cycle_counter = cycle_counter + 1;
+}
+
+//******************************************************************************
+static uint64_t __attribute__((noinline)) ticks_before(void)
+{
+    bool enabled = disable_interrupts();
+
+    uint64_t current_ticks = (rollover_count * RELOAD_VALUE) + (RELOAD_VALUE - systick_val);
+    if (current_ticks < last_reported_ticks)
+    {
+        current_ticks = ((rollover_count + 1) * RELOAD_VALUE) + (RELOAD_VALUE - systick_val);
+    }
+
+    restore_interrupts(enabled);
+
+    last_reported_ticks = current_ticks;
+    return current_ticks;
+}
+
+//******************************************************************************
+static uint64_t __attribute__((noinline)) ticks_now(void)
+{
+    bool enabled = disable_interrupts();
+
+    uint64_t current_ticks = rollover_ticks + (RELOAD_VALUE - systick_val);
+    if (systick_pending || (current_ticks < last_reported_ticks))
+    {
+        current_ticks = rollover_ticks + RELOAD_VALUE + (RELOAD_VALUE - systick_val);
+    }
+
+    restore_interrupts(enabled);
+
+    last_reported_ticks = current_ticks;
+    return current_ticks;
+}
+
+//******************************************************************************
+static uint64_t __attribute__((noinline)) cycles_now(void)
+{
+    return cycle_counter;
+}
+
+//******************************************************************************
+static uint64_t __attribute__((noinline)) snapshot_now(void)
+{
+    return snapshot_ticks;
+}
+
+//******************************************************************************
+static uint64_t __attribute__((noinline)) no_read(void)
+{
+    return 0;
+}
+
+//******************************************************************************
+// Return nanoseconds per read.  Reads are summed so they can't be optimized away.
+static double time_reads(uint64_t (*read)(void), uint32_t num_reads, uint64_t * sum)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_reads; ++i)
+    {
+        tick();
+        *sum += read();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / num_reads;
+}
+
+//******************************************************************************
+// Return nanoseconds per read of 'read' with the time for not reading anything taken off.
+static double time_read(uint64_t (*read)(void), double overhead_ns, uint32_t num_reads, uint64_t * sum)
+{
+    return std::max(0.0, time_reads(read, num_reads, sum) - overhead_ns);
+}
+
+//******************************************************************************
+int main(int argc, char ** argv)
+{
+    double simulated_seconds = (argc > 1) ? atof(argv[1]) : 60.0;
+    uint32_t num_reads = (argc > 2) ? atoi(argv[2]) : 100000000;
+
+    host_stop_ticks = (uint64_t)(simulated_seconds * sys_timer.frequency());
+
+    Scheduler::Task * tasks[] =
+    {
+        &comp_filter_task,
+        &send_task,
+        &receive_task,
+        &leds_task,
+        &modes_task,
+        &status_update_task,
+        &stream_task,
+    };
+    for (uint32_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); ++i)
+    {
+        scheduler.registerTask(*tasks[i]);
+    }
+    scheduler.registerPreemptiveTask(main_control_task);
+
+    scheduler.scheduleTasks();
+
+    uint64_t num_runs = main_control_task.numTimesRan();
+    for (uint32_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); ++i)
+    {
+        num_runs += tasks[i]->numTimesRan();
+    }
+
+    double num_cycles = main_control_task.numTimesRan();
+    double tick_reads = host_read_counts().tick_reads / num_cycles;
+    double snapshot_reads = host_read_counts().snapshot_reads / num_cycles;
+    double cycle_reads = host_read_counts().cycle_reads / num_cycles;
+    double runs = num_runs / num_cycles;
+    double tick_reads_before = tick_reads + snapshot_reads + runs;
+
+    printf("Reads per control cycle over %.0f simulated seconds (%.2f task runs per cycle):\n", simulated_seconds, runs);
+    printf("  before: ticks() %6.2f\n", tick_reads_before);
+    printf("  now:    ticks() %6.2f, snapshot %6.2f, cycles() %6.2f\n", tick_reads, snapshot_reads, cycle_reads);
+
+    uint64_t sum = 0;
+    double overhead_ns = time_reads(no_read, num_reads, &sum);
+    double before_ns = time_read(ticks_before, overhead_ns, num_reads, &sum);
+    double now_ns = time_read(ticks_now, overhead_ns, num_reads, &sum);
+    double cycles_ns = time_read(cycles_now, overhead_ns, num_reads, &sum);
+    double snapshot_ns = time_read(snapshot_now, overhead_ns, num_reads, &sum);
+
+    printf("PC time per read (%u reads, %.2f ns each without reading taken off):\n", num_reads, overhead_ns);
+    printf("  ticks() before %5.2f ns, ticks() now %5.2f ns, cycles() %5.2f ns, snapshot %5.2f ns\n",
+           before_ns, now_ns, cycles_ns, snapshot_ns);
+    printf("PC time reading the time per control cycle: before %6.1f ns, now %6.1f ns   (sum %llu)\n",
+           tick_reads_before * before_ns,
+           tick_reads * now_ns + snapshot_reads * snapshot_ns + cycle_reads * cycles_ns,
+           (unsigned long long)(sum & 0xFF));
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Includes
+#include "glo_bulk_transfer.h"
+
+//*****************************************************************************
+GloBulkTransfer::GloBulkTransfer(void) :
+    state_(BULK_STATE_IDLE),
+    transfer_id_(0),
+    glob_id_(0),
+    window_(0),
+    first_(0),
+    last_(0),
+    base_(0),
+    next_new_(0),
+    resend_(0),
+    next_send_seq_(0),
+    timeout_ticks_(0),
+    deadline_ticks_(UINT64_MAX),
+    num_timeouts_(0),
+    num_sent_(0),
+    num_resent_(0)
+{
+}
+
+//*****************************************************************************
+void GloBulkTransfer::start(uint8_t transfer_id, uint8_t glob_id, uint16_t first, uint16_t last, uint16_t window,
+                            uint64_t timeout_ticks, uint64_t now_ticks)
+{
+    state_ = (first <= last) ? BULK_STATE_SENDING : BULK_STATE_DONE;
+    transfer_id_ = transfer_id;
+    glob_id_ = glob_id;
+    window_ = (window > BULK_MAX_WINDOW) ? BULK_MAX_WINDOW : window;
+    window_ = (window_ == 0) ? 1 : window_;
+    first_ = base_ = next_new_ = first;
+    last_ = last;
+    resend_ = 0;
+    timeout_ticks_ = timeout_ticks;
+    deadline_ticks_ = now_ticks + timeout_ticks;
+    num_timeouts_ = 0;
+    num_sent_ = 0;
+    num_resent_ = 0;
+}
+
+//*****************************************************************************
+bool GloBulkTransfer::readyToSend(uint64_t now_ticks) const
+{
+    if (state_ != BULK_STATE_SENDING)
+    {
+        return false;
+    }
+
+    bool window_open = (next_new_ <= last_) && (next_new_ - base_ < window_);
+
+    return (resend_ != 0) || window_open || (now_ticks >= deadline_ticks_);
+}
+
+//*****************************************************************************
+uint16_t GloBulkTransfer::nextInstance(uint64_t now_ticks)
+{
+    if (!readyToSend(now_ticks))
+    {
+        return 0;
+    }
+
+    if (resend_ != 0)
+    {
+        // Oldest missing instance first.
+        uint32_t offset = 0;
+        while (!(resend_ & (1ull << offset)))
+        {
+            offset++;
+        }
+        return (uint16_t)(base_ + offset);
+    }
+
+    if ((next_new_ <= last_) && (next_new_ - base_ < window_))
+    {
+        return (uint16_t)next_new_;
+    }
+
+    // Nothing's been acknowledged in a while.  Either the acknowledgements are being lost or the
+    // receiver stopped listening, so send the oldest instance again to get a new acknowledgement.
+    if (++num_timeouts_ > BULK_MAX_TIMEOUTS)
+    {
+        state_ = BULK_STATE_FAILED;
+        return 0;
+    }
+    resend_ |= 1;
+    deadline_ticks_ = now_ticks + timeout_ticks_;
+
+    return (uint16_t)base_;
+}
+
+//*****************************************************************************
+void GloBulkTransfer::markSent(uint16_t instance, uint64_t now_ticks)
+{
+    send_seq_[instance % BULK_MAX_WINDOW] = next_send_seq_++;
+    num_sent_++;
+
+    if (instance == next_new_)
+    {
+        next_new_++;
+    }
+    else if ((instance >= base_) && (instance - base_ < BULK_MAX_WINDOW))
+    {
+        resend_ &= ~(1ull << (instance - base_));
+        num_resent_++;
+    }
+
+    // Give the receiver a timeout from the last thing sent to acknowledge it.
+    deadline_ticks_ = now_ticks + timeout_ticks_;
+}
+
+//*****************************************************************************
+bool GloBulkTransfer::handleAck(glo_bulk_ack_t const & ack, uint64_t now_ticks)
+{
+    if ((state_ != BULK_STATE_SENDING) || (ack.transfer_id != transfer_id_))
+    {
+        return false;
+    }
+
+    uint32_t next = ack.next_instance;
+    if ((next < base_) || (next > next_new_))
+    {
+        return true; // old (arrived out of order) or acknowledges something that was never sent
+    }
+
+    if (next > base_)
+    {
+        uint32_t num_acked = next - base_;
+        resend_ = (num_acked < 64) ? (resend_ >> num_acked) : 0;
+        base_ = next;
+        num_timeouts_ = 0;
+        deadline_ticks_ = now_ticks + timeout_ticks_;
+    }
+
+    if (base_ > last_)
+    {
+        state_ = BULK_STATE_DONE;
+        return true;
+    }
+
+    // Only send a missing instance again if the receiver got something that was sent after it,
+    // otherwise it could still be on the way (e.g. it was already sent again).
+    uint32_t newest = ack.newest_instance;
+    if ((newest < base_) || (newest >= next_new_))
+    {
+        return true;
+    }
+    uint16_t newest_seq = send_seq_[newest % BULK_MAX_WINDOW];
+
+    uint64_t missing = ack.missing[0] | ((uint64_t)ack.missing[1] << 32);
+    uint32_t num_in_flight = next_new_ - base_;
+    for (uint32_t offset = 0; (offset < num_in_flight) && (missing >> offset); ++offset)
+    {
+        uint16_t seq = send_seq_[(base_ + offset) % BULK_MAX_WINDOW];
+        if ((missing & (1ull << offset)) && ((int16_t)(newest_seq - seq) > 0))
+        {
+            resend_ |= 1ull << offset;
+        }
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+uint64_t GloBulkTransfer::timeoutTicks(void) const
+{
+    return (state_ == BULK_STATE_SENDING) ? deadline_ticks_ : UINT64_MAX;
+}
+
+//*****************************************************************************
+void GloBulkTransfer::describe(glo_bulk_transfer_t * transfer) const
+{
+    transfer->num_sent = num_sent_;
+    transfer->num_resent = num_resent_;
+    transfer->first_instance = (uint16_t)first_;
+    transfer->last_instance = (uint16_t)last_;
+    transfer->window = window_;
+    transfer->transfer_id = transfer_id_;
+    transfer->glob_id = glob_id_;
+    transfer->state = state_;
+}
@@ -1,7 +1,10 @@
 // Includes
+#include <cstring>
 #include "crc.h"
+#include "glo_frame.h"
 #include "glo_rx_link.h"
 #include "globs.h"
+#include "system_timer.h"
 #include "telemetry_send_task.h"
 #include "util_assert.h"
 
@@ -13,8 +16,14 @@ GloRxLink::GloRxLink(Usart * port, new_message_callback_t new_message_callback)
     num_body_bytes_(0),
     body_start_idx_(0),
     data_idx_(0),
+    fragment_size_(0),
+    fragment_received_(0),
+    fragment_id_(0),
+    fragment_instance_(0),
+    num_fragments_dropped_(0),
     num_messages_received_(0),
-    last_rx_packet_num_(0)
+    last_rx_packet_num_(0),
+    framing_(LINK_FRAMING_START_BYTE)
 {
     resetParse();
 }
@@ -22,10 +31,7 @@ GloRxLink::GloRxLink(Usart * port, new_message_callback_t new_message_callback)
 //*****************************************************************************
 void GloRxLink::parse(void)
 {
-    const uint8_t msg_start_byte = 0xFE;
-
     uint8_t in_byte = 0; // new byte read in from port
-    bool complete_message_received = false; // true if received new glob
 
     if (port_ == NULL)
     {
@@ -35,76 +41,276 @@ void GloRxLink::parse(void)
 
     if (port_->getByte(&in_byte))
     {
-        switch (parse_state_)
+        parseByte(in_byte);
+    }
+}
+
+//*****************************************************************************
+uint32_t GloRxLink::parseAvailable(uint32_t max_cycles)
+{
+    uint32_t start_cycles = sys_timer.cycles();
+    uint32_t num_messages = 0;
+
+    if (port_ == NULL)
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Parse failed due to null port.");
+        return 0;
+    }
+
+    bool out_of_time = false;
+    while (!out_of_time)
+    {
+        uint32_t length = 0;
+        uint8_t const * span = port_->peekSpan(&length);
+        if (length == 0)
+        {
+            break; // parsed everything
+        }
+
+        uint32_t used = 0;
+        while ((used < length) && !out_of_time)
         {
-            case -1:  // looking for start byte
-                if (in_byte == msg_start_byte)
+            if (framing_ == LINK_FRAMING_COBS)
+            {
+                // Frame ends at the next zero, no matter what came before it.
+                uint8_t const * frame = span + used;
+                uint8_t const * end = (uint8_t const *)memchr(frame, MSG_COBS_DELIMITER, length - used);
+                if (end == NULL)
                 {
-                    message_data_[data_idx_++] = in_byte;
-                    advanceParse();
+                    appendCobs(frame, length - used);
+                    used = length;
+                    break;
                 }
-                break;
-            case 0:  // pull out id (fall through)
-            case 1:  // pull out byte indicating whether packet num and CRC are valid (fall through)
-            case 2:  // pull out byte one of instance (fall through)
-            case 3:  // pull out byte two of instance (fall through)
-            case 4:  // pull out packet number
-                message_data_[data_idx_++] = in_byte;
-                advanceParse();
-                break;
-            case 5:  // pull out length of data
-                num_body_bytes_ = in_byte;
-                message_data_[data_idx_++] = in_byte;
-                body_start_idx_ = data_idx_;
-                advanceParse();
-                if (num_body_bytes_ == 0)
+
+                uint16_t num_encoded = end - frame;
+                if (data_idx_ == 0)
                 {
-                    advanceParse(); // skip to getting CRC bytes
+                    // Whole frame is in this span so decode straight out of it.
+                    if (handleCobsFrame(frame, num_encoded)) { num_messages++; }
                 }
-                break;
-            case 6:  // pull out body
-                message_data_[data_idx_++] = in_byte;
-                if ((data_idx_ - body_start_idx_) >= num_body_bytes_)
+                else
                 {
-                    advanceParse(); // received all body bytes
+                    appendCobs(frame, num_encoded);
+                    if (handleCobsFrame(message_data_, data_idx_)) { num_messages++; }
+                    resetParse();
                 }
+                used += num_encoded + 1;
+                out_of_time = (sys_timer.cycles() - start_cycles) >= max_cycles;
+                continue;
+            }
+
+            if (parse_state_ != -1)
+            {
+                // Finish message that was started in a previous span.
+                if (parseByte(span[used++])) { num_messages++; }
+                continue;
+            }
+
+            // Skip straight to the next start byte.
+            uint8_t const * start = (uint8_t const *)memchr(span + used, MSG_START_BYTE, length - used);
+            if (start == NULL)
+            {
+                used = length;
                 break;
-            case 7: // pull out lower byte of CRC
-                expected_crc1_ = in_byte;
-                advanceParse();
-                break;
-            case 8: // pull out upper byte of CRC
-                expected_crc2_ = in_byte;
-                complete_message_received = true;
-                // reset parse after handling new message
-                break;
-            default: // safety reset
-                resetParse();
-                break;
+            }
+            used = start - span;
+
+            // Handle the message in place if all of it is in this span.
+            uint32_t remaining = length - used;
+            if (remaining > MSG_LENGTH_IDX)
+            {
+                uint16_t num_message_bytes = MSG_HEADER_SIZE + start[MSG_LENGTH_IDX];
+                if (remaining >= (uint32_t)(num_message_bytes + MSG_CRC_SIZE))
+                {
+                    uint16_t expected_crc = start[num_message_bytes] + (uint16_t)(start[num_message_bytes + 1] << 8);
+                    if (handleMessage(start, num_message_bytes, expected_crc)) { num_messages++; }
+                    used += num_message_bytes + MSG_CRC_SIZE;
+                    out_of_time = (sys_timer.cycles() - start_cycles) >= max_cycles;
+                    continue;
+                }
+            }
+
+            // Rest of the message hasn't been received yet or is on the other side of the wrap
+            // so save what's here and finish it byte by byte.
+            while (used < length)
+            {
+                parseByte(span[used++]);
+            }
         }
 
-        if (complete_message_received)
+        port_->consume(used);
+    }
+
+    return num_messages;
+}
+
+//*****************************************************************************
+bool GloRxLink::parseByte(uint8_t in_byte)
+{
+    bool complete_message_received = false; // true if received new glob
+    bool handled = false;
+
+    if (framing_ == LINK_FRAMING_COBS)
+    {
+        if (in_byte != MSG_COBS_DELIMITER)
         {
-            complete_message_received = false;
+            appendCobs(&in_byte, 1);
+            return false;
+        }
 
-            uint8_t crc_reliable = message_data_[1];
+        handled = handleCobsFrame(message_data_, data_idx_);
+        resetParse();
+        return handled;
+    }
 
-            if (!crc_reliable || verifyCRC())
+    switch (parse_state_)
+    {
+        case -1:  // looking for start byte
+            if (in_byte == MSG_START_BYTE)
             {
-                handleReceivedMessage();
+                message_data_[data_idx_++] = in_byte;
+                advanceParse();
             }
-
+            break;
+        case 0:  // pull out id (fall through)
+        case 1:  // pull out byte indicating whether packet num and CRC are valid (fall through)
+        case 2:  // pull out byte one of instance (fall through)
+        case 3:  // pull out byte two of instance (fall through)
+        case 4:  // pull out packet number
+            message_data_[data_idx_++] = in_byte;
+            advanceParse();
+            break;
+        case 5:  // pull out length of data
+            num_body_bytes_ = in_byte;
+            message_data_[data_idx_++] = in_byte;
+            body_start_idx_ = data_idx_;
+            advanceParse();
+            if (num_body_bytes_ == 0)
+            {
+                advanceParse(); // skip to getting CRC bytes
+            }
+            break;
+        case 6:  // pull out body
+            message_data_[data_idx_++] = in_byte;
+            if ((data_idx_ - body_start_idx_) >= num_body_bytes_)
+            {
+                advanceParse(); // received all body bytes
+            }
+            break;
+        case 7: // pull out lower byte of CRC
+            expected_crc1_ = in_byte;
+            advanceParse();
+            break;
+        case 8: // pull out upper byte of CRC
+            expected_crc2_ = in_byte;
+            complete_message_received = true;
+            // reset parse after handling new message
+            break;
+        default: // safety reset
             resetParse();
-        }
+            break;
+    }
+
+    if (complete_message_received)
+    {
+        uint16_t expected_crc = (uint16_t)expected_crc1_ + (uint16_t)(expected_crc2_ << 8);
+
+        handled = handleMessage(message_data_, data_idx_, expected_crc);
+
+        resetParse();
+    }
+
+    return handled;
+}
+
+//*****************************************************************************
+bool GloRxLink::handleMessage(uint8_t const * message, uint16_t num_bytes, uint16_t expected_crc)
+{
+    uint8_t crc_reliable = message[1];
+
+    if (crc_reliable && !verifyCRC(message, num_bytes, expected_crc))
+    {
+        return false;
+    }
+
+    handleReceivedMessage(message);
+
+    return true;
+}
+
+//*****************************************************************************
+void GloRxLink::appendCobs(uint8_t const * data, uint16_t num_bytes)
+{
+    if (data_idx_ + num_bytes > MSG_COBS_MAX_ENCODED_SIZE)
+    {
+        // Too long to be a frame so throw it all away when the delimiter shows up.
+        data_idx_ = MSG_COBS_MAX_ENCODED_SIZE + 1;
+        return;
+    }
+
+    memcpy(message_data_ + data_idx_, data, num_bytes);
+    data_idx_ += num_bytes;
+}
+
+//*****************************************************************************
+bool GloRxLink::handleCobsFrame(uint8_t const * encoded, uint16_t num_encoded)
+{
+    if ((num_encoded == 0) || (num_encoded > MSG_COBS_MAX_ENCODED_SIZE))
+    {
+        return false;
     }
+
+    uint16_t num_bytes = decodeCobs(encoded, num_encoded, message_data_);
+
+    // Drop anything that doesn't look like a frame.  Line noise ends up here instead of
+    // being checked against a CRC.
+    if ((num_bytes < MSG_HEADER_SIZE + MSG_CRC_SIZE) ||
+        (message_data_[0] != MSG_START_BYTE) ||
+        (num_bytes != MSG_HEADER_SIZE + message_data_[MSG_LENGTH_IDX] + MSG_CRC_SIZE))
+    {
+        return false;
+    }
+
+    uint16_t num_message_bytes = num_bytes - MSG_CRC_SIZE;
+    uint16_t expected_crc = message_data_[num_message_bytes] + (uint16_t)(message_data_[num_message_bytes + 1] << 8);
+
+    return handleMessage(message_data_, num_message_bytes, expected_crc);
 }
 
 //*****************************************************************************
-bool GloRxLink::verifyCRC(void)
+uint16_t GloRxLink::decodeCobs(uint8_t const * encoded, uint16_t num_encoded, uint8_t * decoded)
 {
-    uint16_t expected_crc = (uint16_t)expected_crc1_ + (uint16_t)(expected_crc2_ << 8);
+    // Never writes ahead of what's been read so 'decoded' can be the same buffer as 'encoded'.
+    uint16_t read_idx = 0;
+    uint16_t write_idx = 0;
 
-    uint16_t actual_crc = calculate_crc(message_data_, data_idx_, 0xFFFF);
+    while (read_idx < num_encoded)
+    {
+        uint8_t code = encoded[read_idx++];
+        if ((code == 0) || (read_idx + code - 1 > num_encoded))
+        {
+            return 0; // block runs past end of frame
+        }
+
+        for (uint8_t i = 1; i < code; ++i)
+        {
+            decoded[write_idx++] = encoded[read_idx++];
+        }
+
+        // Every block besides the longest ones and the last one was followed by a zero.
+        if ((code != 0xFF) && (read_idx < num_encoded))
+        {
+            decoded[write_idx++] = 0;
+        }
+    }
+
+    return write_idx;
+}
+
+//*****************************************************************************
+bool GloRxLink::verifyCRC(uint8_t const * message, uint16_t num_bytes, uint16_t expected_crc)
+{
+    uint16_t actual_crc = crc_final(crc_update(crc_init(), message, num_bytes));
 
     bool crc_matches = (actual_crc == expected_crc);
 
@@ -114,25 +320,39 @@ bool GloRxLink::verifyCRC(void)
 }
 
 //*****************************************************************************
-void GloRxLink::handleReceivedMessage(void)
+void GloRxLink::handleReceivedMessage(uint8_t const * message)
 {
-    uint8_t packet_num_reliable = message_data_[1];
-    uint8_t object_id = message_data_[2];
-    uint16_t instance = message_data_[3] + (uint16_t)(message_data_[4] << 8);
-    uint8_t packet_num = message_data_[5];
-    void * glob_data = message_data_ + body_start_idx_;
+    uint8_t packet_num_reliable = message[1];
+    uint8_t object_id = message[MSG_ID_IDX];
+    uint16_t instance = message[MSG_INSTANCE_IDX] + (uint16_t)(message[MSG_INSTANCE_IDX + 1] << 8);
+    uint8_t packet_num = message[5];
 
     if (!packet_num_reliable)
     {
         packet_num = last_rx_packet_num_ + 1;
     }
 
-    if (new_message_callback_)
+    if (object_id == MSG_BATCH_ID)
     {
-        new_message_callback_(object_id, instance, glob_data);
+        handleBatch(message + MSG_HEADER_SIZE, message[MSG_LENGTH_IDX]);
     }
+    else if (object_id == MSG_FRAGMENT_ID)
+    {
+        handleFragment(instance, message + MSG_HEADER_SIZE, message[MSG_LENGTH_IDX]);
+    }
+    else
+    {
+        // Message could be anywhere in the receive buffer so copy body out to be aligned.
+        memcpy(body_, message + MSG_HEADER_SIZE, message[MSG_LENGTH_IDX]);
+        void * glob_data = body_;
 
-    num_messages_received_++;
+        if (new_message_callback_)
+        {
+            new_message_callback_(object_id, instance, glob_data);
+        }
+
+        num_messages_received_++;
+    }
 
     // Can't detect dropped packets unless we know when GUI first connects so we can
     // reset the number of message received.
@@ -148,6 +368,106 @@ void GloRxLink::handleReceivedMessage(void)
 
 }
 
+//*****************************************************************************
+void GloRxLink::handleBatch(uint8_t const * body, uint16_t num_bytes)
+{
+    uint16_t idx = 0;
+    while (idx < num_bytes)
+    {
+        if (idx + MSG_RECORD_HEADER_SIZE > num_bytes)
+        {
+            assert_always_msg(ASSERT_CONTINUE, "Batch record header cut off.");
+            return;
+        }
+
+        uint8_t object_id = body[idx];
+        uint16_t instance = body[idx + 1] + (uint16_t)(body[idx + 2] << 8);
+        uint8_t count = body[idx + 3];
+        uint8_t glob_size = body[idx + 4];
+        idx += MSG_RECORD_HEADER_SIZE;
+
+        if (idx + (uint16_t)count * glob_size > num_bytes)
+        {
+            assert_always_msg(ASSERT_CONTINUE, "Batch record for glob %d is longer than the frame.", (int)object_id);
+            return;
+        }
+
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            // Copy each instance out so it's aligned like a single message.
+            memcpy(body_, body + idx, glob_size);
+            idx += glob_size;
+
+            if (new_message_callback_)
+            {
+                new_message_callback_(object_id, instance + i, body_);
+            }
+
+            num_messages_received_++;
+        }
+    }
+}
+
+//*****************************************************************************
+void GloRxLink::handleFragment(uint16_t instance, uint8_t const * body, uint16_t num_bytes)
+{
+    if (num_bytes < MSG_FRAGMENT_HEADER_SIZE)
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Fragment header cut off.");
+        return;
+    }
+
+    uint8_t object_id = body[0];
+    uint16_t offset = body[1] + (uint16_t)(body[2] << 8);
+    uint16_t glob_size = body[3] + (uint16_t)(body[4] << 8);
+    uint16_t num_data_bytes = num_bytes - MSG_FRAGMENT_HEADER_SIZE;
+
+    if ((glob_size > MSG_MAX_GLOB_SIZE) || (offset + num_data_bytes > glob_size))
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Fragment of glob %d doesn't fit in %d bytes.", (int)object_id, (int)glob_size);
+        return;
+    }
+
+    bool continues = (fragment_size_ != 0) && (object_id == fragment_id_) && (instance == fragment_instance_) &&
+                     (glob_size == fragment_size_) && (offset == fragment_received_);
+
+    if (!continues)
+    {
+        if (fragment_size_ != 0)
+        {
+            num_fragments_dropped_++; // never got the rest of the last one
+        }
+        fragment_size_ = 0;
+
+        if (offset != 0)
+        {
+            return; // missed the start of this one
+        }
+
+        fragment_size_ = glob_size;
+        fragment_received_ = 0;
+        fragment_id_ = object_id;
+        fragment_instance_ = instance;
+    }
+
+    memcpy((uint8_t *)fragment_data_ + offset, body + MSG_FRAGMENT_HEADER_SIZE, num_data_bytes);
+    fragment_received_ += num_data_bytes;
+
+    if (fragment_received_ < fragment_size_)
+    {
+        return;
+    }
+
+    fragment_size_ = 0;
+
+    if (new_message_callback_)
+    {
+        new_message_callback_(object_id, instance, fragment_data_);
+    }
+
+    num_messages_received_++;
+}
+
 //*****************************************************************************
 void GloRxLink::resetParse(void)
 {
@@ -1,16 +1,42 @@
 // Includes
+#include <cstring>
 #include "crc.h"
 #include "glo_tx_link.h"
 #include "globs.h"
 #include "util_assert.h"
 
+// Batch and fragment frames use IDs no glob can have.
+static_assert(NUM_GLOBS <= MSG_FRAGMENT_ID, "Too many globs to tell them apart from batch and fragment frames.");
+
+// Every glob has to fit in the fragment buffer.
+#undef GLOB
+#undef GLOB_SEQLOCK
+#define GLOB(var_name, struct_type, id, num_instances, owner_task) \
+    static_assert(sizeof(struct_type) <= MSG_MAX_GLOB_SIZE, #struct_type " is too big to send.");
+#define GLOB_SEQLOCK GLOB
+#include "glob_list.h"
+
 //*****************************************************************************
 // Constructor
 GloTxLink::GloTxLink(Usart * port) :
     port_(port),
     num_messages_sent_(0),
     num_messages_failed_(0),
-    next_packet_num_(0)
+    num_bytes_sent_(0),
+    next_packet_num_(0),
+    batch_open_(false),
+    batch_size_(0),
+    batch_capacity_(0),
+    num_records_(0),
+    record_start_(0),
+    record_id_(0),
+    record_next_instance_(0),
+    record_count_(0),
+    framing_(LINK_FRAMING_START_BYTE),
+    fragment_size_(0),
+    fragment_offset_(0),
+    fragment_id_(0),
+    fragment_instance_(0)
 {
 }
 
@@ -18,6 +44,7 @@ GloTxLink::GloTxLink(Usart * port) :
 uint8_t GloTxLink::send(uint8_t glob_id, uint16_t glob_instance, void * data_buffer)
 {
     assert(port_ != NULL, ASSERT_STOP);
+    assert(!batch_open_, ASSERT_STOP);
 
     if (glob_id >= NUM_GLOBS)
     {
@@ -28,44 +55,385 @@ uint8_t GloTxLink::send(uint8_t glob_id, uint16_t glob_instance, void * data_buf
 
     GlobBase * glob = globs[glob_id];
 
-    uint8_t num_data_bytes = glob->get_num_bytes();
+    if (needsFragments(glob_id))
+    {
+        if (!sendingFragments(glob_id, glob_instance))
+        {
+            // Copy the whole glob now so every fragment is from the same publish.
+            if (data_buffer == NULL)
+            {
+                glob->copy_to_buffer(fragment_data_, glob_instance);
+            }
+            else
+            {
+                memcpy(fragment_data_, data_buffer, glob->get_send_size());
+            }
+            fragment_size_ = glob->get_send_size();
+            fragment_offset_ = 0;
+            fragment_id_ = glob_id;
+            fragment_instance_ = glob_instance;
+        }
+        return sendFragments();
+    }
+
+    uint8_t num_data_bytes = glob->get_send_size();
 
-    const uint16_t num_header_bytes = 7;
-    send_buffer_[0] = 0xFE; // message start byte
-    send_buffer_[1] = 1;    // non-zero since packet number and CRC are valid.
-    send_buffer_[2] = glob_id;
-    send_buffer_[3] = (uint8_t)glob_instance;
-    send_buffer_[4] = (uint8_t)(glob_instance >> 8);
-    send_buffer_[5] = next_packet_num_;
-    send_buffer_[6] = num_data_bytes;
+    const uint16_t num_header_bytes = MSG_HEADER_SIZE;
+    const uint16_t num_footer_bytes = MSG_CRC_SIZE;
+    uint16_t footer_start = num_data_bytes + num_header_bytes;
+    uint16_t packet_size = footer_start + num_footer_bytes;
+
+    // Build the packet right in the serial port's transfer buffer so the glob data is only copied once.
+    dma_tx_region_t reserved;
+    if (!port_->reserve(packet_size + framingOverhead(), &reserved))
+    {
+        num_messages_failed_++;
+        return SEND_ERROR_NO_ROOM;
+    }
+    dma_tx_region_t packet = reserved.subregion(frameOffset(), packet_size);
+
+    uint8_t header[num_header_bytes];
+    header[0] = MSG_START_BYTE;
+    header[1] = 1;    // non-zero since packet number and CRC are valid.
+    header[2] = glob_id;
+    header[3] = (uint8_t)glob_instance;
+    header[4] = (uint8_t)(glob_instance >> 8);
+    header[5] = next_packet_num_;
+    header[6] = num_data_bytes;
+    packet.write(0, header, num_header_bytes);
 
     if (data_buffer == NULL)
     {
-        glob->copy_to_buffer(send_buffer_ + num_header_bytes, glob_instance);
+        dma_tx_region_t body = packet.subregion(num_header_bytes, num_data_bytes);
+        glob->copy_to_split_buffer(body.part[0], body.length[0], body.part[1], glob_instance, num_data_bytes);
     }
     else
     {
-        memcpy(send_buffer_ + num_header_bytes, data_buffer, num_data_bytes);
+        packet.write(num_header_bytes, data_buffer, num_data_bytes);
     }
 
-    uint16_t footer_start = num_data_bytes + num_header_bytes;
+    // Packet might wrap around the end of the transfer buffer so find the CRC a part at a time.
+    dma_tx_region_t checked = packet.subregion(0, footer_start);
+    uint16_t crc = crc_init();
+    crc = crc_update(crc, checked.part[0], checked.length[0]);
+    crc = crc_final(crc_update(crc, checked.part[1], checked.length[1]));
 
-    uint16_t crc = calculate_crc(send_buffer_, footer_start, 0xFFFF);
+    uint8_t footer[num_footer_bytes];
+    footer[0] = (uint8_t)crc;
+    footer[1] = (uint8_t)(crc >> 8);
+    packet.write(footer_start, footer, num_footer_bytes);
 
-    const uint16_t num_footer_bytes = 2;
-    send_buffer_[footer_start]   = (uint8_t)crc;
-    send_buffer_[footer_start+1] = (uint8_t)(crc >> 8);
+    commitFrame(reserved, packet_size);
 
-    uint16_t packet_size = num_data_bytes + num_header_bytes + num_footer_bytes;
+    num_messages_sent_++;
+    next_packet_num_++;
 
-    if (!port_->sendBuffer(send_buffer_, packet_size))
+    return SEND_SUCCESS;
+}
+
+//*****************************************************************************
+bool GloTxLink::beginBatch(uint16_t max_frame_size)
+{
+    assert(port_ != NULL, ASSERT_STOP);
+    assert(!batch_open_, ASSERT_STOP);
+
+    if (max_frame_size > MSG_MAX_FRAME_SIZE)
+    {
+        max_frame_size = MSG_MAX_FRAME_SIZE;
+    }
+
+    // Need room for at least one byte of glob data.
+    uint16_t reserved = port_->reserveUpTo(max_frame_size + framingOverhead(), &batch_reserved_);
+    if (reserved < framingOverhead() + MSG_HEADER_SIZE + MSG_RECORD_HEADER_SIZE + 1 + MSG_CRC_SIZE)
+    {
+        port_->commit(0);
+        return false;
+    }
+
+    uint16_t frame_size = reserved - framingOverhead();
+    batch_ = batch_reserved_.subregion(frameOffset(), frame_size);
+
+    batch_open_ = true;
+    batch_size_ = MSG_HEADER_SIZE; // header is filled in at the end once the length is known
+    batch_capacity_ = frame_size - MSG_CRC_SIZE;
+    num_records_ = 0;
+    record_count_ = 0;
+
+    return true;
+}
+
+//*****************************************************************************
+uint8_t GloTxLink::addToBatch(uint8_t glob_id, uint16_t glob_instance, void * data_buffer)
+{
+    assert(batch_open_, ASSERT_STOP);
+
+    if (glob_id >= NUM_GLOBS)
     {
         num_messages_failed_++;
+        assert_always_msg(ASSERT_CONTINUE, "Can't send glob %d because highest glob ID is %d", (int)glob_id, (int)NUM_GLOBS-1);
+        return SEND_ERROR_BAD_ID;
+    }
+
+    GlobBase * glob = globs[glob_id];
+
+    // A glob too big for the record header's size byte never fits in a batch anyways.
+    uint16_t num_data_bytes = glob->get_send_size();
+
+    // Keep adding to the current record if this is the next instance of the same glob.
+    bool new_record = (num_records_ == 0) ||
+                      (glob_id != record_id_) ||
+                      (glob_instance != record_next_instance_) ||
+                      (record_count_ == UINT8_MAX);
+
+    uint16_t num_new_bytes = num_data_bytes + (new_record ? MSG_RECORD_HEADER_SIZE : 0);
+    if (batch_size_ + num_new_bytes > batch_capacity_)
+    {
         return SEND_ERROR_NO_ROOM;
     }
 
+    if (new_record)
+    {
+        record_start_ = batch_size_;
+        record_id_ = glob_id;
+        record_count_ = 0;
+        num_records_++;
+
+        uint8_t record_header[MSG_RECORD_HEADER_SIZE];
+        record_header[0] = glob_id;
+        record_header[1] = (uint8_t)glob_instance;
+        record_header[2] = (uint8_t)(glob_instance >> 8);
+        record_header[3] = 0; // count filled in below
+        record_header[4] = (uint8_t)num_data_bytes;
+        batch_.write(batch_size_, record_header, MSG_RECORD_HEADER_SIZE);
+        batch_size_ += MSG_RECORD_HEADER_SIZE;
+    }
+
+    if (data_buffer == NULL)
+    {
+        dma_tx_region_t body = batch_.subregion(batch_size_, num_data_bytes);
+        glob->copy_to_split_buffer(body.part[0], body.length[0], body.part[1], glob_instance, num_data_bytes);
+    }
+    else
+    {
+        batch_.write(batch_size_, data_buffer, num_data_bytes);
+    }
+    batch_size_ += num_data_bytes;
+
+    record_count_++;
+    record_next_instance_ = glob_instance + 1;
+    batch_.write(record_start_ + 3, &record_count_, 1);
+
+    return SEND_SUCCESS;
+}
+
+//*****************************************************************************
+void GloTxLink::endBatch(void)
+{
+    assert(batch_open_, ASSERT_STOP);
+
+    batch_open_ = false;
+
+    if (num_records_ == 0)
+    {
+        port_->commit(0);
+        return;
+    }
+
+    uint8_t header[MSG_HEADER_SIZE];
+    header[0] = MSG_START_BYTE;
+    header[1] = 1; // non-zero since packet number and CRC are valid.
+    header[2] = MSG_BATCH_ID;
+    header[3] = num_records_;
+    header[4] = 0;
+    header[5] = next_packet_num_;
+    header[6] = (uint8_t)(batch_size_ - MSG_HEADER_SIZE);
+    batch_.write(0, header, MSG_HEADER_SIZE);
+
+    dma_tx_region_t checked = batch_.subregion(0, batch_size_);
+    uint16_t crc = crc_init();
+    crc = crc_update(crc, checked.part[0], checked.length[0]);
+    crc = crc_final(crc_update(crc, checked.part[1], checked.length[1]));
+
+    uint8_t footer[MSG_CRC_SIZE];
+    footer[0] = (uint8_t)crc;
+    footer[1] = (uint8_t)(crc >> 8);
+    batch_.write(batch_size_, footer, MSG_CRC_SIZE);
+
+    commitFrame(batch_reserved_, batch_size_ + MSG_CRC_SIZE);
+
+    num_messages_sent_++;
+    next_packet_num_++;
+    num_records_ = 0;
+}
+
+//*****************************************************************************
+uint16_t GloTxLink::frameSize(uint8_t glob_id) const
+{
+    if (glob_id >= NUM_GLOBS)
+    {
+        return 0;
+    }
+
+    if (needsFragments(glob_id))
+    {
+        return MSG_MAX_FRAME_SIZE + framingOverhead();
+    }
+
+    return MSG_HEADER_SIZE + globs[glob_id]->get_send_size() + MSG_CRC_SIZE + framingOverhead();
+}
+
+//*****************************************************************************
+bool GloTxLink::needsFragments(uint8_t glob_id) const
+{
+    return (glob_id < NUM_GLOBS) && (globs[glob_id]->get_send_size() > MSG_MAX_BODY_SIZE);
+}
+
+//*****************************************************************************
+bool GloTxLink::sendingFragments(uint8_t glob_id, uint16_t glob_instance) const
+{
+    return (fragment_size_ != 0) && (glob_id == fragment_id_) && (glob_instance == fragment_instance_);
+}
+
+//*****************************************************************************
+uint8_t GloTxLink::sendFragments(void)
+{
+    uint8_t const * data = (uint8_t const *)fragment_data_;
+
+    while (fragment_offset_ < fragment_size_)
+    {
+        uint16_t num_data_bytes = fragment_size_ - fragment_offset_;
+        if (num_data_bytes > MSG_MAX_FRAGMENT_DATA)
+        {
+            num_data_bytes = MSG_MAX_FRAGMENT_DATA;
+        }
+
+        uint8_t header[MSG_HEADER_SIZE];
+        header[0] = MSG_START_BYTE;
+        header[1] = 1; // non-zero since packet number and CRC are valid.
+        header[2] = MSG_FRAGMENT_ID;
+        header[3] = (uint8_t)fragment_instance_;
+        header[4] = (uint8_t)(fragment_instance_ >> 8);
+        header[5] = next_packet_num_;
+        header[6] = (uint8_t)(MSG_FRAGMENT_HEADER_SIZE + num_data_bytes);
+
+        uint8_t fragment_header[MSG_FRAGMENT_HEADER_SIZE];
+        fragment_header[0] = fragment_id_;
+        fragment_header[1] = (uint8_t)fragment_offset_;
+        fragment_header[2] = (uint8_t)(fragment_offset_ >> 8);
+        fragment_header[3] = (uint8_t)fragment_size_;
+        fragment_header[4] = (uint8_t)(fragment_size_ >> 8);
+
+        uint8_t result = sendFrame(header, fragment_header, MSG_FRAGMENT_HEADER_SIZE,
+                                   data + fragment_offset_, num_data_bytes);
+        if (result != SEND_SUCCESS)
+        {
+            return result; // rest is sent next time
+        }
+
+        fragment_offset_ += num_data_bytes;
+    }
+
+    fragment_size_ = 0;
+
+    return SEND_SUCCESS;
+}
+
+//*****************************************************************************
+uint8_t GloTxLink::sendFrame(uint8_t const * header, uint8_t const * body1, uint16_t num_body1_bytes,
+                             uint8_t const * body2, uint16_t num_body2_bytes)
+{
+    uint16_t footer_start = MSG_HEADER_SIZE + num_body1_bytes + num_body2_bytes;
+    uint16_t packet_size = footer_start + MSG_CRC_SIZE;
+
+    dma_tx_region_t reserved;
+    if (!port_->reserve(packet_size + framingOverhead(), &reserved))
+    {
+        num_messages_failed_++;
+        return SEND_ERROR_NO_ROOM;
+    }
+    dma_tx_region_t packet = reserved.subregion(frameOffset(), packet_size);
+
+    packet.write(0, header, MSG_HEADER_SIZE);
+    packet.write(MSG_HEADER_SIZE, body1, num_body1_bytes);
+    packet.write(MSG_HEADER_SIZE + num_body1_bytes, body2, num_body2_bytes);
+
+    // Everything being sent is already in RAM so the CRC doesn't have to deal with the wrap.
+    uint16_t crc = crc_init();
+    crc = crc_update(crc, header, MSG_HEADER_SIZE);
+    crc = crc_update(crc, body1, num_body1_bytes);
+    crc = crc_final(crc_update(crc, body2, num_body2_bytes));
+
+    uint8_t footer[MSG_CRC_SIZE];
+    footer[0] = (uint8_t)crc;
+    footer[1] = (uint8_t)(crc >> 8);
+    packet.write(footer_start, footer, MSG_CRC_SIZE);
+
+    commitFrame(reserved, packet_size);
+
     num_messages_sent_++;
     next_packet_num_++;
 
     return SEND_SUCCESS;
 }
+
+//*****************************************************************************
+uint16_t GloTxLink::framingOverhead(void) const
+{
+    return (framing_ == LINK_FRAMING_COBS) ? (MSG_COBS_MAX_CODE_BYTES + 1) : 0;
+}
+
+//*****************************************************************************
+uint16_t GloTxLink::frameOffset(void) const
+{
+    return (framing_ == LINK_FRAMING_COBS) ? MSG_COBS_MAX_CODE_BYTES : 0;
+}
+
+//*****************************************************************************
+void GloTxLink::commitFrame(dma_tx_region_t & reserved, uint16_t frame_size)
+{
+    if (framing_ == LINK_FRAMING_COBS)
+    {
+        frame_size = encodeCobs(reserved, frame_size);
+        reserved.at(frame_size++) = MSG_COBS_DELIMITER;
+    }
+
+    port_->commit(frame_size);
+    num_bytes_sent_ += frame_size;
+}
+
+//*****************************************************************************
+uint16_t GloTxLink::encodeCobs(dma_tx_region_t & region, uint16_t frame_size)
+{
+    // The frame was written after room for the code bytes so it can be encoded in place.  Each code
+    // byte replaces a zero, except every 254 bytes without one, so writing never passes reading.
+    uint16_t read_idx = MSG_COBS_MAX_CODE_BYTES;
+    uint16_t end_idx = read_idx + frame_size;
+    uint16_t code_idx = 0;   // where the code for the current block goes
+    uint16_t write_idx = 1;
+    uint8_t code = 1;        // one more than the number of non-zero bytes in the block
+
+    while (read_idx < end_idx)
+    {
+        uint8_t byte = region.at(read_idx++);
+        if (byte == 0)
+        {
+            region.at(code_idx) = code;
+            code_idx = write_idx++;
+            code = 1;
+            continue;
+        }
+
+        region.at(write_idx++) = byte;
+        if (++code == 0xFF)
+        {
+            // Longest block possible so start a new one.
+            region.at(code_idx) = code;
+            code_idx = write_idx++;
+            code = 1;
+        }
+    }
+
+    region.at(code_idx) = code;
+
+    return write_idx;
+}
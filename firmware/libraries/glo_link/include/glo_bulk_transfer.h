@@ -0,0 +1,100 @@
+#ifndef GLO_BULK_TRANSFER_H_INCLUDED
+#define GLO_BULK_TRANSFER_H_INCLUDED
+
+// Includes
+#include <cstdint>
+#include "glob_types.h"
+
+// Most instances that can be sent past the oldest one that hasn't been acknowledged.  Limited by the
+// bits in glo_bulk_ack_t::missing.
+const uint16_t BULK_MAX_WINDOW = 64;
+
+// Timeouts in a row without the receiver acknowledging anything new before a transfer gives up.
+const uint8_t BULK_MAX_TIMEOUTS = 10;
+
+// Keeps track of a reliable bulk transfer, which sends a range of glob instances (e.g. a capture dump)
+// so the receiver can tell what it missed.  The instance number is the sequence number.  The transfer
+// is announced with a glo_bulk_transfer_t and the receiver acknowledges the announcement and every
+// frame with instances in it with a glo_bulk_ack_t.  That holds the first instance it's missing (so it
+// has everything before that) and a bitmap of the instances after it that it's missing.  Only a window
+// of instances is sent past the oldest one that hasn't been acknowledged.
+//
+// Missing instances are sent again straight from the glob, so the glob instances can't be republished
+// until the transfer is done.  If nothing new is acknowledged for a timeout then the oldest instance
+// is sent again to get an acknowledgement, and after BULK_MAX_TIMEOUTS the transfer fails.
+//
+// This only decides what to send next. The send task does the sending.
+class GloBulkTransfer
+{
+  public: // methods
+
+    // Constructor
+    GloBulkTransfer(void);
+
+    // Start sending instances 'first' through 'last' of glob 'glob_id'.  At most 'window' instances
+    // (up to BULK_MAX_WINDOW) are sent past the oldest one that hasn't been acknowledged.
+    void start(uint8_t transfer_id, uint8_t glob_id, uint16_t first, uint16_t last, uint16_t window,
+               uint64_t timeout_ticks, uint64_t now_ticks);
+
+    // Return true if nextInstance() has something to send (or would time out) at 'now_ticks'.
+    bool readyToSend(uint64_t now_ticks) const;
+
+    // Return the instance to send next or 0 if nothing can be sent until an acknowledgement comes in
+    // or it times out.  Missing instances are sent before new ones.
+    uint16_t nextInstance(uint64_t now_ticks);
+
+    // Call once an instance returned by nextInstance() has been sent.
+    void markSent(uint16_t instance, uint64_t now_ticks);
+
+    // Update what's been received from an acknowledgement.  Return false if it's not for this transfer.
+    bool handleAck(glo_bulk_ack_t const & ack, uint64_t now_ticks);
+
+    // Return tick stamp nextInstance() will send the oldest instance again at if nothing is
+    // acknowledged, or UINT64_MAX if not sending.
+    uint64_t timeoutTicks(void) const;
+
+    // Forget the transfer so a new one can be started.
+    void reset(void) { state_ = BULK_STATE_IDLE; }
+
+    // Fill in the glob that describes the transfer to the receiver.
+    void describe(glo_bulk_transfer_t * transfer) const;
+
+    glo_bulk_state_t state(void) const { return state_; }
+
+    // Return oldest instance that hasn't been acknowledged.
+    uint16_t oldestUnacked(void) const { return (uint16_t)base_; }
+
+    // Return how many timeouts in a row there's been without anything new being acknowledged.
+    uint8_t numTimeouts(void) const { return num_timeouts_; }
+
+  private: // fields
+
+    glo_bulk_state_t state_;
+    uint8_t  transfer_id_;
+    uint8_t  glob_id_;
+    uint16_t window_;
+
+    // Instances are kept as 32 bits so 'last + 1' doesn't overflow.
+    uint32_t first_;
+    uint32_t last_;
+    uint32_t base_;     // Oldest instance that hasn't been acknowledged.
+    uint32_t next_new_; // Next instance that's never been sent.
+
+    // Bit i is set if 'base_ + i' needs to be sent again.
+    uint64_t resend_;
+
+    // Sequence number each instance in the window was last sent with, indexed by instance modulo
+    // the window.  Tells whether the receiver could have gotten an instance when it reports it missing.
+    uint16_t send_seq_[BULK_MAX_WINDOW];
+    uint16_t next_send_seq_;
+
+    uint64_t timeout_ticks_;
+    uint64_t deadline_ticks_;
+    uint8_t  num_timeouts_;
+
+    uint32_t num_sent_;
+    uint32_t num_resent_;
+
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef GLO_FRAME_H_INCLUDED
+#define GLO_FRAME_H_INCLUDED
+
+// Includes
+#include <cstdint>
+
+// Message framing shared by GloTxLink and GloRxLink.  Every frame is
+//
+//   start byte | reliable flag | ID | instance (2 bytes) | packet number | body length | body | CRC (2 bytes)
+//
+// with multi-byte fields little endian and the CRC covering everything before it.
+const uint8_t MSG_START_BYTE = 0xFE;
+const uint8_t MSG_HEADER_SIZE = 7;  // start, reliable flag, ID, instance (2 bytes), packet number, body length
+const uint8_t MSG_ID_IDX = 2;       // index of glob ID in header
+const uint8_t MSG_INSTANCE_IDX = 3; // index of instance in header
+const uint8_t MSG_LENGTH_IDX = 6;   // index of body length in header
+const uint8_t MSG_CRC_SIZE = 2;
+const uint16_t MSG_MAX_BODY_SIZE = 255;
+const uint16_t MSG_MAX_FRAME_SIZE = MSG_HEADER_SIZE + MSG_MAX_BODY_SIZE + MSG_CRC_SIZE;
+
+// A batch frame carries several globs under one header and CRC.  It uses an ID that's never given
+// to a glob and the instance field holds the number of records.  The body is a list of records:
+//
+//   glob ID | first instance (2 bytes) | instance count | glob size | 'count' instances of glob data
+//
+// Consecutive instances of the same glob (e.g. a capture dump) share one record.
+const uint8_t MSG_BATCH_ID = 0xFF;
+const uint8_t MSG_RECORD_HEADER_SIZE = 5; // ID, first instance (2 bytes), instance count, glob size
+
+// A glob too big for one frame (more than MSG_MAX_BODY_SIZE bytes) is split into fragment frames.
+// They use another ID that's never given to a glob and the instance field holds the glob's instance.
+// Each body is
+//
+//   glob ID | offset of data in glob (2 bytes) | glob size (2 bytes) | up to MSG_MAX_FRAGMENT_DATA bytes of glob data
+//
+// Other frames can be sent in between fragments, but not fragments of another glob.  The receiver
+// only keeps a glob if every fragment shows up in order.
+const uint8_t MSG_FRAGMENT_ID = 0xFE;
+const uint8_t MSG_FRAGMENT_HEADER_SIZE = 5; // ID, offset (2 bytes), glob size (2 bytes)
+const uint16_t MSG_MAX_FRAGMENT_DATA = MSG_MAX_BODY_SIZE - MSG_FRAGMENT_HEADER_SIZE;
+
+// Biggest glob that can be sent.  Both links keep a copy of the one being fragmented so it's limited by RAM.
+const uint16_t MSG_MAX_GLOB_SIZE = 2560;
+
+// Return bytes it takes to send a 'num_bytes' glob in one frame, or in fragments if it's too big.
+// Doesn't include framing (e.g. COBS).
+inline uint16_t msg_frames_size(uint16_t num_bytes)
+{
+    if (num_bytes <= MSG_MAX_BODY_SIZE)
+    {
+        return MSG_HEADER_SIZE + num_bytes + MSG_CRC_SIZE;
+    }
+    uint16_t num_fragments = (num_bytes + MSG_MAX_FRAGMENT_DATA - 1) / MSG_MAX_FRAGMENT_DATA;
+    return num_bytes + num_fragments * (MSG_HEADER_SIZE + MSG_FRAGMENT_HEADER_SIZE + MSG_CRC_SIZE);
+}
+
+// In COBS mode (LINK_FRAMING_COBS) the same frame is COBS encoded so it has no zero bytes and then
+// a zero byte is sent to end it.  A receiver only has to look for the next zero to resynchronize, so
+// a corrupted frame can never swallow the one after it.  Encoding adds one code byte per 254 bytes.
+const uint8_t MSG_COBS_DELIMITER = 0;
+const uint8_t MSG_COBS_MAX_CODE_BYTES = 1 + MSG_MAX_FRAME_SIZE / 254;
+const uint16_t MSG_COBS_MAX_ENCODED_SIZE = MSG_MAX_FRAME_SIZE + MSG_COBS_MAX_CODE_BYTES;
+
+#endif
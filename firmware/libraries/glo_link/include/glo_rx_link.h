@@ -2,6 +2,8 @@
 #define GLO_RX_LINK_H_INCLUDED
 
 #include <cstdint>
+#include "glo_frame.h"
+#include "glob_types.h"
 #include "usart.h"
 
 typedef void (*new_message_callback_t)(uint8_t, uint16_t, void *);
@@ -17,22 +19,57 @@ class GloRxLink
 
     // Look for newly transmitted object information and progresses through
     // state machine.  Needs be called by a periodic task that runs at least
-    // fast enough to handle data stream rate.  Currently this method only
-    // processes a single byte each time it's called.  Can call dataReady()
-    // to determine if need to parse more data.
+    // fast enough to handle data stream rate.  Only processes a single byte
+    // each time it's called.  Can call dataReady() to determine if need to
+    // parse more data.
     void parse(void);
 
+    // Parse everything that's been received, or until 'max_cycles' (see SystemTimer::cycles()) have
+    // elapsed, whichever comes first.  Complete messages are framed directly in the port's receive
+    // buffer.  Only a message that's split by the end of the buffer, or not fully received yet, is
+    // copied byte by byte like parse().  Checks the time between messages so it can run a little
+    // over the budget.  Return number of messages received.
+    uint32_t parseAvailable(uint32_t max_cycles);
+
     // Return true if there is data ready to be parsed.
     bool dataReady(void) const { return !port_->empty(); }
 
     void setPort(Usart * new_port) { port_ = new_port; }
 
+    // Return how many globs sent in fragments were thrown away because one went missing.
+    uint32_t numFragmentsDropped(void) const { return num_fragments_dropped_; }
+
+    // Change how frames are delimited (see glo_frame.h).  Anything partially received is dropped.
+    void setFraming(glo_link_framing_t framing) { framing_ = framing; resetParse(); }
+
   private: // methods
 
-      void handleReceivedMessage(void);
+      // Run one received byte through the state machine.  Return true if it completed a message.
+      bool parseByte(uint8_t in_byte);
+
+      // Verify a complete 'message' (header and body) and pass it to the callback. Return true if it was handled.
+      bool handleMessage(uint8_t const * message, uint16_t num_bytes, uint16_t expected_crc);
+
+      void handleReceivedMessage(uint8_t const * message);
+
+      // Pass each glob in a batch frame 'body' to the callback. See glo_frame.h.
+      void handleBatch(uint8_t const * body, uint16_t num_bytes);
+
+      // Add fragment frame 'body' to the glob being reassembled and pass it to the callback once it's
+      // all there.  See glo_frame.h.
+      void handleFragment(uint16_t instance, uint8_t const * body, uint16_t num_bytes);
+
+      // Save more of a COBS frame that's being received.
+      void appendCobs(uint8_t const * data, uint16_t num_bytes);
+
+      // Decode a COBS frame (without delimiter) and handle the message in it. Return true if it was handled.
+      bool handleCobsFrame(uint8_t const * encoded, uint16_t num_encoded);
+
+      // Decode COBS 'encoded' bytes into 'decoded', which can be the same buffer.  Return decoded size or 0 if invalid.
+      uint16_t decodeCobs(uint8_t const * encoded, uint16_t num_encoded, uint8_t * decoded);
 
       // Return true if actual CRC matches expected CRC stored in message.
-      bool verifyCRC(void);
+      bool verifyCRC(uint8_t const * message, uint16_t num_bytes, uint16_t expected_crc);
 
       void advanceParse(void);
 
@@ -53,19 +90,35 @@ class GloRxLink
     uint8_t expected_crc1_;
     uint8_t expected_crc2_;
 
-    // Data of entire message excluding checksum.
+    // Data of entire message excluding checksum, or the frame as it's received in COBS mode.
     // Larger than necessary to protect against future changes.
     uint8_t message_data_[300];
 
     // Current index to store next byte in 'message data'.
     uint16_t data_idx_;
 
+    // Copy of the message body handed to the callback. Words so the glob structs are aligned.
+    uint32_t body_[256 / sizeof(uint32_t)];
+
+    // Glob being reassembled from fragment frames.  Words so it's aligned like the glob struct.
+    uint32_t fragment_data_[MSG_MAX_GLOB_SIZE / sizeof(uint32_t)];
+    uint16_t fragment_size_;     // Zero if nothing is being reassembled.
+    uint16_t fragment_received_; // Bytes received so far, in order.
+    uint8_t  fragment_id_;
+    uint16_t fragment_instance_;
+
+    // How many globs were thrown away because a fragment was missing.
+    uint32_t num_fragments_dropped_;
+
     // How many complete messages have been parsed from serial port.
     uint32_t num_messages_received_;
 
     // Last received packet number.  Used to detect dropped packets.
     uint8_t last_rx_packet_num_;
 
+    // How frames are delimited.
+    glo_link_framing_t framing_;
+
 };
 
 #endif
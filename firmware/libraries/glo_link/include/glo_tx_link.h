@@ -4,6 +4,8 @@
 // Includes
 #include <cstdint>
 #include <cstdio>
+#include "glo_frame.h"
+#include "glob_types.h"
 #include "usart.h"
 
 // IDs for possible outcomes of sending a message.
@@ -25,11 +27,68 @@ class GloTxLink
     // Copy glob information and data that is associated with ID and instance
     // into transfer buffer. If 'data_buffer' is specified than will use that as
     // glob data, otherwise will use what's currently stored in the glob.
+    // A glob that's too big for one frame is sent in fragments (see glo_frame.h).  If they don't all
+    // fit then it returns SEND_ERROR_NO_ROOM and sends the rest when called again with the same glob.
     // Return true if successful.
     uint8_t send(uint8_t id, uint16_t instance, void * data_buffer=NULL);
 
+    // Start a batch frame (see glo_frame.h) that's built directly in the transfer buffer.  It will be
+    // up to 'max_frame_size' bytes long (including header and CRC) or however much room is left in the
+    // transfer buffer if that's smaller.  Return false if there isn't room for anything.  Must call
+    // endBatch() before sending anything else.
+    bool beginBatch(uint16_t max_frame_size);
+
+    // Add glob to the open batch. Same arguments as send().  Return SEND_ERROR_NO_ROOM once the batch is full.
+    uint8_t addToBatch(uint8_t id, uint16_t instance, void * data_buffer=NULL);
+
+    // Send the open batch.  Nothing is sent if nothing was added.
+    void endBatch(void);
+
+    // Return true if nothing has been added to the open batch.
+    bool batchEmpty(void) const { return num_records_ == 0; }
+
     void set_port(Usart * new_port) { port_ = new_port; }
 
+    // Change how frames are delimited (see glo_frame.h).  Can't be called with a batch open.
+    void set_framing(glo_link_framing_t framing) { framing_ = framing; }
+
+    // Return how many bytes of the transfer buffer send() needs for glob 'id', including framing.
+    // Only the first fragment if it has to be fragmented.
+    uint16_t frameSize(uint8_t id) const;
+
+    // Return true if glob 'id' is too big for one frame.
+    bool needsFragments(uint8_t id) const;
+
+    // Return true if some of 'id' and 'instance' has been sent in fragments but not all of it.  Sending
+    // any other glob that needs fragments first throws away the rest of it.
+    bool sendingFragments(uint8_t id, uint16_t instance) const;
+
+    // Return how many more bytes than the frame the framing mode needs in the transfer buffer.
+    uint16_t framingOverhead(void) const;
+
+    // Return how many bytes have been handed to the serial port, including framing.
+    uint32_t numBytesSent(void) const { return num_bytes_sent_; }
+
+  private: // methods
+
+    // Send as many of the remaining fragments of the glob in 'fragment_data_' as fit.
+    uint8_t sendFragments(void);
+
+    // Write a 'header' and 'body' frame to the transfer buffer and send it.  'body' is split in two
+    // (either can be empty) so it doesn't have to be copied together first.
+    uint8_t sendFrame(uint8_t const * header, uint8_t const * body1, uint16_t num_body1_bytes,
+                      uint8_t const * body2, uint16_t num_body2_bytes);
+
+    // Return where the frame is written in the reserved region so it can be encoded in place.
+    uint16_t frameOffset(void) const;
+
+    // Encode the 'frame_size' byte frame written at frameOffset() in 'reserved' (if needed) and send it.
+    void commitFrame(dma_tx_region_t & reserved, uint16_t frame_size);
+
+    // COBS encode the frame at MSG_COBS_MAX_CODE_BYTES in 'region' into the start of it.
+    // Return the encoded size (not including the delimiter).
+    uint16_t encodeCobs(dma_tx_region_t & region, uint16_t frame_size);
+
   private: // fields
 
     // Serial port that data gets sent/received over
@@ -37,12 +96,34 @@ class GloTxLink
 
     uint32_t num_messages_sent_;
     uint32_t num_messages_failed_;
+    uint32_t num_bytes_sent_;
 
     // incrementing number from 0 to 255 that's used to detect dropped packets
     uint8_t next_packet_num_;
 
-    // Make larger than necessary to protect against future changes.
-    uint8_t send_buffer_[300];
+    // Batch frame being built in the transfer buffer.
+    bool            batch_open_;
+    dma_tx_region_t batch_reserved_; // Everything reserved including room for framing.
+    dma_tx_region_t batch_;          // Part of the reservation the frame goes in.
+    uint16_t        batch_size_;     // Bytes written so far (including header).
+    uint16_t        batch_capacity_; // Bytes that can be written before the CRC.
+    uint8_t         num_records_;
+
+    // Record that's currently being added to.
+    uint16_t        record_start_;   // Offset of record in batch.
+    uint8_t         record_id_;
+    uint16_t        record_next_instance_;
+    uint8_t         record_count_;
+
+    // How frames are delimited.
+    glo_link_framing_t framing_;
+
+    // Copy of the glob being sent in fragments.  Words so it's aligned like the glob struct.
+    uint32_t fragment_data_[MSG_MAX_GLOB_SIZE / sizeof(uint32_t)];
+    uint16_t fragment_size_;   // Zero if nothing is being fragmented.
+    uint16_t fragment_offset_; // Bytes of the glob already sent.
+    uint8_t  fragment_id_;
+    uint16_t fragment_instance_;
 
 };
 
@@ -1,43 +1,90 @@
 #include "crc.h"
 
-// Lookup table for polynomial 0x1021
-const uint16_t lookup_table[] =
+static_assert((CRC_SLICE_BYTES == 1) || (CRC_SLICE_BYTES == 4) || (CRC_SLICE_BYTES == 8),
+              "CRC_SLICE_BYTES must be 1, 4 or 8.");
+
+//*****************************************************************************
+// Return 'crc' shifted through the 0x1021 polynomial 'num_bits' times (one bit of zero data each).
+static constexpr uint16_t crc_shift(uint16_t crc, uint8_t num_bits)
+{
+    return (num_bits == 0) ? crc :
+           crc_shift((crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1), num_bits - 1);
+}
+
+//*****************************************************************************
+// Table entry for 'byte' followed by 'slice' zero bytes, starting from a CRC of zero.  Slice 0 is the
+// usual byte at a time table.
+static constexpr uint16_t crc_entry(uint8_t slice, uint16_t byte)
 {
-    0, 4129, 8258, 12387, 16516, 20645, 24774, 28903, 33032, 37161, 41290,
-    45419, 49548, 53677, 57806, 61935, 4657, 528, 12915, 8786, 21173,
-    17044, 29431, 25302, 37689, 33560, 45947, 41818, 54205, 50076, 62463,
-    58334, 9314, 13379, 1056, 5121, 25830, 29895, 17572, 21637, 42346,
-    46411, 34088, 38153, 58862, 62927, 50604, 54669, 13907, 9842, 5649,
-    1584, 30423, 26358, 22165, 18100, 46939, 42874, 38681, 34616, 63455,
-    59390, 55197, 51132, 18628, 22757, 26758, 30887, 2112, 6241, 10242,
-    14371, 51660, 55789, 59790, 63919, 35144, 39273, 43274, 47403, 23285,
-    19156, 31415, 27286, 6769, 2640, 14899, 10770, 56317, 52188, 64447,
-    60318, 39801, 35672, 47931, 43802, 27814, 31879, 19684, 23749, 11298,
-    15363, 3168, 7233, 60846, 64911, 52716, 56781, 44330, 48395, 36200,
-    40265, 32407, 28342, 24277, 20212, 15891, 11826, 7761, 3696, 65439,
-    61374, 57309, 53244, 48923, 44858, 40793, 36728, 37256, 33193, 45514,
-    41451, 53516, 49453, 61774, 57711, 4224, 161, 12482, 8419, 20484,
-    16421, 28742, 24679, 33721, 37784, 41979, 46042, 49981, 54044, 58239,
-    62302, 689, 4752, 8947, 13010, 16949, 21012, 25207, 29270, 46570,
-    42443, 38312, 34185, 62830, 58703, 54572, 50445, 13538, 9411, 5280,
-    1153, 29798, 25671, 21540, 17413, 42971, 47098, 34713, 38840, 59231,
-    63358, 50973, 55100, 9939, 14066, 1681, 5808, 26199, 30326, 17941,
-    22068, 55628, 51565, 63758, 59695, 39368, 35305, 47498, 43435, 22596,
-    18533, 30726, 26663, 6336, 2273, 14466, 10403, 52093, 56156, 60223,
-    64286, 35833, 39896, 43963, 48026, 19061, 23124, 27191, 31254, 2801,
-    6864, 10931, 14994, 64814, 60687, 56684, 52557, 48554, 44427, 40424,
-    36297, 31782, 27655, 23652, 19525, 15522, 11395, 7392, 3265, 61215,
-    65342, 53085, 57212, 44955, 49082, 36825, 40952, 28183, 32310, 20053,
-    24180, 11923, 16050, 3793, 7920
+    return crc_shift(byte << 8, 8 * (slice + 1));
+}
+
+// Table for one of the bytes folded in each round.
+struct crc_slice_t
+{
+    uint16_t entry[256];
+};
+
+// One table per byte folded in each round.
+struct crc_table_t
+{
+    crc_slice_t slice[CRC_SLICE_BYTES];
 };
 
+// Lists of indices to expand the tables from.
+template<uint16_t... indices> struct crc_indices {};
+template<uint16_t count, uint16_t... indices> struct crc_make_indices : crc_make_indices<count-1, count-1, indices...> {};
+template<uint16_t... indices> struct crc_make_indices<0, indices...> { typedef crc_indices<indices...> type; };
+
 //*****************************************************************************
-uint16_t calculate_crc(uint8_t * buffer, uint32_t size, uint16_t init)
+template<uint16_t... bytes>
+static constexpr crc_slice_t crc_make_slice(uint8_t slice, crc_indices<bytes...>)
 {
-    uint16_t crc = init;
-    while(size--)
+    return crc_slice_t{ { crc_entry(slice, bytes)... } };
+}
+
+//*****************************************************************************
+template<uint16_t... slices>
+static constexpr crc_table_t crc_make_table(crc_indices<slices...>)
+{
+    return crc_table_t{ { crc_make_slice(slices, crc_make_indices<256>::type())... } };
+}
+
+// Lookup tables for polynomial 0x1021, built by the compiler and kept in flash.
+static constexpr crc_table_t crc_table = crc_make_table(crc_make_indices<CRC_SLICE_BYTES>::type());
+
+// Same values as the byte at a time table this replaced.
+static_assert((crc_table.slice[0].entry[1] == 4129) && (crc_table.slice[0].entry[128] == 37256) &&
+              (crc_table.slice[0].entry[255] == 7920), "CRC table doesn't match polynomial 0x1021.");
+
+//*****************************************************************************
+uint16_t crc_update(uint16_t crc, uint8_t const * data, uint32_t size)
+{
+    crc_slice_t const * table = crc_table.slice;
+
+    // The CRC lines up with the first two bytes of each round and the rest only need their tables.
+#if CRC_SLICE_BYTES == 8
+    while (size >= 8)
+    {
+        crc = table[7].entry[(crc >> 8) ^ data[0]] ^ table[6].entry[(crc & 0xFF) ^ data[1]] ^
+              table[5].entry[data[2]] ^ table[4].entry[data[3]] ^ table[3].entry[data[4]] ^
+              table[2].entry[data[5]] ^ table[1].entry[data[6]] ^ table[0].entry[data[7]];
+        data += 8;
+        size -= 8;
+    }
+#elif CRC_SLICE_BYTES == 4
+    while (size >= 4)
+    {
+        crc = table[3].entry[(crc >> 8) ^ data[0]] ^ table[2].entry[(crc & 0xFF) ^ data[1]] ^
+              table[1].entry[data[2]] ^ table[0].entry[data[3]];
+        data += 4;
+        size -= 4;
+    }
+#endif
+
+    while (size--)
     {
-        crc = (crc << 8) ^ lookup_table[((crc >> 8) ^ *buffer++) & 0xFFFF];
+        crc = (crc << 8) ^ table[0].entry[(crc >> 8) ^ *data++];
     }
     return crc;
 }
@@ -15,7 +15,8 @@ void debug_printf
         ...                  // Variable arguments. (just like printf() uses)
     )
 {
-    glo_debug_message_t debug_message;
+    // Cleared so what's after the text isn't whatever was on the stack.
+    glo_debug_message_t debug_message = {};
 
     va_list args;
     va_start(args, format);
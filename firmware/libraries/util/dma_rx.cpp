@@ -57,13 +57,17 @@ DmaRx::~DmaRx(void)
 }
 
 //*****************************************************************************
-bool DmaRx::empty(void) const
+uint32_t DmaRx::bufferTop(void) const
 {
     // NDTR = Number of data items left to transfer register.
-    uint32_t buff_top = buff_length_ - (uint16_t)dma_stream_->NDTR;
+    return buff_length_ - (uint16_t)dma_stream_->NDTR;
+}
 
+//*****************************************************************************
+bool DmaRx::empty(void) const
+{
     // If top and bottom are at the same point then there's no elements in buffer.
-    return (buff_top == buff_bottom_);
+    return (bufferTop() == buff_bottom_);
 }
 
 //*****************************************************************************
@@ -78,3 +82,27 @@ bool DmaRx::getByte(uint8_t * byte)
 
     return true;
 }
+
+//*****************************************************************************
+uint8_t const * DmaRx::peekSpan(uint32_t * length) const
+{
+    uint32_t buff_top = bufferTop();
+
+    // Top can equal the buffer length for a moment before NDTR reloads, which still works here.
+    if (buff_top >= buff_bottom_)
+    {
+        *length = buff_top - buff_bottom_;
+    }
+    else // wrapped so only return up to the end of the buffer
+    {
+        *length = buff_length_ - buff_bottom_;
+    }
+
+    return &buff_[buff_bottom_];
+}
+
+//*****************************************************************************
+void DmaRx::consume(uint32_t length)
+{
+    buff_bottom_ = (buff_bottom_ + length) % buff_length_;
+}
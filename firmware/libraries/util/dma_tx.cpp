@@ -22,6 +22,8 @@ DmaTx::DmaTx
     buff_top_ = 0;
     dma_top_ = 0;
     dma_active_ = false;
+    reserved_start_ = 0;
+    reserved_length_ = 0;
     transfer_complete_bit_ = transfer_complete_bit;
     transfer_error_bit_ = transfer_error_bit;
     error_count_ = 0;
@@ -73,95 +75,150 @@ DmaTx::~DmaTx(void)
 //*****************************************************************************
 bool DmaTx::sendBuffer(uint8_t const * data, uint16_t len)
 {
-    if ((len > buff_length_) || (len == 0))
+    dma_tx_region_t region;
+    if (!reserve(len, &region))
     {
         return false;
     }
 
-    // Turn off the DMA interrupt since will be messing with transfer buffer.
-    // **Note DMA may still be running.
-    NVIC_DisableIRQ(dma_irq_num_);
+    region.write(0, data, len);
+
+    commit();
 
-    uint16_t start, end;
-    bool copy_successful = copyToTransferBuffer(data, len, &start, &end);
+    return true;
+}
 
-    if (copy_successful && !dma_active_)
+//*****************************************************************************
+bool DmaTx::reserve(uint16_t len, dma_tx_region_t * region)
+{
+    if ((len > buff_length_) || (len == 0))
     {
-        activateDMATransfer(start);
+        return false;
     }
 
-    NVIC_EnableIRQ(dma_irq_num_);
-
-    return copy_successful;
+    return (reserveUpTo(len, region) == len);
 }
 
 //*****************************************************************************
-bool DmaTx::copyToTransferBuffer
-    (
-         uint8_t  const * data,   // Buffer containing new data.
-         uint16_t         len,    // How many bytes to transfer.
-         uint16_t       * start,  // Start index of next transfer.
-         uint16_t       * end     // Ending index of next transfer.
-    )
+uint16_t DmaTx::reserveUpTo(uint16_t max_len, dma_tx_region_t * region)
 {
-    uint16_t num_in_buff = 0;  // How many bytes are already in transfer buffer.
+    // Turn off the DMA interrupt since will be messing with transfer buffer.
+    // **Note DMA may still be running.
+    NVIC_DisableIRQ(dma_irq_num_);
 
-    // Default start and end indices assuming will fit.
-    *start = buff_top_ + 1;
-    *end   = buff_top_ + len;
+    uint16_t num_in_buff = numBytesQueued();  // How many bytes are already in transfer buffer.
 
-    if (dma_active_)
-    {
-        // Find the space in the buffer.
-        uint16_t num_data_left_to_transfer = dma_stream_->NDTR;
-        if (dma_top_ > buff_top_)
-        {
-            num_in_buff = buff_top_ + buff_length_ + num_data_left_to_transfer - dma_top_;
-        }
-        else
-        {
-            num_in_buff = buff_top_ - dma_top_ + num_data_left_to_transfer;
-        }
-    }
-    else
+    // Default start index assuming buffer isn't empty.
+    uint16_t start = buff_top_ + 1;
+
+    if (!dma_active_)
     {
         // Reset to bottom to minimize the rollovers.
-        num_in_buff = buff_top_ = dma_top_ = *start = 0;
-        *end = len - 1;
+        buff_top_ = dma_top_ = start = 0;
     }
 
-    // Check for enough room in the dma buffer.
+    // Only reserve what's free in the dma buffer.
     // The -1 is to prevent a very rare edge case where there is just enough room in top
     // of buffer and the previous copy had split, putting part on top and part on bottom
     // -- and -- the dma has just finished transferring the last byte on the top.
-    if (len > (buff_length_ - num_in_buff - 1))
+    uint16_t len = buff_length_ - num_in_buff - 1;
+    if (len > max_len)
     {
-        return false; // won't fit in buffer.
+        len = max_len;
     }
 
-    if (*start == buff_length_)
+    if (start == buff_length_)
     {
-        *start = 0;
-        *end = len - 1;
-        // Copy to beginning of buffer.
-        memcpy(buff_, data, len);
+        // Starts at beginning of buffer.
+        start = 0;
     }
-    else if (*end >= buff_length_)
+
+    if (start + len > buff_length_)
     {
-        *end -= buff_length_;
-        // Need to copy to end of buffer and then copy the rest into the beginning.
-        memcpy(buff_ + *start, data, buff_length_ - *start);
-        memcpy(buff_, data + buff_length_ - *start, len + *start - buff_length_);
+        // Need to use end of buffer and then the rest of the beginning.
+        region->part[0] = buff_ + start;
+        region->length[0] = buff_length_ - start;
+        region->part[1] = buff_;
+        region->length[1] = len - region->length[0];
     }
     else
     {
-        // Everything's fine.  Just copy into transfer buffer.
-        memcpy(buff_ + *start, data, len);
+        region->part[0] = buff_ + start;
+        region->length[0] = len;
+        region->part[1] = NULL;
+        region->length[1] = 0;
     }
 
-    buff_top_ = *end;
+    reserved_start_ = start;
+    reserved_length_ = len;
 
-    return true;
+    NVIC_EnableIRQ(dma_irq_num_);
+
+    return len;
+}
+
+//*****************************************************************************
+uint16_t DmaTx::freeSpace(void)
+{
+    NVIC_DisableIRQ(dma_irq_num_);
+    uint16_t num_in_buff = numBytesQueued();
+    NVIC_EnableIRQ(dma_irq_num_);
+
+    // Same -1 as reserveUpTo().
+    return buff_length_ - num_in_buff - 1;
+}
+
+//*****************************************************************************
+uint16_t DmaTx::numBytesQueued(void) const
+{
+    if (!dma_active_)
+    {
+        return 0;
+    }
+
+    // Find the space in the buffer.
+    uint16_t num_data_left_to_transfer = dma_stream_->NDTR;
+    if (dma_top_ > buff_top_)
+    {
+        return buff_top_ + buff_length_ + num_data_left_to_transfer - dma_top_;
+    }
+
+    return buff_top_ - dma_top_ + num_data_left_to_transfer;
+}
+
+//*****************************************************************************
+void DmaTx::commit(void)
+{
+    commit(reserved_length_);
+}
+
+//*****************************************************************************
+void DmaTx::commit(uint16_t num_bytes)
+{
+    if (num_bytes > reserved_length_)
+    {
+        num_bytes = reserved_length_;
+    }
+
+    reserved_length_ = 0;
+
+    if (num_bytes == 0)
+    {
+        return; // nothing written so nothing to send
+    }
+
+    // The DMA only ever sends up to the buffer top so the region was safe to fill without
+    // the interrupt disabled, but moving the top has to be atomic with the ISR.
+    NVIC_DisableIRQ(dma_irq_num_);
+
+    buff_top_ = (reserved_start_ + num_bytes - 1) % buff_length_;
+
+    if (!dma_active_)
+    {
+        activateDMATransfer(reserved_start_);
+    }
+
+    NVIC_EnableIRQ(dma_irq_num_);
 }
 
 //*****************************************************************************
@@ -227,3 +284,11 @@ void DmaTx::handleISR(void)
         }
     }
 }
+
+//*****************************************************************************
+void DmaTx::poll(void)
+{
+    NVIC_DisableIRQ(dma_irq_num_);
+    handleISR();
+    NVIC_EnableIRQ(dma_irq_num_);
+}
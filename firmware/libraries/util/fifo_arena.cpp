@@ -0,0 +1,113 @@
+// Includes
+#include <cstddef>
+#include "fifo_arena.h"
+
+//*****************************************************************************
+FifoArena::FifoArena(uint32_t num_bytes) :
+    buffer_(NULL),
+    capacity_(num_bytes & ~3u),
+    head_(0),
+    tail_(0),
+    num_used_(0),
+    num_blocks_(0)
+{
+    buffer_ = new uint32_t[capacity_ / 4];
+}
+
+//*****************************************************************************
+FifoArena::~FifoArena(void)
+{
+    delete[] buffer_;
+}
+
+//*****************************************************************************
+void * FifoArena::allocate(uint32_t num_bytes)
+{
+    uint32_t size = blockSize(num_bytes);
+    if (size > UINT16_MAX)
+    {
+        return NULL; // too big to describe in a block header
+    }
+
+    uint8_t * bytes = reinterpret_cast<uint8_t *>(buffer_);
+
+    if ((head_ > tail_) || (num_used_ == 0))
+    {
+        // Free space is from the head to the end of the buffer and from the start up to the tail.
+        uint32_t end_space = capacity_ - head_;
+        if (size > end_space)
+        {
+            if (size > tail_)
+            {
+                return NULL;
+            }
+
+            // Doesn't fit at the end so pad it out and start again at the front.  Head is never left at
+            // the very end so there's always room for the padding header.
+            block_header_t * padding = reinterpret_cast<block_header_t *>(bytes + head_);
+            padding->size = (uint16_t)end_space;
+            padding->in_use = false;
+            num_used_ += end_space;
+            head_ = 0;
+        }
+    }
+    else if (head_ + size > tail_)
+    {
+        return NULL; // head has wrapped around and is up against the tail (or arena is full)
+    }
+
+    block_header_t * header = reinterpret_cast<block_header_t *>(bytes + head_);
+    header->size = (uint16_t)size;
+    header->in_use = true;
+
+    head_ += size;
+    if (head_ == capacity_)
+    {
+        head_ = 0;
+    }
+    num_used_ += size;
+    num_blocks_++;
+
+    return header + 1;
+}
+
+//*****************************************************************************
+void FifoArena::free(void * block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+
+    block_header_t * header = static_cast<block_header_t *>(block) - 1;
+    header->in_use = false;
+    num_blocks_--;
+
+    reclaim();
+}
+
+//*****************************************************************************
+void FifoArena::reclaim(void)
+{
+    uint8_t * bytes = reinterpret_cast<uint8_t *>(buffer_);
+
+    while (num_used_ > 0)
+    {
+        block_header_t const * oldest = reinterpret_cast<block_header_t const *>(bytes + tail_);
+        if (oldest->in_use)
+        {
+            return;
+        }
+
+        num_used_ -= oldest->size;
+        tail_ += oldest->size;
+        if (tail_ == capacity_)
+        {
+            tail_ = 0;
+        }
+    }
+
+    // Nothing left so start over at the front to leave the most contiguous room.
+    head_ = 0;
+    tail_ = 0;
+}
@@ -0,0 +1,201 @@
+#ifndef CAPTURE_CODEC_H_INCLUDED
+#define CAPTURE_CODEC_H_INCLUDED
+
+// Includes
+#include <cstdint>
+#include <cstring>
+
+// Most channels in a sample.
+const uint8_t CAPTURE_CODEC_MAX_CHANNELS = 16;
+
+// Packs capture samples into fixed size blocks (e.g. the data of a capture data instance) with every
+// channel quantized to an int16 step count: (value - zero) / scale rounded to the nearest and clamped to
+// +/-32767.  Samples are back to back in a block, with the channels of a sample in order.
+//
+// With delta encoding only the first sample in a block is int16s.  The rest are int8 changes from the
+// sample before as the decoder will see it, so a change of more than 127 steps is clamped and caught up
+// over the next samples instead of being lost for good.  Blocks never depend on each other, so a lost
+// block only loses its own samples.
+//
+// Unused bytes at the end of a block (and the samples after the last one in a partly full block) are
+// left as they were, so the receiver has to know how many samples there are (e.g. total_samples).
+class CaptureEncoder
+{
+  public: // methods
+
+    // Constructor. Can't add samples until configure() is called.
+    CaptureEncoder(void) :
+        num_channels_(0),
+        delta_(false),
+        samples_per_block_(0),
+        num_in_block_(0)
+    {
+    }
+
+    // Start over with 'num_channels' with the 'scale' and 'zero' of each, packed into blocks of 'block_bytes'.
+    // Return false if a block can't hold a sample or a scale is zero (or not a number).
+    bool configure(uint8_t num_channels, float const * scale, float const * zero, bool delta, uint16_t block_bytes)
+    {
+        samples_per_block_ = samplesPerBlock(num_channels, delta, block_bytes);
+        num_in_block_ = 0;
+        if ((samples_per_block_ == 0) || (num_channels > CAPTURE_CODEC_MAX_CHANNELS))
+        {
+            samples_per_block_ = 0;
+            return false;
+        }
+
+        for (uint8_t i = 0; i < num_channels; ++i)
+        {
+            if (!(scale[i] > 0.0f) && !(scale[i] < 0.0f))
+            {
+                samples_per_block_ = 0;
+                return false;
+            }
+            inverse_scale_[i] = 1.0f / scale[i];
+            zero_[i] = zero[i];
+        }
+
+        num_channels_ = num_channels;
+        delta_ = delta;
+
+        return true;
+    }
+
+    // Quantize the next sample's 'values' (one per channel) into 'block'.  Return true if that filled the
+    // block, in which case the next sample starts a new one.
+    bool add(float const * values, uint8_t * block)
+    {
+        if (samples_per_block_ == 0)
+        {
+            return false;
+        }
+
+        if (!delta_ || (num_in_block_ == 0))
+        {
+            int16_t * steps = (int16_t *)(block + num_in_block_ * num_channels_ * sizeof(int16_t));
+            for (uint8_t i = 0; i < num_channels_; ++i)
+            {
+                last_[i] = quantize(values[i], inverse_scale_[i], zero_[i]);
+                memcpy(&steps[i], &last_[i], sizeof(int16_t));
+            }
+        }
+        else
+        {
+            int8_t * changes = (int8_t *)(block + num_channels_ * sizeof(int16_t) + (num_in_block_ - 1) * num_channels_);
+            for (uint8_t i = 0; i < num_channels_; ++i)
+            {
+                int32_t change = (int32_t)quantize(values[i], inverse_scale_[i], zero_[i]) - last_[i];
+                change = (change > INT8_MAX) ? INT8_MAX : ((change < -INT8_MAX) ? -INT8_MAX : change);
+                changes[i] = (int8_t)change;
+                last_[i] = (int16_t)(last_[i] + change);
+            }
+        }
+
+        if (++num_in_block_ >= samples_per_block_)
+        {
+            num_in_block_ = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // Start a new block with the next sample, e.g. after sending one that wasn't full.
+    void startBlock(void) { num_in_block_ = 0; }
+
+    // Return how many samples fit in a block, or zero if configure() failed.
+    uint8_t samplesPerBlock(void) const { return samples_per_block_; }
+
+    // Return how many samples are in the block that's being filled.
+    uint8_t numInBlock(void) const { return num_in_block_; }
+
+    // Return how many bytes of a block full samples take.
+    uint16_t usedBytes(void) const
+    {
+        uint16_t first_bytes = num_channels_ * sizeof(int16_t);
+        if (samples_per_block_ == 0)
+        {
+            return 0;
+        }
+        return delta_ ? (first_bytes + (samples_per_block_ - 1) * num_channels_) : (samples_per_block_ * first_bytes);
+    }
+
+    // Return how many samples of 'num_channels' fit in 'block_bytes'.
+    static uint8_t samplesPerBlock(uint8_t num_channels, bool delta, uint16_t block_bytes)
+    {
+        uint16_t first_bytes = num_channels * sizeof(int16_t);
+        if ((num_channels == 0) || (first_bytes > block_bytes))
+        {
+            return 0;
+        }
+        uint16_t num_samples = delta ? (1 + (block_bytes - first_bytes) / num_channels) : (block_bytes / first_bytes);
+        return (num_samples > UINT8_MAX) ? UINT8_MAX : (uint8_t)num_samples;
+    }
+
+    // Return 'value' in steps of 1 / 'inverse_scale' from 'zero'. Not a number is zero.
+    static int16_t quantize(float value, float inverse_scale, float zero)
+    {
+        float steps = (value - zero) * inverse_scale;
+        if (steps >= (float)INT16_MAX)
+        {
+            return INT16_MAX;
+        }
+        if (steps <= (float)-INT16_MAX)
+        {
+            return -INT16_MAX;
+        }
+        if (steps != steps)
+        {
+            return 0;
+        }
+        return (int16_t)((steps >= 0.0f) ? (steps + 0.5f) : (steps - 0.5f));
+    }
+
+  private: // fields
+
+    // Channels in each sample and whether it's delta encoded.
+    uint8_t num_channels_;
+    bool delta_;
+
+    // Block size in samples and how many are in the one being filled.
+    uint8_t samples_per_block_;
+    uint8_t num_in_block_;
+
+    // Multiplying is faster than dividing.
+    float inverse_scale_[CAPTURE_CODEC_MAX_CHANNELS];
+    float zero_[CAPTURE_CODEC_MAX_CHANNELS];
+
+    // Last value the decoder will see for each channel. Used for delta encoding.
+    int16_t last_[CAPTURE_CODEC_MAX_CHANNELS];
+
+};
+
+// Unpacks blocks from a CaptureEncoder (e.g. in a GUI or host tool).
+class CaptureDecoder
+{
+  public: // methods
+
+    // Put the first 'num_samples' samples of 'num_channels' in 'block' into 'values', one channel after another.
+    static void decode(uint8_t const * block, uint8_t num_samples, uint8_t num_channels, float const * scale,
+                       float const * zero, bool delta, float * values)
+    {
+        int16_t last[CAPTURE_CODEC_MAX_CHANNELS];
+        for (uint8_t sample = 0; sample < num_samples; ++sample)
+        {
+            for (uint8_t i = 0; i < num_channels; ++i)
+            {
+                if (!delta || (sample == 0))
+                {
+                    memcpy(&last[i], block + (sample * num_channels + i) * sizeof(int16_t), sizeof(int16_t));
+                }
+                else
+                {
+                    last[i] = (int16_t)(last[i] + (int8_t)block[num_channels * sizeof(int16_t) + (sample - 1) * num_channels + i]);
+                }
+                values[sample * num_channels + i] = zero[i] + scale[i] * last[i];
+            }
+        }
+    }
+
+};
+
+#endif
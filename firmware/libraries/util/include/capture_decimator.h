@@ -0,0 +1,239 @@
+#ifndef CAPTURE_DECIMATOR_H_INCLUDED
+#define CAPTURE_DECIMATOR_H_INCLUDED
+
+// Includes
+#include <cstdint>
+
+// Most channels that can be filtered at once.
+const uint8_t DECIMATOR_MAX_CHANNELS = 16;
+
+// Filter length for each output, so the filter is 'factor' times this long.
+const uint8_t DECIMATOR_TAPS_PER_OUTPUT = 8;
+
+// Most inputs for each output.  Past this the filter would be too long to cut aliasing by 40 dB, so
+// captures that are filtered can't be slower than the control rate divided by this.
+const uint16_t DECIMATOR_MAX_FACTOR = 64;
+
+// Longest filter.
+const uint16_t DECIMATOR_MAX_TAPS = DECIMATOR_TAPS_PER_OUTPUT * DECIMATOR_MAX_FACTOR;
+
+// Low-pass filters samples taken at one rate (e.g. the control loop) before keeping every Nth one, so
+// what happens between the kept samples (e.g. motor and IMU vibration) doesn't alias into them.  The filter
+// is a Hamming windowed sinc with its cutoff at 40% of the output rate.  Anything at 60% of the output rate
+// or more (which would fold back below 40%) is cut by 40 dB or more.
+//
+// Each input is added into the sums of the outputs it's part of (the transposed form of a polyphase
+// decimator), so every input takes the same time and a channel only keeps one sum per output in progress
+// instead of every input the filter spans.
+//
+// Only uses + - * / and sums each output's inputs oldest first, so a host build gives the same bits as
+// the robot as long as neither fuses multiply-adds (the robot builds at -O0 and host tools use
+// -ffp-contract=off).  This is why the CMSIS-DSP decimators aren't used, besides only arm_math.h being
+// in the build.
+class CaptureDecimator
+{
+  public: // methods
+
+    // Constructor. Passes every sample through until configure() is called.
+    CaptureDecimator(void) :
+        num_channels_(0),
+        factor_(1),
+        num_taps_(1),
+        num_sums_(1),
+        oldest_sum_(0),
+        phase_(0),
+        primed_(false)
+    {
+        coefficients_[0] = 1.0f;
+    }
+
+    // Start over with 'num_channels' and keep every 'factor'th output.  A factor of one passes samples
+    // straight through.  Return false (and leave it passing them through) if the arguments are bad.
+    bool configure(uint8_t num_channels, uint16_t factor)
+    {
+        num_channels_ = num_channels;
+        factor_ = 1;
+        num_taps_ = 1;
+        num_sums_ = 1;
+        coefficients_[0] = 1.0f;
+
+        bool valid = (num_channels <= DECIMATOR_MAX_CHANNELS) && (factor > 0) && (factor <= DECIMATOR_MAX_FACTOR);
+        if (valid)
+        {
+            factor_ = factor;
+            num_taps_ = design(factor, coefficients_);
+            num_sums_ = (uint8_t)(num_taps_ / factor);
+        }
+
+        reset();
+
+        return valid;
+    }
+
+    // Forget past samples so the next one starts over, e.g. at the start of a capture.
+    void reset(void)
+    {
+        // The first input finishes the first output.
+        phase_ = factor_ - 1;
+        oldest_sum_ = 0;
+        primed_ = false;
+    }
+
+    // Filter the next sample's 'values' (one per channel).  Return true and put the filtered sample in
+    // 'outputs' if it's one of the kept ones, which is the first one after reset() and every 'factor'th
+    // one after it.  The first sample fills in the past so there's no step at the start.
+    bool add(float const * values, float * outputs)
+    {
+        if (!primed_)
+        {
+            prime(values);
+        }
+
+        // Sums go from the next output to the last one this input is part of, which takes it earliest
+        // in its filter.
+        uint8_t sum = oldest_sum_;
+        for (uint8_t j = 0; j < num_sums_; ++j)
+        {
+            float coefficient = coefficients_[phase_ + (num_sums_ - 1 - j) * factor_];
+            for (uint8_t i = 0; i < num_channels_; ++i)
+            {
+                sums_[sum][i] += coefficient * values[i];
+            }
+            sum = (sum + 1 >= num_sums_) ? 0 : sum + 1;
+        }
+
+        if (++phase_ < factor_)
+        {
+            return false;
+        }
+
+        // Oldest sum is done.  Its inputs are all used so it starts over as the newest one.
+        for (uint8_t i = 0; i < num_channels_; ++i)
+        {
+            outputs[i] = sums_[oldest_sum_][i];
+            sums_[oldest_sum_][i] = 0.0f;
+        }
+        oldest_sum_ = (oldest_sum_ + 1 >= num_sums_) ? 0 : oldest_sum_ + 1;
+        phase_ = 0;
+
+        return true;
+    }
+
+    // Return how many inputs there are for each output.
+    uint16_t factor(void) const { return factor_; }
+
+    // Return how long the filter is.
+    uint16_t numTaps(void) const { return num_taps_; }
+
+    // Return how many inputs an output lags the newest input by, since the filter is centered on the
+    // middle of its inputs.
+    float delay(void) const { return (num_taps_ - 1) * 0.5f; }
+
+    // Return the filter, oldest input first.
+    float const * coefficients(void) const { return coefficients_; }
+
+    // Return the sum of the first 'num_taps' of 'coefficients' added in order.
+    static float sumOf(float const * coefficients, uint16_t num_taps)
+    {
+        float sum = 0.0f;
+        for (uint16_t k = 0; k < num_taps; ++k)
+        {
+            sum += coefficients[k];
+        }
+        return sum;
+    }
+
+    // Put the filter for keeping every 'factor'th input into 'coefficients' (oldest input first) and
+    // return how long it is, which is DECIMATOR_TAPS_PER_OUTPUT times 'factor'.  'coefficients' has to
+    // hold that many.
+    static uint16_t design(uint16_t factor, float * coefficients)
+    {
+        if ((factor <= 1) || (factor > DECIMATOR_MAX_FACTOR))
+        {
+            coefficients[0] = 1.0f;
+            return 1;
+        }
+
+        uint16_t num_taps = DECIMATOR_TAPS_PER_OUTPUT * factor;
+
+        // Cutoff in cycles per input.
+        float cutoff = 0.4f / factor;
+        float middle = (num_taps - 1) * 0.5f;
+
+        for (uint16_t n = 0; n < num_taps; ++n)
+        {
+            float from_middle = n - middle;
+            float sinc = (from_middle == 0.0f) ? 2.0f * cutoff :
+                         sinPi(2.0f * cutoff * from_middle) / (3.14159265f * from_middle);
+            float window = 0.54f - 0.46f * sinPi(2.0f * n / (num_taps - 1) + 0.5f);
+            coefficients[n] = sinc * window;
+        }
+
+        // No gain at DC.
+        float sum = sumOf(coefficients, num_taps);
+        for (uint16_t n = 0; n < num_taps; ++n)
+        {
+            coefficients[n] = coefficients[n] / sum;
+        }
+
+        return num_taps;
+    }
+
+    // Return sin(pi * 'x') from a polynomial rather than the C library so the host gets the same bits.
+    // Good to about 1e-7.
+    static float sinPi(float x)
+    {
+        // sin(pi * x) = -sin(pi * (x - 1)), so bring x to within a half of zero.
+        int32_t whole = (int32_t)((x >= 0.0f) ? (x + 0.5f) : (x - 0.5f));
+        float t = 3.14159265f * (x - whole);
+        float t2 = t * t;
+        float sine = t * (1.0f + t2 * (-1.0f / 6 + t2 * (1.0f / 120 + t2 * (-1.0f / 5040 +
+                     t2 * (1.0f / 362880 + t2 * (-1.0f / 39916800))))));
+        return (whole & 1) ? -sine : sine;
+    }
+
+  private: // methods
+
+    // Start every sum as if all the inputs before 'values' were the same as it.
+    void prime(float const * values)
+    {
+        // The sum that's finished by the first input is missing all but its last input, the next one
+        // all but its last 'factor' + 1, and so on.
+        uint8_t sum = oldest_sum_;
+        for (uint8_t j = 0; j < num_sums_; ++j)
+        {
+            float past = sumOf(coefficients_, num_taps_ - 1 - j * factor_);
+            for (uint8_t i = 0; i < num_channels_; ++i)
+            {
+                sums_[sum][i] = past * values[i];
+            }
+            sum = (sum + 1 >= num_sums_) ? 0 : sum + 1;
+        }
+        primed_ = true;
+    }
+
+  private: // fields
+
+    // Channels in each sample and how many inputs there are for each output.
+    uint8_t num_channels_;
+    uint16_t factor_;
+
+    // Filter, oldest input first.
+    uint16_t num_taps_;
+    float coefficients_[DECIMATOR_MAX_TAPS];
+
+    // Sums of the outputs in progress for each channel, one for each 'factor_' inputs in the filter.
+    // 'oldest_sum_' is finished next.
+    float sums_[DECIMATOR_TAPS_PER_OUTPUT][DECIMATOR_MAX_CHANNELS];
+    uint8_t num_sums_;
+    uint8_t oldest_sum_;
+
+    // Inputs since the last output.
+    uint16_t phase_;
+
+    // False until the first input after reset().
+    bool primed_;
+
+};
+
+#endif
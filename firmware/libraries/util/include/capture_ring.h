@@ -0,0 +1,142 @@
+#ifndef CAPTURE_RING_H_INCLUDED
+#define CAPTURE_RING_H_INCLUDED
+
+// Includes
+#include <atomic>
+#include <cstdint>
+
+// Keeps track of which instances of a glob that's used as a ring buffer hold which samples, e.g. data
+// capture samples in glo_capture_data.  Samples are counted from zero since reset() and sample N is kept in
+// instance (N % size) + 1, so the glob needs one more instance than the ring size since instance 0 isn't used.
+//
+// One task writes samples and another sends them.  When streaming, a sample's instance isn't written over
+// until the sender has released it, so a sample that doesn't fit is dropped and counted as an overrun.
+// Otherwise the oldest samples are written over so the ring always has the last 'size' samples (e.g. the
+// history before a trigger) and nothing is released.
+//
+// The writer can be a preemptive task, so the sender has to disable preemptive tasks while it works out
+// what to send and releases samples, otherwise a reset() in the middle would mix up the two captures.
+class CaptureRing
+{
+  public: // methods
+
+    // Constructor. Empty ring with no room until reset() is called.
+    CaptureRing(void) :
+        size_(0),
+        streaming_(false),
+        finished_(false),
+        num_written_(0),
+        num_queued_(0),
+        num_released_(0),
+        num_overruns_(0),
+        max_backlog_(0)
+    {
+    }
+
+    // Start over with an empty ring of 'size' instances.  If 'streaming' then samples are kept until released.
+    void reset(uint16_t size, bool streaming)
+    {
+        size_ = size;
+        streaming_ = streaming;
+        finished_ = false;
+        num_queued_ = 0;
+        num_overruns_ = 0;
+        max_backlog_ = 0;
+        num_released_.store(0, std::memory_order_relaxed);
+        num_written_.store(0, std::memory_order_release);
+    }
+
+    // Writer - return the instance to write the next sample to, or zero if it has to be dropped because
+    // every instance has a sample that hasn't been released yet (counted as an overrun).
+    uint16_t nextInstance(void)
+    {
+        uint32_t num_written = num_written_.load(std::memory_order_relaxed);
+        if ((size_ == 0) ||
+            (streaming_ && (num_written - num_released_.load(std::memory_order_acquire) >= size_)))
+        {
+            num_overruns_++;
+            return 0;
+        }
+        return instanceOf(num_written);
+    }
+
+    // Writer - the sample was written to the instance returned by nextInstance() so it can be sent.
+    void written(void)
+    {
+        uint32_t num_written = num_written_.load(std::memory_order_relaxed) + 1;
+        num_written_.store(num_written, std::memory_order_release);
+
+        uint32_t backlog = backlogFor(num_written);
+        max_backlog_ = (backlog > max_backlog_) ? backlog : max_backlog_;
+    }
+
+    // Writer - no more samples will be written until the ring is reset.
+    void finish(void) { finished_ = true; }
+
+    // Sender - samples before 'num_queued' have been queued to send.
+    void queued(uint32_t num_queued) { num_queued_ = num_queued; }
+
+    // Sender - everything queued so far has been sent, so the writer can reuse those instances.
+    void releaseQueued(void) { num_released_.store(num_queued_, std::memory_order_release); }
+
+    // Sender - stop holding samples for the sender once everything has been sent.
+    void stopStreaming(void) { streaming_ = false; }
+
+    // Return the instance sample number 'sample' is (or was) kept in.
+    uint16_t instanceOf(uint32_t sample) const { return (uint16_t)(sample % size_ + 1); }
+
+    // Return the oldest sample still in the ring.
+    uint32_t oldest(void) const
+    {
+        uint32_t num_written = numWritten();
+        return streaming_ ? numReleased() : ((num_written > size_) ? (num_written - size_) : 0);
+    }
+
+    // Return how many written samples haven't been released yet.
+    uint32_t backlog(void) const { return backlogFor(numWritten()); }
+
+    // Accessors
+    uint16_t size(void) const { return size_; }
+    bool isStreaming(void) const { return streaming_; }
+    bool isFinished(void) const { return finished_; }
+    uint32_t numWritten(void) const { return num_written_.load(std::memory_order_acquire); }
+    uint32_t numQueued(void) const { return num_queued_; }
+    uint32_t numReleased(void) const { return num_released_.load(std::memory_order_acquire); }
+    uint32_t numOverruns(void) const { return num_overruns_; }
+    uint32_t maxBacklog(void) const { return max_backlog_; }
+
+  private: // methods
+
+    // Return how many samples are waiting to be released if 'num_written' have been written.
+    uint32_t backlogFor(uint32_t num_written) const
+    {
+        return streaming_ ? (num_written - num_released_.load(std::memory_order_acquire)) : 0;
+    }
+
+  private: // fields
+
+    // How many instances the ring uses.
+    uint16_t size_;
+
+    // True if samples are kept until they're released. False if the oldest are written over.
+    volatile bool streaming_;
+
+    // True once the writer is done with this capture.
+    volatile bool finished_;
+
+    // Samples written since the reset.  Only the writer changes it (besides reset()).
+    std::atomic<uint32_t> num_written_;
+
+    // Samples queued to send and released by the sender.  Only the sender changes these.
+    uint32_t num_queued_;
+    std::atomic<uint32_t> num_released_;
+
+    // Samples dropped because the ring was full.
+    volatile uint32_t num_overruns_;
+
+    // Most samples waiting to be released at once.
+    volatile uint32_t max_backlog_;
+
+};
+
+#endif
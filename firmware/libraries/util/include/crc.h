@@ -4,8 +4,35 @@
 // Includes
 #include <cstdint>
 
+// CRC-CCITT (poly 0x1021, not reflected, no final XOR) used to check telemetry frames.
+//
+// The CRC can be found incrementally, e.g. over a frame that wraps around a DMA buffer:
+//
+//   uint16_t crc = crc_init();
+//   crc = crc_update(crc, first_part, first_size);
+//   crc = crc_update(crc, second_part, second_size);
+//   crc = crc_final(crc);
+//
+// crc_update() folds in CRC_SLICE_BYTES bytes per round of table lookups (slicing-by-N).  Define it
+// as 1, 4 or 8 when building to trade table size (512 bytes per slice, in flash) for speed.
+#ifndef CRC_SLICE_BYTES
+#define CRC_SLICE_BYTES 4
+#endif
+
+// Starting value for a frame CRC.
+inline uint16_t crc_init(void) { return 0xFFFF; }
+
+// Return 'crc' updated with the next 'size' bytes of data.
+uint16_t crc_update(uint16_t crc, uint8_t const * data, uint32_t size);
+
+// Return the CRC to send or compare once all data has been added.
+inline uint16_t crc_final(uint16_t crc) { return crc; }
+
 // Return cyclic-redundancy-check (CRC) value of data buffer with specified size.
 // The 'init' parameter is the starting value for the CRC. Uses 0x1021 poly.
-uint16_t calculate_crc(uint8_t * buffer, uint32_t size, uint16_t init);
+inline uint16_t calculate_crc(uint8_t const * buffer, uint32_t size, uint16_t init)
+{
+    return crc_update(init, buffer, size);
+}
 
 #endif
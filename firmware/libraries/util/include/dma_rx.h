@@ -31,6 +31,25 @@ public: // methods
     // 'byte' is a pointer to byte to be returned.
     bool getByte(uint8_t * byte);
 
+    // Return pointer to the next available byte in the buffer and set 'length' to how many bytes
+    // can be read from there without wrapping, so data can be parsed in place instead of a byte at a time.
+    // The bytes stay in the buffer until consume() is called.  When the data wraps around the end of
+    // the buffer the rest is returned by the next call after consuming this one.
+    uint8_t const * peekSpan(uint32_t * length) const;
+
+    // Remove 'length' bytes that were returned by peekSpan() from the buffer.
+    void consume(uint32_t length);
+
+#ifdef HOST_PORT
+    // Host only. Write 'data' into the buffer the same way the DMA hardware would when it's received.
+    void hostReceive(uint8_t const * data, uint32_t length);
+#endif
+
+private: // methods
+
+    // Return index the DMA will write the next received byte to.
+    uint32_t bufferTop(void) const;
+
 private: // fields
 
     uint8_t  * buff_;        // Pointer to dynamically allocated DMA receive buffer.
@@ -2,8 +2,29 @@
 #define DMA_TX_H_INCLUDED
 
 // Includes
+#include <string.h>
 #include "stm32f4xx.h"
 
+// Space in the transfer buffer handed out by DmaTx::reserve().  If it wraps around the end of the
+// buffer then it's split into two parts, otherwise the second part has a length of zero.
+struct dma_tx_region_t
+{
+    uint8_t * part[2];
+    uint16_t  length[2];
+
+    // Return how many bytes are in the region.
+    uint16_t size(void) const { return length[0] + length[1]; }
+
+    // Copy 'len' bytes from 'data' into the region starting 'offset' bytes from the beginning.
+    void write(uint16_t offset, void const * data, uint16_t len);
+
+    // Return the part of the region that starts 'offset' bytes in and is 'len' bytes long.
+    dma_tx_region_t subregion(uint16_t offset, uint16_t len) const;
+
+    // Return the byte 'offset' bytes from the beginning.
+    uint8_t & at(uint16_t offset) { return (offset < length[0]) ? part[0][offset] : part[1][offset - length[0]]; }
+};
+
 // Wraps a buffer that works with direct memory access. Once that user places data into
 // the buffer it will be sent over the configured stream.
 class DmaTx
@@ -31,25 +52,43 @@ public: // methods
     // The buffer is cleared by DMA transfers set up in the tx DMA ISR.
     bool sendBuffer(uint8_t const * data, uint16_t len);
 
+    // Reserve 'len' bytes of the transfer buffer so data can be written straight into it instead of
+    // being copied in by sendBuffer().  Return false if not enough room.  Nothing is sent until
+    // commit() is called.  Only one reservation can be open at a time and sendBuffer() can't be
+    // called in between, so there must only be one task sending.
+    bool reserve(uint16_t len, dma_tx_region_t * region);
+
+    // Same as reserve() but if there isn't room for 'max_len' bytes then reserve whatever is free.
+    // Return how many bytes were reserved (zero if the buffer is full).
+    uint16_t reserveUpTo(uint16_t max_len, dma_tx_region_t * region);
+
+    // Return how many bytes reserveUpTo() could reserve right now.  Only grows until the next
+    // reservation since the DMA keeps emptying the buffer in the background.
+    uint16_t freeSpace(void);
+
+    // Send everything written to the region returned by the last reserve().
+    void commit(void);
+
+    // Send only the first 'num_bytes' of the reserved region and give the rest back.
+    void commit(uint16_t num_bytes);
+
     // Check error and transfer complete bits and if there's more data to be sent then
     // calls activateDMATransfer().  This needs to be called by client whenever they
     // receive a TX ISR.
     void handleISR(void);
 
-private: // methods
+    // Same as handleISR() but with the DMA interrupt disabled so it's safe to call from anywhere.  For when
+    // the interrupt can't run, e.g. sending an assert message from a higher priority interrupt.
+    void poll(void);
 
-    // Attempt to place data into transfer buffer.  If not enough room then return false.
-    bool copyToTransferBuffer
-        (
-            uint8_t  const * data,   // Buffer containing new data.
-            uint16_t         len,    // How many bytes to transfer.
-            uint16_t       * start,  // Start index of next transfer.
-            uint16_t       * end     // Ending index of next transfer.
-        );
+private: // methods
 
     // Start new transfer at specified index of the transfer buffer.
     bool activateDMATransfer(uint16_t start_index);
 
+    // Return how many bytes are waiting to be sent. DMA interrupt must be disabled.
+    uint16_t numBytesQueued(void) const;
+
 private: // fields
 
     uint8_t  * buff_;        // Pointer to dynamically allocated DMA transfer buffer.
@@ -65,6 +104,65 @@ private: // fields
     uint32_t transfer_error_bit_;    // ISR bit (e.g. DMA_IT_TEIFx)
     uint32_t error_count_;           // How many errors have occurred.
 
+    uint16_t reserved_start_;  // Index of the first byte in the open reservation.
+    uint16_t reserved_length_; // How many bytes are in the open reservation.
+
 };
 
+//*****************************************************************************
+inline void dma_tx_region_t::write(uint16_t offset, void const * data, uint16_t len)
+{
+    uint8_t const * bytes = (uint8_t const *)data;
+
+    if (offset < length[0])
+    {
+        uint16_t first_len = length[0] - offset;
+        if (first_len >= len)
+        {
+            memcpy(part[0] + offset, bytes, len);
+            return;
+        }
+        memcpy(part[0] + offset, bytes, first_len);
+        bytes += first_len;
+        len -= first_len;
+        offset = 0;
+    }
+    else
+    {
+        offset -= length[0];
+    }
+
+    memcpy(part[1] + offset, bytes, len);
+}
+
+//*****************************************************************************
+inline dma_tx_region_t dma_tx_region_t::subregion(uint16_t offset, uint16_t len) const
+{
+    dma_tx_region_t sub;
+
+    if (offset >= length[0])
+    {
+        sub.part[0] = part[1] + offset - length[0];
+        sub.length[0] = len;
+        sub.part[1] = NULL;
+        sub.length[1] = 0;
+    }
+    else if (offset + len <= length[0])
+    {
+        sub.part[0] = part[0] + offset;
+        sub.length[0] = len;
+        sub.part[1] = NULL;
+        sub.length[1] = 0;
+    }
+    else
+    {
+        sub.part[0] = part[0] + offset;
+        sub.length[0] = length[0] - offset;
+        sub.part[1] = part[1];
+        sub.length[1] = len - sub.length[0];
+    }
+
+    return sub;
+}
+
 #endif
@@ -0,0 +1,70 @@
+#ifndef FIFO_ARENA_H_INCLUDED
+#define FIFO_ARENA_H_INCLUDED
+
+// Includes
+#include <cstdint>
+
+// Hands out variable sized blocks from one fixed buffer that's used as a ring.  Blocks are carved
+// off the front of the free space and reclaimed from the oldest one, so allocating and freeing are
+// both O(1) when blocks are freed in about the order they were allocated.  A block freed out of order
+// is only marked free and its space gets reclaimed once every older block is freed too.
+// Not interrupt safe, so callers have to disable interrupts if it's shared with an ISR.
+class FifoArena
+{
+  public: // methods
+
+    // Constructor. Dynamically allocates a buffer of 'num_bytes' (rounded down to a multiple of 4).
+    explicit FifoArena(uint32_t num_bytes);
+
+    // Destructor.
+    ~FifoArena(void);
+
+    // Return a 4 byte aligned block that can hold 'num_bytes' or null if there's no room.
+    void * allocate(uint32_t num_bytes);
+
+    // Give back a block returned by allocate().  Does nothing if 'block' is null.
+    void free(void * block);
+
+    // Return how many bytes are tied up in blocks (including block headers and space that's waiting to
+    // be reclaimed).
+    uint32_t numBytesUsed(void) const { return num_used_; }
+
+    // Return how many blocks haven't been freed yet.
+    uint32_t numBlocks(void) const { return num_blocks_; }
+
+    // Return the size of the buffer blocks are allocated from.
+    uint32_t capacity(void) const { return capacity_; }
+
+    // Return how many buffer bytes a block holding 'num_bytes' takes up.
+    static uint32_t blockSize(uint32_t num_bytes) { return (sizeof(block_header_t) + num_bytes + 3) & ~3u; }
+
+  private: // types
+
+    // Stored right before the data of every block.
+    struct block_header_t
+    {
+        uint16_t size;   // Buffer bytes the block takes up, including this header.
+        uint16_t in_use; // False once freed or if it's just padding to the end of the buffer.
+    };
+
+  private: // methods
+
+    // Move the tail past any freed blocks at the oldest end.
+    void reclaim(void);
+
+  private: // fields
+
+    // Backing buffer. Stored as words so blocks are aligned.
+    uint32_t * buffer_;
+    uint32_t capacity_;
+
+    // Byte offsets of where the next block goes and the oldest block still taking up space.
+    uint32_t head_;
+    uint32_t tail_;
+
+    uint32_t num_used_;
+    uint32_t num_blocks_;
+
+};
+
+#endif
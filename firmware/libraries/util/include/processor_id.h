@@ -0,0 +1,13 @@
+#ifndef PROCESSOR_ID_H_INCLUDED
+#define PROCESSOR_ID_H_INCLUDED
+
+// Includes
+#include <cstdint>
+
+// Number of bytes in the unique processor ID.
+#define PROCESSOR_ID_SIZE 12
+
+// Copy the unique processor ID (read from ROM) into 'id'.
+void read_processor_id(uint8_t id[PROCESSOR_ID_SIZE]);
+
+#endif
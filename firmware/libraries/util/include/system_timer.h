@@ -3,36 +3,73 @@
 
 // Includes
 #include <cstdint>
+#include "stm32f4xx.h"
+#ifdef HOST_PORT
+#include "host_port.h"
+#endif
+
+// Data watchpoint and trace (DWT) cycle counter registers. Not defined by the CMSIS core header.
+#define DWT_CTRL_REG   (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT_REG (*(volatile uint32_t *)0xE0001004)
+#define DWT_CTRL_CYCCNTENA (1UL << 0)
 
 // Systick timer with sub-microsecond resolution.
 class SystemTimer
 {
   public: // methods
 
-    // Constructor.  Setup up systick timer.
-    SystemTimer(void);
+    // Constructor.  Setup up systick timer.  If 'interrupt_frequency' is non-zero then the systick
+    // interrupt fires at that rate (Hz), which is what triggers the scheduler's preemptive tier.
+    // Otherwise the timer only interrupts when the 24 bit counter rolls over.
+    SystemTimer(uint32_t interrupt_frequency = 0);
 
-    // Return number of clock ticks since timer was created.
+    // Return number of clock ticks since timer was created.  Disables interrupts so if you don't
+    // need the absolute time then use cycles() or the scheduler's current tick snapshot instead.
     uint64_t ticks(void);
 
+    // Return free running 32 bit cycle count.  Counts at the same rate as ticks() but wraps
+    // every ~25 seconds, so only use it to measure short durations by subtracting two
+    // counts (which is wrap safe). Doesn't disable interrupts.
+#ifdef HOST_PORT
+    uint32_t cycles(void) const { host_read_counts().cycle_reads++; return (uint32_t)virtual_ticks_; }
+#else
+    uint32_t cycles(void) const { return DWT_CYCCNT_REG; }
+#endif
+
     // Return time in seconds since timer was created.
     double seconds(void) { return ticks() * seconds_per_tick_; }
 
+    // Convert a tick stamp (e.g. from ticks()) to seconds.
+    double ticksToSeconds(uint64_t ticks) const { return ticks * seconds_per_tick_; }
+
     // Return rate that timer is running at.
     uint32_t frequency(void) const { return timer_frequency_; }
 
     // Return after the specified number of seconds has elapsed.
     void busyWait(double seconds_to_wait);
 
-  public: // fields
+    // Account for the timer reaching 0 and resetting back. Should only be called from systick interrupt.
+    void rollover(void) { rollover_ticks_ += reload_value_; }
+
+#ifdef HOST_PORT
+    // Host port only. Time doesn't pass on its own, instead the clock jumps forward to 'new_ticks'
+    // or to the next systick interrupt, whichever is first.  Runs the systick interrupt if it's reached.
+    void advance(uint64_t new_ticks);
 
-    // How many times the timer has reached 0 and reset back.
-    // Should only be updated from systick update interrupt.
-    // 64 bit to make calculations of current ticks correct.
-    uint64_t rollover_count_;
+    // Host port only. Move the clock forward while something runs for 'num_ticks', running the systick
+    // interrupt each time it's reached.  Whatever the interrupt runs pushes the end back, like preemption.
+    void busy(uint64_t num_ticks);
+
+    // Host port only. Return the virtual clock without it counting as a read by the firmware.
+    uint64_t virtualTicks(void) const { return virtual_ticks_; }
+#endif
 
   private: // fields
 
+    // Ticks from every time the timer has reached 0 and reset back.  Accumulated
+    // rather than counted so ticks() doesn't need a 64 bit multiply.
+    uint64_t rollover_ticks_;
+
     // Number of clock ticks that timer will reset to after reaching 0.
     uint32_t reload_value_;
 
@@ -45,6 +82,11 @@ class SystemTimer
     // Last value calculated from ticks() method.  Used to detect timer overflow before interrupt has fired.
     uint64_t last_reported_ticks_;
 
+#ifdef HOST_PORT
+    // Current time of the virtual clock.
+    uint64_t virtual_ticks_;
+#endif
+
 };
 
 extern SystemTimer sys_timer;
@@ -24,6 +24,13 @@ enum
     USART2_RX_BUFF_SIZE = 250, // TODO increase these buffer sizes
 };
 
+// Baud rate each bus is set up with.
+enum
+{
+    USART1_BAUD_RATE = 57600,
+    USART2_BAUD_RATE = 115200,
+};
+
 // Universal [A]synchronous Receiver/Transmitter Driver
 // Provide USART implementation using DMA which organizes buses into instances
 // which can be referenced by calling the 'instance()' method.
@@ -48,12 +55,36 @@ public: // methods
     // transfers set up in the tx DMA ISR.
     bool sendBuffer(uint8_t const * data, uint16_t len);
 
+    // Write straight into the send buffer instead of copying. See DmaTx::reserve().
+    bool reserve(uint16_t len, dma_tx_region_t * region) { return dma_tx_->reserve(len, region); }
+    uint16_t reserveUpTo(uint16_t max_len, dma_tx_region_t * region) { return dma_tx_->reserveUpTo(max_len, region); }
+    void commit(void) { dma_tx_->commit(); }
+    void commit(uint16_t num_bytes) { dma_tx_->commit(num_bytes); }
+
+    // Return how many bytes could be reserved right now. See DmaTx::freeSpace().
+    uint16_t freeSpace(void) { return dma_tx_->freeSpace(); }
+
+    // Keep sending without the TX DMA interrupt. See DmaTx::poll().
+    void pollTx(void) { dma_tx_->poll(); }
+
     // Return true if there's nothing left in the receive buffer.
     bool empty(void) const { return dma_rx_->empty(); }
 
+    // Access received bytes in place instead of one at a time. See DmaRx::peekSpan().
+    uint8_t const * peekSpan(uint32_t * length) const { return dma_rx_->peekSpan(length); }
+    void consume(uint32_t length) { dma_rx_->consume(length); }
+
+#ifdef HOST_PORT
+    // Host only. Simulate receiving 'data' over the port.
+    void hostReceive(uint8_t const * data, uint32_t length) { dma_rx_->hostReceive(data, length); }
+#endif
+
     // Update the serial port baud rate (bits / second). This will re-initialize the bus.
     void updateBaudrate(uint32_t baudrate);
 
+    // Return the current baud rate (bits / second).
+    uint32_t baudrate(void) const { return baudrate_; }
+
     // Interrupt service routines which just delegate off to the DMA handlers.
     static void USART1_TX_ISR(void) { Usart::objs[USART_BUS_1].dma_tx_->handleISR(); }
     static void USART2_TX_ISR(void) { Usart::objs[USART_BUS_2].dma_tx_->handleISR(); }
@@ -81,6 +112,9 @@ private: // fields
     usart_bus_t bus_;
     USART_TypeDef * USARTx_;
 
+    // Bits / second the bus is currently set to.
+    uint32_t baudrate_;
+
 }; // Usart
 
 #endif
@@ -0,0 +1,12 @@
+// Includes
+#include <cstring>
+#include "processor_id.h"
+
+// Address of the 96 bit unique device ID register.
+#define PROCESSOR_ID_ADDRESS 0x1FFF7A10
+
+//*****************************************************************************
+void read_processor_id(uint8_t id[PROCESSOR_ID_SIZE])
+{
+    memcpy(id, (void const *)PROCESSOR_ID_ADDRESS, PROCESSOR_ID_SIZE);
+}
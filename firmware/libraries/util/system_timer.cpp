@@ -4,8 +4,8 @@
 #include "scheduler.h"
 
 //*****************************************************************************
-SystemTimer::SystemTimer(void) :
-    rollover_count_(0),
+SystemTimer::SystemTimer(uint32_t interrupt_frequency) :
+    rollover_ticks_(0),
     last_reported_ticks_(0)
 {
     // Request the clock speed of the systick timer so we know many ticks are in each second.
@@ -13,8 +13,12 @@ SystemTimer::SystemTimer(void) :
     RCC_GetClocksFreq(&RCC_Clocks);
     timer_frequency_ = RCC_Clocks.HCLK_Frequency;
 
-    // Systick reload value since it's a 24 bit timer.
+    // Systick reload value. Use the max value since it's a 24 bit timer unless a specific interrupt rate is requested.
     reload_value_ = 0xFFFFFF;
+    if (interrupt_frequency != 0)
+    {
+        reload_value_ = timer_frequency_ / interrupt_frequency;
+    }
 
     // Pre-compute to make calculating current time faster.
     seconds_per_tick_ = 1.0 / timer_frequency_;
@@ -30,31 +34,41 @@ SystemTimer::SystemTimer(void) :
 
     // Set to highest priority so can use time references in interrupt handlers.
     NVIC_SetPriority(SysTick_IRQn, 0x00);
+
+    // Start the cycle counter used for measuring short durations. It's part of the debug
+    // block so trace has to be enabled first.  Runs off the same core clock as systick.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CYCCNT_REG = 0;
+    DWT_CTRL_REG |= DWT_CTRL_CYCCNTENA;
 }
 
 //*****************************************************************************
 extern "C" void SysTick_Handler(void)
 {
-    sys_timer.rollover_count_++;
+    sys_timer.rollover();
+
+    scheduler.triggerPreemptiveTasks();
 }
 
 //******************************************************************************
 uint64_t SystemTimer::ticks(void)
 {
-    // Need to make sure that the reported ticks are always increasing.  If we
-    // detect they didn't increase then the timer rolled over, but the interrupt
-    // we have setup hasn't incremented the rollover count yet... so do it ourselves
-    // by adding 1 to the rollover count.  Need to disable interrupts because the
-    // timer update interrupt could occur between the two calculations of current_ticks
-    // which would essentially make us increase the rollover count one too much.
+    // Need to make sure that the reported ticks are always increasing.  If the timer
+    // rolled over, but the interrupt we have setup hasn't accounted for it yet then
+    // the interrupt will still be pending... so do it ourselves by adding one reload.
+    // With a fast systick interrupt the timer can roll over more than once between calls
+    // so the pending flag is checked rather than just comparing to the last reported ticks.
+    // Need to disable interrupts because the timer update interrupt could occur between
+    // the two calculations of current_ticks which would make us add the reload twice.
     bool interrupts_enabled = scheduler.disableInterrupts();
 
     // Need to subtract current ticks from reload value since systick is a count-down timer.
-    uint64_t current_ticks = (rollover_count_*reload_value_) + (reload_value_ - SysTick->VAL);
+    uint64_t current_ticks = rollover_ticks_ + (reload_value_ - SysTick->VAL);
 
-    if (current_ticks < last_reported_ticks_)
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || (current_ticks < last_reported_ticks_))
     {
-        current_ticks = ((rollover_count_+1)*reload_value_) + (reload_value_ - SysTick->VAL);
+        // Re-read the timer in case it rolled over right after the first read.
+        current_ticks = rollover_ticks_ + reload_value_ + (reload_value_ - SysTick->VAL);
     }
 
     scheduler.restoreInterrupts(interrupts_enabled);
@@ -78,6 +78,8 @@ void Usart::updateBaudrate(uint32_t baudrate)
     USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
     USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx; // TODO: This is causes modes to change for RX only or TX only ports
     USART_Init(USARTx_, &USART_InitStructure);
+
+    baudrate_ = baudrate;
 }
 
 //*****************************************************************************
@@ -108,7 +110,8 @@ void Usart::InitBus1(void)
     assert(usart->dma_rx_ != NULL, ASSERT_STOP);
     assert(usart->dma_tx_ != NULL, ASSERT_STOP);
 
-    USART_InitStructure.USART_BaudRate = 57600;
+    usart->baudrate_ = USART1_BAUD_RATE;
+    USART_InitStructure.USART_BaudRate = USART1_BAUD_RATE;
     USART_InitStructure.USART_WordLength = USART_WordLength_8b;
     USART_InitStructure.USART_StopBits = USART_StopBits_1;
     USART_InitStructure.USART_Parity = USART_Parity_No;
@@ -170,7 +173,8 @@ void Usart::InitBus2(void)
     assert(usart->dma_rx_ != NULL, ASSERT_STOP);
     assert(usart->dma_tx_ != NULL, ASSERT_STOP);
 
-    USART_InitStructure.USART_BaudRate = 115200;
+    usart->baudrate_ = USART2_BAUD_RATE;
+    USART_InitStructure.USART_BaudRate = USART2_BAUD_RATE;
     USART_InitStructure.USART_WordLength = USART_WordLength_8b;
     USART_InitStructure.USART_StopBits = USART_StopBits_1;
     USART_InitStructure.USART_Parity = USART_Parity_No;
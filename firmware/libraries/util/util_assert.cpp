@@ -74,7 +74,8 @@ void util_assert_failed
     buffer[current_index-1] = '\n'; // Replace existing nul character with newline.
     buffer[current_index]   = '\0'; // Re-establish nul character to terminate string.
 
-    glo_assert_message_t assert_message;
+    // Cleared so what's after the text isn't whatever was on the stack.
+    glo_assert_message_t assert_message = {};
     assert_message.action = action;
     memcpy(assert_message.text, buffer, strlen(buffer) + 1); // plus 1 for nul character
 
@@ -85,14 +86,16 @@ void util_assert_failed
     {
         // Since the send task didn't throw an assert we should be able to send back the assert message.
         // Need to go through scheduler so it can update which task is running in case send task throws
-        // an assert when it's being flushed.
-        if (scheduler.runningTaskID() != TASK_ID_TELEM_SEND)
+        // an assert when it's being flushed.  If the assert came from the preemptive tier then it could
+        // have interrupted the send task partway through, so it can't be flushed then either.
+        if ((scheduler.runningTaskID() != TASK_ID_TELEM_SEND) && (scheduler.interruptedTaskID() != TASK_ID_TELEM_SEND))
         {
             scheduler.flushOutgoingMessages();
 
             // Since the receive task didn't throw an assert we should be able to wait for the UI to connect
             // (if it's not already) and request the most recent assert message.
-            if (scheduler.runningTaskID() != TASK_ID_TELEM_RECEIVE)
+            if ((scheduler.runningTaskID() != TASK_ID_TELEM_RECEIVE) &&
+                (scheduler.interruptedTaskID() != TASK_ID_TELEM_RECEIVE))
             {
                 while (true)
                 {
@@ -21,6 +21,9 @@ class PeriodicTask : public Task
     // Decide the tick stamp that the task should run at next. Called right after run().
     virtual void decideWhenToRunNext(void);
 
+    // Return the tick stamp that the task should run at next.
+    virtual uint64_t nextRunTicks(void) const { return next_run_ticks_; }
+
     // Return true if it's time to process a section of code at the specified rate.
     // If trying to use a rate faster than the task itself then will return true
     // every call.  Also be aware of clipping.. if a task is running at 10Hz then
@@ -37,6 +40,13 @@ class PeriodicTask : public Task
     // return false every time.
     bool throttleHz(float frequency);
 
+  protected: // methods
+
+    // Run every time the task is notified of new data (e.g. after subscribing to a glob) rather than
+    // on the timer. The timer then only runs the task if it goes 1.5 periods without being notified,
+    // so the data source should be publishing at the task frequency. Call from the constructor or initialize().
+    void runOnNewData(void) { runs_on_new_data_ = true; }
+
   private: // methods
 
     // Called by scheduler at the desired task frequency.
@@ -57,6 +67,9 @@ class PeriodicTask : public Task
     // The next tick stamp that the task should run at.
     uint64_t next_run_ticks_;
 
+    // True if the task normally runs when notified of new data. See runOnNewData().
+    bool runs_on_new_data_;
+
 };
 
 } // Scheduler namespace
@@ -0,0 +1,116 @@
+#ifndef SCHEDULER_PRIORITY_SET_H_INCLUDED
+#define SCHEDULER_PRIORITY_SET_H_INCLUDED
+
+// Includes
+#include <cstdint>
+
+namespace Scheduler {
+
+// Set of task priorities (0 is the highest) that finds the highest one with two count leading zeros
+// instructions no matter how many priorities there are.  There's one bit per priority spread over
+// words of 32, plus a summary word with a bit for every word that has any bits set.  Holds up to
+// 32 * 32 priorities, although 'NUM_WORDS' only needs to be big enough for the ones that are used.
+// Going through every priority in the set with highestFrom() skips over empty words the same way.
+//
+// Fields are volatile so a set that's added to from interrupts (e.g. the scheduler's ready-set) is
+// always read from memory.  Anything that changes a set interrupts also change has to disable
+// interrupts around it, since a change touches more than one word.
+template <uint8_t NUM_WORDS>
+class PrioritySet
+{
+  public: // methods
+
+    // One past the lowest priority the set can hold.  Returned by highestFrom() when there's nothing left.
+    static const uint16_t END = NUM_WORDS * 32;
+
+    // Constructor. Starts empty.
+    PrioritySet(void) :
+        summary_(0)
+    {
+        for (uint8_t i = 0; i < NUM_WORDS; ++i)
+        {
+            words_[i] = 0;
+        }
+    }
+
+    // Return true if no priorities are in the set.
+    bool empty(void) const { return summary_ == 0; }
+
+    // Return true if 'priority' is in the set.
+    bool contains(uint8_t priority) const { return (words_[priority / 32] & bit(priority % 32)) != 0; }
+
+    // Add 'priority' to the set.
+    void add(uint8_t priority)
+    {
+        words_[priority / 32] |= bit(priority % 32);
+        summary_ |= bit(priority / 32);
+    }
+
+    // Remove 'priority' from the set.
+    void remove(uint8_t priority)
+    {
+        uint8_t word = priority / 32;
+        words_[word] &= ~bit(priority % 32);
+        if (words_[word] == 0)
+        {
+            summary_ &= ~bit(word);
+        }
+    }
+
+    // Return the highest priority (lowest number) in the set, which must not be empty.
+    uint8_t highest(void) const
+    {
+        uint8_t word = highestBit(summary_);
+        return (uint8_t)(word * 32 + highestBit(words_[word]));
+    }
+
+    // Return the highest priority in the set that's 'first' or lower (a number at least as big), or END if
+    // there isn't one.  For example:
+    //   for (uint16_t p = set.highestFrom(0); p != set.END; p = set.highestFrom(p + 1))
+    uint16_t highestFrom(uint16_t first) const
+    {
+        uint8_t word = first / 32;
+        if (word >= NUM_WORDS)
+        {
+            return END;
+        }
+
+        // Leave out the bits before 'first' in its word.
+        uint32_t bits = words_[word] & (0xFFFFFFFFUL >> (first % 32));
+        if (bits == 0)
+        {
+            // Skip to the next word that isn't empty.
+            uint32_t later_words = (word < 31) ? (summary_ & (0xFFFFFFFFUL >> (word + 1))) : 0;
+            if (later_words == 0)
+            {
+                return END;
+            }
+            word = highestBit(later_words);
+            bits = words_[word];
+        }
+
+        return (uint16_t)(word * 32 + highestBit(bits));
+    }
+
+  private: // methods
+
+    // Return the bit for 'index' in a word.  Index 0 is the most significant bit so counting leading
+    // zeros gives the lowest index that's set.
+    static uint32_t bit(uint8_t index) { return 0x80000000UL >> index; }
+
+    // Return the lowest index set in the (non-zero) word. Compiles to a single count leading zeros instruction.
+    static uint8_t highestBit(uint32_t word) { return (uint8_t)__builtin_clz(word); }
+
+  private: // fields
+
+    // Bit set for every word in 'words_' that isn't zero.
+    volatile uint32_t summary_;
+
+    // Bit set for every priority in the set. See bit().
+    volatile uint32_t words_[NUM_WORDS];
+
+};
+
+} // Scheduler namespace
+
+#endif
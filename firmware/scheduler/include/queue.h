@@ -14,7 +14,10 @@ class Queue
 
     // Constructor. Dynamically allocates buffer with the specified size.
     Queue(uint32_t size) :
-          size_(size)
+          size_(size),
+          front_(0),
+          back_(0),
+          num_elements_(0)
     {
         data_ = new T[size_];
     }
@@ -43,9 +46,16 @@ class Queue
     // Removes front element from queue. Useful if you've already peaked at it.
     bool remove(void);
 
+    // Overwrite the front element with 'data' so it keeps its place.  Unlike remove() followed by
+    // enqueue_front() nothing can be enqueued in between.  Return false if the queue is empty.
+    bool replace_front(T & data);
+
     // Return number of elements currently stored in the queue.
     uint32_t count(void) const { return num_elements_; }
 
+    // Every access disables interrupts, so it's safe to use from anywhere. See SpscQueue::LOCK_FREE.
+    static const bool LOCK_FREE = false;
+
   private: // fields
 
       T * data_;      // buffer backing queue.
@@ -173,6 +183,25 @@ bool Queue<T>::remove(void)
     return true; // front element removed
 }
 
+//*****************************************************************************
+template <class T>
+bool Queue<T>::replace_front(T & data)
+{
+    bool interruptsEnabled = scheduler.disableInterrupts();
+
+    if (num_elements_ == 0)
+    {
+        scheduler.restoreInterrupts(interruptsEnabled);
+        return false;
+    }
+
+    data_[front_] = data; // copy new data over front element.
+
+    scheduler.restoreInterrupts(interruptsEnabled);
+
+    return true; // front element replaced
+}
+
 } // Scheduler namespace
 
 #endif
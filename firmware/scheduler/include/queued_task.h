@@ -3,14 +3,18 @@
 
 // Includes
 #include "queue.h"
+#include "spsc_queue.h"
 #include "task.h"
 
 namespace Scheduler {
 
 // Specialized task that has a built in queue used to pass data to the task.
 // The task will be set pending whenever it has one or more items in its queue.
-// The templated type is the type of data to store in the queue.
-template<class T>
+// The templated type is the type of data to store in the queue.  The queue type defaults to
+// the interrupt safe Queue, but if only one task (or interrupt) ever sends data to the task then
+// SpscQueue<T> can be used instead so neither side ever disables interrupts (size must be a power of two).
+// The scheduler then checks the queue each loop (READY_SOURCE_POLLED) instead of being told about every item.
+template<class T, class QueueType = Queue<T> >
 class QueuedTask : public Task
 {
   public: // methods
@@ -19,9 +23,12 @@ class QueuedTask : public Task
     QueuedTask(char const * task_name, task_id_t task_id, uint32_t queue_size) :
         Task(task_name, task_id),
         queue_(queue_size)
-    { }
+    {
+        // Task is marked ready as soon as something is queued, unless that would disable interrupts.
+        ready_source_ = QueueType::LOCK_FREE ? READY_SOURCE_POLLED : READY_SOURCE_EVENT;
+    }
 
-    // Copy 'data' into queue and sets task pending. Return true if successful.
+    // Copy 'data' into queue and sets task pending (or leaves it to be polled). Return true if successful.
     bool enqueue(T & data);
 
     // Return true if there's anything in the task queue.
@@ -35,21 +42,26 @@ class QueuedTask : public Task
   protected: // fields
 
     // Putting items in this queue will cause the task to be scheduled to run.
-    Queue<T> queue_;
+    QueueType queue_;
 
 };
 
 //*****************************************************************************
-template<class T>
-bool QueuedTask<T>::enqueue(T & data)
+template<class T, class QueueType>
+bool QueuedTask<T, QueueType>::enqueue(T & data)
 {
     bool success = queue_.enqueue(data);
+    if (success && !QueueType::LOCK_FREE)
+    {
+        // Let the scheduler know right away instead of waiting for it to check the queue.
+        scheduler.setTaskReady(*this);
+    }
     return success;
 }
 
 //*****************************************************************************
-template<class T>
-bool QueuedTask<T>::needToRun(void)
+template<class T, class QueueType>
+bool QueuedTask<T, QueueType>::needToRun(void)
 {
     return (queue_.count() > 0) || !currentStepIsDefault();
 }
@@ -3,33 +3,88 @@
 
 // Includes
 #include <cstddef>
+#include "priority_set.h"
 #include "task.h"
 #include "system_timer.h"
+#ifdef HOST_PORT
+#include "host_port.h"
+#endif
 
 namespace Scheduler {
 
-// Arbitrary limit.  Can be increased as necessary.
-const uint8_t MAX_NUMBER_OF_TASKS = 16;
+// Arbitrary limit.  Can be increased as necessary, it just costs a pointer per task
+// and another ready-set word for every 32.
+const uint8_t MAX_NUMBER_OF_TASKS = 64;
+
+// Arbitrary limit on how many tasks can be registered to the preemptive tier.
+const uint8_t MAX_NUMBER_OF_PREEMPTIVE_TASKS = 4;
+
+// NVIC priority that preemptive tasks run at (lower is higher priority). Needs to be a lower
+// priority than systick (0) since that's what triggers the preemptive tier, but higher than
+// the peripheral interrupts (e.g. USART DMA at 3) so they don't delay the preemptive tasks.
+const uint8_t PREEMPTIVE_TASK_IRQ_PRIORITY = 2;
+
+// Set to true to record the longest time interrupts were disabled (see maxInterruptsDisabledCycles()).
+// Adds a cycle counter read to every disable/restore so leave off unless measuring.
+const bool MEASURE_INTERRUPTS_DISABLED = false;
+
+// How the scheduler decides which task to run next.
+typedef uint8_t scheduling_mode_t;
+enum
+{
+    // Every loop ask every task if it needs to run and execute the first one that does.
+    // Overhead grows with the number of registered tasks.
+    SCHEDULING_MODE_SCAN,
+
+    // Tasks are marked in a ready-set (one bit per priority) when their tick stamp is reached
+    // or data is queued for them.  The highest priority ready task is found with two count
+    // leading zeros instructions so overhead doesn't depend on the number of registered tasks.
+    SCHEDULING_MODE_READY_SET,
+};
 
 // Simple non-preemptive scheduler that supports task priorities.
 // Each task is run-to-completion (RTC) and has logic built into to determine when it needs to run.
 // There needs to be exactly one instance of this class defined by the user.
+//
+// Optionally periodic tasks can be registered to a preemptive tier instead. These are run from
+// the PendSV interrupt (triggered by systick) so they can interrupt any of the normal tasks,
+// which keeps their timing jitter to interrupt latency rather than however long the longest
+// normal task takes.  Since they can interrupt other tasks, anything they share with other tasks
+// must be accessed atomically (e.g. globs or queues) or with preemptive tasks disabled.
 class Scheduler
 {
   public: // methods
 
     // Constructor
-    Scheduler(void);
+    Scheduler(scheduling_mode_t mode = SCHEDULING_MODE_SCAN);
 
     // Register task so that it's known to Scheduler.  The order that tasks are registered defines their
     // priorities.  Earlier registration = higher priority. Must be called for every task regardless of
     // how it's scheduled.  Return false if there was an error.
     bool registerTask(Task & task);
 
+    // Register periodic task to run from the preemptive tier instead of in scheduleTasks().  The order
+    // tasks are registered defines their priority relative to other preemptive tasks. The task frequency
+    // must divide evenly into the systick interrupt frequency. Return false if there was an error.
+    bool registerPreemptiveTask(Task & task);
+
     // Continuously loops through tasks and determines which ones need to run.
-    // This method will never return.
+    // This method will never return unless stop() is called.
     void scheduleTasks(void);
 
+    // Make scheduleTasks() return once the current loop finishes. Only useful when
+    // running on a host (e.g. to end a simulation) since the robot never stops scheduling.
+    void stop(void) { stop_requested_ = true; }
+
+    // Mark task as ready so it will be executed once it's the highest priority ready task.
+    // Only has an effect when using a ready-set and the task is registered.  Interrupt safe.
+    void setTaskReady(Task & task);
+
+    // Let task know there's new data for it (e.g. a glob it subscribed to was published) so it runs
+    // as soon as possible regardless of how it's normally scheduled. For a preemptive task that means
+    // as soon as the preemptive tier isn't masked.  Interrupt safe.
+    void notifyTask(Task & task);
+
     // Disable all interrupts and return the state of the interrupts before
     // interrupts were disabled.  Return true if interrupts were previously enabled.
     bool disableInterrupts(void) const;
@@ -39,6 +94,26 @@ class Scheduler
     // be restored regardless of the original state.. then 'enabled' should be true.
     void restoreInterrupts(bool enabled) const;
 
+    // Return the longest time (in cycles) that interrupts were disabled by disableInterrupts() since
+    // the last reset. Always zero unless MEASURE_INTERRUPTS_DISABLED is true.
+    uint32_t maxInterruptsDisabledCycles(void) const;
+    void resetInterruptsDisabledCycles(void);
+
+    // Keep preemptive tasks (and any lower priority interrupts) from running, but still allow
+    // higher priority interrupts like systick.  Use when changing data that a preemptive task uses.
+    // Return the previous state that should be passed to restorePreemptiveTasks().
+    uint32_t disablePreemptiveTasks(void) const;
+
+    // Undo disablePreemptiveTasks(). The 'previous_state' should be what was returned by that call.
+    void restorePreemptiveTasks(uint32_t previous_state) const;
+
+    // Should only be called from systick interrupt.  Requests the preemptive tier to run
+    // once systick returns if there are any preemptive tasks and they're done initializing.
+    void triggerPreemptiveTasks(void);
+
+    // Should only be called from PendSV interrupt. Run every preemptive task that's due.
+    void runPreemptiveTasks(void);
+
     // Return true if tasks should be recording information to use in analyzing scheduling.
     bool currentlyTimingTasks(void) const { return timing_tasks_; }
 
@@ -54,20 +129,110 @@ class Scheduler
     // Return the ID of the currently running task or TASK_ID_INVALID if no task is running.
     task_id_t runningTaskID(void) const { return running_task_id_; }
 
+    // Return the ID of the task that the preemptive tier interrupted, or TASK_ID_INVALID if none was running
+    // or the preemptive tier isn't running.
+    task_id_t interruptedTaskID(void) const { return in_preemptive_tier_ ? interrupted_task_id_ : TASK_ID_INVALID; }
+
+    // Return tick count sampled once at the start of the current scheduler loop. Tasks should use
+    // this instead of sys_timer.ticks() unless they really need the exact current time.
+    // When called from the preemptive tier this is sampled at the start of the interrupt instead.
+    uint64_t currentTicks(void) const
+    {
+#ifdef HOST_PORT
+        host_read_counts().snapshot_reads++;
+#endif
+        return in_preemptive_tier_ ? preemptive_ticks_ : current_ticks_;
+    }
+
+    // Return number of registered tasks (not including preemptive ones) and the task at 'index'.
+    uint8_t numTasks(void) const { return num_tasks_; }
+    Task * task(uint8_t index) const { return tasks_[index]; }
+
+    // Return number of tasks registered to the preemptive tier and the task at 'index'.
+    uint8_t numPreemptiveTasks(void) const { return num_preemptive_tasks_; }
+    Task * preemptiveTask(uint8_t index) const { return preemptive_tasks_[index]; }
+
+  private: // methods - hardware specific, see scheduler_port.cpp
+
+    // Setup interrupt priorities used by the scheduler.  Called from constructor.
+    void configureInterrupts(void);
+
+    // Request the preemptive tier to run as soon as any higher priority interrupts return.
+    void pendPreemptiveTasks(void);
+
+    // Called when there aren't any tasks ready to run. The next timer task will be ready at 'wake_ticks'
+    // but polled tasks or interrupts could make a task ready before then.
+    void idle(uint64_t wake_ticks);
+
+  private: // methods
+
+    // Loop through all tasks and execute the first one that needs to run.
+    void runScanPass(void);
+
+    // Mark any timer tasks that are due as ready and then execute the highest priority ready task.
+    void runReadySetPass(void);
+
+    // Mark every timer task whose tick stamp has been reached as ready and find the next tick
+    // stamp that a timer task needs to run at.
+    void readyTimerTasks(void);
+
+    // Remove task from the ready-set.  Interrupt safe.
+    void clearTaskReady(Task & task);
+
+    // Return the earliest tick stamp that any registered timer task needs to run at.
+    uint64_t nextTimerTaskTicks(void) const;
+
+    // Ask polled tasks that would run ahead of every ready task whether they need to run.
+    void readyPolledTasks(void);
+
   private: // fields
 
+    // How to decide which task to run next.
+    scheduling_mode_t mode_;
+
     // Number of successfully registered tasks.
     uint8_t num_tasks_;
 
     // Task array that gets sequentially filled as tasks are registered.
     Task * tasks_[MAX_NUMBER_OF_TASKS];
 
+    // Number of tasks registered to the preemptive tier and the tasks themselves.
+    uint8_t num_preemptive_tasks_;
+    Task * preemptive_tasks_[MAX_NUMBER_OF_PREEMPTIVE_TASKS];
+
+    // Set to true once preemptive tasks are initialized and allowed to run.
+    volatile bool preemptive_tier_started_;
+
+    // True while running preemptive tasks and the system ticks sampled when the tier started running.
+    bool in_preemptive_tier_;
+    uint64_t preemptive_ticks_;
+
+    // Priority of every task that's ready to run. Added to from interrupts.
+    typedef PrioritySet<(MAX_NUMBER_OF_TASKS + 31) / 32> TaskSet;
+    TaskSet ready_set_;
+
+    // Priority of every task that's READY_SOURCE_TIMER or READY_SOURCE_POLLED.
+    TaskSet timer_tasks_;
+    TaskSet polled_tasks_;
+
+    // System ticks sampled at the start of the current scheduler loop.
+    uint64_t current_ticks_;
+
+    // Earliest tick stamp that a timer task (that isn't already ready) needs to run at.
+    uint64_t next_timer_ticks_;
+
+    // Set to true when scheduleTasks() should return.
+    volatile bool stop_requested_;
+
     // Set to true when recording information about how well tasks are running.
     bool timing_tasks_;
 
     // The task that's currently being executed or TASK_ID_INVALID if one's not running.
     task_id_t running_task_id_;
 
+    // The task that was running when the preemptive tier started.  Restored when the tier is done.
+    task_id_t interrupted_task_id_;
+
 };
 
 } // Scheduler namespace
@@ -0,0 +1,193 @@
+#ifndef SCHEDULER_SPSC_QUEUE_H_INCLUDED
+#define SCHEDULER_SPSC_QUEUE_H_INCLUDED
+
+// Includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "util_assert.h"
+
+namespace Scheduler {
+
+// Lock-free alternative to Queue for when there's exactly one producer (the only code that ever enqueues)
+// and one consumer (the only code that ever dequeues/removes), for example an interrupt handing data to a task.
+// The producer only writes the back count and the consumer only writes the front count so neither side
+// ever has to disable interrupts.  Capacity must be a power of two so indices can wrap with a mask.
+template <class T>
+class SpscQueue
+{
+  public: // methods
+
+    // Constructor. Dynamically allocates buffer with the specified size, which must be a power of two.
+    SpscQueue(uint32_t size) :
+          size_(size),
+          mask_(size - 1),
+          front_(0),
+          back_(0)
+    {
+        assert_msg((size_ != 0) && ((size_ & mask_) == 0), ASSERT_STOP, "SPSC queue size must be a power of two.");
+        data_ = new T[size_];
+    }
+
+    // Destructor.
+    ~SpscQueue(void)
+    {
+        delete[] data_;
+    }
+
+    // Producer only. Copy 'data' into the queue. Return false if there's not enough room in the buffer.
+    bool enqueue(T const & data);
+
+    // Producer only. Copy up to 'num' elements into the queue.  Return how many were actually added.
+    uint32_t enqueue_n(T const * data, uint32_t num);
+
+    // Consumer only. Remove front item from queue and copies it to 'data' output parameter.
+    // Return true if copy was successful.
+    bool dequeue(T * data);
+
+    // Consumer only. Remove up to 'num' elements from the front of the queue and copy them into 'data'.
+    // Return how many were actually removed.
+    uint32_t dequeue_n(T * data, uint32_t num);
+
+    // Consumer only. Copies front item from queue into 'data' output parameter but doesn't remove it.
+    // Return true if copy was successful.
+    bool peak(T * data);
+
+    // Consumer only. Return pointer to the front element so it can be used in place, or NULL if the
+    // queue is empty.  Stays valid until remove() is called.
+    T * front(void);
+
+    // Consumer only. Removes front element from queue. Useful if you've already peaked at it.
+    bool remove(void);
+
+    // Return number of elements currently stored in the queue.  If called from the producer (or consumer)
+    // then the true count can only be lower (or higher) by the time this returns.
+    uint32_t count(void) const
+    {
+        return back_.load(std::memory_order_acquire) - front_.load(std::memory_order_acquire);
+    }
+
+    // Nothing ever disables interrupts.  A QueuedTask using this queue is polled instead of the producer
+    // telling the scheduler, since that would disable interrupts (see Scheduler::setTaskReady()).
+    static const bool LOCK_FREE = true;
+
+  private: // fields
+
+      T * data_;      // buffer backing queue.
+      uint32_t size_; // size of data buffer.
+      uint32_t mask_; // size - 1 for wrapping indices.
+
+      // Free running counts that only ever increase (and wrap at 2^32). Mask to get the buffer index.
+      std::atomic<uint32_t> front_; // number of elements dequeued. Only written by consumer.
+      std::atomic<uint32_t> back_;  // number of elements enqueued. Only written by producer.
+
+};
+
+//*****************************************************************************
+template <class T>
+bool SpscQueue<T>::enqueue(T const & data)
+{
+    return enqueue_n(&data, 1) == 1;
+}
+
+//*****************************************************************************
+template <class T>
+uint32_t SpscQueue<T>::enqueue_n(T const * data, uint32_t num)
+{
+    // Only this side writes back_ so it can be read relaxed. Need front_ to be acquired so
+    // the consumer is done with the slots before they're overwritten.
+    uint32_t back = back_.load(std::memory_order_relaxed);
+    uint32_t room = size_ - (back - front_.load(std::memory_order_acquire));
+
+    if (num > room)
+    {
+        num = room;
+    }
+
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        data_[(back + i) & mask_] = data[i];
+    }
+
+    // Release so the copied data is visible before the consumer sees the new back.
+    back_.store(back + num, std::memory_order_release);
+
+    return num;
+}
+
+//*****************************************************************************
+template <class T>
+bool SpscQueue<T>::dequeue(T * data)
+{
+    return dequeue_n(data, 1) == 1;
+}
+
+//*****************************************************************************
+template <class T>
+uint32_t SpscQueue<T>::dequeue_n(T * data, uint32_t num)
+{
+    uint32_t front = front_.load(std::memory_order_relaxed);
+    uint32_t available = back_.load(std::memory_order_acquire) - front;
+
+    if (num > available)
+    {
+        num = available;
+    }
+
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        data[i] = data_[(front + i) & mask_];
+    }
+
+    // Release so the producer can't overwrite the slots until they've been copied out.
+    front_.store(front + num, std::memory_order_release);
+
+    return num;
+}
+
+//*****************************************************************************
+template <class T>
+bool SpscQueue<T>::peak(T * data)
+{
+    T * front_element = front();
+    if (front_element == NULL)
+    {
+        return false;
+    }
+
+    *data = *front_element; // copy data out of queue.
+
+    return true;
+}
+
+//*****************************************************************************
+template <class T>
+T * SpscQueue<T>::front(void)
+{
+    uint32_t front = front_.load(std::memory_order_relaxed);
+    if (back_.load(std::memory_order_acquire) == front)
+    {
+        return NULL;
+    }
+
+    return &data_[front & mask_];
+}
+
+//*****************************************************************************
+template <class T>
+bool SpscQueue<T>::remove(void)
+{
+    uint32_t front = front_.load(std::memory_order_relaxed);
+    if (back_.load(std::memory_order_acquire) == front)
+    {
+        return false;
+    }
+
+    front_.store(front + 1, std::memory_order_release);
+
+    return true; // front element removed
+}
+
+} // Scheduler namespace
+
+#endif
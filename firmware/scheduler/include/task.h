@@ -8,6 +8,18 @@
 
 namespace Scheduler {
 
+// How a task lets the Scheduler know it's ready to run when the Scheduler is using a ready-set.
+typedef uint8_t ready_source_t;
+enum
+{
+    READY_SOURCE_POLLED, // Scheduler calls needToRun() every loop. Default for generic tasks.
+    READY_SOURCE_TIMER,  // Scheduler marks task ready once the tick stamp returned by nextRunTicks() is reached.
+    READY_SOURCE_EVENT,  // Task marks itself ready by calling Scheduler::setTaskReady() (e.g. when data is queued).
+};
+
+// Priority of a task that hasn't been registered with the Scheduler yet.
+const uint8_t INVALID_TASK_PRIORITY = 0xFF;
+
 // Provide base functionality for a run-to-completion (RTC) task.  Meaning each time the
 // task is executed, it must run all the way through.  The task is designed to be non-preemptive
 // which means it can't interrupt a lower priority task whenever it wants.  So the idea is to minimize
@@ -42,6 +54,12 @@ class Task
     // Return unique task ID.
     task_id_t task_id(void) const { return id_; }
 
+    // Return how many times the task has been executed.
+    uint32_t numTimesRan(void) const { return num_times_ran_; }
+
+    // Return true if the task has been notified of new data (see Scheduler::notifyTask()) since it last started running.
+    bool newDataPending(void) const { return new_data_pending_; }
+
   protected: // methods - for Scheduler friend class.
 
     // Should be called by Scheduler before any other methods are called.
@@ -56,6 +74,7 @@ class Task
     // Should only be called from the Scheduler.
     // Provide a non virtual interface (NVI) that will call the needToRun() method
     // and also update some of the generic task properties (e.g. when the task first wanted to run)
+    // A task that's been notified of new data is always ready to run.
     virtual bool readyToRun(void);
 
     // Start/stop recording information about how well task is running.
@@ -77,6 +96,9 @@ class Task
     // Called from readyToRun()
     virtual bool needToRun(void) = 0;
 
+    // Only used by tasks that are READY_SOURCE_TIMER.  Return the tick stamp the task next wants to run at.
+    virtual uint64_t nextRunTicks(void) const { return 0; }
+
     // Subclass can override if it needs a chance to decide when to run next.
     // This should also calculate how late the task was in running.  The default
     // is to base it on the first time the task reported ready to run... but for
@@ -110,9 +132,22 @@ class Task
     const char * name_;
     task_id_t    id_;
 
+    // How the task tells the scheduler it needs to run. Only used when scheduling with a ready-set.
+    ready_source_t ready_source_;
+
+    // Assigned by Scheduler when task is registered.  Lower number = higher priority.
+    uint8_t priority_;
+
     // Set to true once the task's initialize() method has been called.
     bool initialized_;
 
+    // Set to true if task is registered to the scheduler's preemptive tier.
+    bool preemptive_;
+
+    // Set when a glob the task subscribed to is published.  Cleared right before the task runs
+    // so anything published while it's running will make it run again.
+    volatile bool new_data_pending_;
+
     // How many times task has ran. Incremented right before task is ran so the first run will be 1.
     uint32_t num_times_ran_;
 
@@ -130,15 +165,18 @@ class Task
     // Tick count when task last wanted to run.
     uint64_t scheduled_tick_stamp_;
 
-    // Tick count right before task was last ran.
+    // Tick count at the start of the scheduler loop that last ran the task.
     uint64_t started_tick_stamp_;
 
     // Tick count right before task was last ran when it was at it's first (default) step.
     // If a task isn't split into smaller steps then this should be the same as started_tick_stamp_
     uint64_t started_first_step_tick_stamp_;
 
-    // Tick count when task last finished.
-    uint64_t finished_tick_stamp_;
+    // Cycle count (see SystemTimer::cycles()) right before task was last ran.
+    uint32_t started_cycles_;
+
+    // How many ticks the task took the last time it ran.
+    uint32_t run_ticks_;
 
     // Tick count right before task was ran the previous time (only updated if the task is running it's first step).
     uint64_t previous_first_step_started_tick_stamp_;
@@ -13,6 +13,7 @@ enum
     TASK_ID_STATUS_UPDATE,
     TASK_ID_TELEM_RECEIVE,
     TASK_ID_TELEM_SEND,
+    TASK_ID_TELEM_STREAM,
 
     NUM_TASKS,
 
@@ -1,6 +1,7 @@
 // Includes
 #include <cmath>
 #include "periodic_task.h"
+#include "scheduler.h"
 #include "system_timer.h"
 #include "util_assert.h"
 
@@ -11,8 +12,12 @@ PeriodicTask::PeriodicTask(char const * task_name, task_id_t task_id, float freq
     Task(task_name, task_id),
     frequency_(frequency),
     delay_ticks_(1),
-    next_run_ticks_(0)
+    next_run_ticks_(0),
+    runs_on_new_data_(false)
 {
+    // Scheduler can figure out when task needs to run just from next_run_ticks_.
+    ready_source_ = READY_SOURCE_TIMER;
+
     assert_msg(frequency_ > 0, ASSERT_STOP, "Invalid frequency for periodic task.");
     assert_msg(frequency_ <= sys_timer.frequency(), ASSERT_STOP, "Periodic task can't run faster than main timer.");
 
@@ -31,7 +36,7 @@ PeriodicTask::PeriodicTask(char const * task_name, task_id_t task_id, float freq
 //*****************************************************************************
 bool PeriodicTask::needToRun(void)
 {
-    bool enough_ticks_elapsed = sys_timer.ticks() >= next_run_ticks_;
+    bool enough_ticks_elapsed = scheduler.currentTicks() >= next_run_ticks_;
     return enough_ticks_elapsed || !currentStepIsDefault();
 }
 
@@ -45,6 +50,15 @@ void PeriodicTask::decideWhenToRunNext(void)
         return;
     }
 
+    if (runs_on_new_data_)
+    {
+        // Delay is from when the task was notified (or timed out). The timer is just a timeout
+        // in case the data stops so it's relative to this run rather than lined up to the period.
+        Task::decideWhenToRunNext();
+        next_run_ticks_ = started_first_step_tick_stamp_ + delay_ticks_ + delay_ticks_ / 2;
+        return;
+    }
+
     // Need to make sure task has ran once or else next_run_ticks_ won't be valid.
     if (num_times_ran_ > 1)
     {
@@ -1,7 +1,6 @@
 // Includes
 #include <cstdio>
 #include <cstring>
-#include "stm32f4xx.h"
 #include "scheduler.h"
 #include "math_util.h"
 #include "debug_printf.h"
@@ -12,18 +11,31 @@
 namespace Scheduler {
 
 //*****************************************************************************
-Scheduler::Scheduler(void) :
+Scheduler::Scheduler(scheduling_mode_t mode) :
+    mode_(mode),
     num_tasks_(0),
+    num_preemptive_tasks_(0),
+    preemptive_tier_started_(false),
+    in_preemptive_tier_(false),
+    preemptive_ticks_(0),
+    current_ticks_(0),
+    next_timer_ticks_(0),
+    stop_requested_(false),
     timing_tasks_(false),
-    running_task_id_(TASK_ID_INVALID)
+    running_task_id_(TASK_ID_INVALID),
+    interrupted_task_id_(TASK_ID_INVALID)
 {
     for (uint8_t i = 0; i < MAX_NUMBER_OF_TASKS; i++)
     {
         tasks_[i] = NULL;
     }
 
-    // Disable sub-priorities in NVIC (16 main priority levels)
-    SCB->AIRCR = 0x05FA0300;
+    for (uint8_t i = 0; i < MAX_NUMBER_OF_PREEMPTIVE_TASKS; i++)
+    {
+        preemptive_tasks_[i] = NULL;
+    }
+
+    configureInterrupts();
 }
 
 //*****************************************************************************
@@ -36,15 +48,56 @@ bool Scheduler::registerTask(Task & task)
 
     tasks_[num_tasks_] = &task;
 
+    // Tasks are registered in order of priority so the task index is also its priority.
+    task.priority_ = num_tasks_;
+
+    if (task.ready_source_ == READY_SOURCE_TIMER)
+    {
+        timer_tasks_.add(task.priority_);
+    }
+    else if (task.ready_source_ == READY_SOURCE_POLLED)
+    {
+        polled_tasks_.add(task.priority_);
+    }
+
     num_tasks_++;
 
     return true; // task registered successfully
 }
 
+//*****************************************************************************
+bool Scheduler::registerPreemptiveTask(Task & task)
+{
+    if (num_preemptive_tasks_ >= MAX_NUMBER_OF_PREEMPTIVE_TASKS)
+    {
+        return false; // no more room for task.
+    }
+
+    if (task.ready_source_ != READY_SOURCE_TIMER)
+    {
+        return false; // only periodic tasks know when to run from an interrupt.
+    }
+
+    preemptive_tasks_[num_preemptive_tasks_] = &task;
+    task.preemptive_ = true;
+
+    num_preemptive_tasks_++;
+
+    return true; // task registered successfully
+}
+
 //*****************************************************************************
 void Scheduler::scheduleTasks(void)
 {
-    // First go through and initialize all the tasks.
+    // First go through and initialize all the tasks. Preemptive tasks are the highest priority so do them first.
+    for (uint8_t i = 0; i < num_preemptive_tasks_; i++)
+    {
+        Task * task = preemptive_tasks_[i];
+        running_task_id_ = task->task_id();
+        task->tryInitialize();
+        running_task_id_ = TASK_ID_INVALID; // because task is done initializing.
+    }
+
     for (uint8_t i = 0; i < num_tasks_; i++)
     {
         Task * task = tasks_[i];
@@ -53,47 +106,254 @@ void Scheduler::scheduleTasks(void)
         running_task_id_ = TASK_ID_INVALID; // because task is done initializing.
     }
 
-    while (true)
+    // Everything is initialized so preemptive tasks can start running on the next systick interrupt.
+    preemptive_tier_started_ = true;
+
+    if (mode_ == SCHEDULING_MODE_READY_SET)
     {
-        bool task_exectuted_this_loop = false;
+        // Data could have been queued before the scheduler started (e.g. debug messages sent
+        // from main) so make sure those tasks don't get missed.  Timer tasks will be marked
+        // ready on the first loop since next_timer_ticks_ starts at 0.
         for (uint8_t i = 0; i < num_tasks_; i++)
         {
             Task * task = tasks_[i];
-
-            // Every time we loop through all the tasks we only execute the first
-            // one that wants to run. This is what allows certain tasks to be more important
-            // than others.  Regardless of whether we have any intent of executing a task we
-            // always need to check if it needs to run so it can mark if it does need to run
-            // which can be useful in analyzing task scheduling conflicts.
-            if (task->readyToRun() && !task_exectuted_this_loop)
+            if ((task->ready_source_ == READY_SOURCE_EVENT) && task->readyToRun())
             {
-                running_task_id_ = task->task_id();
-                task->execute();
-                task_exectuted_this_loop = true;
-                running_task_id_ = TASK_ID_INVALID; // because task is done running.
+                setTaskReady(*task);
             }
         }
     }
+
+    while (!stop_requested_)
+    {
+        if (mode_ == SCHEDULING_MODE_READY_SET)
+        {
+            runReadySetPass();
+        }
+        else
+        {
+            runScanPass();
+        }
+    }
+}
+
+//*****************************************************************************
+void Scheduler::runScanPass(void)
+{
+    current_ticks_ = sys_timer.ticks();
+
+    bool task_exectuted_this_loop = false;
+    for (uint8_t i = 0; i < num_tasks_; i++)
+    {
+        Task * task = tasks_[i];
+
+        // Every time we loop through all the tasks we only execute the first
+        // one that wants to run. This is what allows certain tasks to be more important
+        // than others.  Regardless of whether we have any intent of executing a task we
+        // always need to check if it needs to run so it can mark if it does need to run
+        // which can be useful in analyzing task scheduling conflicts.
+        if (task->readyToRun() && !task_exectuted_this_loop)
+        {
+            running_task_id_ = task->task_id();
+            task->execute();
+            task_exectuted_this_loop = true;
+            running_task_id_ = TASK_ID_INVALID; // because task is done running.
+        }
+    }
+
+    if (!task_exectuted_this_loop)
+    {
+        idle(nextTimerTaskTicks());
+    }
 }
 
 //*****************************************************************************
-bool Scheduler::disableInterrupts(void) const
+void Scheduler::runReadySetPass(void)
 {
-    // Check state of interrupts before disabling so they can be restored later.
-    bool already_enabled = (__get_PRIMASK() == 0);
-    __disable_irq();
-    return already_enabled;
+    current_ticks_ = sys_timer.ticks();
+
+    // Only look at the timer tasks once the earliest one is due so most loops don't touch them at all.
+    if (current_ticks_ >= next_timer_ticks_)
+    {
+        readyTimerTasks();
+    }
+
+    readyPolledTasks();
+
+    if (ready_set_.empty())
+    {
+        idle(next_timer_ticks_);
+        return; // nothing to run
+    }
+
+    Task * task = tasks_[ready_set_.highest()];
+
+    clearTaskReady(*task);
+
+    running_task_id_ = task->task_id();
+    task->execute();
+    running_task_id_ = TASK_ID_INVALID; // because task is done running.
+
+    // Task might still need to run right away, for example if it's split into smaller
+    // steps or there's more data in its queue.
+    if (task->needToRun())
+    {
+        setTaskReady(*task);
+    }
+    else if (task->ready_source_ == READY_SOURCE_TIMER)
+    {
+        next_timer_ticks_ = min(next_timer_ticks_, task->nextRunTicks());
+    }
 }
 
 //*****************************************************************************
-void Scheduler::restoreInterrupts(bool enabled) const
+void Scheduler::readyTimerTasks(void)
 {
-    if (enabled)
+    next_timer_ticks_ = UINT64_MAX;
+
+    for (uint16_t priority = timer_tasks_.highestFrom(0); priority != TaskSet::END;
+         priority = timer_tasks_.highestFrom(priority + 1))
     {
-        __enable_irq();
+        if (ready_set_.contains((uint8_t)priority))
+        {
+            continue; // will update the next timer ticks once it's done running.
+        }
+
+        Task * task = tasks_[priority];
+        uint64_t run_ticks = task->nextRunTicks();
+
+        if (current_ticks_ >= run_ticks)
+        {
+            setTaskReady(*task);
+        }
+        else
+        {
+            next_timer_ticks_ = min(next_timer_ticks_, run_ticks);
+        }
     }
 }
 
+//*****************************************************************************
+uint64_t Scheduler::nextTimerTaskTicks(void) const
+{
+    uint64_t next_ticks = UINT64_MAX;
+
+    for (uint16_t priority = timer_tasks_.highestFrom(0); priority != TaskSet::END;
+         priority = timer_tasks_.highestFrom(priority + 1))
+    {
+        next_ticks = min(next_ticks, tasks_[priority]->nextRunTicks());
+    }
+
+    return next_ticks;
+}
+
+//*****************************************************************************
+void Scheduler::readyPolledTasks(void)
+{
+    // Polled tasks don't have a way of telling the scheduler they're ready so they have to be asked every
+    // loop, but only the ones ahead of the highest priority ready task since the rest couldn't run anyway.
+    // They're asked once nothing ahead of them is ready, which is when they'd get to run.
+    uint16_t highest_ready = ready_set_.empty() ? TaskSet::END : ready_set_.highest();
+
+    for (uint16_t priority = polled_tasks_.highestFrom(0); priority < highest_ready;
+         priority = polled_tasks_.highestFrom(priority + 1))
+    {
+        if (tasks_[priority]->readyToRun())
+        {
+            // Now the highest priority ready task, so nothing after it could run either.
+            setTaskReady(*tasks_[priority]);
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
+void Scheduler::setTaskReady(Task & task)
+{
+    if ((mode_ != SCHEDULING_MODE_READY_SET) || (task.priority_ == INVALID_TASK_PRIORITY))
+    {
+        return;
+    }
+
+    bool enabled = disableInterrupts();
+
+    ready_set_.add(task.priority_);
+
+    if (!task.scheduled_)
+    {
+        // Record when task first wanted to run to use in task timing analysis.
+        task.scheduled_tick_stamp_ = current_ticks_;
+        task.scheduled_ = true;
+    }
+
+    restoreInterrupts(enabled);
+}
+
+//*****************************************************************************
+void Scheduler::notifyTask(Task & task)
+{
+    task.new_data_pending_ = true;
+
+    if (task.preemptive_)
+    {
+        // Checks all preemptive tasks so no harm in triggering it extra times.
+        if (preemptive_tier_started_)
+        {
+            pendPreemptiveTasks();
+        }
+    }
+    else
+    {
+        // In scan mode readyToRun() picks up the pending data instead.
+        setTaskReady(task);
+    }
+}
+
+//*****************************************************************************
+void Scheduler::clearTaskReady(Task & task)
+{
+    if (task.priority_ == INVALID_TASK_PRIORITY)
+    {
+        return;
+    }
+
+    bool enabled = disableInterrupts();
+    ready_set_.remove(task.priority_);
+    restoreInterrupts(enabled);
+}
+
+//*****************************************************************************
+void Scheduler::triggerPreemptiveTasks(void)
+{
+    if (preemptive_tier_started_ && (num_preemptive_tasks_ > 0))
+    {
+        pendPreemptiveTasks();
+    }
+}
+
+//*****************************************************************************
+void Scheduler::runPreemptiveTasks(void)
+{
+    // Might have interrupted a normal task so need to restore it when done.
+    interrupted_task_id_ = running_task_id_;
+
+    preemptive_ticks_ = sys_timer.ticks();
+    in_preemptive_tier_ = true;
+
+    for (uint8_t i = 0; i < num_preemptive_tasks_; i++)
+    {
+        Task * task = preemptive_tasks_[i];
+        if (task->readyToRun())
+        {
+            running_task_id_ = task->task_id();
+            task->execute();
+        }
+    }
+
+    in_preemptive_tier_ = false;
+    running_task_id_ = interrupted_task_id_;
+}
+
 //*****************************************************************************
 void Scheduler::timeTasks(void)
 {
@@ -101,6 +361,12 @@ void Scheduler::timeTasks(void)
     {
         debug_printf("Stopping task timing.");
         glo_task_timing_t task_timing;
+        for (uint8_t i = 0; i < num_preemptive_tasks_; i++)
+        {
+            preemptive_tasks_[i]->stopTimingAnalysis(task_timing);
+            send_task.handle(task_timing);
+        }
+
         for (uint8_t i = 0; i < num_tasks_; i++)
         {
             tasks_[i]->stopTimingAnalysis(task_timing);
@@ -117,6 +383,11 @@ void Scheduler::timeTasks(void)
     else
     {
         debug_printf("Starting task timing");
+        for (uint8_t i = 0; i < num_preemptive_tasks_; i++)
+        {
+            preemptive_tasks_[i]->startTimingAnalysis();
+        }
+
         for (uint8_t i = 0; i < num_tasks_; i++)
         {
             tasks_[i]->startTimingAnalysis();
@@ -134,11 +405,33 @@ void Scheduler::flushOutgoingMessages(void)
     // Make sure send task has been initialized.
     send_task.tryInitialize();
 
-    while (send_task.readyToRun())
+    // Send everything rather than each class's share, waiting for the DMA to make room if needed.
+    send_task.set_shaping(false);
+
+    while (send_task.numQueued() > 0)
     {
-        send_task.execute();
+        current_ticks_ = sys_timer.ticks();
+        if (in_preemptive_tier_)
+        {
+            // An assert in the preemptive tier flushes from there, so that's the time the send task sees.
+            preemptive_ticks_ = current_ticks_;
+        }
+
+        // The DMA interrupt is lower priority than the preemptive tier, so if the assert came from there then
+        // it can't run to start the next transfer and the buffer would never empty.  Check the DMA directly.
+        send_task.pollTransfer();
+
+        if (send_task.readyToRun())
+        {
+            send_task.execute();
+        }
     }
 
+    send_task.set_shaping(true);
+
+    // Everything's sent so no reason for scheduler to run task again.
+    clearTaskReady(send_task);
+
     running_task_id_ = TASK_ID_INVALID;
 }
 
@@ -152,9 +445,12 @@ void Scheduler::flushIncomingMessages(void)
 
     while (receive_task.readyToRun())
     {
+        current_ticks_ = sys_timer.ticks();
         receive_task.execute();
     }
 
+    clearTaskReady(receive_task);
+
     running_task_id_ = TASK_ID_INVALID;
 }
 
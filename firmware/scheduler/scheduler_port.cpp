@@ -0,0 +1,112 @@
+// Hardware specific parts of the Scheduler for the STM32F4 (Cortex-M4).
+// The host port (see host/) provides its own version of this file.
+
+// Includes
+#include "stm32f4xx.h"
+#include "scheduler.h"
+
+// Cycle count when interrupts were last disabled and longest time they've stayed disabled.
+// Only used if MEASURE_INTERRUPTS_DISABLED is true.
+static uint32_t interrupts_disabled_cycles = 0;
+static uint32_t max_interrupts_disabled_cycles = 0;
+
+namespace Scheduler {
+
+//*****************************************************************************
+void Scheduler::configureInterrupts(void)
+{
+    // Disable sub-priorities in NVIC (16 main priority levels)
+    SCB->AIRCR = 0x05FA0300;
+
+    // Preemptive tasks run from PendSV.
+    NVIC_SetPriority(PendSV_IRQn, PREEMPTIVE_TASK_IRQ_PRIORITY);
+}
+
+//*****************************************************************************
+void Scheduler::pendPreemptiveTasks(void)
+{
+    // Set PendSV pending. It will run as soon as systick returns since nothing else
+    // of a higher priority should be running for very long.
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+//*****************************************************************************
+void Scheduler::idle(uint64_t /*wake_ticks*/)
+{
+    // Nothing to do. Just keep looping so polled tasks get checked right away.
+}
+
+//*****************************************************************************
+extern "C" void PendSV_Handler(void)
+{
+    scheduler.runPreemptiveTasks();
+}
+
+//*****************************************************************************
+bool Scheduler::disableInterrupts(void) const
+{
+    // Check state of interrupts before disabling so they can be restored later.
+    bool already_enabled = (__get_PRIMASK() == 0);
+    __disable_irq();
+
+    if (MEASURE_INTERRUPTS_DISABLED && already_enabled)
+    {
+        interrupts_disabled_cycles = sys_timer.cycles();
+    }
+
+    return already_enabled;
+}
+
+//*****************************************************************************
+void Scheduler::restoreInterrupts(bool enabled) const
+{
+    if (enabled)
+    {
+        if (MEASURE_INTERRUPTS_DISABLED)
+        {
+            uint32_t disabled_cycles = sys_timer.cycles() - interrupts_disabled_cycles;
+            if (disabled_cycles > max_interrupts_disabled_cycles)
+            {
+                max_interrupts_disabled_cycles = disabled_cycles;
+            }
+        }
+
+        __enable_irq();
+    }
+}
+
+//*****************************************************************************
+uint32_t Scheduler::maxInterruptsDisabledCycles(void) const
+{
+    return max_interrupts_disabled_cycles;
+}
+
+//*****************************************************************************
+void Scheduler::resetInterruptsDisabledCycles(void)
+{
+    max_interrupts_disabled_cycles = 0;
+}
+
+//*****************************************************************************
+uint32_t Scheduler::disablePreemptiveTasks(void) const
+{
+    uint32_t previous_state = __get_BASEPRI();
+
+    // BASEPRI masks every interrupt with the same or lower priority. Priority is stored in the upper bits.
+    // Zero means nothing is masked.  Never lower the masking level if it's already higher (e.g. nested calls).
+    uint32_t mask_priority = PREEMPTIVE_TASK_IRQ_PRIORITY << (8 - __NVIC_PRIO_BITS);
+    if ((previous_state == 0) || (previous_state > mask_priority))
+    {
+        __set_BASEPRI(mask_priority);
+    }
+
+    return previous_state;
+}
+
+//*****************************************************************************
+void Scheduler::restorePreemptiveTasks(uint32_t previous_state) const
+{
+    __set_BASEPRI(previous_state);
+}
+
+} // Scheduler namespace
@@ -4,6 +4,9 @@
 #include "system_timer.h"
 #include "math_util.h"
 #include "scheduler.h"
+#ifdef HOST_PORT
+#include "host_port.h"
+#endif
 
 namespace Scheduler {
 
@@ -11,14 +14,19 @@ namespace Scheduler {
 Task::Task(char const * task_name, task_id_t task_id) :
     name_(task_name),
     id_(task_id),
+    ready_source_(READY_SOURCE_POLLED),
+    priority_(INVALID_TASK_PRIORITY),
     initialized_(false),
+    preemptive_(false),
+    new_data_pending_(false),
     num_times_ran_(0),
     current_step_(0),
     current_executed_step_(0),
     scheduled_(false),
     scheduled_tick_stamp_(0),
     started_tick_stamp_(0),
-    finished_tick_stamp_(0),
+    started_cycles_(0),
+    run_ticks_(0),
     previous_first_step_started_tick_stamp_(0),
     late_ticks_(0),
     times_tasked_skipped_(0),
@@ -42,7 +50,9 @@ void Task::execute(void)
 {
     num_times_ran_++;
 
-    started_tick_stamp_ = sys_timer.ticks();
+    // Only need the absolute time the scheduler loop started, which is much cheaper than reading the timer.
+    started_tick_stamp_ = scheduler.currentTicks();
+    started_cycles_ = sys_timer.cycles();
 
     if (currentStepIsDefault())
     {
@@ -54,9 +64,21 @@ void Task::execute(void)
         started_first_step_tick_stamp_ = started_tick_stamp_;
     }
 
+    new_data_pending_ = false;
+
+#ifdef HOST_PORT
+    // Lets the host give tasks a run time, since otherwise they take no virtual time at all.
+    double host_started = host_task_starting(*this);
+#endif
+
     run();
 
-    finished_tick_stamp_ = sys_timer.ticks();
+#ifdef HOST_PORT
+    host_task_finished(*this, host_started);
+#endif
+
+    // Cycle counter is 32 bits, but that's plenty for how long a task should run.
+    run_ticks_ = sys_timer.cycles() - started_cycles_;
 
     decideWhenToRunNext();
 
@@ -74,12 +96,12 @@ void Task::execute(void)
 //*****************************************************************************
 bool Task::readyToRun(void)
 {
-    bool need_to_run = needToRun();
+    bool need_to_run = new_data_pending_ || needToRun();
 
     if (need_to_run && !scheduled_)
     {
         // Record when task first wanted to run to use in task timing analysis.
-        scheduled_tick_stamp_ = sys_timer.ticks();
+        scheduled_tick_stamp_ = scheduler.currentTicks();
         scheduled_ = true;
     }
 
@@ -146,9 +168,6 @@ void Task::recordTimingInfo(void)
 {
     task_timing_execute_counts_++;
 
-    // How long task took to run this time.
-    uint32_t run_ticks = finished_tick_stamp_ - started_tick_stamp_;
-
     // How many ticks elapsed between the last run and this run.  If the task is split
     // up into smaller steps then ignore those sub-steps when calculating interval.
     uint32_t interval_ticks = started_first_step_tick_stamp_ - previous_first_step_started_tick_stamp_;
@@ -157,9 +176,9 @@ void Task::recordTimingInfo(void)
     delay_ticks_max_ = max(delay_ticks_max_, late_ticks_);
     delay_ticks_min_ = min(delay_ticks_min_, late_ticks_);
     delay_ticks_sum_ += late_ticks_;
-    run_ticks_max_ = max(run_ticks_max_, run_ticks);
-    run_ticks_min_ = min(run_ticks_min_, run_ticks);
-    run_ticks_sum_ += run_ticks;
+    run_ticks_max_ = max(run_ticks_max_, run_ticks_);
+    run_ticks_min_ = min(run_ticks_min_, run_ticks_);
+    run_ticks_sum_ += run_ticks_;
     interval_ticks_max_ = max(interval_ticks_max_, interval_ticks);
     interval_ticks_min_ = min(interval_ticks_min_, interval_ticks);
     interval_ticks_sum_ += interval_ticks;
@@ -8,7 +8,8 @@
 
 //******************************************************************************
 ComplementaryFilterTask::ComplementaryFilterTask( float frequency) :
-        PeriodicTask("Comp. Filter", TASK_ID_FILTER, frequency)
+        PeriodicTask("Comp. Filter", TASK_ID_FILTER, frequency),
+        sample_ticks_(0)
 {
     current_step_ = READ_ACCEL;
 }
@@ -31,10 +32,13 @@ void ComplementaryFilterTask::initialize(void)
 //******************************************************************************
 void ComplementaryFilterTask::publishNewData(void)
 {
-    glo_imu.publish(&imu_);
-    glo_raw_imu.publish(&raw_imu_);
-    glo_quaternion.publish(&quaternion_);
-    glo_roll_pitch_yaw.publish(&roll_pitch_yaw_);
+    // Publish as a group so the main control task always sees the IMU and attitude from the same step.
+    uint32_t group_state = GlobBase::begin_group_publish();
+    glo_imu.publish(&imu_, 1, sample_ticks_);
+    glo_raw_imu.publish(&raw_imu_, 1, sample_ticks_);
+    glo_quaternion.publish(&quaternion_, 1, sample_ticks_);
+    glo_roll_pitch_yaw.publish(&roll_pitch_yaw_, 1, sample_ticks_);
+    GlobBase::end_group_publish(group_state);
 }
 
 //******************************************************************************
@@ -43,6 +47,7 @@ void ComplementaryFilterTask::run(void)
     switch (current_step_)
     {
         case READ_ACCEL:
+            sample_ticks_ = scheduler.currentTicks();
             mpu_.readAccel(raw_imu_.accels);
             current_step_ = READ_GYRO;
             break;
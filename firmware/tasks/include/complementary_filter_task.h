@@ -50,6 +50,10 @@ private: // fields
     // Filter used to provide state measurements.
     ComplementaryFilter complementary_filter_;
 
+    // System ticks when the accelerometer was last read.  Published as the tick stamp of the
+    // filter output so consumers know how old the measurement actually is.
+    uint64_t sample_ticks_;
+
     // Globs that this task owns.
     glo_raw_imu_t raw_imu_;
     glo_imu_t imu_;
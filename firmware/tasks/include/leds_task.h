@@ -3,6 +3,7 @@
 
 // Includes
 #include "digital_out.h"
+#include "glob_snapshot.h"
 #include "green_leds.h"
 #include "periodic_task.h"
 #include "user_leds.h"
@@ -24,8 +25,8 @@ private: // methods
     // if the battery is getting low.
     virtual void run(void);
 
-    // Not currently implemented.
-    virtual void initialize(void) {}
+    // Setup snapshot of globs from other tasks.
+    virtual void initialize(void);
 
     // Ran at a slower rate than main task.  In charge of updating LEDs that shouldn't change really fast.
     void slowRun(void);
@@ -53,6 +54,9 @@ private: // fields
     glo_modes_t modes_;
     glo_analog_t analog_;
 
+    // Reads the globs from other tasks together.
+    GlobSnapshot snapshot_;
+
 };
 
 // Task instance - defined in main.cpp
@@ -3,9 +3,15 @@
 
 // Includes
 #include "analog_in.h"
+#include "capture_codec.h"
+#include "capture_decimator.h"
+#include "capture_ring.h"
 #include "derivative_filter.h"
 #include "digital_out.h"
 #include "encoder.h"
+#include "glob_gather.h"
+#include "glob_snapshot.h"
+#include "glob_trigger.h"
 #include "glob_types.h"
 #include "periodic_task.h"
 #include "pid_controller.h"
@@ -16,8 +22,11 @@ class MainControlTask : public Scheduler::PeriodicTask
 {
 public: // methods
 
-    // Constructor
-    MainControlTask(float frequency);
+    // Constructor. Runs on the timer at 'frequency' unless 'run_on_new_attitude' is true, in which case it runs
+    // every time the filter has a new attitude estimate instead and 'frequency' has to match the filter's
+    // (delta_t and the controller tuning depend on it).  That lines control up with the IMU samples, but the
+    // filter is a normal task so control then waits on it and picks up its scheduling jitter.
+    MainControlTask(float frequency, bool run_on_new_attitude = false);
 
     // Clear and publish theta zero.
     void reset_zero_tilt_angle(void);
@@ -25,6 +34,12 @@ public: // methods
     // Validate and publish new capture command.
     void handle(glo_capture_command_t & command);
 
+    // Switch to new capture channels if they're valid and send back what's being captured.
+    void handle(glo_capture_channels_t & channels);
+
+    // Use new capture trigger settings if they're valid and send them back with the state.
+    void handle(glo_capture_trigger_t & trigger);
+
     // Publish wave settings
     void handle(glo_wave_t & wave);
 
@@ -39,6 +54,16 @@ public: // methods
     // Reset commands and filters back to default state.
     void reset(void);
 
+    // Return ticks from when the IMU was sampled to when the motor PWM based on it was set.  Recorded the
+    // first time each sample is used. Last, maximum and average since startup.
+    uint32_t sensorToPwmTicks(void) const { return sensor_to_pwm_ticks_; }
+    uint32_t sensorToPwmTicksMax(void) const { return sensor_to_pwm_ticks_max_; }
+    uint32_t sensorToPwmTicksAvg(void) const;
+
+    // Return which capture data instances hold which samples.  The telemetry stream task sends samples out
+    // of it while a streaming capture is running.
+    CaptureRing & captureRing(void) { return capture_ring_; }
+
 public: // fields
 
     // PID controllers. Public to keep in sync with global PID parameters.
@@ -69,10 +94,27 @@ private: // methods
     // If there is a critical error, such as low battery, then the values will be set to 0.
     void updateMotorPWM(void);
 
+    // Update sensor to PWM latency counters if the motors were just set using a new IMU sample.
+    void recordSensorToPwmLatency(void);
+
     // Check if need to be capturing data and if so then saves data off
     // until it's time to send back.
     void runDataCapture(void);
 
+    // Compile 'channels' into the capture gather table and update the capture channels glob with
+    // the result.  Must be called with preemptive tasks disabled (or from this task).
+    void setCaptureChannels(glo_capture_channels_t & channels);
+
+    // Publish the capture data instance that's being filled to the next instance of the ring buffer.
+    void publishCaptureData(void);
+
+    // Return how many samples the capture data instances hold when not streaming.
+    uint32_t captureCapacity(void) const { return (uint32_t)max_samples_ * capture_channels_.samples_per_instance; }
+
+    // Send the samples from around the trigger (or the last ones if it never triggered) once a triggered
+    // capture stops, then the capture command with how many there are.
+    void sendTriggeredCapture(void);
+
     // Run full state feedback loop for balancing + yaw control.
     void balanceMode(void);
 
@@ -129,9 +171,27 @@ private: // fields
     // How many times task has been ran since data collection was started.
     uint32_t capture_run_counts_;
 
-    // Maximum number of sample data to record before stopping data capture.
+    // Maximum number of sample data to record before stopping data capture (unless streaming).
     uint16_t max_samples_;
 
+    // Capture data glob instances used as a ring buffer.
+    CaptureRing capture_ring_;
+
+    // Copies the capture channels into each sample.
+    GlobGather capture_gather_;
+
+    // Packs samples into capture data instances with the quantized formats, and how many samples are
+    // in the last instance that was published.
+    CaptureEncoder capture_encoder_;
+    uint8_t last_instance_samples_;
+
+    // Filters every channel at the task rate when capturing slower than that.
+    CaptureDecimator capture_decimator_;
+
+    // Waits for the capture trigger, and the sample number it happened on.
+    GlobTrigger trigger_;
+    uint32_t trigger_sample_;
+
     // Globs from other tasks.
     glo_modes_t modes_;
     glo_motion_commands_t motion_commands_;
@@ -140,6 +200,18 @@ private: // fields
     glo_theta_zero_t theta_zero_;
     glo_status_data_t status_data_;
 
+    // Reads all the globs from other tasks together.
+    GlobSnapshot snapshot_;
+
+    // Tick stamp of the IMU sample the motors were last set with.
+    uint64_t last_sample_ticks_;
+
+    // Sensor to PWM latency counters. See sensorToPwmTicks().
+    uint32_t sensor_to_pwm_ticks_;
+    uint32_t sensor_to_pwm_ticks_max_;
+    uint64_t sensor_to_pwm_ticks_sum_;
+    uint32_t sensor_to_pwm_count_;
+
     // Globs that this task owns.
     glo_motor_pwm_t motor_pwm_;
     glo_odometry_t odometry_;
@@ -147,6 +219,8 @@ private: // fields
     glo_wave_t wave_;
     glo_capture_command_t capture_command_;
     glo_capture_data_t capture_data_;
+    glo_capture_channels_t capture_channels_;
+    glo_capture_trigger_t capture_trigger_;
 
 };
 
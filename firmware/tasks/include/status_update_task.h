@@ -3,6 +3,7 @@
 
 // Includes
 #include "digital_out.h"
+#include "glob_snapshot.h"
 #include "glob_types.h"
 #include "periodic_task.h"
 
@@ -20,8 +21,8 @@ public: // methods
 
 private: // methods
 
-    // Not implemented.
-    virtual void initialize(void) {}
+    // Setup snapshot of globs from other tasks.
+    virtual void initialize(void);
 
     // Send status data over telemetry.
     virtual void run(void);
@@ -40,6 +41,9 @@ private: // fields
     glo_analog_t analog_;
     glo_motor_pwm_t motor_pwm_;
 
+    // Reads the globs this task needs together. Includes the last published status.
+    GlobSnapshot snapshot_;
+
     // Globs that this task owns.
     glo_status_data_t status_data_;
     glo_modes_t modes_;
@@ -7,6 +7,9 @@
 #include "glo_rx_link.h"
 #include "task.h"
 
+// Longest the task spends parsing each time it runs. [seconds]
+const float RECEIVE_PARSE_BUDGET = 50e-6f;
+
 // Receive and handle data coming in over serial link.
 class TelemetryReceiveTask : public Scheduler::Task
 {
@@ -31,6 +34,9 @@ public: // methods
     // Send back the request glob.  If instance is 0 then sends back all instances.
     void handle(glo_request_t & msg, uint16_t instance);
 
+    // Switch the telemetry link to a new mode and send the mode back.
+    void handle(glo_link_mode_t & mode);
+
 private: // methods
 
     // Setup glo receive link.
@@ -52,6 +58,9 @@ private: // fields
     // Receive link for parsing incoming glob messages.
     GloRxLink * glo_rx_link_;
 
+    // RECEIVE_PARSE_BUDGET converted to timer cycles.
+    uint32_t parse_budget_cycles_;
+
     // Serial bus wrapped by glo link.
     usart_bus_t bus_;
     Usart * serial_port_;
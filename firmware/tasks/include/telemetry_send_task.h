@@ -2,25 +2,61 @@
 #define TELEMETRY_SEND_TASK_H_INCLUDED
 
 // Includes
+#include "fifo_arena.h"
+#include "glo_bulk_transfer.h"
 #include "glo_tx_link.h"
 #include "glob_types.h"
-#include "queued_task.h"
-#include "simple_array.h"
+#include "queue.h"
+#include "task.h"
 
 // Forward declarations
 struct glob_queue_t;
-struct glob_data_queue_t;
+
+// Largest frame to pack queued globs into. See GloTxLink::beginBatch().
+const uint16_t TELEMETRY_BATCH_MTU = MSG_MAX_FRAME_SIZE;
+
+// Most transfer buffer bytes a single frame can take in either framing mode.
+const uint16_t TELEMETRY_MAX_FRAME_BYTES = MSG_COBS_MAX_ENCODED_SIZE + 1;
+
+// Share of the link's bytes/second (from the serial port baud rate) each class is budgeted.  Classes
+// with budget left are sent first in priority order.  A class that's over budget still sends if
+// nothing with budget left is waiting, so the link is never idle when there's something to send.
+const float TELEMETRY_CLASS_SHARE[NUM_TELEMETRY_CLASSES] = { 0.2f, 0.4f, 0.4f };
+
+// How many seconds of unused budget a class can save up for a burst.
+const float TELEMETRY_BURST_SECONDS = 0.1f;
+
+// Transfer buffer bytes each class leaves free for the classes above it, so a new assert message or
+// status update only waits behind what's already in the buffer instead of a full buffer of capture data.
+const uint16_t TELEMETRY_CLASS_HEADROOM[NUM_TELEMETRY_CLASSES] = { 0, TELEMETRY_MAX_FRAME_BYTES, 2 * TELEMETRY_MAX_FRAME_BYTES };
+
+// How often (in seconds) the telemetry stats glob is published while there's something to send.
+const float TELEMETRY_STATS_PERIOD = 1.0f;
+
+// Bytes set aside for copies of globs saved by send_copy().  Each copy takes up its glob size plus a
+// 4 byte header (see FifoArena), so this holds 15 of the largest globs or a lot more small ones.
+const uint32_t TELEMETRY_SAVE_BUFFER_BYTES = 15 * 256;
+
+// Most instances a reliable bulk transfer sends ahead of what the GUI has acknowledged.  Needs to cover
+// a round trip through the transfer buffer (about 90 ms at 115200 baud, so ~30 capture data instances).
+const uint16_t TELEMETRY_BULK_WINDOW = BULK_MAX_WINDOW;
+
+// Seconds without an acknowledgement before a reliable bulk transfer sends the oldest instance again.
+// Counted from the last send so it only has to cover draining the transfer buffer and the reply.
+const float TELEMETRY_BULK_TIMEOUT = 0.15f;
 
 // Define easier to reference templated type.
 typedef Scheduler::Queue<glob_queue_t> GlobQueue;
 
-// Queued task (i.e. only runs when items are placed in its queue) that sends
-// globs over a serial interface.
-class TelemetrySendTask : public Scheduler::QueuedTask<glob_queue_t>
+// Task that sends globs over a serial interface.  Globs are queued by class (see telemetry_class_t)
+// and each class gets a share of the link's bandwidth, so a capture dump or burst of debug messages
+// can't hold up status updates.  Only hands the link as much as there's room for in the transfer buffer
+// and otherwise waits (on a timer) for the DMA to make room, so it runs when queued to or when there's room.
+class TelemetrySendTask : public Scheduler::Task
 {
   public: // methods
 
-    // Constructor
+    // Constructor. Each class gets a queue that can hold 'queue_size' globs.
     TelemetrySendTask(uint32_t queue_size);
 
     // Take the data currently stored in the glob with specified id and instance, save off
@@ -35,6 +71,9 @@ class TelemetrySendTask : public Scheduler::QueuedTask<glob_queue_t>
     // 0 then it has no effect. Return true if glob is successfully sent.
     // Note: This doesn't copy the glob data when this method is called. The data that is
     // sent is what's stored in the glob when it is dequeued in the run() method.
+    // If the GUI turned on reliable bulk transfers (see glo_link_mode_t) then a range of instances is
+    // sent as one (see GloBulkTransfer), so the instances shouldn't be republished until it's done.  That
+    // includes a range of one (e.g. 5 to 5), since a capture stream can have just one instance ready.
     bool send(uint8_t id, uint16_t instance=1, uint16_t stop_instance=0);
 
     // Send back all recent assert/debug messages in the order they were published.
@@ -44,20 +83,98 @@ class TelemetrySendTask : public Scheduler::QueuedTask<glob_queue_t>
     // Publish and send new assert message. Return true if message is sent.
     bool handle(glo_assert_message_t & message);
 
+    // Return how many assert messages there have been since boot (e.g. so a capture can trigger on one).
+    uint32_t numAsserts(void) const { return num_asserts_; }
+
     // Publish and send new debug message. Return true if message is sent.
     bool handle(glo_debug_message_t & message);
 
     // Publish and send task timing glob. Return true if message is sent.
     bool handle(glo_task_timing_t const & timing);
 
+    // Update the reliable bulk transfer with an acknowledgement from the GUI.
+    void handle(glo_bulk_ack_t const & ack);
+
+    // Set the largest frame queued globs are packed into.  If zero then every glob is sent in
+    // its own frame, for receivers that don't understand batch frames.
+    void set_batch_mtu(uint16_t mtu) { batch_mtu_ = mtu; }
+
+    // If false then every class can use the whole link and transfer buffer.  Used to flush everything
+    // out before stopping, so reliable bulk transfers are sent the rest of the way without waiting for
+    // acknowledgements.
+    void set_shaping(bool enabled) { shaping_enabled_ = enabled; }
+
+    // Return how many globs are waiting to be sent in every class.
+    uint32_t numQueued(void) const;
+
+    // Return how many globs are waiting to be sent in 'glob_class'.  A range of instances (or a reliable bulk
+    // transfer) stays queued until its last instance is handed to the link (or acknowledged).
+    uint32_t numQueued(telemetry_class_t glob_class) const { return queues_[glob_class]->count(); }
+
+    // Return how many bytes/second the link can send, from the serial port baud rate.
+    uint32_t linkBytesPerSecond(void) const;
+
+    // Start the next DMA transfer if the last one finished, for when the DMA interrupt can't run (e.g.
+    // flushing an assert message from the preemptive tier).  Does nothing if not initialized yet.
+    void pollTransfer(void);
+
   protected: // methods
 
     // Setup 'glo transfer link' with underlying serial port.
     virtual void initialize(void);
 
-    // Pull items out of queue and send them over 'glo transfer link'.
+    // Pull items out of the class queues and send them over 'glo transfer link'.
     virtual void run(void);
 
+    // Return true if a queued glob can be sent right now.
+    virtual bool needToRun(void);
+
+    // Return tick stamp to check for room in the transfer buffer again at.
+    virtual uint64_t nextRunTicks(void) const { return next_run_ticks_; }
+
+    // Decide when the transfer buffer will have room for what's waiting.
+    virtual void decideWhenToRunNext(void);
+
+  private: // methods
+
+    // Put glob in its class queue and let the scheduler know. Return false if the queue is full.
+    bool enqueue(glob_queue_t & glob);
+
+    // Return which class a glob is sent in.
+    telemetry_class_t classify(glob_queue_t const & glob) const;
+
+    // Return the class to send from next or NUM_TELEMETRY_CLASSES if nothing can be sent yet.  'room' is
+    // set to how many transfer buffer bytes the class can use and 'shortfall' to how many more bytes
+    // need to be free before anything waiting can be sent.
+    telemetry_class_t nextClass(uint16_t * room, uint16_t * shortfall);
+
+    // Send one frame from 'glob_class', either a single glob or a batch of them.
+    void sendFrom(telemetry_class_t glob_class, uint16_t room);
+
+    // Send the next frame of the reliable bulk transfer for 'glob', starting or finishing it if needed.
+    void sendReliable(telemetry_class_t glob_class, glob_queue_t const & glob, uint16_t room);
+
+    // Return true if the reliable bulk transfer at the front of a queue isn't waiting on the GUI.
+    bool reliableReady(void) const;
+
+    // Publish and send the glob describing the reliable bulk transfer.
+    void announceTransfer(void);
+
+    // Send or add to the open batch the glob at the front of the queue. Return the send result.
+    int sendQueued(glob_queue_t const & glob, bool batched);
+
+    // Remove the glob at the front of its queue once it's handled and queue up its next instance.
+    void finishQueued(telemetry_class_t glob_class, glob_queue_t const & glob);
+
+    // Add to each class budget for the time since the last refill.
+    void refillBudgets(void);
+
+    // Publish the telemetry stats glob once a stats period has gone by.
+    void updateStats(void);
+
+    // Switch the link to what's in the link mode glob.
+    void applyLinkMode(void);
+
   private: // fields
 
     // Transfer link for sending glob messages.
@@ -67,42 +184,72 @@ class TelemetrySendTask : public Scheduler::QueuedTask<glob_queue_t>
     usart_bus_t bus_;
     Usart * serial_port_;
 
-    // Buffer to save globs in until they can be sent.
-    SimpleArray<glob_data_queue_t> save_buffer_;
+    // Buffer to save glob copies in until they can be sent.  Copies are mostly sent in the order
+    // they're saved, except when a higher class jumps ahead.
+    FifoArena save_buffer_;
+
+    // Largest frame to pack queued globs into, or zero to not batch.
+    uint16_t batch_mtu_;
+
+    // Globs waiting to be sent in each class.
+    GlobQueue * queues_[NUM_TELEMETRY_CLASSES];
+
+    // Bytes each class can send before it's over budget.  Goes negative by up to a frame when a class
+    // sends more than it has left.
+    float budgets_[NUM_TELEMETRY_CLASSES];
+
+    // Tick stamp budgets were last refilled at.
+    uint64_t refill_ticks_;
+
+    // False if classes aren't limited to their budget and headroom. See set_shaping().
+    bool shaping_enabled_;
+
+    // Tick stamp to run at next if waiting for room in the transfer buffer or an acknowledgement.
+    uint64_t next_run_ticks_;
+
+    // Range of instances being sent reliably.  Only one at a time, the rest wait in the queue.
+    // Only touched by this task and the receive task (acknowledgements), which don't preempt each other.
+    GloBulkTransfer bulk_transfer_;
+    uint8_t next_transfer_id_;
+
+    // True if ranges of instances are sent as reliable bulk transfers.
+    bool reliable_bulk_;
+
+    // Stats since the last time the stats glob was published.
+    uint32_t bytes_sent_[NUM_TELEMETRY_CLASSES];
+    uint16_t max_queue_depth_[NUM_TELEMETRY_CLASSES];
+    uint32_t num_dropped_[NUM_TELEMETRY_CLASSES]; // since boot
+    uint64_t stats_start_ticks_;
 
     // Next instance numbers to publish debug/assert messages to.
     // Used for caching messages for the UI to request on connect.
     uint16_t next_assert_instance_;
     uint16_t next_debug_instance_;
 
+    // Assert messages since boot.
+    volatile uint32_t num_asserts_;
+
 };
 
-// Data type stored in task queue. Stores glob meta-data so multiple glob types
-// can be stored in the same queue. Individual tasks can define queue types
-// for passing the same glob type, or any other data type.
+// Data type stored in the class queues. Stores glob meta-data so multiple glob types
+// can be stored in the same queue.
 struct glob_queue_t
 {
     uint8_t     id;            // Unique ID associated with glob.
     uint16_t    instance;      // Instance number to send.
     uint16_t    stop_instance; // Instance number to stop sending at.  If 0 then will be ignored.
-    array_idx_t storage_idx;   // Index associated with 'copy' of data or INVALID_ARRAY_INDEX.
+    void *      data;          // Saved 'copy' of the glob data in the save buffer or null.
+    bool        reliable;      // True if the range of instances is sent as a reliable bulk transfer.
 
     // Default Constructor.
-    glob_queue_t(void) : id(0), instance(0), stop_instance(0), storage_idx(INVALID_ARRAY_INDEX) {}
+    glob_queue_t(void) : id(0), instance(0), stop_instance(0), data(NULL), reliable(false) {}
 
     // Constructor. If no copy is required then 'data' must be null.
-    glob_queue_t(uint8_t id, uint16_t instance, uint16_t stop_instance, array_idx_t storage_idx) :
-        id(id), instance(instance), stop_instance(stop_instance), storage_idx(storage_idx) {}
+    glob_queue_t(uint8_t id, uint16_t instance, uint16_t stop_instance, void * data, bool reliable=false) :
+        id(id), instance(instance), stop_instance(stop_instance), data(data), reliable(reliable) {}
 
 };
 
-// The data type stored in the 'save_buffer'.  256 bytes since that's the maximum size of glob data.
-// Kind of wasteful since small globs will always take up the full space, but it's simpler to implement.
-struct glob_data_queue_t
-{
-    uint8_t data[256];
-};
-
 // Task instance - defined in main.cpp
 extern TelemetrySendTask send_task;
 
@@ -0,0 +1,93 @@
+#ifndef TELEMETRY_STREAM_TASK_H_INCLUDED
+#define TELEMETRY_STREAM_TASK_H_INCLUDED
+
+// Includes
+#include "glob_types.h"
+#include "periodic_task.h"
+#include "telemetry_send_task.h"
+
+// Most instances a subscription can send each time, so one subscription can't fill the send queue.
+const uint16_t STREAM_MAX_INSTANCES = 16;
+
+// Share of the link's bytes/second every stream together can use.  Streamed globs are sent in the
+// control class, so this is most of its share with the rest left for status updates and replies.
+const float STREAM_LINK_SHARE = 0.75f * TELEMETRY_CLASS_SHARE[TELEMETRY_CLASS_CONTROL];
+
+// Slowest a subscription is slowed down to so it fits under the bandwidth limit before it's rejected.
+const float STREAM_MIN_RATE = 0.1f;
+
+// Seconds ahead to look at when the other streams send when picking when a new one sends.
+const float STREAM_STAGGER_SECONDS = 1.0f;
+
+// Most capture samples queued at once while streaming a capture.  Only one range is queued at a time,
+// so with reliable bulk transfers on this is how many instances each transfer sends.
+const uint16_t CAPTURE_STREAM_CHUNK = 64;
+
+// How often (in seconds) the capture status is sent while streaming a capture.
+const float CAPTURE_STATUS_PERIOD = 0.5f;
+
+// A granted subscription and when it sends.
+struct telemetry_stream_t
+{
+    glo_stream_subscription_t subscription;
+    uint32_t period;         // Runs between sends. Zero if not streaming.
+    uint32_t phase;          // Sends on runs where the run count modulo 'period' is this.
+    float    bytes_per_send; // Including framing for every instance.
+};
+
+// Sends globs the GUI subscribed to (see glo_stream_subscription_t) at the rates it asked for, so it
+// doesn't have to keep requesting them.  Each subscription sends every so many runs of the task and
+// is started on the run where it adds the least to the biggest burst, so streams at the same rate are
+// spread out instead of all queued at once.  The bytes/second of every stream together is kept under
+// STREAM_LINK_SHARE of the link by slowing down (or rejecting) new subscriptions.
+//
+// Also sends the samples of a streaming capture (see glo_capture_command_t) out of the capture ring
+// buffer while the main control task is still filling it.  Capture data is sent in the bulk class so
+// it doesn't count against the stream bandwidth, and the next chunk is only queued once the last one
+// has been sent, so how fast the link drains the ring is the backpressure on the capture.
+class TelemetryStreamTask : public Scheduler::PeriodicTask
+{
+  public: // methods
+
+    // Constructor. Subscription rates are rounded to a whole number of runs at 'frequency'.
+    TelemetryStreamTask(float frequency);
+
+    // Replace subscription 'instance' with 'subscription' and send back what was granted.
+    void handle(glo_stream_subscription_t & subscription, uint16_t instance);
+
+    // Return bytes/second every stream together is expected to send, including framing.
+    float bytesPerSecond(void) const;
+
+  private: // methods
+
+    virtual void initialize(void) {}
+
+    // Queue up every glob that's due to be sent.
+    virtual void run(void);
+
+    // Release the capture samples that have been sent and queue up the next ones.  Sends the capture
+    // status every so often and the capture command once the last sample is sent.
+    void sendCapture(void);
+
+    // Validate 'subscription' and figure out when 'stream' sends, adjusting the subscription to what's
+    // granted.  Return the status to send back.
+    glo_stream_status_t subscribe(glo_stream_subscription_t & subscription, telemetry_stream_t * stream);
+
+    // Return which run (modulo 'period') a stream sending 'num_bytes' every 'period' runs should send on
+    // so it collides with the fewest bytes from the other streams.
+    uint32_t pickPhase(uint32_t period, float num_bytes) const;
+
+  private: // fields
+
+    // Every subscription, indexed by instance - 1.
+    telemetry_stream_t streams_[STREAM_MAX_SUBSCRIPTIONS];
+
+    // How many times the task has run.
+    uint32_t num_runs_;
+
+};
+
+// Task instance - defined in main.cpp
+extern TelemetryStreamTask stream_task;
+
+#endif
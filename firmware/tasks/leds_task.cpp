@@ -14,11 +14,17 @@ LedsTask::LedsTask(float frequency) :
 {
 }
 
+//******************************************************************************
+void LedsTask::initialize(void)
+{
+    snapshot_.add(glo_modes, &modes_);
+    snapshot_.add(glo_analog, &analog_);
+}
+
 //******************************************************************************
 void LedsTask::readNewData(void)
 {
-    glo_modes.read(&modes_);
-    glo_analog.read(&analog_);
+    snapshot_.read();
 }
 
 //******************************************************************************
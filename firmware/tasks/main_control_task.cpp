@@ -1,6 +1,9 @@
 // Includes
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include "debug_printf.h"
+#include "glob_registry.h"
 #include "globs.h"
 #include "main_control_task.h"
 #include "math_util.h"
@@ -10,7 +13,18 @@
 #include "util_assert.h"
 
 //******************************************************************************
-MainControlTask::MainControlTask(float frequency) :
+// Add a float channel to a capture channel list.
+static void add_capture_channel(glo_capture_channels_t & channels, glob_id_t id, uint16_t offset)
+{
+    uint8_t i = channels.num_channels++;
+    channels.glob_id[i] = id;
+    channels.instance[i] = 1;
+    channels.offset[i] = offset;
+    channels.type[i] = GLOB_FIELD_FLOAT;
+}
+
+//******************************************************************************
+MainControlTask::MainControlTask(float frequency, bool run_on_new_attitude) :
         PeriodicTask("Main Control", TASK_ID_MAIN_CONTROL, frequency),
         yaw_pid(2, 20, 0.05, -0.3, 0.3, -0.8, 0.8),
         left_speed_pid(1.00, 30, 0.0, -0.3, 0.3, -0.8, 0.8),
@@ -31,13 +45,25 @@ MainControlTask::MainControlTask(float frequency) :
         capturing_data_(false),
         capture_counter_(0),
         capture_run_counts_(0),
-        max_samples_(0)
+        max_samples_(0),
+        last_instance_samples_(0),
+        trigger_sample_(0),
+        last_sample_ticks_(0),
+        sensor_to_pwm_ticks_(0),
+        sensor_to_pwm_ticks_max_(0),
+        sensor_to_pwm_ticks_sum_(0),
+        sensor_to_pwm_count_(0)
 {
     for (uint8_t i = 0; i < 4; ++i)
     {
         // Set full state feedback gains to default values.
         K_[i] = K_DEFAULT[i];
     }
+
+    if (run_on_new_attitude)
+    {
+        runOnNewData();
+    }
 }
 
 //******************************************************************************
@@ -45,17 +71,48 @@ void MainControlTask::initialize(void)
 {
     // Subtract one since instance 0 isn't used.
     max_samples_ = globs[GLO_ID_CAPTURE_DATA]->get_num_instances() - 1;
+
+    snapshot_.add(glo_modes, &modes_);
+    snapshot_.add(glo_imu, &imu_);
+    snapshot_.add(glo_roll_pitch_yaw, &roll_pitch_yaw_);
+    snapshot_.add(glo_theta_zero, &theta_zero_);
+    snapshot_.add(glo_motion_commands, &motion_commands_);
+    snapshot_.add(glo_status_data, &status_data_);
+
+    // Capture channels from globs this task already has copies of are taken from the copies, which are
+    // also newer for the globs it owns since those aren't published until the end of the run.
+    capture_gather_.addLocal(GLO_ID_MODES, &modes_);
+    capture_gather_.addLocal(GLO_ID_MOTION_COMMANDS, &motion_commands_);
+    capture_gather_.addLocal(GLO_ID_IMU, &imu_);
+    capture_gather_.addLocal(GLO_ID_ROLL_PITCH_YAW, &roll_pitch_yaw_);
+    capture_gather_.addLocal(GLO_ID_THETA_ZERO, &theta_zero_);
+    capture_gather_.addLocal(GLO_ID_STATUS_DATA, &status_data_);
+    capture_gather_.addLocal(GLO_ID_MOTOR_PWM, &motor_pwm_);
+    capture_gather_.addLocal(GLO_ID_ODOMETRY, &odometry_);
+    capture_gather_.addLocal(GLO_ID_ANALOG, &analog_);
+    capture_gather_.addLocal(GLO_ID_WAVE, &wave_);
+
+    // Capture the same channels that used to be hard coded until the GUI picks its own.
+    glo_capture_channels_t channels;
+    memset(&channels, 0, sizeof(channels));
+    setCaptureChannels(channels);
+
+    // No trigger until the GUI sets one.
+    memset(&capture_trigger_, 0, sizeof(capture_trigger_));
+    glo_capture_trigger.publish(&capture_trigger_);
+
+    if (runs_on_new_data_)
+    {
+        // Run as soon as the filter has a new attitude estimate rather than on a fixed timer that isn't lined
+        // up with it.  Roll-pitch-yaw is published last in the filter's group so everything else is new too.
+        glo_roll_pitch_yaw.subscribe(*this);
+    }
 }
 
 //******************************************************************************
 void MainControlTask::readNewData(void)
 {
-    glo_modes.read(&modes_);
-    glo_imu.read(&imu_);
-    glo_roll_pitch_yaw.read(&roll_pitch_yaw_);
-    glo_theta_zero.read(&theta_zero_);
-    glo_motion_commands.read(&motion_commands_);
-    glo_status_data.read(&status_data_);
+    snapshot_.read();
 }
 
 //******************************************************************************
@@ -117,6 +174,7 @@ void MainControlTask::run(void)
 
     // Update how much voltage is being applied to the motors.
     updateMotorPWM();
+    recordSensorToPwmLatency();
 
     // Capture / send back data if the user has requested it.
     runDataCapture();
@@ -175,6 +233,31 @@ void MainControlTask::updateMotorPWM(void)
     hbridge_.setDutyB(right_duty);
 }
 
+//******************************************************************************
+void MainControlTask::recordSensorToPwmLatency(void)
+{
+    // Filter stamps its output with when the IMU was sampled.
+    uint64_t sample_ticks = glo_roll_pitch_yaw.get_tick_stamp();
+    if ((sample_ticks == 0) || (sample_ticks == last_sample_ticks_))
+    {
+        return; // no new sample so not a measure of how fast it's reacted to.
+    }
+
+    last_sample_ticks_ = sample_ticks;
+
+    sensor_to_pwm_ticks_ = (uint32_t)(sys_timer.ticks() - sample_ticks);
+    sensor_to_pwm_ticks_max_ = max(sensor_to_pwm_ticks_max_, sensor_to_pwm_ticks_);
+    sensor_to_pwm_ticks_sum_ += sensor_to_pwm_ticks_;
+    sensor_to_pwm_count_++;
+}
+
+//******************************************************************************
+uint32_t MainControlTask::sensorToPwmTicksAvg(void) const
+{
+    if (sensor_to_pwm_count_ == 0) { return 0; }
+    return (uint32_t)(sensor_to_pwm_ticks_sum_ / sensor_to_pwm_count_);
+}
+
 //******************************************************************************
 void MainControlTask::runDataCapture(void)
 {
@@ -186,13 +269,37 @@ void MainControlTask::runDataCapture(void)
     {
         capturing_data_ = true;
         capture_counter_ = 0;
+
+        // A triggered capture keeps overwriting the oldest samples until the trigger, so it's never streamed.
+        trigger_.arm(capture_trigger_, send_task.numAsserts());
+        capture_trigger_.state = trigger_.isArmed() ? TRIGGER_STATE_ARMED : TRIGGER_STATE_IDLE;
+        capture_trigger_.num_pre_sent = 0;
+        glo_capture_trigger.publish(&capture_trigger_);
+
+        capture_ring_.reset(max_samples_, (capture_command_.stream != 0) && !trigger_.isArmed());
+        capture_encoder_.startBlock();
+        last_instance_samples_ = 0;
+
+        // Filter out what's too fast for the capture rate unless the GUI wants every Nth sample as it is.
+        // Same factor as throttleHz() would use.
+        uint16_t factor = (capture_command_.frequency == 0) ? 1 : (uint16_t)(this->frequency_ / capture_command_.frequency);
+        capture_decimator_.configure(capture_gather_.numChannels(), capture_command_.unfiltered ? 1 : factor);
+
+        // Send what the GUI needs to decode the samples, in case it's changed since they were set.
+        send_task.send(glo_capture_channels.get_id());
         debug_printf("I'm starting to collect data.");
     }
 
     // Check if we need to stop sending data because our buffer is full or user wants to stop.
-    bool buffer_full = (capture_counter_ >= max_samples_);
-    bool have_desired_samples = (capture_counter_ >= capture_command_.desired_samples);
-    if (currently_capturing_data && (buffer_full || have_desired_samples))
+    // When streaming the buffer never fills up since the telemetry stream task is sending it out.
+    // A triggered capture goes until it has the samples after the trigger, however long that takes.
+    bool triggered_capture = (capture_trigger_.state == TRIGGER_STATE_ARMED) ||
+                             (capture_trigger_.state == TRIGGER_STATE_TRIGGERED);
+    bool buffer_full = !capture_ring_.isStreaming() && !triggered_capture && (capture_counter_ >= captureCapacity());
+    bool have_desired_samples = !triggered_capture && (capture_counter_ >= capture_command_.desired_samples);
+    bool have_post_samples = (capture_trigger_.state == TRIGGER_STATE_TRIGGERED) &&
+                             (capture_counter_ >= trigger_sample_ + capture_trigger_.post_samples);
+    if (currently_capturing_data && (buffer_full || have_desired_samples || have_post_samples))
     {
         currently_capturing_data = false;
 
@@ -201,12 +308,34 @@ void MainControlTask::runDataCapture(void)
         glo_capture_command.publish(&capture_command_);
     }
 
-    if (!currently_capturing_data && capturing_data_ && (capture_counter_ > 0))
+    // Publish the last samples even if they don't fill an instance.
+    if (!currently_capturing_data && capturing_data_ && (capture_encoder_.numInBlock() > 0))
+    {
+        publishCaptureData();
+        capture_encoder_.startBlock();
+    }
+
+    if (!currently_capturing_data && capturing_data_ && capture_ring_.isStreaming())
+    {
+        // Samples have been going out the whole time.  The stream task sends back the command once the
+        // rest are sent, so the UI knows how many made it into the buffer (i.e. weren't overrun).
+        debug_printf("I collected %d data samples, %d overran.", capture_counter_, capture_ring_.numOverruns());
+        uint32_t num_written = capture_ring_.numWritten();
+        capture_command_.total_samples = (num_written == 0) ? 0 :
+            (num_written - 1) * capture_channels_.samples_per_instance + last_instance_samples_;
+        glo_capture_command.publish(&capture_command_);
+        capture_ring_.finish();
+    }
+    else if (!currently_capturing_data && capturing_data_ && triggered_capture)
+    {
+        sendTriggeredCapture();
+    }
+    else if (!currently_capturing_data && capturing_data_ && (capture_counter_ > 0))
     {
         // Just stopped taking data so first send send back all captured data instances.
         // then send back packet telling UI how many samples it should've gotten.
         debug_printf("I collected %d data samples.", capture_counter_);
-        send_task.send(glo_capture_data.get_id(), 1, capture_counter_);
+        send_task.send(glo_capture_data.get_id(), 1, capture_ring_.numWritten());
         capture_command_.total_samples = capture_counter_;
         glo_capture_command.publish(&capture_command_);
         send_task.send(glo_capture_command.get_id());
@@ -217,30 +346,77 @@ void MainControlTask::runDataCapture(void)
 
     if (currently_capturing_data)
     {
-        if (throttleHz(capture_command_.frequency))
+        float values[CAPTURE_MAX_CHANNELS];
+        bool filtered = (capture_decimator_.factor() > 1);
+        bool take_sample = false;
+        if (filtered)
+        {
+            // Every run goes through the filter, which says which ones to keep.
+            float inputs[CAPTURE_MAX_CHANNELS];
+            capture_gather_.read();
+            for (uint8_t i = 0; i < capture_gather_.numChannels(); ++i)
+            {
+                inputs[i] = capture_gather_.value(i);
+            }
+            take_sample = capture_decimator_.add(inputs, values);
+        }
+        else if (throttleHz(capture_command_.frequency))
+        {
+            // Read in globs that are only used for data capture.
+            capture_gather_.read();
+            for (uint8_t i = 0; i < capture_gather_.numChannels(); ++i)
+            {
+                values[i] = capture_gather_.value(i);
+            }
+            take_sample = true;
+        }
+
+        if (take_sample)
         {
             if (capture_counter_ == 0)
             {
-                // Reset capture run counts here so first timestamp will be 0 seconds.
+                // Reset capture run counts here so first timestamp will be 0 seconds (less the filter delay).
                 capture_run_counts_ = 0;
             }
 
-            // Read in globs that are only used for data capture.
-            // -- none right now
-
-            capture_data_.time = delta_t_ * capture_run_counts_;
-            capture_data_.d1 = roll_pitch_yaw_.rpy[1]; // robot tilt (i.e. pitch)
-            capture_data_.d2 = wave_.value;
-            capture_data_.d3 = motor_pwm_.left_duty;
-            capture_data_.d4 = motor_pwm_.right_duty;
-            capture_data_.d5 = odometry_.left_distance;
-            capture_data_.d6 = odometry_.right_distance;
-            capture_data_.d7 = odometry_.left_speed;
-            capture_data_.d8 = odometry_.right_speed;
-
-            // Use capture counter as instance number to publish to.
-            // Need to add one because instance numbers are indexed from 1.
-            glo_capture_data.publish(&capture_data_, capture_counter_ + 1);
+            // Filtered samples are from the middle of the inputs that went into them.
+            float sample_time = delta_t_ * (capture_run_counts_ - capture_decimator_.delay());
+
+            if (capture_channels_.format == CAPTURE_FORMAT_RAW)
+            {
+                capture_data_.time = sample_time;
+                if (filtered)
+                {
+                    capture_gather_.pack(values, capture_data_.data);
+                }
+                else
+                {
+                    capture_gather_.gather(capture_data_.data);
+                }
+                publishCaptureData();
+            }
+            else
+            {
+                // Only the first sample in an instance has its time.
+                if (capture_encoder_.numInBlock() == 0)
+                {
+                    capture_data_.time = sample_time;
+                }
+
+                if (capture_encoder_.add(values, capture_data_.data))
+                {
+                    publishCaptureData();
+                }
+            }
+
+            if (trigger_.check(values, send_task.numAsserts()))
+            {
+                // Let the GUI know right away since the samples after it could take a while.
+                trigger_sample_ = capture_counter_;
+                capture_trigger_.state = TRIGGER_STATE_TRIGGERED;
+                glo_capture_trigger.publish(&capture_trigger_);
+                send_task.send(glo_capture_trigger.get_id());
+            }
 
             ++capture_counter_;
         }
@@ -250,23 +426,193 @@ void MainControlTask::runDataCapture(void)
     }
 }
 
+//******************************************************************************
+void MainControlTask::publishCaptureData(void)
+{
+    // Ring buffer only wraps when streaming or waiting for a trigger, otherwise this is the number of
+    // instances published plus one (since instance numbers are indexed from 1).  Zero if sending has
+    // fallen too far behind.
+    uint16_t instance = capture_ring_.nextInstance();
+    if (instance != 0)
+    {
+        glo_capture_data.publish(&capture_data_, instance);
+        capture_ring_.written();
+
+        uint8_t num_in_block = capture_encoder_.numInBlock();
+        last_instance_samples_ = (num_in_block == 0) ? capture_channels_.samples_per_instance : num_in_block;
+    }
+}
+
+//******************************************************************************
+void MainControlTask::sendTriggeredCapture(void)
+{
+    // Keep up to the pre-trigger samples that are still in the ring and everything after the trigger.
+    // If it was stopped before it triggered then send what would've been kept if it triggered just now.
+    // Ring numbers count instances, which can hold more than one sample.
+    uint32_t samples_per_instance = capture_channels_.samples_per_instance;
+    uint32_t end = capture_ring_.numWritten();
+    uint32_t oldest = capture_ring_.oldest();
+    uint32_t last_sample = (capture_trigger_.state == TRIGGER_STATE_TRIGGERED) ? trigger_sample_ : capture_counter_;
+    uint32_t first_sample = last_sample - min(last_sample, (uint32_t)capture_trigger_.pre_samples);
+    uint32_t first = max(oldest, first_sample / samples_per_instance);
+    capture_trigger_.num_pre_sent = last_sample - first * samples_per_instance;
+    trigger_.disarm();
+
+    uint32_t num_samples = capture_counter_ - first * samples_per_instance;
+    debug_printf("I collected %d data samples, sending %d around the trigger.", capture_counter_, num_samples);
+
+    // The samples wrap around the end of the ring if the history did, so send them in time order.
+    if (end > first)
+    {
+        uint16_t first_instance = capture_ring_.instanceOf(first);
+        uint16_t last_instance = capture_ring_.instanceOf(end - 1);
+        if (first_instance <= last_instance)
+        {
+            send_task.send(glo_capture_data.get_id(), first_instance, last_instance);
+        }
+        else
+        {
+            send_task.send(glo_capture_data.get_id(), first_instance, capture_ring_.size());
+            send_task.send(glo_capture_data.get_id(), 1, last_instance);
+        }
+    }
+
+    capture_trigger_.state = TRIGGER_STATE_DONE;
+    glo_capture_trigger.publish(&capture_trigger_);
+    send_task.send(glo_capture_trigger.get_id());
+
+    capture_command_.total_samples = num_samples;
+    glo_capture_command.publish(&capture_command_);
+    send_task.send(glo_capture_command.get_id());
+}
+
 //******************************************************************************
 void MainControlTask::handle(glo_capture_command_t & command)
 {
-    // Validate request command settings.
-    command.desired_samples = limit(command.desired_samples, (uint32_t)1, (uint32_t)max_samples_);
+    // Validate request command settings.  Streaming is only limited by how fast samples can be sent.
+    if (!command.stream)
+    {
+        command.desired_samples = limit(command.desired_samples, (uint32_t)1, captureCapacity());
+    }
+    else if (command.desired_samples == 0)
+    {
+        command.desired_samples = UINT32_MAX; // until stopped
+    }
 
     if ((command.frequency == 0) || (command.frequency > max_samples_))
     {
         command.frequency = this->frequency_; // set to task frequency
     }
 
+    // The filter can only keep aliasing out down to so many runs per sample (see CaptureDecimator), so
+    // filtered captures can't be slower than that.  The command sent back has the rate that's used.
+    uint16_t min_filtered_frequency = (uint16_t)ceilf(this->frequency_ / DECIMATOR_MAX_FACTOR);
+    if (!command.unfiltered && (command.frequency < min_filtered_frequency))
+    {
+        debug_printf("Filtered captures can't be slower than %d Hz.", min_filtered_frequency);
+        command.frequency = min_filtered_frequency;
+    }
+
     // Scale the desired frequency to the closest frequency that can be achieved based on how fast task is running.
     int32_t scale = int32_t(this->frequency_ / command.frequency);
     command.frequency = (uint16_t)(this->frequency_ / scale);
 
+    // Called from other tasks so don't let this task run in the middle of updating the command.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
     capture_command_ = command;
     glo_capture_command.publish(&command);
+    scheduler.restorePreemptiveTasks(preemptive_state);
+}
+
+//******************************************************************************
+void MainControlTask::handle(glo_capture_channels_t & channels)
+{
+    // Called from other tasks so don't let this task capture a sample in the middle of switching.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
+    if (capturing_data_ || capture_ring_.isStreaming())
+    {
+        capture_channels_.status = CAPTURE_CHANNELS_BUSY;
+        capture_channels_.bad_channel = 0;
+        glo_capture_channels.publish(&capture_channels_);
+    }
+    else
+    {
+        setCaptureChannels(channels);
+    }
+    scheduler.restorePreemptiveTasks(preemptive_state);
+
+    send_task.send(glo_capture_channels.get_id());
+}
+
+//******************************************************************************
+void MainControlTask::handle(glo_capture_trigger_t & trigger)
+{
+    // Everything from before and after the trigger has to fit in the ring at once.
+    bool valid = GlobTrigger::isValid(trigger, capture_gather_) &&
+                 ((trigger.source == TRIGGER_SOURCE_NONE) ||
+                  ((trigger.post_samples > 0) && ((uint32_t)trigger.pre_samples + trigger.post_samples <= max_samples_)));
+
+    // Called from other tasks so don't let this task arm the trigger in the middle of updating it.
+    // Rejected settings are sent back as the ones still being used.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
+    if (capturing_data_ || capture_ring_.isStreaming() || !valid)
+    {
+        glo_capture_trigger_t rejected = capture_trigger_;
+        rejected.state = TRIGGER_STATE_REJECTED;
+        glo_capture_trigger.publish(&rejected);
+    }
+    else
+    {
+        capture_trigger_ = trigger;
+        capture_trigger_.num_pre_sent = 0;
+        capture_trigger_.state = TRIGGER_STATE_IDLE;
+        glo_capture_trigger.publish(&capture_trigger_);
+    }
+    scheduler.restorePreemptiveTasks(preemptive_state);
+
+    send_task.send(glo_capture_trigger.get_id());
+}
+
+//******************************************************************************
+void MainControlTask::setCaptureChannels(glo_capture_channels_t & channels)
+{
+    if (channels.num_channels == 0)
+    {
+        memset(&channels, 0, sizeof(channels));
+        add_capture_channel(channels, GLO_ID_ROLL_PITCH_YAW, offsetof(glo_roll_pitch_yaw_t, rpy[1])); // robot tilt (i.e. pitch)
+        add_capture_channel(channels, GLO_ID_WAVE, offsetof(glo_wave_t, value));
+        add_capture_channel(channels, GLO_ID_MOTOR_PWM, offsetof(glo_motor_pwm_t, left_duty));
+        add_capture_channel(channels, GLO_ID_MOTOR_PWM, offsetof(glo_motor_pwm_t, right_duty));
+        add_capture_channel(channels, GLO_ID_ODOMETRY, offsetof(glo_odometry_t, left_distance));
+        add_capture_channel(channels, GLO_ID_ODOMETRY, offsetof(glo_odometry_t, right_distance));
+        add_capture_channel(channels, GLO_ID_ODOMETRY, offsetof(glo_odometry_t, left_speed));
+        add_capture_channel(channels, GLO_ID_ODOMETRY, offsetof(glo_odometry_t, right_speed));
+    }
+
+    // Check the format first since compiling replaces the old channels.
+    CaptureEncoder encoder;
+    bool quantized = (channels.format != CAPTURE_FORMAT_RAW);
+    bool format_ok = (channels.format < NUM_CAPTURE_FORMATS) &&
+                     (!quantized || encoder.configure(channels.num_channels, channels.scale, channels.zero,
+                                                      channels.format == CAPTURE_FORMAT_INT16_DELTA, CAPTURE_MAX_CHANNEL_BYTES));
+
+    // Rejected channels are sent back with the ones that are still being captured.
+    uint8_t bad_channel = 0;
+    glo_capture_channels_status_t status = format_ok ? capture_gather_.compile(channels, &bad_channel) :
+                                                       (glo_capture_channels_status_t)CAPTURE_CHANNELS_BAD_FORMAT;
+    if (status == CAPTURE_CHANNELS_OK)
+    {
+        capture_channels_ = channels;
+        capture_encoder_ = encoder;
+        capture_channels_.samples_per_instance = quantized ? encoder.samplesPerBlock() : 1;
+        uint16_t data_bytes = quantized ? encoder.usedBytes() : capture_gather_.sampleBytes();
+        glo_capture_data.set_send_size(offsetof(glo_capture_data_t, data) + data_bytes);
+    }
+    capture_channels_.status = status;
+    capture_channels_.bad_channel = bad_channel;
+    capture_channels_.sample_bytes = glo_capture_data.get_send_size();
+
+    glo_capture_channels.publish(&capture_channels_);
 }
 
 //******************************************************************************
@@ -286,22 +632,29 @@ void MainControlTask::handle(glo_wave_t & wave)
 
     // TODO calculate trapezoidal coefficients
 
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
     wave_ = wave;
     glo_wave.publish(&wave);
+    scheduler.restorePreemptiveTasks(preemptive_state);
 }
 
 //******************************************************************************
 void MainControlTask::handle_balance_tilt_gains(glo_pid_params_t & tilt_params)
 {
+    // Update both gains together so the balance loop never runs with a mismatched pair.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
     K_[0] = tilt_params.kp;
     K_[1] = tilt_params.kd;
+    scheduler.restorePreemptiveTasks(preemptive_state);
 }
 
 //******************************************************************************
 void MainControlTask::handle_balance_position_gains(glo_pid_params_t & position_params)
 {
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
     K_[2] = position_params.kp;
     K_[3] = position_params.kd;
+    scheduler.restorePreemptiveTasks(preemptive_state);
 }
 
 //******************************************************************************
@@ -331,6 +684,9 @@ void MainControlTask::get_balance_position_gains(glo_pid_params_t & position_par
 //******************************************************************************
 void MainControlTask::reset(void)
 {
+    // Called from the modes task so don't let this task run with half reset filters.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
+
     left_encoder_.set(0);
     right_encoder_.set(0);
     left_deriv_.reset();
@@ -340,4 +696,6 @@ void MainControlTask::reset(void)
     beta_deriv_.reset();
     distance_command_ = 0.0f;
     yaw_command_ = 0.0f;
+
+    scheduler.restorePreemptiveTasks(preemptive_state);
 }
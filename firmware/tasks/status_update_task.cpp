@@ -3,6 +3,7 @@
 #include "globs.h"
 #include "math_util.h"
 #include "physical_constants.h"
+#include "processor_id.h"
 #include "robot_settings.h"
 #include "telemetry_send_task.h"
 #include "util_assert.h"
@@ -14,16 +15,22 @@ StatusUpdateTask::StatusUpdateTask(float frequency) :
 {
 }
 
+//******************************************************************************
+void StatusUpdateTask::initialize(void)
+{
+    snapshot_.add(glo_status_data, &status_data_);
+    snapshot_.add(glo_roll_pitch_yaw, &roll_pitch_yaw_);
+    snapshot_.add(glo_odometry, &odometry_);
+    snapshot_.add(glo_modes, &modes_);
+    snapshot_.add(glo_analog, &analog_);
+    snapshot_.add(glo_motor_pwm, &motor_pwm_);
+}
+
 //******************************************************************************
 void StatusUpdateTask::readNewData(void)
 {
     // Read in data needed to send status data to user.
-    glo_status_data.read(&status_data_);
-    glo_roll_pitch_yaw.read(&roll_pitch_yaw_);
-    glo_odometry.read(&odometry_);
-    glo_modes.read(&modes_);
-    glo_analog.read(&analog_);
-    glo_motor_pwm.read(&motor_pwm_);
+    snapshot_.read();
 }
 
 //******************************************************************************
@@ -61,7 +68,7 @@ void StatusUpdateTask::run(void)
     status_data_.left_pwm = motor_pwm_.left_duty;
     status_data_.right_pwm = motor_pwm_.right_duty;
     status_data_.firmware_version = FIRMWARE_VERSION;
-    memcpy(status_data_.processor_id, (void *)0x1FFF7A10, 12);
+    read_processor_id(status_data_.processor_id);
 
     publishNewData();
 }
@@ -6,12 +6,14 @@
 #include "modes_task.h"
 #include "robot_settings.h"
 #include "telemetry_send_task.h"
+#include "telemetry_stream_task.h"
 #include "util_assert.h"
 
 //******************************************************************************
 TelemetryReceiveTask::TelemetryReceiveTask(void) :
       Task("Receive", TASK_ID_TELEM_RECEIVE),
       glo_rx_link_(NULL),
+      parse_budget_cycles_(0),
       bus_(USART_BUS_2),
       serial_port_(NULL)
 {
@@ -33,6 +35,15 @@ void TelemetryReceiveTask::initialize(void)
     glo_rx_link_ = new GloRxLink(serial_port_, newMessageCallback);
     assert(glo_rx_link_ != NULL, ASSERT_STOP);
 
+    parse_budget_cycles_ = (uint32_t)(RECEIVE_PARSE_BUDGET * sys_timer.frequency());
+
+    // Always start out in the original framing so a GUI that doesn't know about link modes still works.
+    glo_link_mode_t link_mode;
+    link_mode.framing = LINK_FRAMING_START_BYTE;
+    link_mode.batch_frames = (TELEMETRY_BATCH_MTU > 0);
+    link_mode.reliable_bulk = false;
+    glo_link_mode.publish(&link_mode);
+
     syncPidParameters();
 }
 
@@ -45,10 +56,10 @@ bool TelemetryReceiveTask::needToRun(void)
 //******************************************************************************
 void TelemetryReceiveTask::run(void)
 {
-    // Parse any received data to try to form a complete message.
-    // If a message is received then it is immediately handled in new message callback.
-    // This will only parse one byte to make sure task returns quickly.
-    glo_rx_link_->parse();
+    // Parse all received data to form complete messages, which are immediately handled in
+    // new message callback.  Stops early if it takes too long so other tasks aren't delayed.
+    // Anything left over will be parsed the next time since the task is still ready to run.
+    glo_rx_link_->parseAvailable(parse_budget_cycles_);
 }
 
 //******************************************************************************
@@ -78,6 +89,21 @@ void TelemetryReceiveTask::newMessageCallback(uint8_t object_id, uint16_t instan
         case GLO_ID_REQUEST:
             receive_task.handle(*((glo_request_t *)glob_data), instance);
             break;
+        case GLO_ID_LINK_MODE:
+            receive_task.handle(*((glo_link_mode_t *)glob_data));
+            break;
+        case GLO_ID_BULK_ACK:
+            send_task.handle(*((glo_bulk_ack_t *)glob_data));
+            break;
+        case GLO_ID_CAPTURE_CHANNELS:
+            main_control_task.handle(*((glo_capture_channels_t *)glob_data));
+            break;
+        case GLO_ID_CAPTURE_TRIGGER:
+            main_control_task.handle(*((glo_capture_trigger_t *)glob_data));
+            break;
+        case GLO_ID_STREAM_SUBSCRIPTION:
+            stream_task.handle(*((glo_stream_subscription_t *)glob_data), instance);
+            break;
         default:
             assert_always_msg(ASSERT_CONTINUE, "Received unhandled glob with id: %d", object_id);
             break;
@@ -159,6 +185,9 @@ void TelemetryReceiveTask::handle(glo_pid_params_t & params, uint16_t instance)
 {
     uint16_t controller_id = instance-1;
 
+    // Main control task can preempt this task so don't let it run with partially updated parameters.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
+
     switch (controller_id)
     {
         case PID_ID_LEFT_SPEED_CONTROLLER:
@@ -189,6 +218,8 @@ void TelemetryReceiveTask::handle(glo_pid_params_t & params, uint16_t instance)
             assert_always_msg(ASSERT_CONTINUE, "No PID controller with ID %d", (int)controller_id);
     }
 
+    scheduler.restorePreemptiveTasks(preemptive_state);
+
     glo_pid_params.publish(&params, instance);
 }
 
@@ -197,6 +228,8 @@ void TelemetryReceiveTask::syncPidParameters(void)
 {
     glo_pid_params_t params[NUM_PID_CONTROLLERS];
 
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
+
     main_control_task.left_speed_pid.get(params[PID_ID_LEFT_SPEED_CONTROLLER]);
     main_control_task.right_speed_pid.get(params[PID_ID_RIGHT_SPEED_CONTROLLER]);
     main_control_task.yaw_pid.get(params[PID_ID_YAW_CONTROLLER]);
@@ -206,6 +239,8 @@ void TelemetryReceiveTask::syncPidParameters(void)
     main_control_task.left_position_pid.get(params[PID_ID_LEFT_POSITION_CONTROLLER]);
     main_control_task.right_position_pid.get(params[PID_ID_RIGHT_POSITION_CONTROLLER]);
 
+    scheduler.restorePreemptiveTasks(preemptive_state);
+
     for (uint16_t i = 0; i < NUM_PID_CONTROLLERS; ++i)
     {
         glo_pid_params.publish(&params[i], i+1);
@@ -237,3 +272,20 @@ void TelemetryReceiveTask::handle(glo_request_t & msg, uint16_t instance)
         send_task.send(msg.requested_id, instance);
     }
 }
+
+//******************************************************************************
+void TelemetryReceiveTask::handle(glo_link_mode_t & mode)
+{
+    if (mode.framing >= NUM_LINK_FRAMINGS)
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Invalid link framing %d", (int)mode.framing);
+        return;
+    }
+
+    glo_link_mode.publish(&mode);
+
+    // Receive in the new mode right away since the GUI switches as soon as it gets the reply.
+    // The send task switches once it has sent the reply in the old mode.
+    glo_rx_link_->setFraming(mode.framing);
+    send_task.send(GLO_ID_LINK_MODE);
+}
@@ -8,39 +8,151 @@
 
 //******************************************************************************
 TelemetrySendTask::TelemetrySendTask(uint32_t queue_size) :
-        QueuedTask<glob_queue_t>("Send", TASK_ID_TELEM_SEND, queue_size),
+        Task("Send", TASK_ID_TELEM_SEND),
         glo_tx_link_(NULL),
         bus_(USART_BUS_2),
         serial_port_(NULL),
-        save_buffer_(15),
+        save_buffer_(TELEMETRY_SAVE_BUFFER_BYTES),
+        batch_mtu_(TELEMETRY_BATCH_MTU),
+        refill_ticks_(0),
+        shaping_enabled_(true),
+        next_run_ticks_(0),
+        next_transfer_id_(0),
+        reliable_bulk_(false),
+        stats_start_ticks_(0),
         next_assert_instance_(1),
-        next_debug_instance_(1)
+        next_debug_instance_(1),
+        num_asserts_(0)
 {
+    // Runs as soon as something is queued, or on a timer once there's room in the transfer buffer.
+    ready_source_ = Scheduler::READY_SOURCE_TIMER;
+
+    for (telemetry_class_t i = 0; i < NUM_TELEMETRY_CLASSES; ++i)
+    {
+        queues_[i] = new GlobQueue(queue_size);
+        budgets_[i] = 0;
+        bytes_sent_[i] = 0;
+        max_queue_depth_[i] = 0;
+        num_dropped_[i] = 0;
+    }
 }
 
 //******************************************************************************
 bool TelemetrySendTask::send_copy(uint8_t id, uint16_t instance)
 {
-    // Request a spot to save data.  If there aren't any available then it won't be saved
+    // Request just enough room to save the data.  If there isn't any then it won't be saved
     // and when it comes time to send it will just send what's currently stored.
-    array_idx_t storage_idx = INVALID_ARRAY_INDEX;
-    void * storage_buffer = save_buffer_.requestStorage(&storage_idx);
+    // Disable interrupts since tasks in the preemptive tier can send copies too.
+    bool enabled = scheduler.disableInterrupts();
+    void * storage_buffer = save_buffer_.allocate(globs[id]->get_num_bytes());
+    scheduler.restoreInterrupts(enabled);
     globs[id]->copy_to_buffer(storage_buffer, instance);
-    assert_msg(storage_idx != INVALID_ARRAY_INDEX, ASSERT_CONTINUE, "Telem save buffer too small.");
 
-    glob_queue_t new_element(id, instance, 0, storage_idx);
+    // Reporting an assert message that didn't fit would need another spot, and so on forever.
+    assert_msg((storage_buffer != NULL) || (id == GLO_ID_ASSERT_MESSAGE), ASSERT_CONTINUE, "Telem save buffer too small.");
 
-    return enqueue(new_element);
+    glob_queue_t new_element(id, instance, 0, storage_buffer);
+
+    if (!enqueue(new_element))
+    {
+        // Won't be sent so don't hold on to the copy.
+        enabled = scheduler.disableInterrupts();
+        save_buffer_.free(storage_buffer);
+        scheduler.restoreInterrupts(enabled);
+        return false;
+    }
+
+    return true;
 }
 
 //******************************************************************************
 bool TelemetrySendTask::send(uint8_t id, uint16_t instance, uint16_t stop_instance)
 {
-    glob_queue_t new_element(id, instance, stop_instance, INVALID_ARRAY_INDEX);
+    bool reliable = reliable_bulk_ && (stop_instance != 0) && (stop_instance >= instance);
+    glob_queue_t new_element(id, instance, stop_instance, NULL, reliable);
 
     return enqueue(new_element);
 }
 
+//******************************************************************************
+uint32_t TelemetrySendTask::numQueued(void) const
+{
+    uint32_t num_queued = 0;
+    for (telemetry_class_t i = 0; i < NUM_TELEMETRY_CLASSES; ++i)
+    {
+        num_queued += queues_[i]->count();
+    }
+    return num_queued;
+}
+
+//******************************************************************************
+bool TelemetrySendTask::enqueue(glob_queue_t & glob)
+{
+    telemetry_class_t glob_class = classify(glob);
+    GlobQueue * queue = queues_[glob_class];
+
+    // Globs are sent from every tier so keep the stats consistent with the queue.
+    bool enabled = scheduler.disableInterrupts();
+    bool success = queue->enqueue(glob);
+    if (!success)
+    {
+        num_dropped_[glob_class]++;
+    }
+    else if (queue->count() > max_queue_depth_[glob_class])
+    {
+        max_queue_depth_[glob_class] = queue->count();
+    }
+    scheduler.restoreInterrupts(enabled);
+
+    if (success)
+    {
+        // Let the scheduler know right away instead of waiting for it to check the queue.
+        scheduler.setTaskReady(*this);
+    }
+
+    return success;
+}
+
+//******************************************************************************
+telemetry_class_t TelemetrySendTask::classify(glob_queue_t const & glob) const
+{
+    switch (glob.id)
+    {
+        case GLO_ID_ASSERT_MESSAGE:
+        case GLO_ID_LINK_MODE:
+        case GLO_ID_BULK_TRANSFER:
+            return TELEMETRY_CLASS_CRITICAL;
+
+        case GLO_ID_DEBUG_MESSAGE:
+        case GLO_ID_TASK_TIMING:
+        case GLO_ID_CAPTURE_DATA:
+            return TELEMETRY_CLASS_BULK;
+    }
+
+    if (glob.stop_instance > glob.instance)
+    {
+        return TELEMETRY_CLASS_BULK; // e.g. every instance of a glob was requested.
+    }
+
+    return TELEMETRY_CLASS_CONTROL;
+}
+
+//******************************************************************************
+uint32_t TelemetrySendTask::linkBytesPerSecond(void) const
+{
+    // 8N1 so 10 bits per byte.  The port might not be setup yet, but the baud rate is.
+    return Usart::instance(bus_)->baudrate() / 10;
+}
+
+//******************************************************************************
+void TelemetrySendTask::pollTransfer(void)
+{
+    if (serial_port_ != NULL)
+    {
+        serial_port_->pollTx();
+    }
+}
+
 //******************************************************************************
 void TelemetrySendTask::initialize(void)
 {
@@ -54,44 +166,433 @@ void TelemetrySendTask::initialize(void)
 
     glo_tx_link_ = new GloTxLink(serial_port_);
     assert(glo_tx_link_ != NULL, ASSERT_STOP);
+
+    refill_ticks_ = stats_start_ticks_ = scheduler.currentTicks();
+}
+
+//******************************************************************************
+bool TelemetrySendTask::needToRun(void)
+{
+    if (glo_tx_link_ == NULL)
+    {
+        return false; // not initialized yet
+    }
+
+    uint16_t room = 0;
+    uint16_t shortfall = 0;
+    return nextClass(&room, &shortfall) < NUM_TELEMETRY_CLASSES;
 }
 
 //******************************************************************************
 void TelemetrySendTask::run(void)
 {
-    glob_queue_t glob;
-    if (queue_.peak(&glob))
+    refillBudgets();
+
+    updateStats();
+
+    uint16_t room = 0;
+    uint16_t shortfall = 0;
+    telemetry_class_t glob_class = nextClass(&room, &shortfall);
+    if (glob_class >= NUM_TELEMETRY_CLASSES)
+    {
+        return; // nothing queued or waiting for room in the transfer buffer
+    }
+
+    uint32_t bytes_before = glo_tx_link_->numBytesSent();
+
+    sendFrom(glob_class, room);
+
+    uint32_t num_bytes = glo_tx_link_->numBytesSent() - bytes_before;
+    budgets_[glob_class] -= num_bytes;
+    bytes_sent_[glob_class] += num_bytes;
+}
+
+//******************************************************************************
+void TelemetrySendTask::decideWhenToRunNext(void)
+{
+    Task::decideWhenToRunNext();
+
+    // Send again if the GUI doesn't acknowledge the reliable bulk transfer in time.
+    next_run_ticks_ = bulk_transfer_.timeoutTicks();
+
+    uint16_t room = 0;
+    uint16_t shortfall = 0;
+    if ((glo_tx_link_ == NULL) || (nextClass(&room, &shortfall) < NUM_TELEMETRY_CLASSES) || (shortfall == 0))
+    {
+        return; // either runs again right away or nothing is waiting on the DMA
+    }
+
+    // Check again once the DMA should have sent enough to make room.  8N1 so 10 bits per byte.
+    uint32_t bytes_per_second = serial_port_->baudrate() / 10;
+    uint64_t wait_ticks = (uint64_t)shortfall * sys_timer.frequency() / bytes_per_second + 1;
+    uint64_t room_ticks = scheduler.currentTicks() + wait_ticks;
+    if (room_ticks < next_run_ticks_)
+    {
+        next_run_ticks_ = room_ticks;
+    }
+}
+
+//******************************************************************************
+telemetry_class_t TelemetrySendTask::nextClass(uint16_t * room, uint16_t * shortfall)
+{
+    telemetry_class_t over_budget_class = NUM_TELEMETRY_CLASSES;
+    uint16_t over_budget_room = 0;
+    *shortfall = 0;
+
+    // Scan mode polls this every pass, so don't mask interrupts to check the DMA and peak at the
+    // queues when nothing's queued.  The counts can be read without locking.
+    if (numQueued() == 0)
+    {
+        *room = 0;
+        return NUM_TELEMETRY_CLASSES;
+    }
+
+    uint16_t free_space = serial_port_->freeSpace();
+
+    // Only one glob can be sent in fragments at a time, so if one was partly sent then don't start
+    // another until it's done (as long as it's still queued).
+    bool fragments_queued = false;
+    for (telemetry_class_t i = 0; i < NUM_TELEMETRY_CLASSES; ++i)
+    {
+        glob_queue_t glob;
+        if (queues_[i]->peak(&glob) && glo_tx_link_->sendingFragments(glob.id, glob.instance))
+        {
+            fragments_queued = true;
+        }
+    }
+
+    for (telemetry_class_t i = 0; i < NUM_TELEMETRY_CLASSES; ++i)
     {
-        // The ID signifying the result (e.g. success, failure) from sending the current glob.
-        int send_result;
+        glob_queue_t glob;
+        if (!queues_[i]->peak(&glob))
+        {
+            continue;
+        }
 
-        if (glob.storage_idx != INVALID_ARRAY_INDEX)
+        if (fragments_queued && glo_tx_link_->needsFragments(glob.id) &&
+            !glo_tx_link_->sendingFragments(glob.id, glob.instance))
         {
-            // The glob data was saved so read it back out and send it.
-            void * saved_data = save_buffer_.reference(glob.storage_idx);
-            send_result = glo_tx_link_->send(glob.id, glob.instance, saved_data);
-            save_buffer_.remove(glob.storage_idx);
+            continue;
         }
-        else // just send what's currently stored in glob.
+
+        if (glob.reliable && shaping_enabled_ && !reliableReady())
         {
-            send_result = glo_tx_link_->send(glob.id, glob.instance);
+            continue; // waiting on the GUI to acknowledge what's been sent
         }
 
-        if (send_result != SEND_ERROR_NO_ROOM)
+        uint16_t headroom = shaping_enabled_ ? TELEMETRY_CLASS_HEADROOM[i] : 0;
+        uint16_t needed = glo_tx_link_->frameSize(glob.id);
+
+        // If more than one glob is waiting then wait for room to batch them, otherwise a long range
+        // request trickles out one glob per frame as fast as the DMA makes room for each one.
+        // Reliable transfers are always sent in batches, even a range of one.
+        bool batchable = (queues_[i]->count() > 1) || (glob.stop_instance > glob.instance) || glob.reliable;
+        if (shaping_enabled_ && batchable && (batch_mtu_ > 0))
         {
-            // Remove element since we either sent it or won't be able to send it.
-            queue_.remove();
+            uint16_t batch_needed = batch_mtu_ + glo_tx_link_->framingOverhead();
+            needed = (batch_needed > needed) ? batch_needed : needed;
+        }
 
-            // Check if we need to keep sending more instances of this glob.
-            // This just puts another element in the queue so it lets the task return quickly.
-            // Need to put in front of the queue because some messages rely on being sent all at once.
-            if ((glob.stop_instance > 0) && (glob.stop_instance > glob.instance))
+        needed += headroom;
+        if (free_space < needed)
+        {
+            // Wait for the DMA to catch up.
+            if ((*shortfall == 0) || (needed - free_space < *shortfall))
             {
-                glob_queue_t next_glob(glob.id, glob.instance+1, glob.stop_instance, INVALID_ARRAY_INDEX);
-                queue_.enqueue_front(next_glob);
+                *shortfall = needed - free_space;
             }
+            continue;
+        }
+
+        if (!shaping_enabled_ || (budgets_[i] > 0))
+        {
+            *room = free_space - headroom;
+            return i;
+        }
+
+        if (over_budget_class == NUM_TELEMETRY_CLASSES)
+        {
+            over_budget_class = i;
+            over_budget_room = free_space - headroom;
         }
     }
+
+    // Nothing with budget left can go so don't leave the link idle.
+    *room = over_budget_room;
+    return over_budget_class;
+}
+
+//******************************************************************************
+void TelemetrySendTask::sendFrom(telemetry_class_t glob_class, uint16_t room)
+{
+    GlobQueue * queue = queues_[glob_class];
+
+    glob_queue_t glob;
+    if (!queue->peak(&glob))
+    {
+        return;
+    }
+
+    if (glob.id == GLO_ID_LINK_MODE)
+    {
+        // Reply goes out by itself in the old mode and then everything after it uses the new one.
+        if (sendQueued(glob, false) != SEND_ERROR_NO_ROOM)
+        {
+            finishQueued(glob_class, glob);
+            applyLinkMode();
+        }
+        return;
+    }
+
+    if (glob.reliable)
+    {
+        sendReliable(glob_class, glob, room);
+        return;
+    }
+
+    // A batch only saves anything if there's more than one glob to send.  One that has to be sent
+    // in fragments goes by itself.
+    bool single_glob = ((queue->count() == 1) && (glob.stop_instance <= glob.instance)) ||
+                       glo_tx_link_->needsFragments(glob.id);
+
+    // Only ask for as much of the transfer buffer as the class is allowed to use.
+    uint16_t max_frame_size = room - glo_tx_link_->framingOverhead();
+    if (max_frame_size > batch_mtu_)
+    {
+        max_frame_size = batch_mtu_;
+    }
+
+    if ((batch_mtu_ == 0) || single_glob || !glo_tx_link_->beginBatch(max_frame_size))
+    {
+        // One glob per frame.
+        if (sendQueued(glob, false) != SEND_ERROR_NO_ROOM)
+        {
+            finishQueued(glob_class, glob);
+        }
+        return;
+    }
+
+    // Pack as many globs from the class into the frame as will fit.
+    while (queue->peak(&glob) && (glob.id != GLO_ID_LINK_MODE) && !glob.reliable)
+    {
+        int send_result = sendQueued(glob, true);
+        if (send_result == SEND_ERROR_NO_ROOM)
+        {
+            break;
+        }
+        finishQueued(glob_class, glob);
+    }
+
+    bool nothing_fit = glo_tx_link_->batchEmpty();
+
+    glo_tx_link_->endBatch();
+
+    if (nothing_fit && queue->peak(&glob))
+    {
+        // Batch overhead didn't leave enough room, but it fits on its own.
+        if (sendQueued(glob, false) != SEND_ERROR_NO_ROOM)
+        {
+            finishQueued(glob_class, glob);
+        }
+    }
+}
+
+//******************************************************************************
+void TelemetrySendTask::sendReliable(telemetry_class_t glob_class, glob_queue_t const & glob, uint16_t room)
+{
+    GlobQueue * queue = queues_[glob_class];
+    uint64_t now_ticks = scheduler.currentTicks();
+    glo_bulk_state_t state = bulk_transfer_.state();
+
+    if (!shaping_enabled_ && ((state == BULK_STATE_IDLE) || (state == BULK_STATE_SENDING)))
+    {
+        // Flushing before stopping so no acknowledgements are coming.  Send whatever's left once.
+        uint16_t first = (state == BULK_STATE_SENDING) ? bulk_transfer_.oldestUnacked() : glob.instance;
+        bulk_transfer_.reset();
+        glob_queue_t rest(glob.id, first, glob.stop_instance, NULL);
+        queue->replace_front(rest);
+        return;
+    }
+
+    if (state == BULK_STATE_IDLE)
+    {
+        // Let the GUI know what's coming.  The announcement is critical so it goes before any instances.
+        uint64_t timeout_ticks = (uint64_t)(TELEMETRY_BULK_TIMEOUT * sys_timer.frequency());
+        bulk_transfer_.start(next_transfer_id_++, glob.id, glob.instance, glob.stop_instance,
+                             TELEMETRY_BULK_WINDOW, timeout_ticks, now_ticks);
+        announceTransfer();
+        return;
+    }
+
+    if (state != BULK_STATE_SENDING)
+    {
+        assert_msg(state == BULK_STATE_DONE, ASSERT_CONTINUE, "Bulk transfer of glob %d failed at instance %d.",
+                   (int)glob.id, (int)bulk_transfer_.oldestUnacked());
+        announceTransfer();
+        bulk_transfer_.reset();
+        queue->remove();
+        return;
+    }
+
+    // Only ask for as much of the transfer buffer as the class is allowed to use.
+    uint16_t max_frame_size = room - glo_tx_link_->framingOverhead();
+    if (max_frame_size > batch_mtu_)
+    {
+        max_frame_size = batch_mtu_;
+    }
+
+    // Missing instances are sent first so a batch can hold a few separate records.
+    bool batched = (batch_mtu_ > 0) && !glo_tx_link_->needsFragments(glob.id) && glo_tx_link_->beginBatch(max_frame_size);
+    uint8_t num_timeouts = bulk_transfer_.numTimeouts();
+
+    uint16_t instance = 0;
+    while ((instance = bulk_transfer_.nextInstance(now_ticks)) != 0)
+    {
+        uint8_t send_result = batched ? glo_tx_link_->addToBatch(glob.id, instance) :
+                                        glo_tx_link_->send(glob.id, instance);
+        if (send_result == SEND_ERROR_NO_ROOM)
+        {
+            break;
+        }
+
+        bulk_transfer_.markSent(instance, now_ticks);
+
+        if (!batched)
+        {
+            break;
+        }
+    }
+
+    if (batched)
+    {
+        glo_tx_link_->endBatch();
+    }
+
+    if (bulk_transfer_.numTimeouts() > num_timeouts)
+    {
+        // Nothing's been acknowledged in a while so the GUI might have missed the announcement.
+        announceTransfer();
+    }
+}
+
+//******************************************************************************
+bool TelemetrySendTask::reliableReady(void) const
+{
+    // Starting or finishing a transfer is always ready.
+    return (bulk_transfer_.state() != BULK_STATE_SENDING) || bulk_transfer_.readyToSend(scheduler.currentTicks());
+}
+
+//******************************************************************************
+void TelemetrySendTask::announceTransfer(void)
+{
+    glo_bulk_transfer_t transfer;
+    bulk_transfer_.describe(&transfer);
+    glo_bulk_transfer.publish(&transfer);
+
+    // Copy since the next transfer can start before the end of this one is announced.
+    this->send_copy(glo_bulk_transfer.get_id());
+}
+
+//******************************************************************************
+int TelemetrySendTask::sendQueued(glob_queue_t const & glob, bool batched)
+{
+    // If the glob data was saved then that's sent instead of what's currently stored in glob.
+    if (batched)
+    {
+        return glo_tx_link_->addToBatch(glob.id, glob.instance, glob.data);
+    }
+
+    return glo_tx_link_->send(glob.id, glob.instance, glob.data);
+}
+
+//******************************************************************************
+void TelemetrySendTask::finishQueued(telemetry_class_t glob_class, glob_queue_t const & glob)
+{
+    if (glob.data != NULL)
+    {
+        bool enabled = scheduler.disableInterrupts();
+        save_buffer_.free(glob.data);
+        scheduler.restoreInterrupts(enabled);
+    }
+
+    // Check if we need to keep sending more instances of this glob.
+    // This just updates the element in the queue so it lets the task return quickly.
+    // Needs to stay in front of the queue because some messages rely on being sent all at once, so it's
+    // replaced in place.  Removing it and putting the rest back would let a glob sent from the preemptive
+    // tier take the freed slot in between, which could drop or reorder the rest of the range.
+    if ((glob.stop_instance > 0) && (glob.stop_instance > glob.instance))
+    {
+        glob_queue_t next_glob(glob.id, glob.instance+1, glob.stop_instance, NULL);
+        queues_[glob_class]->replace_front(next_glob);
+        return;
+    }
+
+    // Remove element since we either sent it or won't be able to send it.
+    queues_[glob_class]->remove();
+}
+
+//******************************************************************************
+void TelemetrySendTask::refillBudgets(void)
+{
+    uint64_t now_ticks = scheduler.currentTicks();
+    float elapsed_seconds = (now_ticks - refill_ticks_) / (float)sys_timer.frequency();
+    refill_ticks_ = now_ticks;
+
+    // 8N1 so 10 bits per byte.
+    float link_bytes_per_second = serial_port_->baudrate() / 10.0f;
+
+    for (telemetry_class_t i = 0; i < NUM_TELEMETRY_CLASSES; ++i)
+    {
+        float class_bytes_per_second = TELEMETRY_CLASS_SHARE[i] * link_bytes_per_second;
+        float max_budget = class_bytes_per_second * TELEMETRY_BURST_SECONDS;
+
+        budgets_[i] += class_bytes_per_second * elapsed_seconds;
+        if (budgets_[i] > max_budget)
+        {
+            budgets_[i] = max_budget;
+        }
+    }
+}
+
+//******************************************************************************
+void TelemetrySendTask::updateStats(void)
+{
+    uint64_t now_ticks = scheduler.currentTicks();
+    float elapsed_seconds = (now_ticks - stats_start_ticks_) / (float)sys_timer.frequency();
+    if (elapsed_seconds < TELEMETRY_STATS_PERIOD)
+    {
+        return;
+    }
+
+    glo_telemetry_stats_t stats;
+
+    bool enabled = scheduler.disableInterrupts();
+    for (telemetry_class_t i = 0; i < NUM_TELEMETRY_CLASSES; ++i)
+    {
+        stats.bytes_per_second[i] = bytes_sent_[i] / elapsed_seconds;
+        stats.queue_depth[i] = queues_[i]->count();
+        stats.max_queue_depth[i] = max_queue_depth_[i];
+        stats.num_dropped[i] = num_dropped_[i];
+
+        bytes_sent_[i] = 0;
+        max_queue_depth_[i] = queues_[i]->count();
+    }
+    scheduler.restoreInterrupts(enabled);
+
+    stats_start_ticks_ = now_ticks;
+
+    glo_telemetry_stats.publish(&stats);
+}
+
+//******************************************************************************
+void TelemetrySendTask::applyLinkMode(void)
+{
+    glo_link_mode_t mode;
+    glo_link_mode.read(&mode);
+
+    glo_tx_link_->set_framing(mode.framing);
+    batch_mtu_ = mode.batch_frames ? TELEMETRY_BATCH_MTU : 0;
+    reliable_bulk_ = (mode.reliable_bulk != 0);
 }
 
 //******************************************************************************
@@ -120,20 +621,33 @@ void TelemetrySendTask::send_cached_debug_messages(void)
 bool TelemetrySendTask::handle(glo_assert_message_t & message)
 {
     message.valid = true;
-    glo_assert_message.publish(&message, next_assert_instance_);
-    bool success = this->send_copy(glo_assert_message.get_id(), next_assert_instance_);
+
+    // Messages can come from any task (including preemptive ones) so claim the instance atomically.
+    // The glob doesn't need interrupts disabled to publish so only keep them off while claiming.
+    bool enabled = scheduler.disableInterrupts();
+    uint16_t instance = next_assert_instance_;
     next_assert_instance_ = (next_assert_instance_ % glo_assert_message.get_num_instances()) + 1;
-    return success;
+    num_asserts_++;
+    scheduler.restoreInterrupts(enabled);
+
+    glo_assert_message.publish(&message, instance);
+    return this->send_copy(glo_assert_message.get_id(), instance);
 }
 
 //******************************************************************************
 bool TelemetrySendTask::handle(glo_debug_message_t & message)
 {
     message.valid = true;
-    glo_debug_message.publish(&message, next_debug_instance_);
-    bool success = this->send_copy(glo_debug_message.get_id(), next_debug_instance_);
+
+    // Messages can come from any task (including preemptive ones) so claim the instance atomically.
+    // The glob doesn't need interrupts disabled to publish so only keep them off while claiming.
+    bool enabled = scheduler.disableInterrupts();
+    uint16_t instance = next_debug_instance_;
     next_debug_instance_ = (next_debug_instance_ % glo_debug_message.get_num_instances()) + 1;
-    return success;
+    scheduler.restoreInterrupts(enabled);
+
+    glo_debug_message.publish(&message, instance);
+    return this->send_copy(glo_debug_message.get_id(), instance);
 }
 
 //******************************************************************************
@@ -142,3 +656,13 @@ bool TelemetrySendTask::handle(glo_task_timing_t const & timing)
     glo_task_timing.publish(&timing);
     return this->send_copy(glo_task_timing.get_id());
 }
+
+//******************************************************************************
+void TelemetrySendTask::handle(glo_bulk_ack_t const & ack)
+{
+    if (bulk_transfer_.handleAck(ack, scheduler.currentTicks()))
+    {
+        // Might be able to send more, or finish, now.
+        scheduler.setTaskReady(*this);
+    }
+}
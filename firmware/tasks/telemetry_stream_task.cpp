@@ -0,0 +1,253 @@
+// Includes
+#include <cmath>
+#include <cstring>
+#include "telemetry_stream_task.h"
+#include "glo_frame.h"
+#include "globs.h"
+#include "main_control_task.h"
+#include "math_util.h"
+#include "util_assert.h"
+
+//******************************************************************************
+TelemetryStreamTask::TelemetryStreamTask(float frequency) :
+      PeriodicTask("Stream", TASK_ID_TELEM_STREAM, frequency),
+      num_runs_(0)
+{
+    memset(streams_, 0, sizeof(streams_));
+}
+
+//******************************************************************************
+void TelemetryStreamTask::run(void)
+{
+    for (uint32_t i = 0; i < STREAM_MAX_SUBSCRIPTIONS; ++i)
+    {
+        telemetry_stream_t const & stream = streams_[i];
+        if ((stream.period == 0) || (num_runs_ % stream.period != stream.phase))
+        {
+            continue;
+        }
+
+        // Send each instance on its own so a range isn't turned into a reliable bulk transfer.
+        glo_stream_subscription_t const & sub = stream.subscription;
+        for (uint32_t instance = sub.first_instance; instance <= sub.last_instance; instance += sub.decimation)
+        {
+            send_task.send(sub.glob_id, (uint16_t)instance);
+        }
+    }
+
+    sendCapture();
+
+    num_runs_++;
+}
+
+//******************************************************************************
+void TelemetryStreamTask::sendCapture(void)
+{
+    CaptureRing & ring = main_control_task.captureRing();
+
+    // The main control task resets the ring when it starts a capture so don't let it run in the middle.
+    uint32_t preemptive_state = scheduler.disablePreemptiveTasks();
+
+    if (!ring.isStreaming())
+    {
+        scheduler.restorePreemptiveTasks(preemptive_state);
+        return;
+    }
+
+    // Only one range is queued at a time, so once the bulk class is empty the last one has been sent.
+    bool done = false;
+    if (send_task.numQueued(TELEMETRY_CLASS_BULK) == 0)
+    {
+        ring.releaseQueued();
+
+        // Stop at the last instance so it's one range.
+        uint32_t first = ring.numReleased();
+        uint16_t first_instance = ring.instanceOf(first);
+        uint32_t num_samples = min(ring.numWritten() - first, (uint32_t)CAPTURE_STREAM_CHUNK);
+        num_samples = min(num_samples, (uint32_t)(ring.size() - first_instance + 1));
+
+        if (num_samples > 0)
+        {
+            if (send_task.send(GLO_ID_CAPTURE_DATA, first_instance, (uint16_t)(first_instance + num_samples - 1)))
+            {
+                ring.queued(first + num_samples);
+            }
+        }
+        else if (ring.isFinished())
+        {
+            ring.stopStreaming();
+            done = true;
+        }
+    }
+
+    glo_capture_status_t status;
+    status.num_captured = ring.numWritten() + ring.numOverruns();
+    status.num_sent = ring.numReleased();
+    status.num_overruns = ring.numOverruns();
+    status.backlog = (uint16_t)ring.backlog();
+    status.max_backlog = (uint16_t)ring.maxBacklog();
+    status.ring_size = ring.size();
+    status.streaming = !done;
+
+    scheduler.restorePreemptiveTasks(preemptive_state);
+
+    uint32_t status_period = (uint32_t)lroundf(CAPTURE_STATUS_PERIOD * frequency_);
+    if (done || (status_period == 0) || (num_runs_ % status_period == 0))
+    {
+        glo_capture_status.publish(&status);
+        send_task.send(glo_capture_status.get_id());
+    }
+
+    if (done)
+    {
+        // Main control task already published how many samples there are.
+        send_task.send(glo_capture_command.get_id());
+    }
+}
+
+//******************************************************************************
+void TelemetryStreamTask::handle(glo_stream_subscription_t & subscription, uint16_t instance)
+{
+    if ((instance == 0) || (instance > STREAM_MAX_SUBSCRIPTIONS))
+    {
+        assert_always_msg(ASSERT_CONTINUE, "Invalid stream subscription %d", (int)instance);
+        return;
+    }
+
+    // Stop the old subscription first so it doesn't count against the new one's bandwidth.
+    telemetry_stream_t & stream = streams_[instance-1];
+    stream.period = 0;
+
+    subscription.status = subscribe(subscription, &stream);
+    if ((subscription.status != STREAM_STATUS_ACTIVE) && (subscription.status != STREAM_STATUS_RATE_LIMITED))
+    {
+        subscription.rate = 0;
+        stream.period = 0;
+    }
+    stream.subscription = subscription;
+
+    // Let the GUI know what it actually got.
+    glo_stream_subscription.publish(&subscription, instance);
+    send_task.send(glo_stream_subscription.get_id(), instance);
+}
+
+//******************************************************************************
+float TelemetryStreamTask::bytesPerSecond(void) const
+{
+    float bytes_per_second = 0;
+    for (uint32_t i = 0; i < STREAM_MAX_SUBSCRIPTIONS; ++i)
+    {
+        if (streams_[i].period != 0)
+        {
+            bytes_per_second += streams_[i].bytes_per_send * frequency_ / streams_[i].period;
+        }
+    }
+    return bytes_per_second;
+}
+
+//******************************************************************************
+glo_stream_status_t TelemetryStreamTask::subscribe(glo_stream_subscription_t & subscription, telemetry_stream_t * stream)
+{
+    if (!(subscription.rate > 0))
+    {
+        return STREAM_STATUS_OFF;
+    }
+
+    // Assert and debug messages are already sent as they happen.
+    uint8_t id = subscription.glob_id;
+    if ((id >= NUM_GLOBS) || (id == GLO_ID_ASSERT_MESSAGE) || (id == GLO_ID_DEBUG_MESSAGE))
+    {
+        return STREAM_STATUS_REJECTED;
+    }
+
+    if (subscription.first_instance == 0)
+    {
+        subscription.first_instance = 1;
+    }
+    if (subscription.last_instance == 0)
+    {
+        subscription.last_instance = subscription.first_instance;
+    }
+    if (subscription.decimation == 0)
+    {
+        subscription.decimation = 1;
+    }
+    if ((subscription.first_instance > subscription.last_instance) ||
+        (subscription.last_instance > globs[id]->get_num_instances()))
+    {
+        return STREAM_STATUS_REJECTED;
+    }
+
+    uint32_t num_sent = (subscription.last_instance - subscription.first_instance) / subscription.decimation + 1;
+    if (num_sent > STREAM_MAX_INSTANCES)
+    {
+        return STREAM_STATUS_REJECTED;
+    }
+
+    uint32_t period = (uint32_t)lroundf(frequency_ / subscription.rate);
+    period = (period == 0) ? 1 : period;
+    uint32_t max_period = (uint32_t)(frequency_ / STREAM_MIN_RATE);
+
+    float bytes_per_send = num_sent * (float)msg_frames_size(globs[id]->get_send_size());
+    float bytes_left = STREAM_LINK_SHARE * send_task.linkBytesPerSecond() - bytesPerSecond();
+
+    glo_stream_status_t status = STREAM_STATUS_ACTIVE;
+    if (bytes_per_send * frequency_ / period > bytes_left)
+    {
+        if (bytes_left <= 0)
+        {
+            return STREAM_STATUS_REJECTED;
+        }
+        period = (uint32_t)ceilf(bytes_per_send * frequency_ / bytes_left);
+        if (period > max_period)
+        {
+            return STREAM_STATUS_REJECTED;
+        }
+        status = STREAM_STATUS_RATE_LIMITED;
+    }
+
+    stream->phase = pickPhase(period, bytes_per_send);
+    stream->bytes_per_send = bytes_per_send;
+    stream->period = period;
+    subscription.rate = frequency_ / period;
+
+    return status;
+}
+
+//******************************************************************************
+uint32_t TelemetryStreamTask::pickPhase(uint32_t period, float num_bytes) const
+{
+    // Look far enough ahead to see every other stream send at least once (up to the stagger limit).
+    uint32_t horizon = (uint32_t)(STREAM_STAGGER_SECONDS * frequency_);
+    horizon = (horizon < period) ? period : horizon;
+
+    uint32_t best_phase = 0;
+    float best_peak = 0;
+    for (uint32_t phase = 0; phase < period; ++phase)
+    {
+        float peak = 0;
+        uint32_t first_run = (phase + period - num_runs_ % period) % period;
+        for (uint32_t run = first_run; run < horizon; run += period)
+        {
+            uint32_t future_run = num_runs_ + run;
+            float burst = num_bytes;
+            for (uint32_t i = 0; i < STREAM_MAX_SUBSCRIPTIONS; ++i)
+            {
+                telemetry_stream_t const & other = streams_[i];
+                if ((other.period != 0) && (future_run % other.period == other.phase))
+                {
+                    burst += other.bytes_per_send;
+                }
+            }
+            peak = (burst > peak) ? burst : peak;
+        }
+
+        if ((phase == 0) || (peak < best_peak))
+        {
+            best_phase = phase;
+            best_peak = peak;
+        }
+    }
+
+    return best_phase;
+}